@@ -0,0 +1,113 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_ACK_HANDLER_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_ACK_HANDLER_H
+
+#include "google/cloud/pubsub/version.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace google {
+namespace cloud {
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Acknowledge or reject a message received via `SubscriberClient::Subscribe()`.
+ *
+ * Each message delivered to the application callback comes with one of these
+ * objects. The application calls `ack()` once the message is successfully
+ * processed, or `nack()` to request that the service redelivers the message.
+ * If the object is destroyed without calling either function the message is
+ * rejected, as if `nack()` was called.
+ *
+ * Both functions consume the object, they can be called at most once, and only
+ * on an rvalue, e.g.:
+ *
+ * @code
+ * std::move(handler).ack();
+ * @endcode
+ *
+ * @par Thread Safety
+ * This is a move-only type. The application may transfer the object to a
+ * different thread, for example, to acknowledge the message once some
+ * asynchronous processing completes.
+ */
+class AckHandler {
+ public:
+  /**
+   * Implement the acknowledgement protocol for a single message.
+   *
+   * This is an implementation detail, applications only need it to mock
+   * `AckHandler` in their tests.
+   */
+  class Impl {
+   public:
+    virtual ~Impl() = 0;
+    virtual void ack() = 0;
+    virtual void nack() = 0;
+    virtual std::string ack_id() const = 0;
+    virtual std::int32_t delivery_attempt() const = 0;
+  };
+
+  explicit AckHandler(std::unique_ptr<Impl> impl) : impl_(std::move(impl)) {}
+
+  /// Rejects the message if neither `ack()` nor `nack()` were called.
+  ~AckHandler();
+
+  AckHandler(AckHandler&&) = default;
+  AckHandler& operator=(AckHandler&& rhs);
+
+  AckHandler(AckHandler const&) = delete;
+  AckHandler& operator=(AckHandler const&) = delete;
+
+  /// Acknowledge the message, the service will not deliver it again.
+  void ack() && {
+    auto impl = std::move(impl_);
+    if (impl) impl->ack();
+  }
+
+  /// Reject the message, the service will deliver it again, maybe to another
+  /// subscriber.
+  void nack() && {
+    auto impl = std::move(impl_);
+    if (impl) impl->nack();
+  }
+
+  /// The id used by the service to identify this delivery of the message.
+  std::string ack_id() const { return impl_ ? impl_->ack_id() : std::string{}; }
+
+  /**
+   * The approximate number of times the service attempted to deliver this
+   * message.
+   *
+   * This is only set if the subscription has a dead letter policy, it is `0`
+   * otherwise.
+   */
+  std::int32_t delivery_attempt() const {
+    return impl_ ? impl_->delivery_attempt() : 0;
+  }
+
+ private:
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_ACK_HANDLER_H
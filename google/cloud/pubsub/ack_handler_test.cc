@@ -0,0 +1,79 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/ack_handler.h"
+#include "google/cloud/internal/make_unique.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+class MockImpl : public AckHandler::Impl {
+ public:
+  MOCK_METHOD(void, ack, (), (override));
+  MOCK_METHOD(void, nack, (), (override));
+  MOCK_METHOD(std::string, ack_id, (), (const, override));
+  MOCK_METHOD(std::int32_t, delivery_attempt, (), (const, override));
+};
+
+TEST(AckHandlerTest, AckOnce) {
+  auto mock = google::cloud::internal::make_unique<MockImpl>();
+  EXPECT_CALL(*mock, ack_id()).WillOnce(::testing::Return("test-ack-id"));
+  EXPECT_CALL(*mock, delivery_attempt()).WillOnce(::testing::Return(42));
+  EXPECT_CALL(*mock, ack()).Times(1);
+  EXPECT_CALL(*mock, nack()).Times(0);
+
+  AckHandler handler(std::move(mock));
+  EXPECT_EQ("test-ack-id", handler.ack_id());
+  EXPECT_EQ(42, handler.delivery_attempt());
+  std::move(handler).ack();
+}
+
+TEST(AckHandlerTest, NackOnce) {
+  auto mock = google::cloud::internal::make_unique<MockImpl>();
+  EXPECT_CALL(*mock, ack()).Times(0);
+  EXPECT_CALL(*mock, nack()).Times(1);
+
+  AckHandler handler(std::move(mock));
+  std::move(handler).nack();
+}
+
+TEST(AckHandlerTest, NackOnDestruction) {
+  auto mock = google::cloud::internal::make_unique<MockImpl>();
+  EXPECT_CALL(*mock, ack()).Times(0);
+  EXPECT_CALL(*mock, nack()).Times(1);
+
+  { AckHandler handler(std::move(mock)); }
+}
+
+TEST(AckHandlerTest, MoveAssignmentRejectsPrevious) {
+  auto m1 = google::cloud::internal::make_unique<MockImpl>();
+  EXPECT_CALL(*m1, nack()).Times(1);
+  auto m2 = google::cloud::internal::make_unique<MockImpl>();
+  EXPECT_CALL(*m2, ack()).Times(1);
+
+  AckHandler h1(std::move(m1));
+  AckHandler h2(std::move(m2));
+  h1 = std::move(h2);
+  std::move(h1).ack();
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,50 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/backoff_policy.h"
+#include "google/cloud/internal/make_unique.h"
+#include "google/cloud/internal/random.h"
+#include <algorithm>
+#include <random>
+
+namespace google {
+namespace cloud {
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+std::unique_ptr<BackoffPolicy> ExponentialBackoffPolicy::clone() const {
+  return google::cloud::internal::make_unique<ExponentialBackoffPolicy>(
+      initial_delay_, maximum_delay_, scaling_);
+}
+
+std::chrono::milliseconds ExponentialBackoffPolicy::OnCompletion() {
+  // Each operation clones the policy, even if it never fails. Seeding a
+  // generator for each clone is expensive, each thread has its own instead.
+  static thread_local auto generator =
+      google::cloud::internal::MakeDefaultPRNG();
+  auto const upper = (std::min)(current_delay_, maximum_delay_).count();
+  auto const delay = std::chrono::microseconds(
+      std::uniform_int_distribution<std::chrono::microseconds::rep>(
+          upper / 2, upper)(generator));
+  current_delay_ = (std::min)(
+      maximum_delay_,
+      std::chrono::microseconds(static_cast<std::chrono::microseconds::rep>(
+          static_cast<double>(current_delay_.count()) * scaling_)));
+  return std::chrono::duration_cast<std::chrono::milliseconds>(delay);
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+}  // namespace cloud
+}  // namespace google
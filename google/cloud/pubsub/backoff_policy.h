@@ -0,0 +1,79 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_BACKOFF_POLICY_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_BACKOFF_POLICY_H
+
+#include "google/cloud/pubsub/version.h"
+#include <chrono>
+#include <memory>
+
+namespace google {
+namespace cloud {
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Control how long to wait before retrying a failed operation.
+ *
+ * Each operation gets its own copy of the policy (see `clone()`).
+ */
+class BackoffPolicy {
+ public:
+  virtual ~BackoffPolicy() = default;
+
+  /// Return a new copy of this policy, with its initial state.
+  virtual std::unique_ptr<BackoffPolicy> clone() const = 0;
+
+  /// Return the delay before the next attempt.
+  virtual std::chrono::milliseconds OnCompletion() = 0;
+};
+
+/**
+ * Truncated exponential backoff with jitter.
+ *
+ * The delay before the first retry is `initial_delay`, each following delay
+ * is `scaling` times longer, up to `maximum_delay`. The policy waits a random
+ * time between half and all of the current delay, so clients that failed at
+ * the same time do not retry at the same time.
+ */
+class ExponentialBackoffPolicy : public BackoffPolicy {
+ public:
+  template <typename Rep1, typename Period1, typename Rep2, typename Period2>
+  ExponentialBackoffPolicy(std::chrono::duration<Rep1, Period1> initial_delay,
+                           std::chrono::duration<Rep2, Period2> maximum_delay,
+                           double scaling)
+      : initial_delay_(std::chrono::duration_cast<std::chrono::microseconds>(
+            initial_delay)),
+        maximum_delay_(std::chrono::duration_cast<std::chrono::microseconds>(
+            maximum_delay)),
+        scaling_(scaling < 1.0 ? 1.0 : scaling),
+        current_delay_(initial_delay_) {}
+
+  std::unique_ptr<BackoffPolicy> clone() const override;
+  std::chrono::milliseconds OnCompletion() override;
+
+ private:
+  std::chrono::microseconds const initial_delay_;
+  std::chrono::microseconds const maximum_delay_;
+  double const scaling_;
+  std::chrono::microseconds current_delay_;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_BACKOFF_POLICY_H
@@ -0,0 +1,76 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/backoff_policy.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using ms = std::chrono::milliseconds;
+
+TEST(BackoffPolicyTest, ExponentialWithJitter) {
+  ExponentialBackoffPolicy policy(ms(100), ms(1000), 2.0);
+  auto tested = policy.clone();
+  for (auto const upper : {100, 200, 400, 800, 1000, 1000}) {
+    auto const delay = tested->OnCompletion();
+    EXPECT_LE(ms(upper / 2), delay) << "upper=" << upper;
+    EXPECT_GE(ms(upper), delay) << "upper=" << upper;
+  }
+
+  // Each clone starts from the initial delay.
+  auto const delay = tested->clone()->OnCompletion();
+  EXPECT_LE(ms(50), delay);
+  EXPECT_GE(ms(100), delay);
+}
+
+TEST(BackoffPolicyTest, Jitter) {
+  ExponentialBackoffPolicy policy(ms(1000), ms(1000), 2.0);
+  auto const first = policy.OnCompletion();
+  bool different = false;
+  for (int i = 0; i != 100 && !different; ++i) {
+    different = policy.OnCompletion() != first;
+  }
+  EXPECT_TRUE(different);
+}
+
+TEST(BackoffPolicyTest, JitterAcrossClones) {
+  // The clones share the generator of their thread, they do not repeat the
+  // same delays.
+  ExponentialBackoffPolicy policy(ms(1000), ms(1000), 2.0);
+  auto const first = policy.clone()->OnCompletion();
+  bool different = false;
+  for (int i = 0; i != 100 && !different; ++i) {
+    different = policy.clone()->OnCompletion() != first;
+  }
+  EXPECT_TRUE(different);
+}
+
+TEST(BackoffPolicyTest, ScalingBelowOne) {
+  ExponentialBackoffPolicy policy(ms(100), ms(1000), 0.5);
+  for (int i = 0; i != 5; ++i) {
+    auto const delay = policy.OnCompletion();
+    EXPECT_LE(ms(50), delay);
+    EXPECT_GE(ms(100), delay);
+  }
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,57 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/idempotency_policy.h"
+#include "google/cloud/internal/make_unique.h"
+
+namespace google {
+namespace cloud {
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+std::unique_ptr<IdempotencyPolicy> DefaultIdempotencyPolicy::clone() const {
+  return google::cloud::internal::make_unique<DefaultIdempotencyPolicy>();
+}
+
+bool DefaultIdempotencyPolicy::IsIdempotent(Operation operation) const {
+  switch (operation) {
+    case Operation::kListTopics:
+    case Operation::kListSubscriptions:
+    case Operation::kPull:
+    case Operation::kAcknowledge:
+    case Operation::kModifyAckDeadline:
+      return true;
+    case Operation::kCreateTopic:
+    case Operation::kDeleteTopic:
+    case Operation::kPublish:
+    case Operation::kCreateSubscription:
+    case Operation::kDeleteSubscription:
+      return false;
+  }
+  return false;
+}
+
+std::unique_ptr<IdempotencyPolicy> AlwaysRetryIdempotencyPolicy::clone()
+    const {
+  return google::cloud::internal::make_unique<AlwaysRetryIdempotencyPolicy>();
+}
+
+bool AlwaysRetryIdempotencyPolicy::IsIdempotent(Operation) const {
+  return true;
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+}  // namespace cloud
+}  // namespace google
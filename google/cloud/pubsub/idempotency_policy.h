@@ -0,0 +1,91 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_IDEMPOTENCY_POLICY_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_IDEMPOTENCY_POLICY_H
+
+#include "google/cloud/pubsub/version.h"
+#include <memory>
+
+namespace google {
+namespace cloud {
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Control which operations are retried.
+ *
+ * Retrying an operation that is not idempotent can change its result, for
+ * example, retrying a `CreateTopic()` that succeeded, but whose response was
+ * lost, fails with `kAlreadyExists`, and retrying a `Publish()` can publish
+ * the same messages twice. Only the operations for which this policy returns
+ * `true` are retried.
+ */
+class IdempotencyPolicy {
+ public:
+  /// The operations that may be retried.
+  enum class Operation {
+    kCreateTopic,
+    kListTopics,
+    kDeleteTopic,
+    kPublish,
+    kCreateSubscription,
+    kListSubscriptions,
+    kDeleteSubscription,
+    kPull,
+    kAcknowledge,
+    kModifyAckDeadline,
+  };
+
+  virtual ~IdempotencyPolicy() = default;
+
+  /// Return a new copy of this policy.
+  virtual std::unique_ptr<IdempotencyPolicy> clone() const = 0;
+
+  /// Return `true` if @p operation can be safely retried.
+  virtual bool IsIdempotent(Operation operation) const = 0;
+};
+
+/**
+ * Retry the read-only operations, and the operations that are safe to repeat.
+ *
+ * The `List*()` operations, `Pull()`, and the acknowledgement and deadline
+ * changes are retried. Creating and deleting topics or subscriptions, and
+ * publishing messages, are not.
+ */
+class DefaultIdempotencyPolicy : public IdempotencyPolicy {
+ public:
+  std::unique_ptr<IdempotencyPolicy> clone() const override;
+  bool IsIdempotent(Operation operation) const override;
+};
+
+/**
+ * Retry all operations.
+ *
+ * Use this policy if the application tolerates the side effects of retrying,
+ * for example, if the subscribers already handle duplicate messages, retrying
+ * `Publish()` is preferable to losing the messages.
+ */
+class AlwaysRetryIdempotencyPolicy : public IdempotencyPolicy {
+ public:
+  std::unique_ptr<IdempotencyPolicy> clone() const override;
+  bool IsIdempotent(Operation operation) const override;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_IDEMPOTENCY_POLICY_H
@@ -0,0 +1,53 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/idempotency_policy.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using Operation = IdempotencyPolicy::Operation;
+
+TEST(IdempotencyPolicyTest, Default) {
+  DefaultIdempotencyPolicy policy;
+  auto tested = policy.clone();
+  EXPECT_FALSE(tested->IsIdempotent(Operation::kCreateTopic));
+  EXPECT_TRUE(tested->IsIdempotent(Operation::kListTopics));
+  EXPECT_FALSE(tested->IsIdempotent(Operation::kDeleteTopic));
+  EXPECT_FALSE(tested->IsIdempotent(Operation::kPublish));
+  EXPECT_FALSE(tested->IsIdempotent(Operation::kCreateSubscription));
+  EXPECT_TRUE(tested->IsIdempotent(Operation::kListSubscriptions));
+  EXPECT_FALSE(tested->IsIdempotent(Operation::kDeleteSubscription));
+  EXPECT_TRUE(tested->IsIdempotent(Operation::kPull));
+  EXPECT_TRUE(tested->IsIdempotent(Operation::kAcknowledge));
+  EXPECT_TRUE(tested->IsIdempotent(Operation::kModifyAckDeadline));
+}
+
+TEST(IdempotencyPolicyTest, AlwaysRetry) {
+  AlwaysRetryIdempotencyPolicy policy;
+  auto tested = policy.clone();
+  EXPECT_TRUE(tested->IsIdempotent(Operation::kCreateTopic));
+  EXPECT_TRUE(tested->IsIdempotent(Operation::kPublish));
+  EXPECT_TRUE(tested->IsIdempotent(Operation::kDeleteSubscription));
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+}  // namespace cloud
+}  // namespace google
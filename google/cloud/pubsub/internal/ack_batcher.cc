@@ -0,0 +1,104 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/ack_batcher.h"
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+AckBatcher::AckBatcher(google::cloud::grpc_utils::CompletionQueue cq,
+                       SendFunction send, std::size_t maximum_count,
+                       std::chrono::microseconds hold_time,
+                       std::shared_ptr<SubscriberCounters> counters)
+    : cq_(std::move(cq)),
+      send_(std::move(send)),
+      maximum_count_(maximum_count == 0 ? 1 : maximum_count),
+      hold_time_(hold_time),
+      counters_(std::move(counters)) {}
+
+void AckBatcher::Ack(std::string ack_id) {
+  std::unique_lock<std::mutex> lk(mu_);
+  if (shutdown_) return;
+  pending_.add_ack_ids(std::move(ack_id));
+  OnAdd(std::move(lk));
+}
+
+void AckBatcher::ModifyDeadline(std::string ack_id, std::int32_t seconds) {
+  std::unique_lock<std::mutex> lk(mu_);
+  if (shutdown_) return;
+  pending_.add_modify_deadline_ack_ids(std::move(ack_id));
+  pending_.add_modify_deadline_seconds(seconds);
+  OnAdd(std::move(lk));
+}
+
+void AckBatcher::Flush() { SendBatch(std::unique_lock<std::mutex>(mu_)); }
+
+void AckBatcher::Shutdown() {
+  std::unique_lock<std::mutex> lk(mu_);
+  shutdown_ = true;
+  SendBatch(std::move(lk));
+}
+
+void AckBatcher::OnAdd(std::unique_lock<std::mutex> lk) {
+  auto const count = PendingCount();
+  if (count >= maximum_count_) {
+    SendBatch(std::move(lk));
+    return;
+  }
+  if (count != 1) return;
+  // This is the first item in the batch, start its timer. Hold the lock while
+  // starting the timer: the completion queue shuts down only after
+  // `Shutdown()` returns.
+  using TimerResult = StatusOr<std::chrono::system_clock::time_point>;
+  std::weak_ptr<AckBatcher> w = shared_from_this();
+  auto const generation = generation_;
+  cq_.MakeRelativeTimer(hold_time_)
+      .then([w, generation](future<TimerResult> f) {
+        // If the timer was cancelled the completion queue is shutting down,
+        // the batch is sent by `Shutdown()`.
+        if (!f.get().ok()) return;
+        if (auto self = w.lock()) self->OnTimer(generation);
+      });
+}
+
+void AckBatcher::OnTimer(std::uint64_t generation) {
+  std::unique_lock<std::mutex> lk(mu_);
+  // The batch was already sent, because it reached the maximum count.
+  if (generation != generation_) return;
+  SendBatch(std::move(lk));
+}
+
+std::size_t AckBatcher::PendingCount() const {
+  return static_cast<std::size_t>(pending_.ack_ids_size() +
+                                  pending_.modify_deadline_ack_ids_size());
+}
+
+void AckBatcher::SendBatch(std::unique_lock<std::mutex> lk) {
+  auto const count = PendingCount();
+  if (count == 0) return;
+  google::pubsub::v1::StreamingPullRequest request;
+  request.Swap(&pending_);
+  ++generation_;
+  lk.unlock();
+  counters_->ack_batches.fetch_add(1);
+  counters_->ack_batch_items.fetch_add(count);
+  send_(std::move(request));
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
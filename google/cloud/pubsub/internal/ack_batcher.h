@@ -0,0 +1,93 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_ACK_BATCHER_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_ACK_BATCHER_H
+
+#include "google/cloud/pubsub/internal/subscriber_counters.h"
+#include "google/cloud/pubsub/version.h"
+#include "google/cloud/grpc_utils/completion_queue.h"
+#include <google/pubsub/v1/pubsub.pb.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Collect acknowledgements and deadline modifications into batches.
+ *
+ * Sending one request per message would require thousands of requests per
+ * second in busy subscribers. This class collects the acknowledgements,
+ * rejections (a deadline modification to 0 seconds), and deadline extensions
+ * into a single `StreamingPullRequest`, which is sent when it contains
+ * `maximum_count` items, or `hold_time` after the first item was added,
+ * whichever happens first.
+ *
+ * Objects of this class must be created via `std::make_shared<>()`, the
+ * timers hold a weak pointer to the batcher.
+ */
+class AckBatcher : public std::enable_shared_from_this<AckBatcher> {
+ public:
+  /// Send a batch, called without holding any locks.
+  using SendFunction =
+      std::function<void(google::pubsub::v1::StreamingPullRequest)>;
+
+  AckBatcher(google::cloud::grpc_utils::CompletionQueue cq, SendFunction send,
+             std::size_t maximum_count, std::chrono::microseconds hold_time,
+             std::shared_ptr<SubscriberCounters> counters);
+
+  /// Acknowledge @p ack_id.
+  void Ack(std::string ack_id);
+
+  /// Change the deadline for @p ack_id, use `0` to reject the message.
+  void ModifyDeadline(std::string ack_id, std::int32_t seconds);
+
+  /// Send the current batch, if any.
+  void Flush();
+
+  /// Flush the current batch and ignore any new items.
+  void Shutdown();
+
+ private:
+  void OnAdd(std::unique_lock<std::mutex> lk);
+  void OnTimer(std::uint64_t generation);
+  std::size_t PendingCount() const;
+  void SendBatch(std::unique_lock<std::mutex> lk);
+
+  google::cloud::grpc_utils::CompletionQueue cq_;
+  SendFunction const send_;
+  std::size_t const maximum_count_;
+  std::chrono::microseconds const hold_time_;
+  std::shared_ptr<SubscriberCounters> counters_;
+
+  std::mutex mu_;
+  google::pubsub::v1::StreamingPullRequest pending_;
+  std::uint64_t generation_ = 0;
+  bool shutdown_ = false;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_ACK_BATCHER_H
@@ -0,0 +1,139 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/ack_batcher.h"
+#include "google/cloud/pubsub/internal/background_threads.h"
+#include <gmock/gmock.h>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+class BatchCollector {
+ public:
+  AckBatcher::SendFunction AsFunction() {
+    return [this](google::pubsub::v1::StreamingPullRequest r) {
+      std::lock_guard<std::mutex> lk(mu_);
+      batches_.push_back(std::move(r));
+      cv_.notify_all();
+    };
+  }
+
+  std::vector<google::pubsub::v1::StreamingPullRequest> WaitFor(
+      std::size_t count) {
+    std::unique_lock<std::mutex> lk(mu_);
+    cv_.wait(lk, [&] { return batches_.size() >= count; });
+    return batches_;
+  }
+
+ private:
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::vector<google::pubsub::v1::StreamingPullRequest> batches_;
+};
+
+TEST(AckBatcherTest, FlushOnCount) {
+  BackgroundThreads background(1);
+  BatchCollector collector;
+  auto counters = std::make_shared<SubscriberCounters>();
+  auto batcher = std::make_shared<AckBatcher>(
+      background.cq(), collector.AsFunction(), 3, std::chrono::hours(1),
+      counters);
+
+  batcher->Ack("a0");
+  batcher->ModifyDeadline("m0", 0);
+  batcher->Ack("a1");
+  batcher->Ack("a2");
+  auto batches = collector.WaitFor(1);
+  ASSERT_EQ(1U, batches.size());
+  EXPECT_THAT(batches[0].ack_ids(), ElementsAre("a0", "a1"));
+  EXPECT_THAT(batches[0].modify_deadline_ack_ids(), ElementsAre("m0"));
+  EXPECT_THAT(batches[0].modify_deadline_seconds(), ElementsAre(0));
+
+  batcher->Flush();
+  batches = collector.WaitFor(2);
+  ASSERT_EQ(2U, batches.size());
+  EXPECT_THAT(batches[1].ack_ids(), ElementsAre("a2"));
+
+  auto const stats = counters->Snapshot();
+  EXPECT_EQ(2U, stats.ack_batches);
+  EXPECT_EQ(4U, stats.ack_batch_items);
+  EXPECT_DOUBLE_EQ(2.0, stats.average_ack_batch_size());
+}
+
+TEST(AckBatcherTest, FlushOnTimer) {
+  BackgroundThreads background(1);
+  BatchCollector collector;
+  auto batcher = std::make_shared<AckBatcher>(
+      background.cq(), collector.AsFunction(), 100,
+      std::chrono::milliseconds(5), std::make_shared<SubscriberCounters>());
+
+  batcher->Ack("a0");
+  batcher->ModifyDeadline("m0", 30);
+  auto batches = collector.WaitFor(1);
+  ASSERT_EQ(1U, batches.size());
+  EXPECT_THAT(batches[0].ack_ids(), ElementsAre("a0"));
+  EXPECT_THAT(batches[0].modify_deadline_seconds(), ElementsAre(30));
+
+  // A new batch starts a new timer.
+  batcher->Ack("a1");
+  batches = collector.WaitFor(2);
+  ASSERT_EQ(2U, batches.size());
+  EXPECT_THAT(batches[1].ack_ids(), ElementsAre("a1"));
+  EXPECT_THAT(batches[1].modify_deadline_ack_ids(), IsEmpty());
+}
+
+TEST(AckBatcherTest, ShutdownFlushesAndDiscards) {
+  BackgroundThreads background(1);
+  BatchCollector collector;
+  auto counters = std::make_shared<SubscriberCounters>();
+  auto batcher = std::make_shared<AckBatcher>(
+      background.cq(), collector.AsFunction(), 100, std::chrono::hours(1),
+      counters);
+
+  batcher->Ack("a0");
+  batcher->Shutdown();
+  batcher->Ack("a1");
+  batcher->Flush();
+  auto batches = collector.WaitFor(1);
+  ASSERT_EQ(1U, batches.size());
+  EXPECT_THAT(batches[0].ack_ids(), ElementsAre("a0"));
+  EXPECT_EQ(1U, counters->Snapshot().ack_batches);
+}
+
+TEST(AckBatcherTest, EmptyFlush) {
+  BackgroundThreads background(1);
+  BatchCollector collector;
+  auto counters = std::make_shared<SubscriberCounters>();
+  auto batcher = std::make_shared<AckBatcher>(
+      background.cq(), collector.AsFunction(), 100, std::chrono::hours(1),
+      counters);
+  batcher->Flush();
+  EXPECT_EQ(0U, counters->Snapshot().ack_batches);
+  EXPECT_DOUBLE_EQ(0.0, counters->Snapshot().average_ack_batch_size());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,74 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/ack_id_map.h"
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+namespace {
+/// Small sessions start with small chunks, the chunks double up to 64KiB.
+std::size_t constexpr kMinimumChunkSize = 4 * 1024;
+std::size_t constexpr kMaximumChunkSize = 64 * 1024;
+}  // namespace
+
+std::uint32_t HashAckId(char const* data, std::size_t size) {
+  // The ack ids are long, hash them 8 bytes at a time: a variation of FNV-1a
+  // on 64-bit words, with the MurmurHash3 finalizer to mix the high bits.
+  auto constexpr kPrime = 1099511628211ULL;
+  std::uint64_t hash = 14695981039346656037ULL ^ size;
+  std::size_t i = 0;
+  for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t)) {
+    std::uint64_t word;
+    std::memcpy(&word, data + i, sizeof(word));
+    hash = (hash ^ word) * kPrime;
+  }
+  for (; i != size; ++i) {
+    hash = (hash ^ static_cast<unsigned char>(data[i])) * kPrime;
+  }
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return static_cast<std::uint32_t>(hash);
+}
+
+char* AckIdArena::Allocate(std::size_t size) {
+  if (chunks_.empty() || chunk_capacity_ - chunk_used_ < size) {
+    auto capacity = chunks_.empty()
+                        ? kMinimumChunkSize
+                        : (std::min)(kMaximumChunkSize, 2 * chunk_capacity_);
+    capacity = (std::max)(capacity, size);
+    chunks_.emplace_back(new char[capacity]);
+    chunk_capacity_ = capacity;
+    chunk_used_ = 0;
+    allocated_bytes_ += capacity;
+  }
+  auto* p = chunks_.back().get() + chunk_used_;
+  chunk_used_ += size;
+  live_bytes_ += size;
+  return p;
+}
+
+bool AckIdArena::NeedsCompaction() const {
+  return allocated_bytes_ > 2 * live_bytes_ + kMaximumChunkSize;
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
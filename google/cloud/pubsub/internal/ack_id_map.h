@@ -0,0 +1,385 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_ACK_ID_MAP_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_ACK_ID_MAP_H
+
+#include "google/cloud/pubsub/version.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/// Hash the bytes of an ack id.
+std::uint32_t HashAckId(char const* data, std::size_t size);
+
+/**
+ * Store ack ids in large chunks of memory.
+ *
+ * The ack ids are copied one after the other into chunks of up to 64KiB, so
+ * millions of ack ids need a few thousand allocations instead of one each.
+ * Released ack ids are not reused, the owner calls `NeedsCompaction()` and
+ * copies the live ack ids into a new arena once most of the memory is unused.
+ */
+class AckIdArena {
+ public:
+  AckIdArena() = default;
+
+  AckIdArena(AckIdArena&&) = default;
+  AckIdArena& operator=(AckIdArena&&) = default;
+
+  /// Copy @p size bytes from @p data into the arena.
+  char const* Store(char const* data, std::size_t size) {
+    auto* p = Allocate(size);
+    std::memcpy(p, data, size);
+    return p;
+  }
+
+  /// Reserve @p size bytes in the arena, the caller fills them.
+  char* Allocate(std::size_t size);
+
+  /// Mark @p size bytes as no longer used.
+  void Release(std::size_t size) { live_bytes_ -= size; }
+
+  /// Return true if more than half of the allocated memory is unused.
+  bool NeedsCompaction() const;
+
+  /// The total memory allocated for the chunks.
+  std::size_t allocated_bytes() const { return allocated_bytes_; }
+
+  /// The memory used by ack ids that were not released.
+  std::size_t live_bytes() const { return live_bytes_; }
+
+  /// The number of chunks, that is, the number of allocations.
+  std::size_t chunk_count() const { return chunks_.size(); }
+
+ private:
+  std::vector<std::unique_ptr<char[]>> chunks_;
+  std::size_t chunk_capacity_ = 0;
+  std::size_t chunk_used_ = 0;
+  std::size_t allocated_bytes_ = 0;
+  std::size_t live_bytes_ = 0;
+};
+
+/// A stable reference to an `AckIdMap` entry, see `AckIdMap::Add()`.
+using AckIdHandle = std::uint64_t;
+
+/**
+ * A hash map from ack ids to @p T optimized for millions of entries.
+ *
+ * A session may lease millions of messages, and `std::unordered_map` would
+ * use a node, and a separate allocation for each ack id string, for each
+ * message. This class copies the ack ids into an `AckIdArena`, keeps the
+ * entries in a dense vector, and indexes them with an open-addressing hash
+ * table (linear probing, with backward-shift deletion). The table only holds
+ * 32-bit indices into the vector, so it stays small even at low load factors.
+ *
+ * The ack ids are exposed to the callbacks as a `Key`, which is only valid
+ * during the call. Entries inserted with `Add()` also have a handle, which
+ * stays valid as other entries move, until the entry is removed. A handle is
+ * the hash of the ack id and a serial number, finding it probes the table
+ * without comparing ack ids, and needs no additional memory. This class is not
+ * thread-safe.
+ */
+template <typename T>
+class AckIdMap {
+ public:
+  /// A reference to an ack id stored in the map.
+  struct Key {
+    char const* data;
+    std::size_t size;
+
+    std::string ToString() const { return std::string(data, size); }
+  };
+
+  using Handle = AckIdHandle;
+
+  AckIdMap() = default;
+
+  /// The number of entries.
+  std::size_t size() const { return entries_.size(); }
+
+  /// Insert (or replace) the value for @p ack_id, return true if inserted.
+  bool Insert(std::string const& ack_id, T value) {
+    auto const hash = HashAckId(ack_id.data(), ack_id.size());
+    auto slot = FindSlot(ack_id.data(), ack_id.size(), hash);
+    if (slot != kNotFound && slots_[slot] != kEmpty) {
+      entries_[slots_[slot]].value = std::move(value);
+      return false;
+    }
+    // Keep the load factor below 7/8, linear probing degrades quickly past
+    // that point.
+    if ((entries_.size() + 1) * 8 > slots_.size() * 7) {
+      Rehash((std::max)(kMinimumSlots, slots_.size() * 2));
+      slot = FindSlot(ack_id.data(), ack_id.size(), hash);
+    }
+    Append(slot, ack_id, hash, std::string{}, std::move(value));
+    return true;
+  }
+
+  /**
+   * Insert the entry for @p ack_id, and return its handle.
+   *
+   * @p payload is stored in the arena, next to the ack id, see `PayloadOf()`.
+   * If @p ack_id is already in the map its entry, and handle, are replaced.
+   */
+  Handle Add(std::string const& ack_id, std::string const& payload, T value) {
+    auto const hash = HashAckId(ack_id.data(), ack_id.size());
+    auto slot = FindSlot(ack_id.data(), ack_id.size(), hash);
+    if (slot != kNotFound && slots_[slot] != kEmpty) {
+      RemoveSlot(slot);
+      slot = FindSlot(ack_id.data(), ack_id.size(), hash);
+    }
+    if ((entries_.size() + 1) * 8 > slots_.size() * 7) {
+      Rehash((std::max)(kMinimumSlots, slots_.size() * 2));
+      slot = FindSlot(ack_id.data(), ack_id.size(), hash);
+    }
+    return Append(slot, ack_id, hash, payload, std::move(value));
+  }
+
+  /// Return the value for @p ack_id, or `nullptr` if not found.
+  T* Find(std::string const& ack_id) {
+    auto const slot = FindSlot(ack_id.data(), ack_id.size(),
+                               HashAckId(ack_id.data(), ack_id.size()));
+    if (slot == kNotFound || slots_[slot] == kEmpty) return nullptr;
+    return &entries_[slots_[slot]].value;
+  }
+
+  /// Return the value for @p handle, or `nullptr` if the entry was removed.
+  T* Find(Handle handle) {
+    auto const slot = FindSlot(handle);
+    return slot == kNotFound ? nullptr : &entries_[slots_[slot]].value;
+  }
+  T const* Find(Handle handle) const {
+    auto const slot = FindSlot(handle);
+    return slot == kNotFound ? nullptr : &entries_[slots_[slot]].value;
+  }
+
+  /// The ack id for @p handle, valid until the map changes.
+  Key KeyOf(Handle handle) const {
+    auto const& e = entries_[slots_[FindSlot(handle)]];
+    return Key{e.data, e.size};
+  }
+
+  /// The payload stored with @p handle, valid until the map changes.
+  Key PayloadOf(Handle handle) const {
+    auto const& e = entries_[slots_[FindSlot(handle)]];
+    return Key{e.data + e.size, e.payload_size};
+  }
+
+  /// Remove @p handle, moving its value to @p value, return false if not found.
+  bool Remove(Handle handle, T& value) {
+    auto const slot = FindSlot(handle);
+    if (slot == kNotFound) return false;
+    value = std::move(entries_[slots_[slot]].value);
+    RemoveSlot(slot);
+    MaybeCompact();
+    return true;
+  }
+
+  /// Remove @p ack_id, moving its value to @p value, return false if not found.
+  bool Remove(std::string const& ack_id, T& value) {
+    auto const slot = FindSlot(ack_id.data(), ack_id.size(),
+                               HashAckId(ack_id.data(), ack_id.size()));
+    if (slot == kNotFound || slots_[slot] == kEmpty) return false;
+    auto const index = slots_[slot];
+    value = std::move(entries_[index].value);
+    RemoveSlot(slot);
+    MaybeCompact();
+    return true;
+  }
+
+  /**
+   * Call @p f for each entry, and remove the entries where it returns `true`.
+   *
+   * @p f is called as `bool f(Key, T&)`, the entries are visited in an
+   * unspecified order.
+   */
+  template <typename Functor>
+  void RemoveIf(Functor&& f) {
+    for (std::size_t i = 0; i < entries_.size();) {
+      auto& e = entries_[i];
+      if (!f(Key{e.data, e.size}, e.value)) {
+        ++i;
+        continue;
+      }
+      // The last entry moves to `i`, do not advance.
+      RemoveSlot(SlotOf(static_cast<std::uint32_t>(i)));
+    }
+    MaybeCompact();
+  }
+
+  /// The number of chunks used to store the ack ids.
+  std::size_t chunk_count() const { return arena_.chunk_count(); }
+
+  /// The approximate memory used by the map, in bytes.
+  std::size_t memory_usage() const {
+    return sizeof(*this) + arena_.allocated_bytes() +
+           entries_.capacity() * sizeof(Entry) +
+           slots_.capacity() * sizeof(std::uint32_t);
+  }
+
+ private:
+  struct Entry {
+    // The ack id, followed by the payload.
+    char const* data;
+    std::uint32_t size;
+    std::uint32_t hash;
+    std::uint32_t payload_size;
+    std::uint32_t serial;
+    T value;
+  };
+
+  static std::uint32_t constexpr kEmpty = 0xFFFFFFFF;
+  static std::size_t constexpr kNotFound = static_cast<std::size_t>(-1);
+  static std::size_t constexpr kMinimumSlots = 16;
+
+  std::size_t mask() const { return slots_.size() - 1; }
+
+  /// Store a new entry in the empty @p slot, return its handle.
+  Handle Append(std::size_t slot, std::string const& ack_id,
+                std::uint32_t hash, std::string const& payload, T value) {
+    auto const size = static_cast<std::uint32_t>(ack_id.size());
+    auto const payload_size = static_cast<std::uint32_t>(payload.size());
+    auto* data = arena_.Allocate(size + payload_size);
+    std::memcpy(data, ack_id.data(), size);
+    if (payload_size != 0) {
+      std::memcpy(data + size, payload.data(), payload_size);
+    }
+    auto const serial = next_serial_++;
+    entries_.push_back(
+        Entry{data, size, hash, payload_size, serial, std::move(value)});
+    slots_[slot] = static_cast<std::uint32_t>(entries_.size() - 1);
+    return (static_cast<Handle>(serial) << 32) | hash;
+  }
+
+  /// Return the slot for @p handle, or `kNotFound` if it was removed.
+  std::size_t FindSlot(Handle handle) const {
+    if (slots_.empty()) return kNotFound;
+    auto const hash = static_cast<std::uint32_t>(handle & 0xFFFFFFFF);
+    auto const serial = static_cast<std::uint32_t>(handle >> 32);
+    for (std::size_t i = hash & mask();; i = (i + 1) & mask()) {
+      auto const index = slots_[i];
+      if (index == kEmpty) return kNotFound;
+      auto const& e = entries_[index];
+      if (e.hash == hash && e.serial == serial) return i;
+    }
+  }
+
+  /// Return the slot for the ack id, or the empty slot where it would go.
+  std::size_t FindSlot(char const* data, std::size_t size,
+                       std::uint32_t hash) const {
+    if (slots_.empty()) return kNotFound;
+    for (std::size_t i = hash & mask();; i = (i + 1) & mask()) {
+      auto const index = slots_[i];
+      if (index == kEmpty) return i;
+      auto const& e = entries_[index];
+      if (e.hash == hash && e.size == size &&
+          std::memcmp(e.data, data, size) == 0) {
+        return i;
+      }
+    }
+  }
+
+  /// Return the slot containing the entry at @p index.
+  std::size_t SlotOf(std::uint32_t index) const {
+    auto i = entries_[index].hash & mask();
+    while (slots_[i] != index) i = (i + 1) & mask();
+    return i;
+  }
+
+  /// Remove the entry referenced by @p slot.
+  void RemoveSlot(std::size_t slot) {
+    auto const index = slots_[slot];
+    arena_.Release(entries_[index].size + entries_[index].payload_size);
+
+    // Shift back any entries in the same probe sequence, so lookups do not
+    // need tombstones.
+    auto hole = slot;
+    for (auto i = (slot + 1) & mask(); slots_[i] != kEmpty;
+         i = (i + 1) & mask()) {
+      auto const home = entries_[slots_[i]].hash & mask();
+      // The entry at `i` can move to the hole unless its home is in the
+      // (cyclic) range (hole, i].
+      bool const stays =
+          hole <= i ? (hole < home && home <= i) : (hole < home || home <= i);
+      if (stays) continue;
+      slots_[hole] = slots_[i];
+      hole = i;
+    }
+    slots_[hole] = kEmpty;
+
+    // Keep the entries dense, move the last entry into the removed position.
+    auto const last = static_cast<std::uint32_t>(entries_.size() - 1);
+    if (index != last) {
+      slots_[SlotOf(last)] = index;
+      entries_[index] = std::move(entries_.back());
+    }
+    entries_.pop_back();
+  }
+
+  void Rehash(std::size_t slot_count) {
+    std::vector<std::uint32_t> slots(slot_count, kEmpty);
+    auto const m = slot_count - 1;
+    for (std::size_t index = 0; index != entries_.size(); ++index) {
+      auto i = entries_[index].hash & m;
+      while (slots[i] != kEmpty) i = (i + 1) & m;
+      slots[i] = static_cast<std::uint32_t>(index);
+    }
+    slots_.swap(slots);
+  }
+
+  /// Release unused memory after many entries are removed.
+  void MaybeCompact() {
+    if (!arena_.NeedsCompaction()) return;
+    AckIdArena arena;
+    for (auto& e : entries_) {
+      e.data = arena.Store(e.data, e.size + e.payload_size);
+    }
+    arena_ = std::move(arena);
+    // The table and the entries keep their high-water mark, shrink them too.
+    if (entries_.capacity() > 2 * entries_.size()) entries_.shrink_to_fit();
+    auto slot_count = kMinimumSlots;
+    while (entries_.size() * 8 > slot_count * 3) slot_count *= 2;
+    if (slot_count < slots_.size()) Rehash(slot_count);
+  }
+
+  AckIdArena arena_;
+  std::vector<Entry> entries_;
+  std::vector<std::uint32_t> slots_;
+  std::uint32_t next_serial_ = 0;
+};
+
+template <typename T>
+std::uint32_t constexpr AckIdMap<T>::kEmpty;
+template <typename T>
+std::size_t constexpr AckIdMap<T>::kNotFound;
+template <typename T>
+std::size_t constexpr AckIdMap<T>::kMinimumSlots;
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_ACK_ID_MAP_H
@@ -0,0 +1,160 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/ack_id_map.h"
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+// Measure the memory used to track the leases of many messages.
+//
+// Run with:
+//   ack_id_map_benchmark --benchmark_counters_tabular=true
+//
+// Each iteration leases N messages (the argument), with random ack ids of 176
+// bytes (typical of the service), and then acknowledges them. The
+// `bytes_per_message` counter is the memory allocated while all the messages
+// are leased, divided by N. It does not include the overhead of the allocator
+// itself, which is usually 8 to 16 bytes for each of the
+// `allocations_per_message`.
+
+auto constexpr kAckIdSize = 176;
+
+/// The same lease information as `LeaseManager`.
+struct Lease {
+  std::chrono::steady_clock::time_point received;
+  std::chrono::steady_clock::time_point deadline;
+  std::size_t bytes;
+};
+
+/// Count the memory allocated by the `std::unordered_map` nodes and buckets.
+struct AllocationCounters {
+  std::int64_t bytes = 0;
+  std::int64_t count = 0;
+};
+AllocationCounters counters;
+
+template <typename T>
+struct CountingAllocator {
+  using value_type = T;
+
+  CountingAllocator() = default;
+  template <typename U>
+  explicit CountingAllocator(CountingAllocator<U> const&) {}
+
+  T* allocate(std::size_t n) {
+    counters.bytes += static_cast<std::int64_t>(n * sizeof(T));
+    ++counters.count;
+    return std::allocator<T>().allocate(n);
+  }
+  void deallocate(T* p, std::size_t n) {
+    counters.bytes -= static_cast<std::int64_t>(n * sizeof(T));
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  template <typename U>
+  bool operator==(CountingAllocator<U> const&) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(CountingAllocator<U> const&) const {
+    return false;
+  }
+};
+
+std::vector<std::string> MakeAckIds(std::size_t count) {
+  static char const kChars[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+  std::mt19937_64 generator(42);
+  std::uniform_int_distribution<int> pick(0, sizeof(kChars) - 2);
+  std::vector<std::string> ids(count);
+  for (auto& id : ids) {
+    id.resize(kAckIdSize);
+    for (auto& c : id) c = kChars[pick(generator)];
+  }
+  return ids;
+}
+
+void ReportMemory(benchmark::State& state, std::int64_t bytes,
+                  std::int64_t count) {
+  auto const n = static_cast<double>(state.range(0));
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["bytes_per_message"] = static_cast<double>(bytes) / n;
+  state.counters["allocations_per_message"] = static_cast<double>(count) / n;
+}
+
+void BM_UnorderedMapLeases(benchmark::State& state) {
+  auto const ids = MakeAckIds(static_cast<std::size_t>(state.range(0)));
+  std::int64_t bytes = 0;
+  std::int64_t count = 0;
+  for (auto _ : state) {
+    counters = AllocationCounters{};
+    std::unordered_map<
+        std::string, Lease, std::hash<std::string>, std::equal_to<std::string>,
+        CountingAllocator<std::pair<std::string const, Lease>>>
+        leases;
+    auto const now = std::chrono::steady_clock::now();
+    std::int64_t key_bytes = 0;
+    for (auto const& id : ids) {
+      auto& lease = leases[id];
+      lease = Lease{now, now, 100};
+    }
+    // The keys use `std::allocator`, count their buffers separately. The ack
+    // ids are too large for the small string optimization.
+    for (auto const& kv : leases) {
+      key_bytes += static_cast<std::int64_t>(kv.first.capacity() + 1);
+    }
+    bytes = counters.bytes + key_bytes;
+    count = counters.count + static_cast<std::int64_t>(leases.size());
+    for (auto const& id : ids) leases.erase(id);
+  }
+  ReportMemory(state, bytes, count);
+}
+BENCHMARK(BM_UnorderedMapLeases)->Arg(10000)->Arg(100000)->Arg(2000000);
+
+void BM_AckIdMapLeases(benchmark::State& state) {
+  auto const ids = MakeAckIds(static_cast<std::size_t>(state.range(0)));
+  std::int64_t bytes = 0;
+  std::int64_t count = 0;
+  for (auto _ : state) {
+    AckIdMap<Lease> leases;
+    auto const now = std::chrono::steady_clock::now();
+    for (auto const& id : ids) leases.Insert(id, Lease{now, now, 100});
+    bytes = static_cast<std::int64_t>(leases.memory_usage());
+    // The arena chunks, plus the entries and the table.
+    count = static_cast<std::int64_t>(leases.chunk_count()) + 2;
+    Lease lease{};
+    for (auto const& id : ids) leases.Remove(id, lease);
+  }
+  ReportMemory(state, bytes, count);
+}
+BENCHMARK(BM_AckIdMapLeases)->Arg(10000)->Arg(100000)->Arg(2000000);
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,187 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/ack_id_map.h"
+#include <gmock/gmock.h>
+#include <random>
+#include <unordered_map>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using ::testing::UnorderedElementsAre;
+
+TEST(AckIdMapTest, InsertFindRemove) {
+  AckIdMap<int> map;
+  EXPECT_EQ(nullptr, map.Find("a0"));
+  EXPECT_TRUE(map.Insert("a0", 0));
+  EXPECT_TRUE(map.Insert("a1", 1));
+  EXPECT_FALSE(map.Insert("a1", 10));
+  EXPECT_EQ(2U, map.size());
+  ASSERT_NE(nullptr, map.Find("a1"));
+  EXPECT_EQ(10, *map.Find("a1"));
+
+  int value = -1;
+  EXPECT_TRUE(map.Remove("a0", value));
+  EXPECT_EQ(0, value);
+  EXPECT_FALSE(map.Remove("a0", value));
+  EXPECT_EQ(nullptr, map.Find("a0"));
+  EXPECT_EQ(1U, map.size());
+}
+
+TEST(AckIdMapTest, RemoveIf) {
+  AckIdMap<int> map;
+  for (int i = 0; i != 10; ++i) map.Insert("a" + std::to_string(i), i);
+  std::vector<std::string> visited;
+  map.RemoveIf([&visited](AckIdMap<int>::Key key, int& value) {
+    visited.push_back(key.ToString());
+    value += 100;
+    return value % 3 != 0;
+  });
+  EXPECT_EQ(10U, visited.size());
+  std::vector<std::string> remaining;
+  map.RemoveIf([&remaining](AckIdMap<int>::Key key, int&) {
+    remaining.push_back(key.ToString());
+    return false;
+  });
+  EXPECT_THAT(remaining, UnorderedElementsAre("a2", "a5", "a8"));
+  ASSERT_NE(nullptr, map.Find("a5"));
+  EXPECT_EQ(105, *map.Find("a5"));
+}
+
+TEST(AckIdMapTest, Handles) {
+  AckIdMap<int> map;
+  std::string const padding(200, 'x');
+  std::vector<AckIdMap<int>::Handle> handles;
+  for (int i = 0; i != 10000; ++i) {
+    handles.push_back(
+        map.Add(padding + std::to_string(i), "p-" + std::to_string(i), i));
+  }
+  // Removing entries moves the other entries, and compacts the arena.
+  map.RemoveIf([](AckIdMap<int>::Key, int& value) { return value % 100 != 0; });
+  ASSERT_EQ(100U, map.size());
+  for (int i = 0; i != 10000; ++i) {
+    auto const h = handles[i];
+    if (i % 100 != 0) {
+      EXPECT_EQ(nullptr, map.Find(h));
+      continue;
+    }
+    ASSERT_NE(nullptr, map.Find(h));
+    EXPECT_EQ(i, *map.Find(h));
+    EXPECT_EQ(padding + std::to_string(i), map.KeyOf(h).ToString());
+    EXPECT_EQ("p-" + std::to_string(i), map.PayloadOf(h).ToString());
+  }
+
+  int value = -1;
+  EXPECT_TRUE(map.Remove(handles[0], value));
+  EXPECT_EQ(0, value);
+  EXPECT_FALSE(map.Remove(handles[0], value));
+  // Adding the same ack id again creates a new handle, the old one is stale.
+  auto const h = map.Add(padding + "0", "", 42);
+  EXPECT_EQ(nullptr, map.Find(handles[0]));
+  ASSERT_NE(nullptr, map.Find(padding + "0"));
+  EXPECT_EQ(42, *map.Find(h));
+  EXPECT_EQ("", map.PayloadOf(h).ToString());
+  auto const replaced = map.Add(padding + "0", "", 7);
+  EXPECT_EQ(nullptr, map.Find(h));
+  EXPECT_EQ(7, *map.Find(replaced));
+  EXPECT_EQ(100U, map.size());
+}
+
+TEST(AckIdMapTest, MatchesUnorderedMap) {
+  // Random operations, with short ids so some have the same prefix, and
+  // enough entries to grow the table and compact the arena several times.
+  std::mt19937_64 generator(42);
+  std::uniform_int_distribution<int> id(0, 20000);
+  std::uniform_int_distribution<int> op(0, 2);
+  AckIdMap<int> map;
+  std::unordered_map<std::string, int> expected;
+  for (int i = 0; i != 200000; ++i) {
+    auto const key = "ack-" + std::to_string(id(generator));
+    switch (op(generator)) {
+      case 0:
+        EXPECT_EQ(expected.count(key) == 0, map.Insert(key, i));
+        expected[key] = i;
+        break;
+      case 1: {
+        int value = -1;
+        auto const found = map.Remove(key, value);
+        auto e = expected.find(key);
+        ASSERT_EQ(e != expected.end(), found);
+        if (found) {
+          EXPECT_EQ(e->second, value);
+          expected.erase(e);
+        }
+        break;
+      }
+      default: {
+        auto* value = map.Find(key);
+        auto e = expected.find(key);
+        ASSERT_EQ(e != expected.end(), value != nullptr);
+        if (value != nullptr) {
+          EXPECT_EQ(e->second, *value);
+        }
+        break;
+      }
+    }
+    ASSERT_EQ(expected.size(), map.size());
+  }
+  for (auto const& kv : expected) {
+    auto* value = map.Find(kv.first);
+    ASSERT_NE(nullptr, value);
+    EXPECT_EQ(kv.second, *value);
+  }
+}
+
+TEST(AckIdMapTest, ReleasesMemory) {
+  AckIdMap<int> map;
+  auto const empty = map.memory_usage();
+  std::string const padding(200, 'x');
+  for (int i = 0; i != 100000; ++i) {
+    map.Insert(padding + std::to_string(i), i);
+  }
+  auto const full = map.memory_usage();
+  EXPECT_LT(100000U * 200, full);
+
+  map.RemoveIf([](AckIdMap<int>::Key, int& value) { return value >= 10; });
+  EXPECT_EQ(10U, map.size());
+  EXPECT_GT(full / 100, map.memory_usage() - empty);
+  for (int i = 0; i != 10; ++i) {
+    auto* value = map.Find(padding + std::to_string(i));
+    ASSERT_NE(nullptr, value);
+    EXPECT_EQ(i, *value);
+  }
+}
+
+TEST(AckIdArenaTest, Compaction) {
+  AckIdArena arena;
+  std::string const id(100, 'x');
+  for (int i = 0; i != 1000; ++i) {
+    EXPECT_EQ(id, std::string(arena.Store(id.data(), id.size()), id.size()));
+  }
+  EXPECT_EQ(100000U, arena.live_bytes());
+  EXPECT_LE(100000U, arena.allocated_bytes());
+  EXPECT_FALSE(arena.NeedsCompaction());
+  for (int i = 0; i != 900; ++i) arena.Release(id.size());
+  EXPECT_TRUE(arena.NeedsCompaction());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,61 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/ack_latency_histogram.h"
+#include <algorithm>
+#include <cmath>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+int constexpr AckLatencyHistogram::kMaximumSeconds;
+
+AckLatencyHistogram::AckLatencyHistogram(std::size_t window_size)
+    : buckets_(kMaximumSeconds + 1),
+      window_(window_size == 0 ? 1 : window_size) {}
+
+void AckLatencyHistogram::Record(std::chrono::milliseconds latency) {
+  using Rep = std::chrono::milliseconds::rep;
+  auto const ms = (std::max)(latency.count(), Rep{0});
+  auto const seconds =
+      (std::min)(static_cast<Rep>(kMaximumSeconds), (ms + 999) / 1000);
+  if (size_ == window_.size()) {
+    --buckets_[window_[next_]];
+  } else {
+    ++size_;
+  }
+  window_[next_] = static_cast<std::uint16_t>(seconds);
+  ++buckets_[window_[next_]];
+  next_ = (next_ + 1) % window_.size();
+}
+
+std::chrono::seconds AckLatencyHistogram::Percentile(double percentile) const {
+  if (size_ == 0) return std::chrono::seconds(0);
+  auto const p = (std::max)(0.0, (std::min)(1.0, percentile));
+  auto const target = (std::max)(
+      std::size_t{1}, static_cast<std::size_t>(std::ceil(p * size_)));
+  std::size_t count = 0;
+  for (std::size_t i = 0; i != buckets_.size(); ++i) {
+    count += buckets_[i];
+    if (count >= target) return std::chrono::seconds(i);
+  }
+  return std::chrono::seconds(kMaximumSeconds);
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
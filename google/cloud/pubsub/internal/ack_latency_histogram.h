@@ -0,0 +1,72 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_ACK_LATENCY_HISTOGRAM_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_ACK_LATENCY_HISTOGRAM_H
+
+#include "google/cloud/pubsub/version.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * A rolling histogram of the time to acknowledge messages.
+ *
+ * The service accepts ack deadlines with a granularity of one second, so the
+ * histogram uses one bucket per second, up to `kMaximumSeconds`. Only the most
+ * recent `window_size` samples are kept, older samples are evicted as new ones
+ * arrive, so the percentiles track changes in the application behavior.
+ *
+ * This class is not thread-safe, the caller must provide synchronization.
+ */
+class AckLatencyHistogram {
+ public:
+  /// The largest value recorded, the maximum ack deadline in the service.
+  static int constexpr kMaximumSeconds = 600;
+
+  explicit AckLatencyHistogram(std::size_t window_size);
+
+  /// Record a sample, rounded up to the next second.
+  void Record(std::chrono::milliseconds latency);
+
+  /**
+   * Return the smallest value (in seconds) that is larger than or equal to the
+   * @p percentile fraction of the samples.
+   *
+   * Returns 0 if there are no samples.
+   */
+  std::chrono::seconds Percentile(double percentile) const;
+
+  /// The number of samples in the window.
+  std::size_t size() const { return size_; }
+
+ private:
+  std::vector<std::uint32_t> buckets_;
+  std::vector<std::uint16_t> window_;
+  std::size_t next_ = 0;
+  std::size_t size_ = 0;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_ACK_LATENCY_HISTOGRAM_H
@@ -0,0 +1,75 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/ack_latency_histogram.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+TEST(AckLatencyHistogramTest, Empty) {
+  AckLatencyHistogram histogram(100);
+  EXPECT_EQ(0U, histogram.size());
+  EXPECT_EQ(seconds(0), histogram.Percentile(0.99));
+}
+
+TEST(AckLatencyHistogramTest, RoundsUp) {
+  AckLatencyHistogram histogram(100);
+  histogram.Record(milliseconds(5));
+  EXPECT_EQ(seconds(1), histogram.Percentile(0.99));
+  histogram.Record(milliseconds(3001));
+  EXPECT_EQ(seconds(4), histogram.Percentile(0.99));
+  EXPECT_EQ(seconds(1), histogram.Percentile(0.5));
+}
+
+TEST(AckLatencyHistogramTest, Percentiles) {
+  AckLatencyHistogram histogram(1000);
+  for (int i = 1; i <= 100; ++i) histogram.Record(seconds(i));
+  EXPECT_EQ(100U, histogram.size());
+  EXPECT_EQ(seconds(1), histogram.Percentile(0.0));
+  EXPECT_EQ(seconds(50), histogram.Percentile(0.5));
+  EXPECT_EQ(seconds(99), histogram.Percentile(0.99));
+  EXPECT_EQ(seconds(100), histogram.Percentile(1.0));
+}
+
+TEST(AckLatencyHistogramTest, Clamped) {
+  AckLatencyHistogram histogram(10);
+  histogram.Record(std::chrono::hours(1));
+  EXPECT_EQ(seconds(AckLatencyHistogram::kMaximumSeconds),
+            histogram.Percentile(0.99));
+  histogram.Record(milliseconds(-5));
+  EXPECT_EQ(seconds(0), histogram.Percentile(0.5));
+}
+
+TEST(AckLatencyHistogramTest, RollingWindow) {
+  AckLatencyHistogram histogram(10);
+  for (int i = 0; i != 10; ++i) histogram.Record(seconds(300));
+  EXPECT_EQ(seconds(300), histogram.Percentile(0.99));
+  // The new samples evict the old ones.
+  for (int i = 0; i != 10; ++i) histogram.Record(seconds(2));
+  EXPECT_EQ(10U, histogram.size());
+  EXPECT_EQ(seconds(2), histogram.Percentile(0.99));
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
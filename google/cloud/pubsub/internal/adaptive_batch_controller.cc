@@ -0,0 +1,100 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/adaptive_batch_controller.h"
+#include <algorithm>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+namespace {
+// The baseline latency grows by this fraction on each sample, so a permanent
+// change in the latency is eventually accepted as the new baseline.
+auto constexpr kBaselineDecay = 0.01;
+// The weight of each new sample in the moving average of the throughput.
+auto constexpr kThroughputWeight = 0.1;
+}  // namespace
+
+double constexpr AdaptiveBatchController::kLatencyTolerance;
+int constexpr AdaptiveBatchController::kSteps;
+double constexpr AdaptiveBatchController::kThroughputTolerance;
+
+AdaptiveBatchController::AdaptiveBatchController(
+    pubsub::PublisherOptions const& options)
+    : minimum_bytes_((std::min)(options.minimum_batch_bytes(),
+                                options.maximum_batch_bytes())),
+      maximum_bytes_(options.maximum_batch_bytes()),
+      bytes_step_((std::max)(std::size_t{1},
+                             (maximum_bytes_ - minimum_bytes_) / kSteps)),
+      minimum_hold_time_((std::min)(options.minimum_hold_time(),
+                                    options.maximum_hold_time())
+                             .count()),
+      maximum_hold_time_(options.maximum_hold_time().count()),
+      hold_time_step_((std::max)(std::chrono::microseconds::rep{1},
+                                 (maximum_hold_time_ - minimum_hold_time_) /
+                                     kSteps)),
+      batch_bytes_(minimum_bytes_),
+      hold_time_(minimum_hold_time_) {}
+
+double AdaptiveBatchController::throughput() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return throughput_;
+}
+
+void AdaptiveBatchController::OnCompletion(std::size_t bytes,
+                                           std::chrono::microseconds latency,
+                                           bool success) {
+  auto const sample = static_cast<double>((std::max)(
+      latency, std::chrono::microseconds(1)).count());
+  std::lock_guard<std::mutex> lk(mu_);
+  auto const rate = static_cast<double>(bytes) * 1.0E6 / sample;
+  auto const keeps_up = rate >= kThroughputTolerance * throughput_;
+  throughput_ = throughput_ == 0
+                    ? rate
+                    : (1 - kThroughputWeight) * throughput_ +
+                          kThroughputWeight * rate;
+  if (!success) {
+    Decrease();
+    return;
+  }
+  baseline_latency_ = baseline_latency_ == 0
+                          ? sample
+                          : (std::min)(baseline_latency_ * (1 + kBaselineDecay),
+                                       sample);
+  if (sample <= kLatencyTolerance * baseline_latency_) {
+    Increase(keeps_up);
+  } else {
+    Decrease();
+  }
+}
+
+void AdaptiveBatchController::Increase(bool increase_hold_time) {
+  batch_bytes_.store(
+      (std::min)(maximum_bytes_, batch_bytes_.load() + bytes_step_));
+  if (!increase_hold_time) return;
+  hold_time_.store(
+      (std::min)(maximum_hold_time_, hold_time_.load() + hold_time_step_));
+}
+
+void AdaptiveBatchController::Decrease() {
+  batch_bytes_.store((std::max)(minimum_bytes_, batch_bytes_.load() / 2));
+  hold_time_.store((std::max)(minimum_hold_time_, hold_time_.load() / 2));
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,98 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_ADAPTIVE_BATCH_CONTROLLER_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_ADAPTIVE_BATCH_CONTROLLER_H
+
+#include "google/cloud/pubsub/publisher_options.h"
+#include "google/cloud/pubsub/version.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Adjust the batch size and hold time using additive-increase,
+ * multiplicative-decrease (AIMD).
+ *
+ * The controller keeps a baseline latency: the lowest latency observed, which
+ * slowly increases to adapt to changes in the network or the service. An RPC
+ * that succeeds with a latency within `kLatencyTolerance` of the baseline
+ * increases the batch size by a fixed step. Any slower, or failed, RPC halves
+ * the batch size and the hold time. The values stay within the bounds
+ * configured in `pubsub::PublisherOptions`, starting from the minimums.
+ *
+ * The controller also keeps a moving average of the throughput, in bytes per
+ * second. Holding messages longer only pays off if the larger batches move
+ * more bytes per second, so a fast RPC increases the hold time only if its
+ * throughput is within `kThroughputTolerance` of the average, or above it.
+ *
+ * This class is thread-safe, the current values can be read without locking.
+ */
+class AdaptiveBatchController {
+ public:
+  /// The RPCs are "fast" if their latency is below this multiple of baseline.
+  static double constexpr kLatencyTolerance = 2.0;
+  /// The number of steps between the minimum and maximum values.
+  static int constexpr kSteps = 32;
+  /// The hold time grows while the throughput stays above this fraction.
+  static double constexpr kThroughputTolerance = 0.9;
+
+  explicit AdaptiveBatchController(pubsub::PublisherOptions const& options);
+
+  /// The current limit for the batch size.
+  std::size_t batch_bytes() const { return batch_bytes_.load(); }
+
+  /// The current hold time.
+  std::chrono::microseconds hold_time() const {
+    return std::chrono::microseconds(hold_time_.load());
+  }
+
+  /// The moving average of the throughput, in bytes per second.
+  double throughput() const;
+
+  /// Update the values after a RPC for @p bytes completes.
+  void OnCompletion(std::size_t bytes, std::chrono::microseconds latency,
+                    bool success);
+
+ private:
+  void Increase(bool increase_hold_time);
+  void Decrease();
+
+  std::size_t const minimum_bytes_;
+  std::size_t const maximum_bytes_;
+  std::size_t const bytes_step_;
+  std::chrono::microseconds::rep const minimum_hold_time_;
+  std::chrono::microseconds::rep const maximum_hold_time_;
+  std::chrono::microseconds::rep const hold_time_step_;
+
+  std::atomic<std::size_t> batch_bytes_;
+  std::atomic<std::chrono::microseconds::rep> hold_time_;
+
+  mutable std::mutex mu_;
+  double baseline_latency_ = 0;
+  double throughput_ = 0;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_ADAPTIVE_BATCH_CONTROLLER_H
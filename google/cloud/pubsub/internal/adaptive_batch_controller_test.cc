@@ -0,0 +1,137 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/adaptive_batch_controller.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+pubsub::PublisherOptions TestOptions() {
+  return pubsub::PublisherOptions{}
+      .enable_adaptive_batching()
+      .set_minimum_batch_bytes(1000)
+      .set_maximum_batch_bytes(1000 + 32 * 100)
+      .set_minimum_hold_time(microseconds(100))
+      .set_maximum_hold_time(microseconds(100 + 32 * 10));
+}
+
+TEST(AdaptiveBatchControllerTest, StartsAtMinimum) {
+  AdaptiveBatchController controller(TestOptions());
+  EXPECT_EQ(1000U, controller.batch_bytes());
+  EXPECT_EQ(microseconds(100), controller.hold_time());
+}
+
+TEST(AdaptiveBatchControllerTest, FastRpcsIncrease) {
+  AdaptiveBatchController controller(TestOptions());
+  controller.OnCompletion(1000, milliseconds(10), true);
+  EXPECT_EQ(1100U, controller.batch_bytes());
+  EXPECT_EQ(microseconds(110), controller.hold_time());
+  for (int i = 0; i != 2 * AdaptiveBatchController::kSteps; ++i) {
+    controller.OnCompletion(1000, milliseconds(10), true);
+  }
+  EXPECT_EQ(1000U + 32 * 100, controller.batch_bytes());
+  EXPECT_EQ(microseconds(100 + 32 * 10), controller.hold_time());
+}
+
+TEST(AdaptiveBatchControllerTest, HoldTimeFollowsThroughput) {
+  AdaptiveBatchController controller(TestOptions());
+  controller.OnCompletion(4000, milliseconds(10), true);
+  EXPECT_EQ(1100U, controller.batch_bytes());
+  EXPECT_EQ(microseconds(110), controller.hold_time());
+  // The RPC is fast, but moves fewer bytes per second than the average: the
+  // batch can grow, but holding the messages longer does not help.
+  controller.OnCompletion(1000, milliseconds(10), true);
+  EXPECT_EQ(1200U, controller.batch_bytes());
+  EXPECT_EQ(microseconds(110), controller.hold_time());
+  controller.OnCompletion(8000, milliseconds(10), true);
+  EXPECT_EQ(1300U, controller.batch_bytes());
+  EXPECT_EQ(microseconds(120), controller.hold_time());
+}
+
+TEST(AdaptiveBatchControllerTest, SlowRpcsDecrease) {
+  AdaptiveBatchController controller(TestOptions());
+  for (int i = 0; i != AdaptiveBatchController::kSteps; ++i) {
+    controller.OnCompletion(1000, milliseconds(10), true);
+  }
+  EXPECT_EQ(4200U, controller.batch_bytes());
+  controller.OnCompletion(1000, milliseconds(30), true);
+  EXPECT_EQ(2100U, controller.batch_bytes());
+  EXPECT_EQ(microseconds(210), controller.hold_time());
+  controller.OnCompletion(1000, milliseconds(30), true);
+  EXPECT_EQ(1050U, controller.batch_bytes());
+  controller.OnCompletion(1000, milliseconds(30), true);
+  EXPECT_EQ(1000U, controller.batch_bytes());
+  EXPECT_EQ(microseconds(100), controller.hold_time());
+}
+
+TEST(AdaptiveBatchControllerTest, ErrorsDecrease) {
+  AdaptiveBatchController controller(TestOptions());
+  for (int i = 0; i != 10; ++i) {
+    controller.OnCompletion(1000, milliseconds(10), true);
+  }
+  EXPECT_EQ(2000U, controller.batch_bytes());
+  controller.OnCompletion(1000, milliseconds(1), false);
+  EXPECT_EQ(1000U, controller.batch_bytes());
+}
+
+TEST(AdaptiveBatchControllerTest, BaselineAdapts) {
+  AdaptiveBatchController controller(TestOptions());
+  controller.OnCompletion(1000, milliseconds(10), true);
+  // The latency increases permanently, eventually the controller accepts the
+  // new latency as normal and the batches grow again.
+  auto last = controller.batch_bytes();
+  bool grew = false;
+  for (int i = 0; i != 200 && !grew; ++i) {
+    controller.OnCompletion(1000, milliseconds(40), true);
+    grew = controller.batch_bytes() > last;
+    last = controller.batch_bytes();
+  }
+  EXPECT_TRUE(grew);
+}
+
+TEST(AdaptiveBatchControllerTest, MinimumAboveMaximum) {
+  auto const options = pubsub::PublisherOptions{}
+                           .set_minimum_batch_bytes(5000)
+                           .set_maximum_batch_bytes(1000)
+                           .set_minimum_hold_time(milliseconds(5))
+                           .set_maximum_hold_time(milliseconds(1));
+  AdaptiveBatchController controller(options);
+  EXPECT_EQ(1000U, controller.batch_bytes());
+  EXPECT_EQ(milliseconds(1), controller.hold_time());
+  controller.OnCompletion(1000, milliseconds(10), true);
+  EXPECT_EQ(1000U, controller.batch_bytes());
+  EXPECT_EQ(milliseconds(1), controller.hold_time());
+}
+
+TEST(AdaptiveBatchControllerTest, Throughput) {
+  AdaptiveBatchController controller(TestOptions());
+  EXPECT_EQ(0, controller.throughput());
+  controller.OnCompletion(1000, milliseconds(10), true);
+  EXPECT_DOUBLE_EQ(100000.0, controller.throughput());
+  controller.OnCompletion(2000, milliseconds(10), true);
+  EXPECT_DOUBLE_EQ(110000.0, controller.throughput());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,81 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/arena_pool.h"
+#include "google/cloud/internal/make_unique.h"
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+namespace {
+google::protobuf::ArenaOptions MakeArenaOptions(char* block,
+                                                std::size_t size) {
+  google::protobuf::ArenaOptions options;
+  options.initial_block = block;
+  options.initial_block_size = size;
+  // Any additional blocks are released on each Reset(), make them large
+  // enough that a big request needs only a few.
+  options.start_block_size = size;
+  return options;
+}
+}  // namespace
+
+ArenaPool::PooledArena::PooledArena(std::size_t initial_block_size)
+    : initial_block(new char[initial_block_size]),
+      arena(MakeArenaOptions(initial_block.get(), initial_block_size)) {}
+
+ArenaPool::Lease ArenaPool::Acquire() {
+  std::unique_ptr<PooledArena> arena;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (!idle_.empty()) {
+      arena = std::move(idle_.back());
+      idle_.pop_back();
+    }
+  }
+  if (!arena) {
+    arena = google::cloud::internal::make_unique<PooledArena>(
+        initial_block_size_);
+  }
+  return Lease(
+      std::unique_ptr<PooledArena, Releaser>(arena.release(), Releaser(this)));
+}
+
+void ArenaPool::Release(PooledArena* arena) {
+  std::unique_ptr<PooledArena> owned(arena);
+  // Run the message destructors outside the lock.
+  owned->arena.Reset();
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (idle_.size() < maximum_pooled_) {
+      idle_.push_back(std::move(owned));
+      return;
+    }
+  }
+  // The pool is full, `owned` is deleted outside the lock.
+}
+
+ArenaPool& DefaultArenaPool() {
+  auto constexpr kMaximumPooled = 64;
+  auto constexpr kInitialBlockSize = 64 * 1024;
+  static auto* const kPool = new ArenaPool(kMaximumPooled, kInitialBlockSize);
+  return *kPool;
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
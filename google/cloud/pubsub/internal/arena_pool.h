@@ -0,0 +1,122 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_ARENA_POOL_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_ARENA_POOL_H
+
+#include "google/cloud/pubsub/version.h"
+#include <google/protobuf/arena.h>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * A pool of reusable `google::protobuf::Arena` objects.
+ *
+ * Each arena owns an initial block of @p initial_block_size bytes. Returning
+ * an arena to the pool resets it, which releases all its messages and any
+ * blocks allocated after the initial one, but keeps the initial block. Thus
+ * the next user of the arena can create messages without calling the
+ * allocator, as long as they fit in the initial block.
+ *
+ * At most @p maximum_pooled arenas are kept, any additional arenas are
+ * deleted when they are returned to the pool.
+ *
+ * The pool must outlive any `Lease` obtained from it.
+ */
+class ArenaPool {
+ private:
+  struct PooledArena;
+
+ public:
+  ArenaPool(std::size_t maximum_pooled, std::size_t initial_block_size)
+      : maximum_pooled_(maximum_pooled),
+        initial_block_size_(initial_block_size) {}
+
+  /// Return the arena to its pool.
+  class Releaser {
+   public:
+    explicit Releaser(ArenaPool* pool = nullptr) : pool_(pool) {}
+    void operator()(PooledArena* arena) const { pool_->Release(arena); }
+
+   private:
+    ArenaPool* pool_;
+  };
+
+  /// Exclusive use of an arena, returned to the pool on destruction.
+  class Lease {
+   public:
+    Lease() = default;
+
+    google::protobuf::Arena* get() const { return &impl_->arena; }
+    google::protobuf::Arena* operator->() const { return get(); }
+
+   private:
+    friend class ArenaPool;
+    explicit Lease(std::unique_ptr<PooledArena, Releaser> impl)
+        : impl_(std::move(impl)) {}
+
+    std::unique_ptr<PooledArena, Releaser> impl_;
+  };
+
+  /// Get an arena from the pool, creating a new one if the pool is empty.
+  Lease Acquire();
+
+  /// The number of idle arenas in the pool.
+  std::size_t pooled() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return idle_.size();
+  }
+
+ private:
+  struct PooledArena {
+    explicit PooledArena(std::size_t initial_block_size);
+
+    std::unique_ptr<char[]> initial_block;
+    google::protobuf::Arena arena;
+  };
+
+  void Release(PooledArena* arena);
+
+  std::size_t const maximum_pooled_;
+  std::size_t const initial_block_size_;
+  mutable std::mutex mu_;
+  std::vector<std::unique_ptr<PooledArena>> idle_;
+};
+
+/**
+ * The pool used for the requests and responses in the data path.
+ *
+ * The publisher builds its `PublishRequest`s in these arenas, and the
+ * subscriber parses each `StreamingPullResponse` into one. The responses for
+ * unary `Pull()` calls are allocated by the generated gRPC stubs, which do not
+ * accept an arena.
+ *
+ * The pool is never deleted, requests may be sent from background threads
+ * that are still running during the program termination.
+ */
+ArenaPool& DefaultArenaPool();
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_ARENA_POOL_H
@@ -0,0 +1,73 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/arena_pool.h"
+#include <google/pubsub/v1/pubsub.pb.h>
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+TEST(ArenaPoolTest, ReusesArenas) {
+  ArenaPool pool(2, 1024);
+  EXPECT_EQ(0, pool.pooled());
+  google::protobuf::Arena* first;
+  {
+    auto lease = pool.Acquire();
+    first = lease.get();
+    auto* request = google::protobuf::Arena::CreateMessage<
+        google::pubsub::v1::PublishRequest>(lease.get());
+    request->add_messages()->set_data("test-data");
+    EXPECT_EQ(lease.get(), request->GetArena());
+    EXPECT_LT(0, lease->SpaceUsed());
+  }
+  EXPECT_EQ(1, pool.pooled());
+
+  auto lease = pool.Acquire();
+  EXPECT_EQ(first, lease.get());
+  EXPECT_EQ(0, lease->SpaceUsed());
+  EXPECT_EQ(0, pool.pooled());
+}
+
+TEST(ArenaPoolTest, MaximumPooled) {
+  ArenaPool pool(2, 1024);
+  {
+    auto a0 = pool.Acquire();
+    auto a1 = pool.Acquire();
+    auto a2 = pool.Acquire();
+    EXPECT_NE(a0.get(), a1.get());
+    EXPECT_NE(a1.get(), a2.get());
+  }
+  EXPECT_EQ(2, pool.pooled());
+}
+
+TEST(ArenaPoolTest, LeaseIsMovable) {
+  ArenaPool pool(2, 1024);
+  {
+    auto a0 = pool.Acquire();
+    auto* arena = a0.get();
+    auto a1 = std::move(a0);
+    EXPECT_EQ(arena, a1.get());
+  }
+  EXPECT_EQ(1, pool.pooled());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,49 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/background_threads.h"
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+BackgroundThreads::BackgroundThreads(std::size_t thread_count) {
+  if (thread_count == 0) thread_count = 1;
+  pool_.reserve(thread_count);
+  for (std::size_t i = 0; i != thread_count; ++i) {
+    // Capture a copy of the completion queue, the thread may outlive this
+    // object, see the destructor.
+    auto cq = cq_;
+    pool_.emplace_back([cq]() mutable { cq.Run(); });
+  }
+}
+
+BackgroundThreads::~BackgroundThreads() {
+  cq_.Shutdown();
+  for (auto& t : pool_) {
+    // The last reference to the owner of this object may be released by a
+    // continuation running in the pool, a thread cannot join itself.
+    if (t.get_id() == std::this_thread::get_id()) {
+      t.detach();
+      continue;
+    }
+    t.join();
+  }
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,62 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_BACKGROUND_THREADS_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_BACKGROUND_THREADS_H
+
+#include "google/cloud/pubsub/version.h"
+#include "google/cloud/grpc_utils/completion_queue.h"
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Run the event loop for a `CompletionQueue` in a pool of background threads.
+ *
+ * All the asynchronous operations started on `cq()` (RPCs and timers) complete
+ * in one of these threads, and that is where any continuations attached to
+ * their futures run.
+ */
+class BackgroundThreads {
+ public:
+  explicit BackgroundThreads(std::size_t thread_count);
+
+  /// Shutdown the completion queue and wait for the threads to finish.
+  ~BackgroundThreads();
+
+  BackgroundThreads(BackgroundThreads const&) = delete;
+  BackgroundThreads& operator=(BackgroundThreads const&) = delete;
+
+  /// The completion queue served by the background threads.
+  google::cloud::grpc_utils::CompletionQueue cq() const { return cq_; }
+
+  /// The number of threads in the pool.
+  std::size_t size() const { return pool_.size(); }
+
+ private:
+  google::cloud::grpc_utils::CompletionQueue cq_;
+  std::vector<std::thread> pool_;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_BACKGROUND_THREADS_H
@@ -0,0 +1,53 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/background_threads.h"
+#include "google/cloud/future.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+TEST(BackgroundThreadsTest, RunsInPool) {
+  BackgroundThreads background(2);
+  EXPECT_EQ(2U, background.size());
+
+  promise<std::thread::id> p;
+  background.cq().RunAsync(
+      [&p](google::cloud::grpc_utils::CompletionQueue&) {
+        p.set_value(std::this_thread::get_id());
+      });
+  EXPECT_NE(std::this_thread::get_id(), p.get_future().get());
+}
+
+TEST(BackgroundThreadsTest, TimersExpire) {
+  BackgroundThreads background(1);
+  auto expired =
+      background.cq().MakeRelativeTimer(std::chrono::milliseconds(5)).get();
+  EXPECT_TRUE(expired.ok());
+}
+
+TEST(BackgroundThreadsTest, AtLeastOneThread) {
+  BackgroundThreads background(0);
+  EXPECT_EQ(1U, background.size());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
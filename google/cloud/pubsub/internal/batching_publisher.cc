@@ -0,0 +1,380 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/batching_publisher.h"
+#include "google/cloud/internal/make_unique.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+std::size_t constexpr BatchingPublisher::kMinimumSequencerSweepSize;
+
+namespace {
+/// Assign a small, stable, integer to each thread, used to select a shard.
+std::size_t ThreadIndex() {
+  static std::atomic<std::size_t> next_index{0};
+  static thread_local std::size_t const index = next_index.fetch_add(1);
+  return index;
+}
+}  // namespace
+
+BatchingPublisher::BatchingPublisher(
+    google::cloud::grpc_utils::CompletionQueue cq,
+    std::shared_ptr<PublisherStub> stub, pubsub::PublisherOptions options)
+    : cq_(std::move(cq)),
+      stub_(std::move(stub)),
+      options_(std::move(options)),
+      encoder_(options_.direct_encoding()
+                   ? std::make_shared<PublishRequestEncoder>()
+                   : nullptr),
+      batch_controller_(
+          options_.adaptive_batching()
+              ? std::make_shared<AdaptiveBatchController>(options_)
+              : nullptr),
+      flow_control_(std::make_shared<PublisherFlowControl>(
+          options_.maximum_pending_messages(),
+          options_.maximum_pending_bytes())) {
+  // hardware_concurrency() may return 0 if the value is not computable.
+  auto const shard_count = (std::max)(1U, std::thread::hardware_concurrency());
+  shards_.reserve(shard_count);
+  for (unsigned i = 0; i != shard_count; ++i) {
+    shards_.push_back(google::cloud::internal::make_unique<Shard>());
+  }
+}
+
+BatchingPublisher::~BatchingPublisher() {
+  // No timer can call OnTimer() once the destructor starts (their weak_ptr is
+  // expired), send any pending messages now.
+  for (auto& s : shards_) Drain(*s, /*start_timers=*/false);
+  std::vector<Batch> batches;
+  for (auto& kv : pending_) batches.push_back(std::move(kv.second));
+  pending_.clear();
+  open_.clear();
+  Send(std::move(batches));
+}
+
+future<StatusOr<std::string>> BatchingPublisher::Publish(
+    std::string const& topic, pubsub::Message message) {
+  if (!message.ordering_key().empty() && !options_.message_ordering()) {
+    return make_ready_future(StatusOr<std::string>(
+        Status(StatusCode::kInvalidArgument,
+               "messages with an ordering key require message ordering, see "
+               "PublisherOptions::enable_message_ordering()")));
+  }
+  auto const bytes = MessageProtoSize(message);
+  if (!AcquireFlowControl(bytes)) {
+    return make_ready_future(StatusOr<std::string>(
+        Status(StatusCode::kResourceExhausted,
+               "too many pending messages in the publisher")));
+  }
+  promise<StatusOr<std::string>> p;
+  auto f = p.get_future();
+  PendingMessage pending{topic, std::move(message), bytes, std::move(p)};
+  if (!pending.message.ordering_key().empty()) {
+    // The shard may be drained by another thread, which could add this
+    // message after a later message with the same key, published from a
+    // different shard. Ordered messages are in their batch before this
+    // function returns.
+    std::vector<PendingMessage> messages;
+    messages.push_back(std::move(pending));
+    AddToBatches(std::move(messages), /*start_timers=*/true);
+    return f;
+  }
+  auto& shard = *shards_[ThreadIndex() % shards_.size()];
+  shard.queue.Push(std::move(pending));
+  Drain(shard, /*start_timers=*/true);
+  return f;
+}
+
+void BatchingPublisher::Drain(Shard& shard, bool start_timers) {
+  // Only one thread drains each shard, this preserves the order of the
+  // messages. The other producers return immediately, the draining thread
+  // picks up their messages before it stops.
+  for (;;) {
+    if (shard.draining.exchange(true)) return;
+    auto messages = shard.queue.PopAll();
+    if (!messages.empty()) AddToBatches(std::move(messages), start_timers);
+    shard.draining.store(false);
+    // A producer may have pushed a message after PopAll(), but before the
+    // flag was reset. That producer did not drain the queue, so we must.
+    if (shard.queue.empty()) return;
+  }
+}
+
+void BatchingPublisher::AddToBatches(std::vector<PendingMessage> messages,
+                                     bool start_timers) {
+  std::vector<Batch> ready;
+  std::vector<PendingMessage> rejected;
+  std::vector<Status> rejected_status;
+  std::vector<std::pair<BatchKey, std::uint64_t>> started;
+
+  std::unique_lock<std::mutex> lk(mu_);
+  for (auto& m : messages) {
+    BatchKey key(m.topic, m.message.ordering_key());
+    std::shared_ptr<OrderingKeySequencer> sequencer;
+    if (!key.second.empty()) {
+      sequencer = Sequencer(key);
+      auto paused = sequencer->PausedStatus();
+      if (!paused.ok()) {
+        rejected.push_back(std::move(m));
+        rejected_status.push_back(std::move(paused));
+        continue;
+      }
+    }
+    auto loc = pending_.find(key);
+    // Send the current batch first if this message would overflow it.
+    if (loc != pending_.end() &&
+        loc->second.bytes + m.bytes > MaximumBatchBytes()) {
+      open_.erase(loc->second.id);
+      ready.push_back(std::move(loc->second));
+      pending_.erase(loc);
+      loc = pending_.end();
+    }
+    if (loc == pending_.end()) {
+      loc = pending_.emplace(key, Batch{}).first;
+      loc->second.id = ++next_batch_id_;
+      if (!sequencer) open_.emplace(loc->second.id, key);
+      loc->second.contents.topic = m.topic;
+      loc->second.sequencer = std::move(sequencer);
+      started.emplace_back(key, loc->second.id);
+    }
+    auto& batch = loc->second;
+    batch.contents.messages.push_back(std::move(m.message));
+    batch.bytes += m.bytes;
+    batch.contents.waiters.push_back(std::move(m.waiter));
+    if (IsFull(batch)) {
+      open_.erase(batch.id);
+      ready.push_back(std::move(batch));
+      pending_.erase(loc);
+    }
+  }
+  lk.unlock();
+
+  for (std::size_t i = 0; i != rejected.size(); ++i) {
+    flow_control_->Release(1, rejected[i].bytes);
+    rejected[i].waiter.set_value(std::move(rejected_status[i]));
+  }
+  Send(std::move(ready));
+  if (start_timers) StartTimers(std::move(started));
+}
+
+std::shared_ptr<OrderingKeySequencer> const& BatchingPublisher::Sequencer(
+    BatchKey const& key) {
+  auto loc = sequencers_.find(key);
+  if (loc != sequencers_.end()) return loc->second;
+  if (sequencers_.size() >= sequencer_sweep_size_) EraseIdleSequencers();
+  return sequencers_
+      .emplace(key, std::make_shared<OrderingKeySequencer>(cq_, stub_, encoder_,
+                                                           key.second))
+      .first->second;
+}
+
+void BatchingPublisher::EraseIdleSequencers() {
+  // New references to a sequencer are only created from `sequencers_`, with
+  // `mu_` held. If this is the only reference, no batch for the key is open,
+  // queued, or in flight (the RPC callbacks hold a reference). Paused
+  // sequencers are kept, `ResumePublish()` needs them.
+  for (auto i = sequencers_.begin(); i != sequencers_.end();) {
+    if (i->second.use_count() == 1 && i->second->PausedStatus().ok()) {
+      i = sequencers_.erase(i);
+      continue;
+    }
+    ++i;
+  }
+  // Sweep again once the number of keys doubles, this amortizes the cost of
+  // each sweep over the new keys.
+  sequencer_sweep_size_ =
+      (std::max)(kMinimumSequencerSweepSize, 2 * sequencers_.size());
+}
+
+void BatchingPublisher::StartTimers(
+    std::vector<std::pair<BatchKey, std::uint64_t>> batches) {
+  if (batches.empty()) return;
+  // Start the hold timers outside the lock, their continuations may run
+  // immediately (for example, if the completion queue is shutting down).
+  using TimerResult = StatusOr<std::chrono::system_clock::time_point>;
+  std::weak_ptr<BatchingPublisher> w = shared_from_this();
+  std::vector<future<void>> timers;
+  timers.reserve(batches.size());
+  for (auto const& b : batches) {
+    auto key = b.first;
+    auto id = b.second;
+    timers.push_back(cq_.MakeRelativeTimer(HoldTime())
+                         .then([w, key, id](future<TimerResult>) {
+                           if (auto self = w.lock()) self->OnTimer(key, id);
+                         }));
+  }
+  std::vector<future<void>> unused;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    for (std::size_t i = 0; i != batches.size(); ++i) {
+      auto loc = pending_.find(batches[i].first);
+      if (loc != pending_.end() && loc->second.id == batches[i].second) {
+        loc->second.timer = std::move(timers[i]);
+        continue;
+      }
+      unused.push_back(std::move(timers[i]));
+    }
+  }
+  // These batches were sent before their timer was stored, release the timer
+  // resources.
+  for (auto& t : unused) t.cancel();
+}
+
+void BatchingPublisher::Flush() {
+  // The batches created while draining are sent below, they do not need a
+  // timer.
+  for (auto& s : shards_) Drain(*s, /*start_timers=*/false);
+  std::vector<Batch> batches;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    for (auto& kv : pending_) batches.push_back(std::move(kv.second));
+    pending_.clear();
+    open_.clear();
+  }
+  Send(std::move(batches));
+}
+
+void BatchingPublisher::ResumePublish(std::string const& topic,
+                                      std::string const& ordering_key) {
+  std::lock_guard<std::mutex> lk(mu_);
+  auto loc = sequencers_.find(BatchKey(topic, ordering_key));
+  if (loc == sequencers_.end()) return;
+  loc->second->Resume();
+}
+
+pubsub::PublisherCapacity BatchingPublisher::Capacity() const {
+  return flow_control_->Capacity();
+}
+
+std::size_t BatchingPublisher::sequencer_count() {
+  std::lock_guard<std::mutex> lk(mu_);
+  return sequencers_.size();
+}
+
+bool BatchingPublisher::AcquireFlowControl(std::size_t bytes) {
+  if (flow_control_->TryAcquire(bytes)) return true;
+  switch (options_.flow_control_action()) {
+    case pubsub::PublisherFlowControlAction::kBlock:
+      // Blocking in the continuation of a `Publish()` future can deadlock:
+      // this thread may be the one needed to complete the pending batches.
+      if (InPublishBatchCompletion()) return false;
+      // Do not wait for the hold time of the pending batches, they may be
+      // holding the capacity this message needs.
+      Flush();
+      flow_control_->Acquire(bytes);
+      return true;
+    case pubsub::PublisherFlowControlAction::kDropOldest:
+      while (DropOldest()) {
+        if (flow_control_->TryAcquire(bytes)) return true;
+      }
+      return false;
+    case pubsub::PublisherFlowControlAction::kReject:
+      break;
+  }
+  return false;
+}
+
+bool BatchingPublisher::DropOldest() {
+  std::unique_lock<std::mutex> lk(mu_);
+  if (open_.empty()) return false;
+  auto loc = pending_.find(open_.begin()->second);
+  auto& batch = loc->second;
+  auto& messages = batch.contents.messages;
+  auto const bytes = MessageProtoSize(messages.front());
+  messages.erase(messages.begin());
+  auto& waiters = batch.contents.waiters;
+  auto p = std::move(waiters.front());
+  waiters.erase(waiters.begin());
+  batch.bytes -= bytes;
+  future<void> timer;
+  if (waiters.empty()) {
+    timer = std::move(batch.timer);
+    open_.erase(open_.begin());
+    pending_.erase(loc);
+  }
+  lk.unlock();
+  if (timer.valid()) timer.cancel();
+  flow_control_->Release(1, bytes);
+  p.set_value(Status(StatusCode::kResourceExhausted,
+                     "message dropped by the publisher flow control"));
+  return true;
+}
+
+bool BatchingPublisher::IsFull(Batch const& batch) const {
+  return batch.contents.waiters.size() >=
+             options_.maximum_batch_message_count() ||
+         batch.bytes >= MaximumBatchBytes();
+}
+
+std::size_t BatchingPublisher::MaximumBatchBytes() const {
+  if (batch_controller_) return batch_controller_->batch_bytes();
+  return options_.maximum_batch_bytes();
+}
+
+std::chrono::microseconds BatchingPublisher::HoldTime() const {
+  if (batch_controller_) return batch_controller_->hold_time();
+  return options_.maximum_hold_time();
+}
+
+void BatchingPublisher::OnTimer(BatchKey const& key, std::uint64_t id) {
+  std::vector<Batch> batches;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto loc = pending_.find(key);
+    // The batch may have been sent already, and a new one started.
+    if (loc == pending_.end() || loc->second.id != id) return;
+    open_.erase(id);
+    batches.push_back(std::move(loc->second));
+    pending_.erase(loc);
+  }
+  Send(std::move(batches));
+}
+
+void BatchingPublisher::Send(std::vector<Batch> batches) {
+  for (auto& b : batches) {
+    // Stop the hold timer, this is a no-op if it already expired.
+    if (b.timer.valid()) b.timer.cancel();
+    auto flow_control = flow_control_;
+    auto const messages = b.contents.waiters.size();
+    auto const bytes = b.bytes;
+    auto controller = batch_controller_;
+    b.contents.on_completion = [flow_control, controller, messages, bytes](
+                                   Status const& status,
+                                   std::chrono::microseconds latency) {
+      flow_control->Release(messages, bytes);
+      // Batches that never started a RPC say nothing about the latency.
+      if (controller && latency.count() != 0) {
+        controller->OnCompletion(bytes, latency, status.ok());
+      }
+    };
+    b.contents.compress =
+        options_.compression() && bytes >= options_.compression_threshold();
+    if (b.sequencer) {
+      b.sequencer->Publish(std::move(b.contents));
+      continue;
+    }
+    SendPublishBatch(cq_, *stub_, std::move(b.contents), encoder_.get());
+  }
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,208 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_BATCHING_PUBLISHER_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_BATCHING_PUBLISHER_H
+
+#include "google/cloud/pubsub/internal/adaptive_batch_controller.h"
+#include "google/cloud/pubsub/internal/mpsc_queue.h"
+#include "google/cloud/pubsub/internal/ordering_key_sequencer.h"
+#include "google/cloud/pubsub/internal/publish_batch.h"
+#include "google/cloud/pubsub/internal/publish_request_encoder.h"
+#include "google/cloud/pubsub/internal/publisher_flow_control.h"
+#include "google/cloud/pubsub/internal/publisher_stub.h"
+#include "google/cloud/pubsub/message.h"
+#include "google/cloud/pubsub/publisher_capacity.h"
+#include "google/cloud/pubsub/publisher_options.h"
+#include "google/cloud/pubsub/version.h"
+#include "google/cloud/future.h"
+#include "google/cloud/grpc_utils/completion_queue.h"
+#include "google/cloud/status_or.h"
+#include <google/pubsub/v1/pubsub.pb.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Collect published messages into batches and send them to Cloud Pub/Sub.
+ *
+ * Messages are grouped by topic and ordering key. Each group is sent as a
+ * single `PublishRequest` as soon as any of the limits in
+ * `pubsub::PublisherOptions` is reached. Batches are sent using asynchronous
+ * RPCs, and the hold time is implemented with timers, both run in @p cq.
+ * `Publish()` never blocks waiting for a RPC to complete.
+ *
+ * Batches without an ordering key are sent as soon as they are ready. Batches
+ * with an ordering key go through the `OrderingKeySequencer` for their key,
+ * which keeps at most one batch in flight per key. The sequencers of idle keys
+ * are erased as the number of keys grows, only paused keys keep their state.
+ *
+ * The number of pending messages, from `Publish()` until their RPC completes,
+ * is limited as configured in `pubsub::PublisherOptions`.
+ *
+ * With adaptive batching, the batch size limit and the hold time come from an
+ * `AdaptiveBatchController`, updated as each RPC completes.
+ *
+ * Many threads may call `Publish()` at the same time. To avoid contention on
+ * the mutex protecting the batches, `Publish()` pushes each message to a
+ * lock-free queue, one of several shards selected by the calling thread. A
+ * single thread drains each shard at a time, adding all the messages in the
+ * shard to their batches with a single lock acquisition. The other threads
+ * return without waiting for the mutex. Messages with an ordering key skip the
+ * shards: a later message for the same key, published from a different shard,
+ * could be batched first. They are added to their batch before `Publish()`
+ * returns.
+ *
+ * Objects of this class must be created via `std::make_shared<>()`, the timers
+ * hold a `std::weak_ptr<>` to the publisher.
+ */
+class BatchingPublisher
+    : public std::enable_shared_from_this<BatchingPublisher> {
+ public:
+  BatchingPublisher(google::cloud::grpc_utils::CompletionQueue cq,
+                    std::shared_ptr<PublisherStub> stub,
+                    pubsub::PublisherOptions options);
+
+  /// Sends any pending messages, the RPCs complete in the background.
+  ~BatchingPublisher();
+
+  /**
+   * Add @p message to the current batch for @p topic and its ordering key.
+   *
+   * The returned future is satisfied with the server-assigned message id once
+   * the batch containing the message is sent, or with the error status if the
+   * batch fails. Messages with an ordering key fail immediately if message
+   * ordering is not enabled, or if publishing for that key is paused.
+   *
+   * If the flow control limits are reached this function may block, reject
+   * the message, or drop older messages, depending on the configured
+   * `pubsub::PublisherFlowControlAction`.
+   *
+   * The batch shares the payload of @p message, it is not copied until the
+   * batch is sent.
+   */
+  future<StatusOr<std::string>> Publish(std::string const& topic,
+                                        pubsub::Message message);
+
+  /// Send all pending batches, without waiting for their hold time to expire.
+  void Flush();
+
+  /// Accept new messages for @p ordering_key after an error.
+  void ResumePublish(std::string const& topic,
+                     std::string const& ordering_key);
+
+  /// The current flow control state.
+  pubsub::PublisherCapacity Capacity() const;
+
+  /// The number of ordering keys with a sequencer, mostly for testing.
+  std::size_t sequencer_count();
+
+ private:
+  static std::size_t constexpr kMinimumSequencerSweepSize = 1024;
+
+  /// The topic and the ordering key.
+  using BatchKey = std::pair<std::string, std::string>;
+  struct BatchKeyHash {
+    std::size_t operator()(BatchKey const& key) const {
+      std::hash<std::string> h;
+      return h(key.first) * 31 + h(key.second);
+    }
+  };
+
+  struct Batch {
+    std::uint64_t id = 0;
+    PublishBatch contents;
+    std::size_t bytes = 0;
+    future<void> timer;
+    // Only set for batches with an ordering key.
+    std::shared_ptr<OrderingKeySequencer> sequencer;
+  };
+
+  /// A message waiting in one of the shards.
+  struct PendingMessage {
+    std::string topic;
+    pubsub::Message message;
+    std::size_t bytes;
+    promise<StatusOr<std::string>> waiter;
+  };
+
+  struct Shard {
+    MpscQueue<PendingMessage> queue;
+    std::atomic<bool> draining{false};
+  };
+
+  void Drain(Shard& shard, bool start_timers);
+  void AddToBatches(std::vector<PendingMessage> messages, bool start_timers);
+  void StartTimers(std::vector<std::pair<BatchKey, std::uint64_t>> batches);
+  std::shared_ptr<OrderingKeySequencer> const& Sequencer(BatchKey const& key);
+  void EraseIdleSequencers();
+  bool AcquireFlowControl(std::size_t bytes);
+  /**
+   * Fail the oldest unsent message without an ordering key.
+   *
+   * Dropping a message with an ordering key would leave a gap in the ordered
+   * stream, those are never dropped. Returns false if there is no message to
+   * drop.
+   */
+  bool DropOldest();
+  bool IsFull(Batch const& batch) const;
+  std::size_t MaximumBatchBytes() const;
+  std::chrono::microseconds HoldTime() const;
+  void OnTimer(BatchKey const& key, std::uint64_t id);
+  void Send(std::vector<Batch> batches);
+
+  google::cloud::grpc_utils::CompletionQueue cq_;
+  std::shared_ptr<PublisherStub> stub_;
+  pubsub::PublisherOptions const options_;
+  // Only set if direct encoding is enabled.
+  std::shared_ptr<PublishRequestEncoder> encoder_;
+  // Only set if adaptive batching is enabled. The RPC callbacks update it,
+  // even after the publisher is deleted.
+  std::shared_ptr<AdaptiveBatchController> batch_controller_;
+  // The RPC callbacks release the flow control, even after the publisher is
+  // deleted.
+  std::shared_ptr<PublisherFlowControl> flow_control_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  std::mutex mu_;
+  std::unordered_map<BatchKey, Batch, BatchKeyHash> pending_;
+  // The keys of the batches without an ordering key in `pending_`, indexed by
+  // batch id, to find the oldest batch to drop.
+  std::map<std::uint64_t, BatchKey> open_;
+  std::unordered_map<BatchKey, std::shared_ptr<OrderingKeySequencer>,
+                     BatchKeyHash>
+      sequencers_;
+  // Erase the idle sequencers when `sequencers_` reaches this size.
+  std::size_t sequencer_sweep_size_ = kMinimumSequencerSweepSize;
+  std::uint64_t next_batch_id_ = 0;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_BATCHING_PUBLISHER_H
@@ -0,0 +1,159 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/background_threads.h"
+#include "google/cloud/pubsub/internal/batching_publisher.h"
+#include "google/cloud/pubsub/internal/mpsc_queue.h"
+#include "google/cloud/internal/make_unique.h"
+#include <benchmark/benchmark.h>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+// Measure how Publish() scales with the number of threads calling it.
+//
+// Run with:
+//   batching_publisher_benchmark --benchmark_counters_tabular=true
+//
+// The stub completes each PublishRequest immediately, so the benchmark
+// measures the cost of queueing and batching, without any I/O. The
+// `BM_*Queue*` benchmarks compare the lock-free queue used by the publisher
+// against a mutex-protected queue.
+
+/// A stub that completes all requests immediately.
+class NullPublisherStub : public PublisherStub {
+ public:
+  StatusOr<google::pubsub::v1::Topic> CreateTopic(
+      grpc::ClientContext&, google::pubsub::v1::Topic const&) override {
+    return Status(StatusCode::kUnimplemented, "unused");
+  }
+  StatusOr<google::pubsub::v1::ListTopicsResponse> ListTopics(
+      grpc::ClientContext&,
+      google::pubsub::v1::ListTopicsRequest const&) override {
+    return Status(StatusCode::kUnimplemented, "unused");
+  }
+  future<StatusOr<google::pubsub::v1::ListTopicsResponse>> AsyncListTopics(
+      google::cloud::grpc_utils::CompletionQueue&,
+      std::unique_ptr<grpc::ClientContext>,
+      google::pubsub::v1::ListTopicsRequest const&) override {
+    return make_ready_future(StatusOr<google::pubsub::v1::ListTopicsResponse>(
+        Status(StatusCode::kUnimplemented, "unused")));
+  }
+  Status DeleteTopic(grpc::ClientContext&,
+                     google::pubsub::v1::DeleteTopicRequest const&) override {
+    return Status(StatusCode::kUnimplemented, "unused");
+  }
+  future<StatusOr<google::pubsub::v1::PublishResponse>> AsyncPublish(
+      google::cloud::grpc_utils::CompletionQueue&,
+      std::unique_ptr<grpc::ClientContext>,
+      google::pubsub::v1::PublishRequest const& request) override {
+    google::pubsub::v1::PublishResponse response;
+    for (int i = 0; i != request.messages_size(); ++i) {
+      response.add_message_ids("id");
+    }
+    return make_ready_future(
+        StatusOr<google::pubsub::v1::PublishResponse>(std::move(response)));
+  }
+  future<StatusOr<google::pubsub::v1::PublishResponse>> AsyncPublishEncoded(
+      google::cloud::grpc_utils::CompletionQueue&,
+      std::unique_ptr<grpc::ClientContext>, grpc::ByteBuffer const&) override {
+    return make_ready_future(StatusOr<google::pubsub::v1::PublishResponse>(
+        Status(StatusCode::kUnimplemented, "unused")));
+  }
+  future<Status> AsyncWaitForConnected(
+      google::cloud::grpc_utils::CompletionQueue&,
+      std::chrono::system_clock::time_point) override {
+    return make_ready_future(Status{});
+  }
+};
+
+std::unique_ptr<BackgroundThreads> background;
+std::shared_ptr<BatchingPublisher> publisher;
+
+void BM_Publish(benchmark::State& state) {
+  if (state.thread_index == 0) {
+    background = google::cloud::internal::make_unique<BackgroundThreads>(1);
+    publisher = std::make_shared<BatchingPublisher>(
+        background->cq(), std::make_shared<NullPublisherStub>(),
+        pubsub::PublisherOptions{}.set_maximum_hold_time(
+            std::chrono::milliseconds(5)));
+  }
+  auto const message =
+      pubsub::MessageBuilder{}.SetData(std::string(128, 'x')).Build();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        publisher->Publish("projects/p/topics/t", message));
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index == 0) {
+    publisher.reset();
+    background.reset();
+  }
+}
+BENCHMARK(BM_Publish)->ThreadRange(1, 64)->UseRealTime();
+
+MpscQueue<std::string> mpsc_queue;
+
+void BM_MpscQueuePush(benchmark::State& state) {
+  std::string const value(128, 'x');
+  int count = 0;
+  for (auto _ : state) {
+    mpsc_queue.Push(value);
+    // Drain the queue periodically, like the publisher does.
+    if (++count % 64 == 0) {
+      benchmark::DoNotOptimize(mpsc_queue.PopAll());
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index == 0) mpsc_queue.PopAll();
+}
+BENCHMARK(BM_MpscQueuePush)->ThreadRange(1, 64)->UseRealTime();
+
+std::mutex mutex_queue_mu;
+std::deque<std::string> mutex_queue;
+
+void BM_MutexQueuePush(benchmark::State& state) {
+  std::string const value(128, 'x');
+  int count = 0;
+  for (auto _ : state) {
+    {
+      std::lock_guard<std::mutex> lk(mutex_queue_mu);
+      mutex_queue.push_back(value);
+    }
+    if (++count % 64 == 0) {
+      std::deque<std::string> tmp;
+      {
+        std::lock_guard<std::mutex> lk(mutex_queue_mu);
+        tmp.swap(mutex_queue);
+      }
+      benchmark::DoNotOptimize(tmp);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index == 0) mutex_queue.clear();
+}
+BENCHMARK(BM_MutexQueuePush)->ThreadRange(1, 64)->UseRealTime();
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,729 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/batching_publisher.h"
+#include "google/cloud/pubsub/internal/background_threads.h"
+#include "google/cloud/pubsub/testing/mock_publisher_stub.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <grpcpp/impl/codegen/proto_utils.h>
+#include <gmock/gmock.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using ::google::cloud::grpc_utils::CompletionQueue;
+using ::testing::_;
+using ::testing::ElementsAre;
+using PublishResult = StatusOr<google::pubsub::v1::PublishResponse>;
+
+pubsub::Message MakeMessage(std::string data, std::string ordering_key = {}) {
+  return pubsub::MessageBuilder{}
+      .SetData(std::move(data))
+      .SetOrderingKey(std::move(ordering_key))
+      .Build();
+}
+
+/// Return a PublishResponse with the message data as the message id.
+future<PublishResult> EchoIds(
+    CompletionQueue&, std::unique_ptr<grpc::ClientContext>,
+    google::pubsub::v1::PublishRequest const& request) {
+  google::pubsub::v1::PublishResponse response;
+  for (auto const& m : request.messages()) response.add_message_ids(m.data());
+  return make_ready_future(PublishResult(std::move(response)));
+}
+
+std::shared_ptr<BatchingPublisher> MakeTestPublisher(
+    BackgroundThreads& background, std::shared_ptr<PublisherStub> stub,
+    pubsub::PublisherOptions options) {
+  return std::make_shared<BatchingPublisher>(
+      background.cq(), std::move(stub), std::move(options));
+}
+
+std::vector<std::string> DataOf(
+    google::pubsub::v1::PublishRequest const& request) {
+  std::vector<std::string> data;
+  for (auto const& m : request.messages()) data.push_back(m.data());
+  return data;
+}
+
+TEST(BatchingPublisherTest, SendsWhenMessageCountReached) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  EXPECT_CALL(*mock, AsyncPublish(_, _, _))
+      .WillOnce([](CompletionQueue& cq,
+                   std::unique_ptr<grpc::ClientContext> context,
+                   google::pubsub::v1::PublishRequest const& request) {
+        EXPECT_EQ("projects/p/topics/t", request.topic());
+        EXPECT_THAT(DataOf(request), ElementsAre("m0", "m1"));
+        return EchoIds(cq, std::move(context), request);
+      });
+
+  BackgroundThreads background(1);
+  auto publisher = MakeTestPublisher(
+      background, mock,
+      pubsub::PublisherOptions{}
+          .set_maximum_hold_time(std::chrono::hours(1))
+          .set_maximum_batch_message_count(2));
+  auto f0 = publisher->Publish("projects/p/topics/t", MakeMessage("m0"));
+  auto f1 = publisher->Publish("projects/p/topics/t", MakeMessage("m1"));
+  auto r0 = f0.get();
+  ASSERT_STATUS_OK(r0);
+  EXPECT_EQ("m0", *r0);
+  auto r1 = f1.get();
+  ASSERT_STATUS_OK(r1);
+  EXPECT_EQ("m1", *r1);
+}
+
+TEST(BatchingPublisherTest, SendsWhenBytesReached) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  EXPECT_CALL(*mock, AsyncPublish(_, _, _))
+      .WillOnce([](CompletionQueue& cq,
+                   std::unique_ptr<grpc::ClientContext> context,
+                   google::pubsub::v1::PublishRequest const& request) {
+        EXPECT_THAT(DataOf(request), ElementsAre("m0"));
+        return EchoIds(cq, std::move(context), request);
+      })
+      .WillOnce([](CompletionQueue& cq,
+                   std::unique_ptr<grpc::ClientContext> context,
+                   google::pubsub::v1::PublishRequest const& request) {
+        EXPECT_THAT(DataOf(request), ElementsAre("m1"));
+        return EchoIds(cq, std::move(context), request);
+      });
+
+  auto const size = MessageProtoSize(MakeMessage("m0"));
+  BackgroundThreads background(1);
+  auto publisher = MakeTestPublisher(
+      background, mock,
+      pubsub::PublisherOptions{}
+          .set_maximum_hold_time(std::chrono::hours(1))
+          .set_maximum_batch_bytes(size + 1));
+  auto f0 = publisher->Publish("projects/p/topics/t", MakeMessage("m0"));
+  // This message does not fit in the current batch, which is sent first.
+  auto f1 = publisher->Publish("projects/p/topics/t", MakeMessage("m1"));
+  EXPECT_EQ("m0", f0.get().value());
+  publisher->Flush();
+  EXPECT_EQ("m1", f1.get().value());
+}
+
+TEST(BatchingPublisherTest, SendsWhenHoldTimeExpires) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  EXPECT_CALL(*mock, AsyncPublish(_, _, _)).WillOnce(EchoIds);
+
+  BackgroundThreads background(1);
+  auto publisher = MakeTestPublisher(
+      background, mock,
+      pubsub::PublisherOptions{}
+          .set_maximum_hold_time(std::chrono::milliseconds(5))
+          .set_maximum_batch_message_count(100));
+  auto r = publisher->Publish("projects/p/topics/t", MakeMessage("m0")).get();
+  ASSERT_STATUS_OK(r);
+  EXPECT_EQ("m0", *r);
+}
+
+TEST(BatchingPublisherTest, BatchesByTopic) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  EXPECT_CALL(*mock, AsyncPublish(_, _, _))
+      .Times(2)
+      .WillRepeatedly([](CompletionQueue& cq,
+                         std::unique_ptr<grpc::ClientContext> context,
+                         google::pubsub::v1::PublishRequest const& request) {
+        EXPECT_EQ(1, request.messages_size());
+        EXPECT_EQ(request.topic(), "projects/p/topics/" +
+                                       request.messages(0).data().substr(0, 2));
+        return EchoIds(cq, std::move(context), request);
+      });
+
+  BackgroundThreads background(1);
+  auto publisher = MakeTestPublisher(
+      background, mock,
+      pubsub::PublisherOptions{}.set_maximum_hold_time(std::chrono::hours(1)));
+  auto f0 = publisher->Publish("projects/p/topics/t0", MakeMessage("t0-m"));
+  auto f1 = publisher->Publish("projects/p/topics/t1", MakeMessage("t1-m"));
+  publisher->Flush();
+  EXPECT_EQ("t0-m", f0.get().value());
+  EXPECT_EQ("t1-m", f1.get().value());
+}
+
+TEST(BatchingPublisherTest, DirectEncoding) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  EXPECT_CALL(*mock, AsyncPublish(_, _, _)).Times(0);
+  EXPECT_CALL(*mock, AsyncPublishEncoded(_, _, _))
+      .WillOnce([](CompletionQueue& cq,
+                   std::unique_ptr<grpc::ClientContext> context,
+                   grpc::ByteBuffer const& buffer) {
+        auto copy = buffer;
+        google::pubsub::v1::PublishRequest request;
+        auto status = grpc::SerializationTraits<
+            google::pubsub::v1::PublishRequest>::Deserialize(&copy, &request);
+        EXPECT_TRUE(status.ok());
+        EXPECT_EQ("projects/p/topics/t", request.topic());
+        EXPECT_THAT(DataOf(request), ElementsAre("m0", "m1"));
+        return EchoIds(cq, std::move(context), request);
+      });
+
+  BackgroundThreads background(1);
+  auto publisher = MakeTestPublisher(
+      background, mock,
+      pubsub::PublisherOptions{}
+          .set_maximum_hold_time(std::chrono::hours(1))
+          .set_maximum_batch_message_count(2)
+          .enable_direct_encoding());
+  auto f0 = publisher->Publish("projects/p/topics/t", MakeMessage("m0"));
+  auto f1 = publisher->Publish("projects/p/topics/t", MakeMessage("m1"));
+  EXPECT_EQ("m0", f0.get().value());
+  EXPECT_EQ("m1", f1.get().value());
+}
+
+TEST(BatchingPublisherTest, CompressesLargeBatches) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  std::vector<grpc_compression_algorithm> algorithms;
+  EXPECT_CALL(*mock, AsyncPublish(_, _, _))
+      .Times(2)
+      .WillRepeatedly([&](CompletionQueue& cq,
+                          std::unique_ptr<grpc::ClientContext> context,
+                          google::pubsub::v1::PublishRequest const& request) {
+        algorithms.push_back(context->compression_algorithm());
+        return EchoIds(cq, std::move(context), request);
+      });
+
+  BackgroundThreads background(1);
+  auto publisher = MakeTestPublisher(
+      background, mock,
+      pubsub::PublisherOptions{}
+          .set_maximum_batch_message_count(1)
+          .enable_compression()
+          .set_compression_threshold(100));
+  auto const large = std::string(200, 'x');
+  EXPECT_EQ("m0", publisher->Publish("projects/p/topics/t", MakeMessage("m0"))
+                      .get()
+                      .value());
+  EXPECT_EQ(large,
+            publisher->Publish("projects/p/topics/t", MakeMessage(large))
+                .get()
+                .value());
+  EXPECT_THAT(algorithms, ElementsAre(GRPC_COMPRESS_NONE, GRPC_COMPRESS_GZIP));
+}
+
+TEST(BatchingPublisherTest, AdaptiveBatchingStartsAtMinimum) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  EXPECT_CALL(*mock, AsyncPublish(_, _, _))
+      .WillOnce([](CompletionQueue& cq,
+                   std::unique_ptr<grpc::ClientContext> context,
+                   google::pubsub::v1::PublishRequest const& request) {
+        EXPECT_THAT(DataOf(request), ElementsAre("m0", "m1"));
+        return EchoIds(cq, std::move(context), request);
+      })
+      .WillOnce(EchoIds);
+
+  auto const size = MessageProtoSize(MakeMessage("m0"));
+  BackgroundThreads background(1);
+  auto publisher = MakeTestPublisher(
+      background, mock,
+      pubsub::PublisherOptions{}
+          .enable_adaptive_batching()
+          .set_minimum_batch_bytes(2 * size)
+          .set_minimum_hold_time(std::chrono::hours(1))
+          .set_maximum_hold_time(std::chrono::hours(1)));
+  auto f0 = publisher->Publish("projects/p/topics/t", MakeMessage("m0"));
+  auto f1 = publisher->Publish("projects/p/topics/t", MakeMessage("m1"));
+  EXPECT_EQ("m0", f0.get().value());
+  EXPECT_EQ("m1", f1.get().value());
+  auto f2 = publisher->Publish("projects/p/topics/t", MakeMessage("m2"));
+  publisher->Flush();
+  EXPECT_EQ("m2", f2.get().value());
+}
+
+TEST(BatchingPublisherTest, ErrorSatisfiesAllMessages) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  EXPECT_CALL(*mock, AsyncPublish(_, _, _))
+      .WillOnce([](CompletionQueue&, std::unique_ptr<grpc::ClientContext>,
+                   google::pubsub::v1::PublishRequest const&) {
+        return make_ready_future(
+            PublishResult(Status(StatusCode::kPermissionDenied, "uh-oh")));
+      });
+
+  BackgroundThreads background(1);
+  auto publisher = MakeTestPublisher(
+      background, mock,
+      pubsub::PublisherOptions{}
+          .set_maximum_hold_time(std::chrono::hours(1))
+          .set_maximum_batch_message_count(2));
+  auto f0 = publisher->Publish("projects/p/topics/t", MakeMessage("m0"));
+  auto f1 = publisher->Publish("projects/p/topics/t", MakeMessage("m1"));
+  EXPECT_EQ(StatusCode::kPermissionDenied, f0.get().status().code());
+  EXPECT_EQ(StatusCode::kPermissionDenied, f1.get().status().code());
+}
+
+TEST(BatchingPublisherTest, DestructorFlushes) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  EXPECT_CALL(*mock, AsyncPublish(_, _, _)).WillOnce(EchoIds);
+
+  BackgroundThreads background(1);
+  future<StatusOr<std::string>> f;
+  {
+    auto publisher =
+        MakeTestPublisher(background, mock,
+                          pubsub::PublisherOptions{}.set_maximum_hold_time(
+                              std::chrono::hours(1)));
+    f = publisher->Publish("projects/p/topics/t", MakeMessage("m0"));
+  }
+  EXPECT_EQ("m0", f.get().value());
+}
+
+TEST(BatchingPublisherTest, ManyPublishers) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  EXPECT_CALL(*mock, AsyncPublish(_, _, _)).WillRepeatedly(EchoIds);
+
+  BackgroundThreads background(2);
+  auto publisher = MakeTestPublisher(
+      background, mock,
+      pubsub::PublisherOptions{}
+          .set_maximum_hold_time(std::chrono::milliseconds(1))
+          .set_maximum_batch_message_count(10));
+  auto constexpr kThreads = 8;
+  auto constexpr kPerThread = 500;
+  std::vector<std::vector<future<StatusOr<std::string>>>> results(kThreads);
+  std::vector<std::thread> producers;
+  for (int t = 0; t != kThreads; ++t) {
+    producers.emplace_back([&publisher, &results, t] {
+      for (int i = 0; i != kPerThread; ++i) {
+        results[t].push_back(publisher->Publish(
+            "projects/p/topics/t",
+            MakeMessage(std::to_string(t) + "-" + std::to_string(i))));
+      }
+    });
+  }
+  for (auto& t : producers) t.join();
+  publisher->Flush();
+  for (int t = 0; t != kThreads; ++t) {
+    for (int i = 0; i != kPerThread; ++i) {
+      auto r = results[t][i].get();
+      ASSERT_STATUS_OK(r);
+      EXPECT_EQ(std::to_string(t) + "-" + std::to_string(i), *r);
+    }
+  }
+}
+
+TEST(BatchingPublisherTest, OrderingKeyRequiresMessageOrdering) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  EXPECT_CALL(*mock, AsyncPublish(_, _, _)).Times(0);
+
+  BackgroundThreads background(1);
+  auto publisher = MakeTestPublisher(background, mock, {});
+  auto r =
+      publisher->Publish("projects/p/topics/t", MakeMessage("m0", "k")).get();
+  EXPECT_EQ(StatusCode::kInvalidArgument, r.status().code());
+}
+
+TEST(BatchingPublisherTest, OrderingKeysInParallel) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  std::vector<std::string> sent;
+  // Completing a RPC may start the next one, use a container with stable
+  // references.
+  std::deque<promise<PublishResult>> rpcs;
+  EXPECT_CALL(*mock, AsyncPublish(_, _, _))
+      .Times(3)
+      .WillRepeatedly([&](CompletionQueue&,
+                          std::unique_ptr<grpc::ClientContext>,
+                          google::pubsub::v1::PublishRequest const& request) {
+        sent.push_back(request.messages(0).data());
+        rpcs.emplace_back();
+        return rpcs.back().get_future();
+      });
+  auto complete = [&](std::size_t i) {
+    google::pubsub::v1::PublishResponse response;
+    response.add_message_ids(sent[i]);
+    rpcs[i].set_value(std::move(response));
+  };
+
+  BackgroundThreads background(1);
+  auto publisher = MakeTestPublisher(
+      background, mock,
+      pubsub::PublisherOptions{}
+          .set_maximum_hold_time(std::chrono::hours(1))
+          .set_maximum_batch_message_count(1)
+          .enable_message_ordering());
+  auto publish = [&](std::string const& key, std::string const& data) {
+    return publisher->Publish("projects/p/topics/t", MakeMessage(data, key));
+  };
+  auto f0 = publish("k0", "k0-m0");
+  auto f1 = publish("k0", "k0-m1");
+  auto f2 = publish("k1", "k1-m0");
+  // The second message for "k0" waits, but "k1" is not blocked by "k0".
+  EXPECT_THAT(sent, ElementsAre("k0-m0", "k1-m0"));
+  complete(1);
+  EXPECT_EQ("k1-m0", f2.get().value());
+  complete(0);
+  EXPECT_EQ("k0-m0", f0.get().value());
+  EXPECT_THAT(sent, ElementsAre("k0-m0", "k1-m0", "k0-m1"));
+  complete(2);
+  EXPECT_EQ("k0-m1", f1.get().value());
+}
+
+TEST(BatchingPublisherTest, ResumePublish) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  EXPECT_CALL(*mock, AsyncPublish(_, _, _))
+      .WillOnce([](CompletionQueue&, std::unique_ptr<grpc::ClientContext>,
+                   google::pubsub::v1::PublishRequest const&) {
+        return make_ready_future(
+            PublishResult(Status(StatusCode::kUnavailable, "try-again")));
+      })
+      .WillOnce(EchoIds);
+
+  BackgroundThreads background(1);
+  auto publisher = MakeTestPublisher(
+      background, mock,
+      pubsub::PublisherOptions{}
+          .set_maximum_batch_message_count(1)
+          .enable_message_ordering());
+  auto publish = [&](std::string const& key, std::string const& data) {
+    return publisher->Publish("projects/p/topics/t", MakeMessage(data, key));
+  };
+  EXPECT_EQ(StatusCode::kUnavailable, publish("k", "m0").get().status().code());
+  EXPECT_EQ(StatusCode::kFailedPrecondition,
+            publish("k", "m1").get().status().code());
+  publisher->ResumePublish("projects/p/topics/t", "k");
+  EXPECT_EQ("m2", publish("k", "m2").get().value());
+}
+
+TEST(BatchingPublisherTest, OrderedWhileShardsAreDrained) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  std::mutex mu;
+  std::condition_variable cv;
+  std::size_t blocked = 0;
+  bool released = false;
+  std::vector<std::string> ordered;
+  EXPECT_CALL(*mock, AsyncPublish(_, _, _))
+      .WillRepeatedly([&](CompletionQueue& cq,
+                          std::unique_ptr<grpc::ClientContext> context,
+                          google::pubsub::v1::PublishRequest const& request) {
+        std::unique_lock<std::mutex> lk(mu);
+        if (request.messages(0).ordering_key().empty()) {
+          // Hold the thread, and the shard it is draining.
+          ++blocked;
+          cv.notify_all();
+          cv.wait(lk, [&] { return released; });
+        } else {
+          ordered.push_back(request.messages(0).data());
+        }
+        lk.unlock();
+        return EchoIds(cq, std::move(context), request);
+      });
+
+  BackgroundThreads background(1);
+  auto publisher = MakeTestPublisher(
+      background, mock,
+      pubsub::PublisherOptions{}
+          .set_maximum_hold_time(std::chrono::hours(1))
+          .set_maximum_batch_message_count(1)
+          .enable_message_ordering());
+  auto publish = [&](std::string const& key, std::string const& data) {
+    return publisher->Publish("projects/p/topics/t", MakeMessage(data, key));
+  };
+
+  // Each new thread uses the next shard. These threads block while sending
+  // the batch they drained, like a `Flush()` would, until every shard is
+  // held.
+  auto const shards = (std::max)(1U, std::thread::hardware_concurrency());
+  std::vector<std::thread> holders;
+  std::vector<future<StatusOr<std::string>>> held;
+  held.resize(shards);
+  for (unsigned i = 0; i != shards; ++i) {
+    holders.emplace_back(
+        [&, i] { held[i] = publish({}, "hold-" + std::to_string(i)); });
+    std::unique_lock<std::mutex> lk(mu);
+    cv.wait(lk, [&] { return blocked == i + 1; });
+  }
+
+  future<StatusOr<std::string>> fa;
+  std::thread ta([&] { fa = publish("k", "A"); });
+  ta.join();
+  {
+    // "A" was sent before `Publish()` returned, it did not wait in a shard.
+    std::lock_guard<std::mutex> lk(mu);
+    EXPECT_THAT(ordered, ElementsAre("A"));
+  }
+  future<StatusOr<std::string>> fb;
+  std::thread tb([&] { fb = publish("k", "B"); });
+  tb.join();
+
+  {
+    std::lock_guard<std::mutex> lk(mu);
+    released = true;
+    cv.notify_all();
+  }
+  for (auto& t : holders) t.join();
+  publisher->Flush();
+  EXPECT_EQ("A", fa.get().value());
+  EXPECT_EQ("B", fb.get().value());
+  for (auto& f : held) EXPECT_STATUS_OK(f.get());
+  std::lock_guard<std::mutex> lk(mu);
+  EXPECT_THAT(ordered, ElementsAre("A", "B"));
+}
+
+TEST(BatchingPublisherTest, ErasesIdleSequencers) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  EXPECT_CALL(*mock, AsyncPublish(_, _, _))
+      .WillOnce([](CompletionQueue&, std::unique_ptr<grpc::ClientContext>,
+                   google::pubsub::v1::PublishRequest const&) {
+        return make_ready_future(
+            PublishResult(Status(StatusCode::kUnavailable, "try-again")));
+      })
+      .WillRepeatedly(EchoIds);
+
+  BackgroundThreads background(1);
+  auto publisher = MakeTestPublisher(
+      background, mock,
+      pubsub::PublisherOptions{}
+          .set_maximum_batch_message_count(1)
+          .enable_message_ordering());
+  auto publish = [&](std::string const& key, std::string const& data) {
+    return publisher->Publish("projects/p/topics/t", MakeMessage(data, key));
+  };
+  EXPECT_EQ(StatusCode::kUnavailable,
+            publish("paused", "m0").get().status().code());
+  int const count = 5000;
+  for (int i = 0; i != count; ++i) {
+    auto const key = "k-" + std::to_string(i);
+    ASSERT_EQ(key, publish(key, key).get().value());
+  }
+  // Each batch completed immediately, the sequencers for most keys are gone.
+  EXPECT_LT(publisher->sequencer_count(), 2048U);
+  // The paused key is kept, until the application resumes publishing.
+  EXPECT_EQ(StatusCode::kFailedPrecondition,
+            publish("paused", "m1").get().status().code());
+  publisher->ResumePublish("projects/p/topics/t", "paused");
+  EXPECT_EQ("m2", publish("paused", "m2").get().value());
+}
+
+TEST(BatchingPublisherTest, FlowControlReject) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  EXPECT_CALL(*mock, AsyncPublish(_, _, _)).WillOnce(EchoIds);
+
+  BackgroundThreads background(1);
+  auto publisher = MakeTestPublisher(
+      background, mock,
+      pubsub::PublisherOptions{}
+          .set_maximum_hold_time(std::chrono::hours(1))
+          .set_maximum_pending_messages(2)
+          .set_flow_control_action(
+              pubsub::PublisherFlowControlAction::kReject));
+  auto f0 = publisher->Publish("projects/p/topics/t", MakeMessage("m0"));
+  auto f1 = publisher->Publish("projects/p/topics/t", MakeMessage("m1"));
+  auto capacity = publisher->Capacity();
+  EXPECT_EQ(2U, capacity.pending_messages);
+  EXPECT_EQ(0U, capacity.available_messages);
+  auto r2 = publisher->Publish("projects/p/topics/t", MakeMessage("m2")).get();
+  EXPECT_EQ(StatusCode::kResourceExhausted, r2.status().code());
+
+  publisher->Flush();
+  EXPECT_EQ("m0", f0.get().value());
+  EXPECT_EQ("m1", f1.get().value());
+  EXPECT_EQ(0U, publisher->Capacity().pending_messages);
+  EXPECT_EQ(0U, publisher->Capacity().pending_bytes);
+}
+
+TEST(BatchingPublisherTest, FlowControlDropOldest) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  EXPECT_CALL(*mock, AsyncPublish(_, _, _))
+      .WillOnce([](CompletionQueue& cq,
+                   std::unique_ptr<grpc::ClientContext> context,
+                   google::pubsub::v1::PublishRequest const& request) {
+        EXPECT_THAT(DataOf(request), ElementsAre("m1", "m2"));
+        return EchoIds(cq, std::move(context), request);
+      });
+
+  BackgroundThreads background(1);
+  auto publisher = MakeTestPublisher(
+      background, mock,
+      pubsub::PublisherOptions{}
+          .set_maximum_hold_time(std::chrono::hours(1))
+          .set_maximum_pending_messages(2)
+          .set_flow_control_action(
+              pubsub::PublisherFlowControlAction::kDropOldest));
+  auto f0 = publisher->Publish("projects/p/topics/t", MakeMessage("m0"));
+  auto f1 = publisher->Publish("projects/p/topics/t", MakeMessage("m1"));
+  auto f2 = publisher->Publish("projects/p/topics/t", MakeMessage("m2"));
+  EXPECT_EQ(StatusCode::kResourceExhausted, f0.get().status().code());
+  EXPECT_EQ(2U, publisher->Capacity().pending_messages);
+  publisher->Flush();
+  EXPECT_EQ("m1", f1.get().value());
+  EXPECT_EQ("m2", f2.get().value());
+}
+
+TEST(BatchingPublisherTest, FlowControlDropOldestKeepsOrderedMessages) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  std::vector<std::vector<std::string>> sent;
+  EXPECT_CALL(*mock, AsyncPublish(_, _, _))
+      .WillRepeatedly([&sent](CompletionQueue& cq,
+                              std::unique_ptr<grpc::ClientContext> context,
+                              google::pubsub::v1::PublishRequest const& r) {
+        sent.push_back(DataOf(r));
+        return EchoIds(cq, std::move(context), r);
+      });
+
+  BackgroundThreads background(1);
+  auto publisher = MakeTestPublisher(
+      background, mock,
+      pubsub::PublisherOptions{}
+          .set_maximum_hold_time(std::chrono::hours(1))
+          .set_maximum_pending_messages(2)
+          .enable_message_ordering()
+          .set_flow_control_action(
+              pubsub::PublisherFlowControlAction::kDropOldest));
+  auto publish = [&](std::string const& key, std::string const& data) {
+    return publisher->Publish("projects/p/topics/t", MakeMessage(data, key));
+  };
+  // The batch for "k" is the oldest, but only the unordered message is
+  // dropped.
+  auto f0 = publish("k", "k-m0");
+  auto f1 = publish("", "u-m0");
+  auto f2 = publish("k", "k-m1");
+  EXPECT_EQ(StatusCode::kResourceExhausted, f1.get().status().code());
+  // There is nothing left to drop, the new message is rejected.
+  auto f3 = publish("k", "k-m2");
+  EXPECT_EQ(StatusCode::kResourceExhausted, f3.get().status().code());
+
+  publisher->Flush();
+  EXPECT_EQ("k-m0", f0.get().value());
+  EXPECT_EQ("k-m1", f2.get().value());
+  EXPECT_THAT(sent, ElementsAre(ElementsAre("k-m0", "k-m1")));
+}
+
+TEST(BatchingPublisherTest, FlowControlBlock) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  std::deque<promise<PublishResult>> rpcs;
+  std::mutex mu;
+  std::condition_variable cv;
+  EXPECT_CALL(*mock, AsyncPublish(_, _, _))
+      .Times(2)
+      .WillRepeatedly([&](CompletionQueue&,
+                          std::unique_ptr<grpc::ClientContext>,
+                          google::pubsub::v1::PublishRequest const&) {
+        std::lock_guard<std::mutex> lk(mu);
+        rpcs.emplace_back();
+        cv.notify_all();
+        return rpcs.back().get_future();
+      });
+
+  BackgroundThreads background(1);
+  auto publisher = MakeTestPublisher(
+      background, mock,
+      pubsub::PublisherOptions{}
+          .set_maximum_hold_time(std::chrono::hours(1))
+          .set_maximum_pending_messages(1)
+          .set_flow_control_action(
+              pubsub::PublisherFlowControlAction::kBlock));
+  auto f0 = publisher->Publish("projects/p/topics/t", MakeMessage("m0"));
+  // The second call flushes the first message, and blocks until it completes.
+  future<StatusOr<std::string>> f1;
+  std::thread t([&] {
+    f1 = publisher->Publish("projects/p/topics/t", MakeMessage("m1"));
+  });
+  {
+    std::unique_lock<std::mutex> lk(mu);
+    cv.wait(lk, [&] { return !rpcs.empty(); });
+  }
+  google::pubsub::v1::PublishResponse response;
+  response.add_message_ids("id-0");
+  rpcs.front().set_value(response);
+  t.join();
+  EXPECT_EQ("id-0", f0.get().value());
+  EXPECT_EQ(1U, publisher->Capacity().pending_messages);
+  publisher->Flush();
+  {
+    std::unique_lock<std::mutex> lk(mu);
+    cv.wait(lk, [&] { return rpcs.size() == 2; });
+  }
+  response.set_message_ids(0, "id-1");
+  rpcs.back().set_value(response);
+  EXPECT_EQ("id-1", f1.get().value());
+}
+
+TEST(BatchingPublisherTest, FlowControlBlockInCompletion) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  std::deque<promise<PublishResult>> rpcs;
+  std::mutex mu;
+  EXPECT_CALL(*mock, AsyncPublish(_, _, _))
+      .WillRepeatedly([&](CompletionQueue&,
+                          std::unique_ptr<grpc::ClientContext>,
+                          google::pubsub::v1::PublishRequest const&) {
+        std::lock_guard<std::mutex> lk(mu);
+        rpcs.emplace_back();
+        return rpcs.back().get_future();
+      });
+
+  BackgroundThreads background(1);
+  auto publisher = MakeTestPublisher(
+      background, mock,
+      pubsub::PublisherOptions{}
+          .set_maximum_hold_time(std::chrono::hours(1))
+          .set_maximum_pending_messages(2)
+          .set_flow_control_action(
+              pubsub::PublisherFlowControlAction::kBlock));
+  auto f0 = publisher->Publish("projects/p/topics/t", MakeMessage("m0"));
+  publisher->Flush();
+  auto f1 = publisher->Publish("projects/p/topics/t", MakeMessage("m1"));
+
+  // The continuation runs in the thread completing `m0`, blocking there
+  // would deadlock: nothing else would complete `m1`.
+  future<StatusOr<std::string>> f2;
+  future<StatusOr<std::string>> f3;
+  auto done = f0.then([&](future<StatusOr<std::string>>) {
+    f2 = publisher->Publish("projects/p/topics/t", MakeMessage("m2"));
+    f3 = publisher->Publish("projects/p/topics/t", MakeMessage("m3"));
+  });
+  promise<PublishResult> rpc;
+  {
+    std::lock_guard<std::mutex> lk(mu);
+    ASSERT_EQ(1U, rpcs.size());
+    rpc = std::move(rpcs.front());
+    rpcs.pop_front();
+  }
+  google::pubsub::v1::PublishResponse response;
+  response.add_message_ids("id-0");
+  rpc.set_value(response);
+  done.get();
+  ASSERT_TRUE(f3.valid());
+  EXPECT_EQ(StatusCode::kResourceExhausted, f3.get().status().code());
+  EXPECT_EQ(2U, publisher->Capacity().pending_messages);
+
+  // Outside the continuation the publisher blocks as usual.
+  publisher->Flush();
+  {
+    std::lock_guard<std::mutex> lk(mu);
+    ASSERT_EQ(1U, rpcs.size());
+    rpc = std::move(rpcs.front());
+    rpcs.pop_front();
+  }
+  response.set_message_ids(0, "id-1");
+  response.add_message_ids("id-2");
+  rpc.set_value(response);
+  EXPECT_EQ("id-1", f1.get().value());
+  EXPECT_EQ("id-2", f2.get().value());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,86 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/channel_selector.h"
+#include "google/cloud/internal/random.h"
+#include <random>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+ChannelSelector::ChannelSelector(std::size_t channel_count)
+    : channel_count_(channel_count == 0 ? 1 : channel_count),
+      in_flight_(new std::atomic<std::size_t>[channel_count_]) {
+  for (std::size_t i = 0; i != channel_count_; ++i) in_flight_[i] = 0;
+}
+
+std::size_t ChannelSelector::Acquire() {
+  std::size_t channel = 0;
+  if (channel_count_ > 1) {
+    // Each thread has its own generator, the selection never blocks.
+    static thread_local auto generator =
+        google::cloud::internal::MakeDefaultPRNG();
+    auto const a = std::uniform_int_distribution<std::size_t>(
+        0, channel_count_ - 1)(generator);
+    // Pick a different second channel by skipping `a`.
+    auto b = std::uniform_int_distribution<std::size_t>(
+        0, channel_count_ - 2)(generator);
+    if (b >= a) ++b;
+    channel = in_flight_[b].load() < in_flight_[a].load() ? b : a;
+  }
+  in_flight_[channel].fetch_add(1);
+  return channel;
+}
+
+std::size_t ChannelSelector::AcquireOther(std::size_t excluded) {
+  std::size_t channel = 0;
+  if (channel_count_ > 1) {
+    static thread_local auto generator =
+        google::cloud::internal::MakeDefaultPRNG();
+    // Sample from the other `channel_count_ - 1` channels, skipping
+    // `excluded`, and with two or more of them pick the least loaded of two.
+    auto const others = channel_count_ - 1;
+    auto a = std::uniform_int_distribution<std::size_t>(0, others - 1)(
+        generator);
+    auto b = a;
+    if (others > 1) {
+      b = std::uniform_int_distribution<std::size_t>(0, others - 2)(generator);
+      if (b >= a) ++b;
+    }
+    if (a >= excluded) ++a;
+    if (b >= excluded) ++b;
+    channel = in_flight_[b].load() < in_flight_[a].load() ? b : a;
+  }
+  in_flight_[channel].fetch_add(1);
+  return channel;
+}
+
+void ChannelSelector::Release(std::size_t channel) {
+  in_flight_[channel].fetch_sub(1);
+}
+
+std::vector<std::size_t> ChannelSelector::in_flight() const {
+  std::vector<std::size_t> result(channel_count_);
+  for (std::size_t i = 0; i != channel_count_; ++i) {
+    result[i] = in_flight_[i].load();
+  }
+  return result;
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
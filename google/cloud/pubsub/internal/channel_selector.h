@@ -0,0 +1,88 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_CHANNEL_SELECTOR_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_CHANNEL_SELECTOR_H
+
+#include "google/cloud/pubsub/version.h"
+#include "google/cloud/future.h"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Choose the channel for each RPC, and track the RPCs in flight per channel.
+ *
+ * Round-robin performs poorly when one connection is slow, for example, while
+ * the service drains it, or when a stream is blocked: the slow connection
+ * keeps getting its share of the calls, and they pile up. This class uses
+ * the "power of two choices": it samples two channels at random, and picks
+ * the one with fewer RPCs in flight. This avoids the slow connections without
+ * the cost (and the herd behavior) of scanning all the channels.
+ *
+ * Each `Acquire()` must be paired with a `Release()` once the RPC completes,
+ * long-lived streams count as in flight until they are closed. This class is
+ * thread-safe.
+ */
+class ChannelSelector {
+ public:
+  explicit ChannelSelector(std::size_t channel_count);
+
+  /// Pick the channel for a new RPC, and count the RPC as in flight.
+  std::size_t Acquire();
+
+  /**
+   * Pick a channel other than @p excluded, and count the RPC as in flight.
+   *
+   * Used to send a duplicate of a slow RPC over a different connection. With
+   * a single channel this returns that channel.
+   */
+  std::size_t AcquireOther(std::size_t excluded);
+
+  /// Mark an RPC on @p channel as completed.
+  void Release(std::size_t channel);
+
+  /// The number of RPCs in flight on each channel.
+  std::vector<std::size_t> in_flight() const;
+
+  /// The number of channels.
+  std::size_t size() const { return channel_count_; }
+
+ private:
+  std::size_t const channel_count_;
+  std::unique_ptr<std::atomic<std::size_t>[]> in_flight_;
+};
+
+/// Release @p channel when the asynchronous call represented by @p f completes.
+template <typename T>
+future<T> ReleaseOnCompletion(std::shared_ptr<ChannelSelector> selector,
+                              std::size_t channel, future<T> f) {
+  return f.then([selector, channel](future<T> g) {
+    selector->Release(channel);
+    return g.get();
+  });
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_CHANNEL_SELECTOR_H
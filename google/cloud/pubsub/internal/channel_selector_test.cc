@@ -0,0 +1,108 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/channel_selector.h"
+#include <gmock/gmock.h>
+#include <algorithm>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using ::testing::ElementsAre;
+
+TEST(ChannelSelectorTest, SingleChannel) {
+  ChannelSelector selector(1);
+  EXPECT_EQ(0U, selector.Acquire());
+  EXPECT_EQ(0U, selector.Acquire());
+  EXPECT_THAT(selector.in_flight(), ElementsAre(2));
+  selector.Release(0);
+  EXPECT_THAT(selector.in_flight(), ElementsAre(1));
+}
+
+TEST(ChannelSelectorTest, ZeroIsOne) {
+  ChannelSelector selector(0);
+  EXPECT_EQ(1U, selector.size());
+  EXPECT_EQ(0U, selector.Acquire());
+}
+
+TEST(ChannelSelectorTest, PicksLeastLoaded) {
+  // With two channels both are always sampled, the choice is deterministic.
+  ChannelSelector selector(2);
+  auto const first = selector.Acquire();
+  auto const second = selector.Acquire();
+  EXPECT_NE(first, second);
+  auto const third = selector.Acquire();
+  selector.Release(third);
+  selector.Release(first);
+  EXPECT_EQ(first, selector.Acquire());
+}
+
+TEST(ChannelSelectorTest, AcquireOther) {
+  ChannelSelector single(1);
+  EXPECT_EQ(0U, single.AcquireOther(0));
+
+  ChannelSelector selector(4);
+  for (std::size_t excluded = 0; excluded != selector.size(); ++excluded) {
+    for (int i = 0; i != 100; ++i) {
+      auto const channel = selector.AcquireOther(excluded);
+      EXPECT_NE(excluded, channel);
+      ASSERT_LT(channel, selector.size());
+      selector.Release(channel);
+    }
+  }
+  EXPECT_THAT(selector.in_flight(), ElementsAre(0, 0, 0, 0));
+
+  // With three or more channels the least loaded of the others is preferred.
+  ChannelSelector three(3);
+  auto const busy = three.AcquireOther(0);
+  EXPECT_NE(busy, three.AcquireOther(0));
+}
+
+TEST(ChannelSelectorTest, AvoidsSlowChannel) {
+  ChannelSelector selector(4);
+  // Simulate a slow channel: its RPCs never complete, the other RPCs
+  // complete immediately.
+  std::size_t slow = selector.Acquire();
+  std::size_t slow_count = 1;
+  for (int i = 0; i != 1000; ++i) {
+    auto const c = selector.Acquire();
+    if (c == slow) {
+      ++slow_count;
+      continue;
+    }
+    selector.Release(c);
+  }
+  // Once the slow channel has an RPC in flight it is only picked if both
+  // samples are the slow channel, which is impossible.
+  EXPECT_EQ(1U, slow_count);
+  auto const in_flight = selector.in_flight();
+  EXPECT_EQ(1U, in_flight[slow]);
+}
+
+TEST(ChannelSelectorTest, Balanced) {
+  ChannelSelector selector(8);
+  for (int i = 0; i != 8000; ++i) selector.Acquire();
+  auto const in_flight = selector.in_flight();
+  auto const mm = std::minmax_element(in_flight.begin(), in_flight.end());
+  EXPECT_LE(*mm.second - *mm.first, 8U);
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
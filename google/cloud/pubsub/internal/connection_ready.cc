@@ -0,0 +1,66 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/connection_ready.h"
+#include <algorithm>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+namespace {
+using ::google::cloud::grpc_utils::CompletionQueue;
+
+// Most channels connect in a few milliseconds, poll quickly at first, and
+// back off for channels that take longer.
+auto constexpr kInitialPollingPeriod = std::chrono::milliseconds(5);
+auto constexpr kMaximumPollingPeriod = std::chrono::milliseconds(500);
+
+Status NotConnected() {
+  return Status(StatusCode::kDeadlineExceeded,
+                "channel not connected before the deadline");
+}
+
+future<Status> Poll(CompletionQueue cq, std::shared_ptr<grpc::Channel> channel,
+                    std::chrono::system_clock::time_point deadline,
+                    std::chrono::milliseconds period) {
+  // Start connecting if the channel is idle.
+  auto const state = channel->GetState(true);
+  if (state == GRPC_CHANNEL_READY) return make_ready_future(Status{});
+  auto const now = std::chrono::system_clock::now();
+  if (now >= deadline) return make_ready_future(NotConnected());
+  auto const next = (std::min)(deadline, now + period);
+  auto const next_period = (std::min)(2 * period, kMaximumPollingPeriod);
+  return cq.MakeDeadlineTimer(next).then(
+      [cq, channel, deadline, next_period](
+          future<StatusOr<std::chrono::system_clock::time_point>> f) {
+        // The timer fails if the completion queue is shutting down.
+        auto expired = f.get();
+        if (!expired) return make_ready_future(expired.status());
+        return Poll(cq, channel, deadline, next_period);
+      });
+}
+}  // namespace
+
+future<Status> AsyncWaitForConnected(
+    CompletionQueue& cq, std::shared_ptr<grpc::Channel> channel,
+    std::chrono::system_clock::time_point deadline) {
+  return Poll(cq, std::move(channel), deadline, kInitialPollingPeriod);
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,48 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_CONNECTION_READY_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_CONNECTION_READY_H
+
+#include "google/cloud/pubsub/version.h"
+#include "google/cloud/future.h"
+#include "google/cloud/grpc_utils/completion_queue.h"
+#include "google/cloud/status.h"
+#include <grpcpp/channel.h>
+#include <chrono>
+#include <memory>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Connect @p channel, the returned future is satisfied once it is ready.
+ *
+ * The future is satisfied with `kDeadlineExceeded` if the channel is not
+ * ready before @p deadline. The channel state is polled using timers in
+ * @p cq, with a growing period, no thread blocks while the channel connects,
+ * so many channels can connect in parallel.
+ */
+future<Status> AsyncWaitForConnected(
+    google::cloud::grpc_utils::CompletionQueue& cq,
+    std::shared_ptr<grpc::Channel> channel,
+    std::chrono::system_clock::time_point deadline);
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_CONNECTION_READY_H
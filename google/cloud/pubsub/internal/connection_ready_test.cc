@@ -0,0 +1,100 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "google/cloud/pubsub/internal/connection_ready.h"
+#include "google/cloud/pubsub/internal/background_threads.h"
+#include <gmock/gmock.h>
+#include <grpcpp/generic/async_generic_service.h>
+#include <grpcpp/grpcpp.h>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+/// A server that accepts connections, and does not handle any RPCs.
+class TestServer {
+ public:
+  TestServer() {
+    grpc::ServerBuilder builder;
+    builder.RegisterAsyncGenericService(&service_);
+    builder.AddListeningPort("localhost:0", grpc::InsecureServerCredentials(),
+                             &port_);
+    cq_ = builder.AddCompletionQueue();
+    server_ = builder.BuildAndStart();
+    poll_ = std::thread([this] {
+      void* tag;
+      bool ok;
+      while (cq_->Next(&tag, &ok)) continue;
+    });
+  }
+
+  ~TestServer() { Shutdown(); }
+
+  void Shutdown() {
+    if (!poll_.joinable()) return;
+    server_->Shutdown();
+    cq_->Shutdown();
+    poll_.join();
+  }
+
+  std::string address() const { return "localhost:" + std::to_string(port_); }
+
+ private:
+  grpc::AsyncGenericService service_;
+  int port_ = 0;
+  std::unique_ptr<grpc::ServerCompletionQueue> cq_;
+  std::unique_ptr<grpc::Server> server_;
+  std::thread poll_;
+};
+
+TEST(ConnectionReadyTest, Connects) {
+  TestServer server;
+  BackgroundThreads background(1);
+  auto cq = background.cq();
+  auto channel =
+      grpc::CreateChannel(server.address(), grpc::InsecureChannelCredentials());
+  auto const deadline =
+      std::chrono::system_clock::now() + std::chrono::seconds(30);
+  auto status = AsyncWaitForConnected(cq, channel, deadline).get();
+  EXPECT_TRUE(status.ok()) << status.message();
+  EXPECT_EQ(GRPC_CHANNEL_READY, channel->GetState(false));
+
+  // A connected channel is ready immediately.
+  auto f = AsyncWaitForConnected(cq, channel, deadline);
+  EXPECT_EQ(std::future_status::ready, f.wait_for(std::chrono::seconds(0)));
+  EXPECT_TRUE(f.get().ok());
+}
+
+TEST(ConnectionReadyTest, DeadlineExceeded) {
+  // Reserve a port, and stop listening, so nothing accepts the connections.
+  TestServer server;
+  server.Shutdown();
+  BackgroundThreads background(1);
+  auto cq = background.cq();
+  auto channel =
+      grpc::CreateChannel(server.address(), grpc::InsecureChannelCredentials());
+  auto const deadline =
+      std::chrono::system_clock::now() + std::chrono::milliseconds(200);
+  auto status = AsyncWaitForConnected(cq, channel, deadline).get();
+  EXPECT_EQ(StatusCode::kDeadlineExceeded, status.code());
+  EXPECT_LE(deadline, std::chrono::system_clock::now());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
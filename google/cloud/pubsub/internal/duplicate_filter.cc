@@ -0,0 +1,91 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/duplicate_filter.h"
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+DuplicateFilter::DuplicateFilter(std::size_t capacity,
+                                 std::chrono::seconds window)
+    : capacity_(capacity), window_(window) {}
+
+bool DuplicateFilter::IsDuplicate(std::string const& message_id,
+                                  Clock::time_point now) {
+  std::lock_guard<std::mutex> lk(mu_);
+  Expire(now);
+  auto i = index_.find(message_id);
+  if (i == index_.end()) return false;
+  Touch(i->second, now);
+  return true;
+}
+
+void DuplicateFilter::Record(std::string const& message_id,
+                             Clock::time_point now) {
+  std::lock_guard<std::mutex> lk(mu_);
+  Expire(now);
+  auto i = index_.find(message_id);
+  if (i != index_.end()) {
+    Touch(i->second, now);
+    return;
+  }
+  if (capacity_ == 0) return;
+  if (index_.size() == capacity_) EvictOldest();
+  lru_.push_front(Entry{nullptr, now});
+  auto inserted = index_.emplace(message_id, lru_.begin()).first;
+  lru_.front().message_id = &inserted->first;
+  id_bytes_ += inserted->first.capacity();
+}
+
+std::size_t DuplicateFilter::size() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return index_.size();
+}
+
+std::size_t DuplicateFilter::memory_usage() const {
+  // An estimate: each list node and hash map node has two pointers besides
+  // the value, plus the buckets and the message id characters.
+  auto constexpr kListNode = sizeof(Entry) + 2 * sizeof(void*);
+  auto constexpr kMapNode =
+      sizeof(std::pair<std::string const, List::iterator>) +
+      2 * sizeof(void*);
+  std::lock_guard<std::mutex> lk(mu_);
+  return sizeof(*this) + index_.size() * (kListNode + kMapNode) +
+         index_.bucket_count() * sizeof(void*) + id_bytes_;
+}
+
+void DuplicateFilter::Expire(Clock::time_point now) {
+  while (!lru_.empty() && now - lru_.back().recorded >= window_) {
+    EvictOldest();
+  }
+}
+
+void DuplicateFilter::EvictOldest() {
+  auto i = index_.find(*lru_.back().message_id);
+  id_bytes_ -= i->first.capacity();
+  index_.erase(i);
+  lru_.pop_back();
+}
+
+void DuplicateFilter::Touch(List::iterator i, Clock::time_point now) {
+  i->recorded = now;
+  lru_.splice(lru_.begin(), lru_, i);
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
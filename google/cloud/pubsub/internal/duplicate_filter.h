@@ -0,0 +1,91 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_DUPLICATE_FILTER_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_DUPLICATE_FILTER_H
+
+#include "google/cloud/pubsub/version.h"
+#include <chrono>
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Remember the ids of recently acknowledged messages.
+ *
+ * Cloud Pub/Sub delivers messages at least once, a message may be delivered
+ * again after it is acknowledged, for example, if the acknowledgement is lost
+ * when a stream is closed. The session records the id of each acknowledged
+ * message, and drops any redelivery found in the filter.
+ *
+ * The filter is a time-windowed LRU cache: it keeps at most `capacity` ids,
+ * evicting the least recently used first, and forgets ids after `window`. A
+ * hit refreshes the id, the service may deliver the same message several
+ * times.
+ *
+ * This class is thread-safe.
+ */
+class DuplicateFilter {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  DuplicateFilter(std::size_t capacity, std::chrono::seconds window);
+
+  /// Return true if @p message_id was recorded in the last `window`.
+  bool IsDuplicate(std::string const& message_id, Clock::time_point now);
+
+  /// Record the id of an acknowledged message.
+  void Record(std::string const& message_id, Clock::time_point now);
+
+  /// The number of ids in the filter.
+  std::size_t size() const;
+
+  /// The approximate memory used by the filter, in bytes.
+  std::size_t memory_usage() const;
+
+ private:
+  struct Entry {
+    // Points to the key in `index_`, the ids are not stored twice.
+    std::string const* message_id;
+    Clock::time_point recorded;
+  };
+  using List = std::list<Entry>;
+
+  void Expire(Clock::time_point now);
+  void EvictOldest();
+  void Touch(List::iterator i, Clock::time_point now);
+
+  std::size_t const capacity_;
+  std::chrono::seconds const window_;
+
+  mutable std::mutex mu_;
+  // The most recently used ids are at the front.
+  List lru_;
+  std::unordered_map<std::string, List::iterator> index_;
+  std::size_t id_bytes_ = 0;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_DUPLICATE_FILTER_H
@@ -0,0 +1,82 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/duplicate_filter.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using std::chrono::seconds;
+
+TEST(DuplicateFilterTest, RecordAndLookup) {
+  DuplicateFilter filter(100, seconds(60));
+  auto const t0 = DuplicateFilter::Clock::now();
+  EXPECT_FALSE(filter.IsDuplicate("m0", t0));
+  filter.Record("m0", t0);
+  filter.Record("m0", t0);
+  EXPECT_EQ(1U, filter.size());
+  EXPECT_TRUE(filter.IsDuplicate("m0", t0 + seconds(1)));
+  EXPECT_FALSE(filter.IsDuplicate("m1", t0 + seconds(1)));
+}
+
+TEST(DuplicateFilterTest, ExpiresAfterWindow) {
+  DuplicateFilter filter(100, seconds(60));
+  auto const t0 = DuplicateFilter::Clock::now();
+  filter.Record("m0", t0);
+  filter.Record("m1", t0 + seconds(30));
+  EXPECT_FALSE(filter.IsDuplicate("m0", t0 + seconds(60)));
+  EXPECT_EQ(1U, filter.size());
+  // A hit refreshes the entry.
+  EXPECT_TRUE(filter.IsDuplicate("m1", t0 + seconds(80)));
+  EXPECT_TRUE(filter.IsDuplicate("m1", t0 + seconds(130)));
+  EXPECT_FALSE(filter.IsDuplicate("m1", t0 + seconds(190)));
+  EXPECT_EQ(0U, filter.size());
+}
+
+TEST(DuplicateFilterTest, EvictsLeastRecentlyUsed) {
+  DuplicateFilter filter(2, seconds(60));
+  auto const t0 = DuplicateFilter::Clock::now();
+  filter.Record("m0", t0);
+  filter.Record("m1", t0);
+  EXPECT_TRUE(filter.IsDuplicate("m0", t0));
+  filter.Record("m2", t0);
+  EXPECT_EQ(2U, filter.size());
+  EXPECT_TRUE(filter.IsDuplicate("m0", t0));
+  EXPECT_FALSE(filter.IsDuplicate("m1", t0));
+  EXPECT_TRUE(filter.IsDuplicate("m2", t0));
+}
+
+TEST(DuplicateFilterTest, MemoryUsage) {
+  DuplicateFilter filter(1000, seconds(60));
+  auto const t0 = DuplicateFilter::Clock::now();
+  auto const empty = filter.memory_usage();
+  for (int i = 0; i != 1000; ++i) {
+    filter.Record("message-id-" + std::to_string(1000000000 + i), t0);
+  }
+  auto const full = filter.memory_usage();
+  EXPECT_LT(empty + 1000 * 20, full);
+  EXPECT_FALSE(filter.IsDuplicate("m0", t0 + seconds(60)));
+  EXPECT_EQ(0U, filter.size());
+  EXPECT_GT(full, filter.memory_usage());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,67 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/hedging.h"
+#include <algorithm>
+#include <cmath>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+HedgeDelay::HedgeDelay(double percentile, std::size_t window_size,
+                       std::size_t minimum_samples,
+                       std::chrono::milliseconds minimum_delay)
+    : percentile_((std::min)(1.0, (std::max)(0.0, percentile))),
+      minimum_samples_((std::max)(std::size_t{1}, minimum_samples)),
+      minimum_delay_((std::max)(std::chrono::milliseconds(1), minimum_delay)),
+      window_((std::max)(std::size_t{1}, window_size)) {}
+
+void HedgeDelay::Record(std::chrono::milliseconds latency) {
+  std::lock_guard<std::mutex> lk(mu_);
+  window_[next_] = latency;
+  next_ = (next_ + 1) % window_.size();
+  size_ = (std::min)(size_ + 1, window_.size());
+  if (size_ < minimum_samples_) return;
+
+  // The window is small, a partial sort of a copy is cheaper than keeping a
+  // sorted structure up to date.
+  std::vector<std::chrono::milliseconds> samples(window_.begin(),
+                                                 window_.begin() + size_);
+  auto const rank = static_cast<std::size_t>(
+      std::ceil(percentile_ * static_cast<double>(size_)));
+  auto const index = rank == 0 ? 0 : rank - 1;
+  std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+  delay_ = (std::max)(minimum_delay_, samples[index]);
+}
+
+std::chrono::milliseconds HedgeDelay::Delay() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return delay_;
+}
+
+HedgeTimer MakeHedgeTimer(google::cloud::grpc_utils::CompletionQueue cq) {
+  return [cq](std::chrono::milliseconds delay) mutable {
+    return cq.MakeRelativeTimer(delay).then(
+        [](future<StatusOr<std::chrono::system_clock::time_point>> f) {
+          return f.get().ok();
+        });
+  };
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,267 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_HEDGING_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_HEDGING_H
+
+#include "google/cloud/pubsub/internal/channel_selector.h"
+#include "google/cloud/pubsub/internal/retry_loop.h"
+#include "google/cloud/pubsub/version.h"
+#include "google/cloud/future.h"
+#include "google/cloud/grpc_utils/completion_queue.h"
+#include "google/cloud/internal/make_unique.h"
+#include "google/cloud/status_or.h"
+#include <grpcpp/grpcpp.h>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Track the latency of an RPC, and compute how long to wait before hedging it.
+ *
+ * The delay is the @p percentile of the most recent @p window_size successful
+ * calls, but at least @p minimum_delay. Until @p minimum_samples calls
+ * complete the latency is unknown, and `Delay()` returns zero, meaning the
+ * calls should not be hedged.
+ *
+ * Hedging at the 95th percentile sends (about) 5% more calls, the delay
+ * follows the latency of the service, so this holds when the service slows
+ * down too. This class is thread-safe.
+ */
+class HedgeDelay {
+ public:
+  explicit HedgeDelay(
+      double percentile = 0.95, std::size_t window_size = 128,
+      std::size_t minimum_samples = 16,
+      std::chrono::milliseconds minimum_delay = std::chrono::milliseconds(5));
+
+  /// Record the latency of a successful call.
+  void Record(std::chrono::milliseconds latency);
+
+  /// How long to wait before hedging a call, zero disables hedging.
+  std::chrono::milliseconds Delay() const;
+
+ private:
+  double const percentile_;
+  std::size_t const minimum_samples_;
+  std::chrono::milliseconds const minimum_delay_;
+  mutable std::mutex mu_;
+  std::vector<std::chrono::milliseconds> window_;
+  std::size_t next_ = 0;
+  std::size_t size_ = 0;
+  std::chrono::milliseconds delay_ = std::chrono::milliseconds(0);
+};
+
+/**
+ * Start a timer, the future is satisfied with `true` once it expires.
+ *
+ * The future is satisfied with `false` if the timer cannot run, for example,
+ * because its completion queue is shutting down.
+ */
+using HedgeTimer = std::function<future<bool>(std::chrono::milliseconds)>;
+
+/// Return a `HedgeTimer` using the timers in @p cq.
+HedgeTimer MakeHedgeTimer(google::cloud::grpc_utils::CompletionQueue cq);
+
+/// The clock used to measure the latency of the hedged calls.
+using HedgeClock = std::function<std::chrono::steady_clock::time_point()>;
+
+/// Implement `AsyncHedgedCall()`, the object owns itself until it completes.
+template <typename Response, typename Functor>
+class AsyncHedgedCallImpl
+    : public std::enable_shared_from_this<
+          AsyncHedgedCallImpl<Response, Functor>> {
+ public:
+  AsyncHedgedCallImpl(std::shared_ptr<ChannelSelector> selector,
+                      std::shared_ptr<HedgeDelay> delay, HedgeTimer timer,
+                      Functor call, HedgeClock clock)
+      : selector_(std::move(selector)),
+        delay_(std::move(delay)),
+        timer_(std::move(timer)),
+        call_(std::move(call)),
+        clock_(std::move(clock)) {}
+
+  future<StatusOr<Response>> Start(
+      std::unique_ptr<grpc::ClientContext> context) {
+    auto f = result_.get_future();
+    auto const hedge_delay = delay_->Delay();
+    auto const hedged = selector_->size() >= 2 &&
+                        hedge_delay != std::chrono::milliseconds(0);
+    configure_ = CopyContextSettings(*context);
+    std::unique_lock<std::mutex> lk(mu_);
+    primary_ = selector_->Acquire();
+    primary_context_ = context.get();
+    starting_ = true;
+    start_ = clock_();
+    lk.unlock();
+
+    auto self = this->shared_from_this();
+    call_(primary_, std::move(context))
+        .then([self](future<StatusOr<Response>> g) {
+          self->OnPrimary(g.get());
+        });
+    if (hedged) {
+      timer_(hedge_delay).then([self](future<bool> g) {
+        if (g.get()) self->OnHedgeDelay();
+      });
+    }
+    lk.lock();
+    starting_ = false;
+    MaybeDeliver(std::move(lk));
+    return f;
+  }
+
+ private:
+  void OnHedgeDelay() {
+    std::unique_lock<std::mutex> lk(mu_);
+    if (primary_done_) return;
+    auto context = google::cloud::internal::make_unique<grpc::ClientContext>();
+    configure_(*context);
+    hedge_ = selector_->AcquireOther(primary_);
+    hedge_context_ = context.get();
+    hedge_running_ = true;
+    starting_ = true;
+    lk.unlock();
+
+    auto self = this->shared_from_this();
+    call_(hedge_, std::move(context))
+        .then([self](future<StatusOr<Response>> g) {
+          self->OnHedge(g.get());
+        });
+    lk.lock();
+    starting_ = false;
+    MaybeDeliver(std::move(lk));
+  }
+
+  void OnPrimary(StatusOr<Response> r) {
+    selector_->Release(primary_);
+    std::unique_lock<std::mutex> lk(mu_);
+    primary_context_ = nullptr;
+    primary_done_ = true;
+    // Only the primary call measures the latency of the service, the hedge
+    // starts late and its latency is biased low.
+    if (r.ok() && !HasSuccess()) {
+      delay_->Record(std::chrono::duration_cast<std::chrono::milliseconds>(
+          clock_() - start_));
+    }
+    Offer(std::move(r), hedge_context_);
+    MaybeDeliver(std::move(lk));
+  }
+
+  void OnHedge(StatusOr<Response> r) {
+    selector_->Release(hedge_);
+    std::unique_lock<std::mutex> lk(mu_);
+    hedge_context_ = nullptr;
+    hedge_running_ = false;
+    // The primary call is slower than the time elapsed so far, record that
+    // lower bound, dropping the sample would bias the delay low too.
+    if (r.ok() && !HasSuccess()) {
+      delay_->Record(std::chrono::duration_cast<std::chrono::milliseconds>(
+          clock_() - start_));
+    }
+    Offer(std::move(r), primary_context_);
+    MaybeDeliver(std::move(lk));
+  }
+
+  bool HasSuccess() const { return has_result_ && response_.ok(); }
+
+  // Keep the first success, or the first error if there is no success.
+  void Offer(StatusOr<Response> r, grpc::ClientContext* other) {
+    if (has_result_ && (response_.ok() || !r.ok())) return;
+    has_result_ = true;
+    response_ = std::move(r);
+    if (response_.ok() && other != nullptr) other->TryCancel();
+  }
+
+  // Satisfy the future once there is a success, or once all the calls
+  // failed. Never while `call_` runs, the caller may release the objects it
+  // references as soon as the future is satisfied.
+  void MaybeDeliver(std::unique_lock<std::mutex> lk) {
+    if (delivered_ || starting_ || !has_result_) return;
+    if (!response_.ok() && (!primary_done_ || hedge_running_)) return;
+    delivered_ = true;
+    auto r = std::move(response_);
+    lk.unlock();
+    result_.set_value(std::move(r));
+  }
+
+  std::shared_ptr<ChannelSelector> const selector_;
+  std::shared_ptr<HedgeDelay> const delay_;
+  HedgeTimer const timer_;
+  Functor call_;
+  HedgeClock const clock_;
+  ContextConfigurator configure_;
+  std::mutex mu_;
+  std::size_t primary_ = 0;
+  std::size_t hedge_ = 0;
+  grpc::ClientContext* primary_context_ = nullptr;
+  grpc::ClientContext* hedge_context_ = nullptr;
+  std::chrono::steady_clock::time_point start_;
+  bool starting_ = false;
+  bool primary_done_ = false;
+  bool hedge_running_ = false;
+  bool has_result_ = false;
+  bool delivered_ = false;
+  StatusOr<Response> response_;
+  promise<StatusOr<Response>> result_;
+};
+
+/**
+ * Make an asynchronous call, and hedge it if it takes longer than
+ * `delay->Delay()`.
+ *
+ * The call starts on the channel returned by `selector->Acquire()`, using
+ * @p context. If it has not completed when the @p timer for the hedge delay
+ * expires, a duplicate starts on a different channel, with the same deadline
+ * and compression. The first successful response wins, and the other call is
+ * cancelled. If both calls fail the first error is returned.
+ *
+ * The latency of the primary call, measured with @p clock, is recorded in
+ * @p delay. If the hedge wins the primary latency is unknown, and the time
+ * until the hedge completes is recorded instead, as a lower bound.
+ *
+ * Only use this function with idempotent calls: both calls may reach the
+ * service. @p call must be a callable compatible with
+ * `future<StatusOr<Response>>(std::size_t channel,
+ * std::unique_ptr<grpc::ClientContext>)`, and must keep the context alive
+ * until the future is satisfied, as the gRPC stubs do. The returned future is
+ * not satisfied while @p call runs, so @p call may reference objects the
+ * caller keeps until then.
+ */
+template <typename Response, typename Functor>
+future<StatusOr<Response>> AsyncHedgedCall(
+    std::shared_ptr<ChannelSelector> selector,
+    std::shared_ptr<HedgeDelay> delay, HedgeTimer timer,
+    std::unique_ptr<grpc::ClientContext> context, Functor call,
+    HedgeClock clock = std::chrono::steady_clock::now) {
+  auto impl = std::make_shared<AsyncHedgedCallImpl<Response, Functor>>(
+      std::move(selector), std::move(delay), std::move(timer), std::move(call),
+      std::move(clock));
+  return impl->Start(std::move(context));
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_HEDGING_H
@@ -0,0 +1,332 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/hedging.h"
+#include "google/cloud/internal/make_unique.h"
+#include <gmock/gmock.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using ::testing::ElementsAre;
+using ms = std::chrono::milliseconds;
+using Response = StatusOr<std::string>;
+
+/// A `HedgeTimer` that only expires when the test says so.
+class FakeTimer {
+ public:
+  HedgeTimer timer() {
+    return [this](ms delay) {
+      delays.push_back(delay);
+      timers_.emplace_back();
+      return timers_.back().get_future();
+    };
+  }
+
+  void Expire(bool expired = true) { timers_.back().set_value(expired); }
+
+  std::vector<ms> delays;
+
+ private:
+  std::vector<promise<bool>> timers_;
+};
+
+/// A call made by `AsyncHedgedCall()`, completed by the test.
+struct FakeCall {
+  std::size_t channel;
+  std::unique_ptr<grpc::ClientContext> context;
+  promise<Response> response;
+};
+
+/// Record the calls, and keep their contexts until the test completes them.
+class FakeCalls {
+ public:
+  std::function<future<Response>(std::size_t,
+                                 std::unique_ptr<grpc::ClientContext>)>
+  functor() {
+    return [this](std::size_t channel,
+                  std::unique_ptr<grpc::ClientContext> context) {
+      calls.push_back(std::make_shared<FakeCall>());
+      calls.back()->channel = channel;
+      calls.back()->context = std::move(context);
+      return calls.back()->response.get_future();
+    };
+  }
+
+  void Complete(std::size_t i, Response r) {
+    calls[i]->response.set_value(std::move(r));
+  }
+
+  std::vector<std::shared_ptr<FakeCall>> calls;
+};
+
+/// A clock that only advances when the test says so.
+struct FakeClock {
+  std::chrono::steady_clock::time_point now;
+  HedgeClock clock() {
+    return [this] { return now; };
+  }
+};
+
+/// Record enough samples in @p delay to hedge after @p latency.
+void Train(HedgeDelay& delay, ms latency) {
+  for (int i = 0; i != 16; ++i) delay.Record(latency);
+}
+
+future<Response> Start(std::shared_ptr<ChannelSelector> selector,
+                       std::shared_ptr<HedgeDelay> delay, FakeTimer& timer,
+                       FakeCalls& calls, FakeClock& clock,
+                       std::unique_ptr<grpc::ClientContext> context =
+                           google::cloud::internal::make_unique<
+                               grpc::ClientContext>()) {
+  return AsyncHedgedCall<std::string>(
+      std::move(selector), std::move(delay), timer.timer(),
+      std::move(context), calls.functor(), clock.clock());
+}
+
+TEST(HedgeDelayTest, NoDelayWithoutSamples) {
+  HedgeDelay delay(0.95, 128, 4);
+  EXPECT_EQ(ms(0), delay.Delay());
+  for (int i = 0; i != 3; ++i) delay.Record(ms(20));
+  EXPECT_EQ(ms(0), delay.Delay());
+  delay.Record(ms(20));
+  EXPECT_EQ(ms(20), delay.Delay());
+}
+
+TEST(HedgeDelayTest, Percentile) {
+  HedgeDelay delay(0.95, 100, 1);
+  for (int i = 100; i != 0; --i) delay.Record(ms(i));
+  EXPECT_EQ(ms(95), delay.Delay());
+}
+
+TEST(HedgeDelayTest, MinimumDelay) {
+  HedgeDelay delay(0.95, 16, 1, ms(10));
+  delay.Record(ms(1));
+  EXPECT_EQ(ms(10), delay.Delay());
+}
+
+TEST(HedgeDelayTest, AdaptsToRecentSamples) {
+  HedgeDelay delay(0.95, 8, 1);
+  for (int i = 0; i != 8; ++i) delay.Record(ms(100));
+  EXPECT_EQ(ms(100), delay.Delay());
+  for (int i = 0; i != 8; ++i) delay.Record(ms(10));
+  EXPECT_EQ(ms(10), delay.Delay());
+}
+
+TEST(HedgedCallTest, NoHedgeWithoutDelay) {
+  auto selector = std::make_shared<ChannelSelector>(2);
+  FakeTimer timer;
+  FakeCalls calls;
+  FakeClock clock;
+  auto r = Start(selector, std::make_shared<HedgeDelay>(), timer, calls, clock);
+  EXPECT_TRUE(timer.delays.empty());
+  ASSERT_EQ(1, calls.calls.size());
+  calls.Complete(0, std::string("primary"));
+  auto response = r.get();
+  ASSERT_TRUE(response.ok());
+  EXPECT_EQ("primary", *response);
+  EXPECT_THAT(selector->in_flight(), ElementsAre(0, 0));
+}
+
+TEST(HedgedCallTest, NoHedgeWithSingleChannel) {
+  auto selector = std::make_shared<ChannelSelector>(1);
+  auto delay = std::make_shared<HedgeDelay>();
+  Train(*delay, ms(5));
+  FakeTimer timer;
+  FakeCalls calls;
+  FakeClock clock;
+  auto r = Start(selector, delay, timer, calls, clock);
+  EXPECT_TRUE(timer.delays.empty());
+  ASSERT_EQ(1, calls.calls.size());
+  calls.Complete(0, std::string("primary"));
+  EXPECT_TRUE(r.get().ok());
+}
+
+TEST(HedgedCallTest, FastCallIsNotHedged) {
+  auto selector = std::make_shared<ChannelSelector>(2);
+  auto delay = std::make_shared<HedgeDelay>();
+  Train(*delay, ms(500));
+  FakeTimer timer;
+  FakeCalls calls;
+  FakeClock clock;
+  auto r = Start(selector, delay, timer, calls, clock);
+  EXPECT_THAT(timer.delays, ElementsAre(ms(500)));
+  calls.Complete(0, std::string("primary"));
+  auto response = r.get();
+  ASSERT_TRUE(response.ok());
+  EXPECT_EQ("primary", *response);
+  // The timer expires after the call completes, there is nothing to hedge.
+  timer.Expire();
+  EXPECT_EQ(1, calls.calls.size());
+  EXPECT_THAT(selector->in_flight(), ElementsAre(0, 0));
+}
+
+TEST(HedgedCallTest, SlowCallIsHedged) {
+  auto selector = std::make_shared<ChannelSelector>(4);
+  auto delay = std::make_shared<HedgeDelay>();
+  Train(*delay, ms(10));
+  FakeTimer timer;
+  FakeCalls calls;
+  FakeClock clock;
+  auto const deadline =
+      std::chrono::system_clock::now() + std::chrono::minutes(1);
+  auto context = google::cloud::internal::make_unique<grpc::ClientContext>();
+  context->set_deadline(deadline);
+  context->set_compression_algorithm(GRPC_COMPRESS_GZIP);
+  auto r = Start(selector, delay, timer, calls, clock, std::move(context));
+  timer.Expire();
+  ASSERT_EQ(2, calls.calls.size());
+  EXPECT_NE(calls.calls[0]->channel, calls.calls[1]->channel);
+  // The hedge uses the same deadline, and the same compression.
+  EXPECT_EQ(deadline, calls.calls[1]->context->deadline());
+  EXPECT_EQ(GRPC_COMPRESS_GZIP,
+            calls.calls[1]->context->compression_algorithm());
+
+  calls.Complete(1, std::string("hedge"));
+  auto response = r.get();
+  ASSERT_TRUE(response.ok());
+  EXPECT_EQ("hedge", *response);
+  // The primary call completes (cancelled) after the result is returned.
+  calls.Complete(0, Status(StatusCode::kCancelled, "cancelled"));
+  EXPECT_THAT(selector->in_flight(), ElementsAre(0, 0, 0, 0));
+}
+
+TEST(HedgedCallTest, PrimaryWinsAfterHedge) {
+  auto selector = std::make_shared<ChannelSelector>(2);
+  auto delay = std::make_shared<HedgeDelay>();
+  Train(*delay, ms(10));
+  FakeTimer timer;
+  FakeCalls calls;
+  FakeClock clock;
+  auto r = Start(selector, delay, timer, calls, clock);
+  timer.Expire();
+  ASSERT_EQ(2, calls.calls.size());
+  calls.Complete(0, std::string("primary"));
+  auto response = r.get();
+  ASSERT_TRUE(response.ok());
+  EXPECT_EQ("primary", *response);
+  calls.Complete(1, Status(StatusCode::kCancelled, "cancelled"));
+  EXPECT_THAT(selector->in_flight(), ElementsAre(0, 0));
+}
+
+TEST(HedgedCallTest, PrimaryFailsBeforeHedge) {
+  auto selector = std::make_shared<ChannelSelector>(2);
+  auto delay = std::make_shared<HedgeDelay>();
+  Train(*delay, ms(10));
+  FakeTimer timer;
+  FakeCalls calls;
+  FakeClock clock;
+  auto r = Start(selector, delay, timer, calls, clock);
+  calls.Complete(0, Status(StatusCode::kUnavailable, "try-again"));
+  EXPECT_EQ(StatusCode::kUnavailable, r.get().status().code());
+  timer.Expire();
+  EXPECT_EQ(1, calls.calls.size());
+}
+
+TEST(HedgedCallTest, TimerFailureDoesNotHedge) {
+  auto selector = std::make_shared<ChannelSelector>(2);
+  auto delay = std::make_shared<HedgeDelay>();
+  Train(*delay, ms(10));
+  FakeTimer timer;
+  FakeCalls calls;
+  FakeClock clock;
+  auto r = Start(selector, delay, timer, calls, clock);
+  timer.Expire(false);
+  EXPECT_EQ(1, calls.calls.size());
+  calls.Complete(0, std::string("primary"));
+  EXPECT_TRUE(r.get().ok());
+}
+
+TEST(HedgedCallTest, SuccessPreferredOverError) {
+  auto selector = std::make_shared<ChannelSelector>(2);
+  auto delay = std::make_shared<HedgeDelay>();
+  Train(*delay, ms(10));
+  FakeTimer timer;
+  FakeCalls calls;
+  FakeClock clock;
+  auto r = Start(selector, delay, timer, calls, clock);
+  timer.Expire();
+  calls.Complete(0, Status(StatusCode::kUnavailable, "try-again"));
+  // The hedge may still succeed.
+  EXPECT_FALSE(r.is_ready());
+  calls.Complete(1, std::string("hedge"));
+  auto response = r.get();
+  ASSERT_TRUE(response.ok());
+  EXPECT_EQ("hedge", *response);
+}
+
+TEST(HedgedCallTest, BothFail) {
+  auto selector = std::make_shared<ChannelSelector>(2);
+  auto delay = std::make_shared<HedgeDelay>();
+  Train(*delay, ms(10));
+  FakeTimer timer;
+  FakeCalls calls;
+  FakeClock clock;
+  auto r = Start(selector, delay, timer, calls, clock);
+  timer.Expire();
+  calls.Complete(0, Status(StatusCode::kUnavailable, "primary"));
+  calls.Complete(1, Status(StatusCode::kUnavailable, "hedge"));
+  auto response = r.get();
+  EXPECT_EQ(StatusCode::kUnavailable, response.status().code());
+  EXPECT_EQ("primary", response.status().message());
+}
+
+TEST(HedgedCallTest, RecordsPrimaryLatency) {
+  auto selector = std::make_shared<ChannelSelector>(2);
+  auto delay = std::make_shared<HedgeDelay>(0.95, 16, 1);
+  FakeTimer timer;
+  FakeCalls calls;
+  FakeClock clock;
+  auto r = Start(selector, delay, timer, calls, clock);
+  clock.now += ms(20);
+  calls.Complete(0, std::string("primary"));
+  ASSERT_TRUE(r.get().ok());
+  EXPECT_EQ(ms(20), delay->Delay());
+}
+
+TEST(HedgedCallTest, RecordsLowerBoundWhenHedgeWins) {
+  auto selector = std::make_shared<ChannelSelector>(2);
+  // Use the slowest sample in the window as the delay.
+  auto delay = std::make_shared<HedgeDelay>(1.0, 16, 16);
+  Train(*delay, ms(10));
+  FakeTimer timer;
+  FakeCalls calls;
+  FakeClock clock;
+  auto r = Start(selector, delay, timer, calls, clock);
+  clock.now += ms(10);
+  timer.Expire();
+  clock.now += ms(20);
+  calls.Complete(1, std::string("hedge"));
+  ASSERT_TRUE(r.get().ok());
+  // The hedge took 20ms, but the primary took at least 30ms.
+  EXPECT_EQ(ms(30), delay->Delay());
+
+  // The primary completing later does not add a second sample.
+  clock.now += ms(100);
+  calls.Complete(0, std::string("primary"));
+  EXPECT_EQ(ms(30), delay->Delay());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
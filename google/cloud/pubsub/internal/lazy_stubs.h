@@ -0,0 +1,130 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_LAZY_STUBS_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_LAZY_STUBS_H
+
+#include "google/cloud/pubsub/version.h"
+#include "google/cloud/future.h"
+#include "google/cloud/grpc_utils/completion_queue.h"
+#include "google/cloud/status.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * A fixed-size array of stubs, each created on first use.
+ *
+ * Creating a channel resolves the endpoint and loads the credentials, with
+ * many channels this delays the application startup. This class creates each
+ * stub (and its channel) the first time it is used. Applications that prefer
+ * to pay that cost upfront call `AsyncWaitForConnected()`, which creates all
+ * the stubs and connects their channels in parallel.
+ *
+ * @tparam Stub the stub type, must provide a
+ *     `future<Status> AsyncWaitForConnected(grpc_utils::CompletionQueue&,
+ *     std::chrono::system_clock::time_point)` member function.
+ */
+template <typename Stub>
+class LazyStubs {
+ public:
+  /// Called with the channel id to create each stub.
+  using Factory = std::function<std::shared_ptr<Stub>(int)>;
+
+  LazyStubs(std::size_t size, Factory factory)
+      : size_(size == 0 ? 1 : size),
+        factory_(std::move(factory)),
+        slots_(new Slot[size_]) {}
+
+  /// Wrap stubs that are already created, mostly for testing.
+  explicit LazyStubs(std::vector<std::shared_ptr<Stub>> stubs)
+      : LazyStubs(stubs.size(), [stubs](int id) { return stubs[id]; }) {}
+
+  /// Return the @p i-th stub, creating it if needed. Thread-safe.
+  Stub& operator[](std::size_t i) {
+    auto& slot = slots_[i];
+    std::call_once(slot.once, [this, &slot, i] {
+      slot.stub = factory_(static_cast<int>(i));
+      created_.fetch_add(1);
+    });
+    return *slot.stub;
+  }
+
+  /// The number of stubs.
+  std::size_t size() const { return size_; }
+
+  /// The number of stubs created so far.
+  std::size_t created() const { return created_.load(); }
+
+  /**
+   * Create all the stubs and connect them in parallel.
+   *
+   * The channels connect asynchronously on @p cq. The returned future is
+   * satisfied once all of them are connected, or failed to connect before
+   * @p deadline, with the first error reported, if any.
+   */
+  future<Status> AsyncWaitForConnected(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::chrono::system_clock::time_point deadline) {
+    struct Pending {
+      std::mutex mu;
+      std::size_t count;
+      Status status;
+      promise<Status> done;
+    };
+    auto pending = std::make_shared<Pending>();
+    pending->count = size_;
+    auto f = pending->done.get_future();
+    for (std::size_t i = 0; i != size_; ++i) {
+      (*this)[i].AsyncWaitForConnected(cq, deadline).then(
+          [pending](future<Status> g) {
+            auto s = g.get();
+            std::unique_lock<std::mutex> lk(pending->mu);
+            if (pending->status.ok() && !s.ok()) pending->status = std::move(s);
+            if (--pending->count != 0) return;
+            auto status = std::move(pending->status);
+            lk.unlock();
+            pending->done.set_value(std::move(status));
+          });
+    }
+    return f;
+  }
+
+ private:
+  struct Slot {
+    std::once_flag once;
+    std::shared_ptr<Stub> stub;
+  };
+
+  std::size_t const size_;
+  Factory const factory_;
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<std::size_t> created_{0};
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_LAZY_STUBS_H
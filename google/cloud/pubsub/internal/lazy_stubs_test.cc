@@ -0,0 +1,94 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/lazy_stubs.h"
+#include "google/cloud/pubsub/testing/mock_publisher_stub.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using ::testing::_;
+using ::testing::ByMove;
+using ::testing::ElementsAre;
+using ::testing::InvokeWithoutArgs;
+using ::testing::Return;
+
+TEST(LazyStubsTest, CreatedOnFirstUse) {
+  std::vector<int> ids;
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  LazyStubs<PublisherStub> stubs(3, [&](int id) {
+    ids.push_back(id);
+    return mock;
+  });
+  EXPECT_EQ(3U, stubs.size());
+  EXPECT_EQ(0U, stubs.created());
+  EXPECT_EQ(mock.get(), &stubs[2]);
+  EXPECT_EQ(mock.get(), &stubs[2]);
+  EXPECT_EQ(1U, stubs.created());
+  EXPECT_EQ(mock.get(), &stubs[0]);
+  EXPECT_EQ(2U, stubs.created());
+  EXPECT_THAT(ids, ElementsAre(2, 0));
+}
+
+TEST(LazyStubsTest, WaitForConnectedConnectsInParallel) {
+  auto constexpr kCount = 4;
+  // The channels connect asynchronously, all of them start connecting before
+  // any of them is ready.
+  std::vector<promise<Status>> connecting(kCount);
+  LazyStubs<PublisherStub> stubs(kCount, [&](int id) {
+    auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+    EXPECT_CALL(*mock, AsyncWaitForConnected)
+        .WillOnce(InvokeWithoutArgs(
+            [&connecting, id] { return connecting[id].get_future(); }));
+    return mock;
+  });
+  google::cloud::grpc_utils::CompletionQueue cq;
+  auto const deadline =
+      std::chrono::system_clock::now() + std::chrono::seconds(30);
+  auto connected = stubs.AsyncWaitForConnected(cq, deadline);
+  EXPECT_EQ(4U, stubs.created());
+  for (auto& p : connecting) {
+    EXPECT_EQ(std::future_status::timeout,
+              connected.wait_for(std::chrono::seconds(0)));
+    p.set_value(Status{});
+  }
+  EXPECT_TRUE(connected.get().ok());
+}
+
+TEST(LazyStubsTest, WaitForConnectedError) {
+  std::vector<std::shared_ptr<PublisherStub>> children;
+  for (int i = 0; i != 3; ++i) {
+    auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+    EXPECT_CALL(*mock, AsyncWaitForConnected(_, _))
+        .WillOnce(Return(ByMove(make_ready_future(
+            i == 1 ? Status(StatusCode::kDeadlineExceeded, "1") : Status{}))));
+    children.push_back(std::move(mock));
+  }
+  LazyStubs<PublisherStub> stubs(std::move(children));
+  google::cloud::grpc_utils::CompletionQueue cq;
+  auto status =
+      stubs.AsyncWaitForConnected(cq, std::chrono::system_clock::now()).get();
+  EXPECT_EQ(StatusCode::kDeadlineExceeded, status.code());
+  EXPECT_EQ("1", status.message());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
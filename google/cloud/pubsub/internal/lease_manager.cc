@@ -0,0 +1,147 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/lease_manager.h"
+#include <algorithm>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+namespace {
+/// Extend the deadlines that expire within this margin, this leaves time to
+/// send the request even if the network or the callbacks are slow.
+auto constexpr kExtensionMargin = std::chrono::seconds(5);
+/// The service rejects deadlines outside this range.
+auto constexpr kMinimumDeadline = std::chrono::seconds(10);
+auto constexpr kMaximumDeadline = std::chrono::seconds(600);
+}  // namespace
+
+std::size_t constexpr LeaseManager::kHistogramWindow;
+double constexpr LeaseManager::kExtensionPercentile;
+
+LeaseManager::LeaseManager(std::chrono::seconds initial_deadline,
+                           std::chrono::seconds max_deadline_time)
+    : initial_deadline_(initial_deadline),
+      max_deadline_time_(max_deadline_time),
+      histogram_(kHistogramWindow) {}
+
+LeaseManager::Handle LeaseManager::Add(std::string const& ack_id,
+                                       std::string const& message_id,
+                                       std::string const& ordering_key,
+                                       std::size_t bytes,
+                                       std::chrono::seconds deadline,
+                                       Clock::time_point now) {
+  auto const message_id_size = static_cast<std::uint32_t>(message_id.size());
+  std::lock_guard<std::mutex> lk(mu_);
+  // The service uses a new ack id for each delivery, but do not leak the
+  // expired count if an ack id is added twice.
+  auto const* existing = leases_.Find(ack_id);
+  if (existing != nullptr && existing->expired) --expired_;
+  return leases_.Add(
+      ack_id, message_id + ordering_key,
+      Lease{now, now + deadline, bytes, message_id_size, false});
+}
+
+LeaseManager::Removed LeaseManager::Ack(Handle handle, Clock::time_point now) {
+  std::lock_guard<std::mutex> lk(mu_);
+  Lease lease{};
+  auto result = RemoveImpl(handle, lease);
+  if (result.released.messages == 0) return result;
+  histogram_.Record(std::chrono::duration_cast<std::chrono::milliseconds>(
+      now - lease.received));
+  return result;
+}
+
+LeaseManager::Removed LeaseManager::Nack(Handle handle) {
+  std::lock_guard<std::mutex> lk(mu_);
+  Lease lease{};
+  return RemoveImpl(handle, lease);
+}
+
+std::string LeaseManager::AckId(Handle handle) const {
+  std::lock_guard<std::mutex> lk(mu_);
+  if (leases_.Find(handle) == nullptr) return {};
+  return leases_.KeyOf(handle).ToString();
+}
+
+LeaseManager::Extension LeaseManager::Refresh(Clock::time_point now) {
+  std::lock_guard<std::mutex> lk(mu_);
+  Extension result{{}, ExtensionImpl(), Released{0, 0}};
+  leases_.RemoveIf([&](AckIdMap<Lease>::Key ack_id, Lease& lease) {
+    if (lease.expired) return false;
+    if (now - lease.received >= max_deadline_time_) {
+      // Keep the lease until the handler acknowledges or rejects the message,
+      // that needs its ack id and ordering key.
+      lease.expired = true;
+      ++expired_;
+      ++result.expired.messages;
+      result.expired.bytes += lease.bytes;
+      return false;
+    }
+    if (lease.deadline - now <= kExtensionMargin) {
+      result.ack_ids.push_back(ack_id.ToString());
+      lease.deadline = now + result.deadline;
+    }
+    return false;
+  });
+  return result;
+}
+
+std::chrono::seconds LeaseManager::extension() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return ExtensionImpl();
+}
+
+std::size_t LeaseManager::size() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return leases_.size() - expired_;
+}
+
+std::size_t LeaseManager::memory_usage() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return leases_.memory_usage();
+}
+
+LeaseManager::Removed LeaseManager::RemoveImpl(Handle handle, Lease& lease) {
+  Removed result{{}, {}, {}, Released{0, 0}};
+  auto const* found = leases_.Find(handle);
+  if (found == nullptr) return result;
+  result.ack_id = leases_.KeyOf(handle).ToString();
+  auto const payload = leases_.PayloadOf(handle);
+  result.message_id.assign(payload.data, found->message_id_size);
+  result.ordering_key.assign(payload.data + found->message_id_size,
+                             payload.size - found->message_id_size);
+  leases_.Remove(handle, lease);
+  if (lease.expired) {
+    // The flow control capacity was released when the lease expired.
+    --expired_;
+    return result;
+  }
+  result.released = Released{1, lease.bytes};
+  return result;
+}
+
+std::chrono::seconds LeaseManager::ExtensionImpl() const {
+  if (histogram_.size() == 0) return initial_deadline_;
+  auto const p = histogram_.Percentile(kExtensionPercentile);
+  return (std::max)(std::chrono::seconds(kMinimumDeadline),
+                    (std::min)(std::chrono::seconds(kMaximumDeadline), p));
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,159 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_LEASE_MANAGER_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_LEASE_MANAGER_H
+
+#include "google/cloud/pubsub/internal/ack_id_map.h"
+#include "google/cloud/pubsub/internal/ack_latency_histogram.h"
+#include "google/cloud/pubsub/version.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Track the outstanding messages of a subscription session and extend their
+ * ack deadlines.
+ *
+ * Each message starts with the ack deadline requested by the stream that
+ * received it, streams opened later may request a different deadline. Before
+ * the deadline of a message expires, `Refresh()` returns its ack id so the
+ * session can extend the deadline. The extension is the 99th percentile of
+ * the time taken to acknowledge recent messages, so applications with slow
+ * handlers get longer extensions, and applications with fast handlers recover
+ * quickly if the process crashes. Messages are not extended beyond
+ * `max_deadline_time` since they were received, at that point the service
+ * delivers them again.
+ *
+ * The ack ids are stored in an `AckIdMap`, a session leasing millions of
+ * messages uses a few thousand allocations for them, instead of one per
+ * message. The message id and ordering key, needed only to acknowledge the
+ * message, are stored next to the ack id, and the ack handlers keep a
+ * `Handle` instead of copies of these strings. Expired messages are no longer
+ * extended, but stay in the map until their handler acknowledges or rejects
+ * them.
+ *
+ * This class is thread-safe.
+ */
+class LeaseManager {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /// The number of acknowledgements used to compute the extension.
+  static std::size_t constexpr kHistogramWindow = 1000;
+  /// The percentile of the acknowledgement latency used as the extension.
+  static double constexpr kExtensionPercentile = 0.99;
+
+  /// A reference to a leased message, see `Add()`.
+  using Handle = AckIdHandle;
+
+  /// The messages (and their total size) that are no longer tracked.
+  struct Released {
+    std::size_t messages;
+    std::size_t bytes;
+  };
+
+  /// An acknowledged, or rejected, message.
+  struct Removed {
+    /// Empty if the handle was not found.
+    std::string ack_id;
+    std::string message_id;
+    std::string ordering_key;
+    /// Zero if the message had already expired.
+    Released released;
+  };
+
+  /// The deadlines of a group of messages to extend.
+  struct Extension {
+    std::vector<std::string> ack_ids;
+    std::chrono::seconds deadline;
+    /// The messages that reached `max_deadline_time`.
+    Released expired;
+  };
+
+  LeaseManager(std::chrono::seconds initial_deadline,
+               std::chrono::seconds max_deadline_time);
+
+  /**
+   * Start tracking a message of @p bytes received at @p now.
+   *
+   * @p deadline is the `stream_ack_deadline_seconds` requested by the stream
+   * that received the message, the service expires the message after it.
+   */
+  Handle Add(std::string const& ack_id, std::string const& message_id,
+             std::string const& ordering_key, std::size_t bytes,
+             std::chrono::seconds deadline, Clock::time_point now);
+
+  /// Stop tracking an acknowledged message, and record its processing time.
+  Removed Ack(Handle handle, Clock::time_point now);
+
+  /// Stop tracking a rejected message.
+  Removed Nack(Handle handle);
+
+  /// The ack id of a message, empty if it is no longer tracked.
+  std::string AckId(Handle handle) const;
+
+  /**
+   * Return the messages whose deadline expires soon, and extend their
+   * deadline.
+   *
+   * Messages that reached `max_deadline_time` are no longer tracked.
+   */
+  Extension Refresh(Clock::time_point now);
+
+  /// The current deadline extension.
+  std::chrono::seconds extension() const;
+
+  /// The number of outstanding messages, excluding the expired messages.
+  std::size_t size() const;
+
+  /// The approximate memory used to track the outstanding messages.
+  std::size_t memory_usage() const;
+
+ private:
+  struct Lease {
+    Clock::time_point received;
+    Clock::time_point deadline;
+    std::size_t bytes;
+    // The payload is the message id followed by the ordering key.
+    std::uint32_t message_id_size;
+    bool expired;
+  };
+
+  Removed RemoveImpl(Handle handle, Lease& lease);
+  std::chrono::seconds ExtensionImpl() const;
+
+  std::chrono::seconds const initial_deadline_;
+  std::chrono::seconds const max_deadline_time_;
+
+  mutable std::mutex mu_;
+  AckIdMap<Lease> leases_;
+  std::size_t expired_ = 0;
+  AckLatencyHistogram histogram_;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_LEASE_MANAGER_H
@@ -0,0 +1,142 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/lease_manager.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAre;
+using std::chrono::minutes;
+using std::chrono::seconds;
+
+TEST(LeaseManagerTest, ExtendsBeforeExpiration) {
+  LeaseManager leases(seconds(10), minutes(60));
+  auto const t0 = LeaseManager::Clock::now();
+  leases.Add("a0", "", "", 100, seconds(10), t0);
+  leases.Add("a1", "", "", 100, seconds(10), t0 + seconds(3));
+  EXPECT_EQ(2U, leases.size());
+
+  // Nothing expires within the margin yet.
+  EXPECT_THAT(leases.Refresh(t0 + seconds(1)).ack_ids, IsEmpty());
+
+  auto e = leases.Refresh(t0 + seconds(6));
+  EXPECT_THAT(e.ack_ids, ElementsAre("a0"));
+  EXPECT_EQ(seconds(10), e.deadline);
+
+  // "a0" was just extended, only "a1" needs a new deadline.
+  e = leases.Refresh(t0 + seconds(9));
+  EXPECT_THAT(e.ack_ids, ElementsAre("a1"));
+}
+
+TEST(LeaseManagerTest, UsesRequestedDeadline) {
+  LeaseManager leases(seconds(60), minutes(60));
+  auto const t0 = LeaseManager::Clock::now();
+  // A stream opened after the extension changed requested a shorter deadline
+  // than the initial one, its messages expire sooner.
+  leases.Add("a0", "", "", 100, seconds(60), t0);
+  leases.Add("a1", "", "", 100, seconds(10), t0);
+  EXPECT_THAT(leases.Refresh(t0 + seconds(6)).ack_ids, ElementsAre("a1"));
+}
+
+TEST(LeaseManagerTest, AckAndNackStopTracking) {
+  LeaseManager leases(seconds(10), minutes(60));
+  auto const t0 = LeaseManager::Clock::now();
+  auto const h0 = leases.Add("a0", "m0", "k0", 100, seconds(10), t0);
+  auto const h1 = leases.Add("a1", "m1", "", 100, seconds(10), t0);
+  leases.Add("a2", "", "", 100, seconds(10), t0);
+  EXPECT_EQ("a0", leases.AckId(h0));
+  auto r = leases.Ack(h0, t0 + seconds(1));
+  EXPECT_EQ("a0", r.ack_id);
+  EXPECT_EQ("m0", r.message_id);
+  EXPECT_EQ("k0", r.ordering_key);
+  EXPECT_EQ(1U, r.released.messages);
+  EXPECT_EQ(100U, r.released.bytes);
+  r = leases.Nack(h1);
+  EXPECT_EQ("a1", r.ack_id);
+  EXPECT_EQ("m1", r.message_id);
+  EXPECT_EQ("", r.ordering_key);
+  EXPECT_EQ(1U, r.released.messages);
+  EXPECT_EQ(100U, r.released.bytes);
+  // Each handle can be used once.
+  r = leases.Ack(h0, t0 + seconds(1));
+  EXPECT_EQ("", r.ack_id);
+  EXPECT_EQ(0U, r.released.messages);
+  EXPECT_EQ(0U, r.released.bytes);
+  EXPECT_EQ("", leases.AckId(h0));
+  EXPECT_EQ(1U, leases.size());
+  EXPECT_THAT(leases.Refresh(t0 + seconds(8)).ack_ids, ElementsAre("a2"));
+}
+
+TEST(LeaseManagerTest, ExtensionFromP99) {
+  LeaseManager leases(seconds(10), minutes(60));
+  EXPECT_EQ(seconds(10), leases.extension());
+
+  auto const t0 = LeaseManager::Clock::now();
+  for (int i = 0; i != 100; ++i) {
+    auto h = leases.Add("a" + std::to_string(i), "", "", 100, seconds(10), t0);
+    // Most messages are fast, 2% take two minutes.
+    leases.Ack(h, t0 + (i < 98 ? seconds(1) : minutes(2)));
+  }
+  EXPECT_EQ(seconds(120), leases.extension());
+
+  leases.Add("slow", "", "", 100, seconds(10), t0);
+  auto e = leases.Refresh(t0 + seconds(8));
+  EXPECT_THAT(e.ack_ids, ElementsAre("slow"));
+  EXPECT_EQ(seconds(120), e.deadline);
+}
+
+TEST(LeaseManagerTest, ExtensionAtLeastMinimum) {
+  LeaseManager leases(seconds(30), minutes(60));
+  auto const t0 = LeaseManager::Clock::now();
+  auto h = leases.Add("a0", "", "", 100, seconds(30), t0);
+  leases.Ack(h, t0 + std::chrono::milliseconds(5));
+  EXPECT_EQ(seconds(10), leases.extension());
+}
+
+TEST(LeaseManagerTest, StopsAtMaxDeadlineTime) {
+  LeaseManager leases(seconds(10), minutes(1));
+  auto const t0 = LeaseManager::Clock::now();
+  auto h = leases.Add("a0", "", "k0", 100, seconds(10), t0);
+  leases.Add("a1", "", "", 100, seconds(10), t0 + seconds(30));
+  auto e = leases.Refresh(t0 + seconds(60));
+  EXPECT_THAT(e.ack_ids, UnorderedElementsAre("a1"));
+  EXPECT_EQ(1U, e.expired.messages);
+  EXPECT_EQ(100U, e.expired.bytes);
+  EXPECT_EQ(1U, leases.size());
+
+  // The expired message is not extended, but the handler can still find its
+  // ack id and ordering key, the flow control capacity was already released.
+  e = leases.Refresh(t0 + seconds(61));
+  EXPECT_THAT(e.ack_ids, IsEmpty());
+  EXPECT_EQ(0U, e.expired.messages);
+  auto r = leases.Ack(h, t0 + seconds(61));
+  EXPECT_EQ("a0", r.ack_id);
+  EXPECT_EQ("k0", r.ordering_key);
+  EXPECT_EQ(0U, r.released.messages);
+  EXPECT_EQ(0U, r.released.bytes);
+  EXPECT_EQ(1U, leases.size());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
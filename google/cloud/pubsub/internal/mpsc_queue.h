@@ -0,0 +1,105 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_MPSC_QUEUE_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_MPSC_QUEUE_H
+
+#include "google/cloud/pubsub/version.h"
+#include <atomic>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * A lock-free, unbounded, multiple-producer queue.
+ *
+ * Producers call `Push()` without any locks: each element is a node in an
+ * intrusive stack, pushed with a single compare-and-swap. The consumer takes
+ * all the elements at once with `PopAll()`, which swaps the head of the stack
+ * and restores the insertion order.
+ *
+ * `PopAll()` is safe to call from multiple threads, but two concurrent calls
+ * may return their elements in any order. Callers that need FIFO order across
+ * calls must serialize them.
+ */
+template <typename T>
+class MpscQueue {
+ public:
+  MpscQueue() = default;
+  ~MpscQueue() {
+    auto* n = head_.exchange(nullptr);
+    while (n != nullptr) {
+      auto* next = n->next;
+      delete n;
+      n = next;
+    }
+  }
+
+  MpscQueue(MpscQueue const&) = delete;
+  MpscQueue& operator=(MpscQueue const&) = delete;
+
+  /// Add @p value to the queue.
+  void Push(T value) {
+    auto* n = new Node{std::move(value), head_.load(std::memory_order_relaxed)};
+    while (!head_.compare_exchange_weak(n->next, n, std::memory_order_release,
+                                        std::memory_order_relaxed)) {
+    }
+  }
+
+  /// Remove all the elements in the queue, in the order they were pushed.
+  std::vector<T> PopAll() {
+    auto* n = head_.exchange(nullptr, std::memory_order_acquire);
+    // The stack is in reverse order, reverse the list before extracting the
+    // values.
+    Node* reversed = nullptr;
+    std::size_t count = 0;
+    while (n != nullptr) {
+      auto* next = n->next;
+      n->next = reversed;
+      reversed = n;
+      n = next;
+      ++count;
+    }
+    std::vector<T> result;
+    result.reserve(count);
+    while (reversed != nullptr) {
+      auto* next = reversed->next;
+      result.push_back(std::move(reversed->value));
+      delete reversed;
+      reversed = next;
+    }
+    return result;
+  }
+
+  /// Returns true if the queue has no elements, this is only a snapshot.
+  bool empty() const { return head_.load() == nullptr; }
+
+ private:
+  struct Node {
+    T value;
+    Node* next;
+  };
+
+  std::atomic<Node*> head_{nullptr};
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_MPSC_QUEUE_H
@@ -0,0 +1,84 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/mpsc_queue.h"
+#include <gmock/gmock.h>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using ::testing::ElementsAre;
+
+TEST(MpscQueueTest, Fifo) {
+  MpscQueue<std::string> queue;
+  EXPECT_TRUE(queue.empty());
+  queue.Push("a");
+  queue.Push("b");
+  queue.Push("c");
+  EXPECT_FALSE(queue.empty());
+  EXPECT_THAT(queue.PopAll(), ElementsAre("a", "b", "c"));
+  EXPECT_TRUE(queue.empty());
+  EXPECT_TRUE(queue.PopAll().empty());
+}
+
+TEST(MpscQueueTest, MoveOnly) {
+  MpscQueue<std::unique_ptr<int>> queue;
+  queue.Push(std::unique_ptr<int>(new int(42)));
+  auto values = queue.PopAll();
+  ASSERT_EQ(1U, values.size());
+  EXPECT_EQ(42, *values[0]);
+  // Elements left in the queue are released by the destructor.
+  queue.Push(std::unique_ptr<int>(new int(7)));
+}
+
+TEST(MpscQueueTest, ManyProducers) {
+  auto constexpr kThreads = 8;
+  auto constexpr kPerThread = 10000;
+  MpscQueue<std::pair<int, int>> queue;
+  std::vector<std::thread> producers;
+  for (int t = 0; t != kThreads; ++t) {
+    producers.emplace_back([&queue, t] {
+      for (int i = 0; i != kPerThread; ++i) queue.Push({t, i});
+    });
+  }
+
+  std::vector<int> next(kThreads, 0);
+  int received = 0;
+  auto consume = [&] {
+    for (auto const& v : queue.PopAll()) {
+      // Elements from the same producer are received in order.
+      EXPECT_EQ(next[v.first], v.second);
+      next[v.first] = v.second + 1;
+      ++received;
+    }
+  };
+  while (received != kThreads * kPerThread) {
+    consume();
+    if (received != kThreads * kPerThread) std::this_thread::yield();
+  }
+  for (auto& t : producers) t.join();
+  EXPECT_TRUE(queue.empty());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,71 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/ordered_dispatcher.h"
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+void OrderedDispatcher::Dispatch(std::string const& ordering_key,
+                                 std::function<void()> task) {
+  if (!ordering_key.empty()) {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (shutdown_) return;
+    auto i = keys_.find(ordering_key);
+    if (i != keys_.end()) {
+      i->second.push_back(std::move(task));
+      return;
+    }
+    keys_.emplace(ordering_key, std::deque<std::function<void()>>{});
+  }
+  executor_->Run(std::move(task));
+}
+
+void OrderedDispatcher::Done(std::string const& ordering_key) {
+  if (ordering_key.empty()) return;
+  std::function<void()> next;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto i = keys_.find(ordering_key);
+    if (i == keys_.end()) return;
+    if (i->second.empty()) {
+      keys_.erase(i);
+      return;
+    }
+    next = std::move(i->second.front());
+    i->second.pop_front();
+  }
+  executor_->Run(std::move(next));
+}
+
+void OrderedDispatcher::Shutdown() {
+  std::unordered_map<std::string, std::deque<std::function<void()>>> keys;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    shutdown_ = true;
+    keys.swap(keys_);
+  }
+}
+
+std::size_t OrderedDispatcher::active_keys() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return keys_.size();
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,79 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_ORDERED_DISPATCHER_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_ORDERED_DISPATCHER_H
+
+#include "google/cloud/pubsub/subscriber_executor.h"
+#include "google/cloud/pubsub/version.h"
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Schedule the callbacks for ordered subscriptions.
+ *
+ * Messages with the same ordering key run one at a time and in the order they
+ * were received: each key has a FIFO queue, and the next message for a key is
+ * scheduled only after `Done()` is called for the previous one, that is, once
+ * it is acknowledged or rejected. Messages with different ordering keys (and
+ * messages without a key) are scheduled in the executor immediately, so they
+ * run in parallel on all its threads. A hot key occupies at most one thread.
+ */
+class OrderedDispatcher {
+ public:
+  explicit OrderedDispatcher(std::shared_ptr<pubsub::SubscriberExecutor> e)
+      : executor_(std::move(e)) {}
+
+  /// Run @p task after any previous tasks with the same @p ordering_key.
+  void Dispatch(std::string const& ordering_key, std::function<void()> task);
+
+  /// The message for @p ordering_key is done, schedule the next one.
+  void Done(std::string const& ordering_key);
+
+  /**
+   * Discard the queued tasks, and any new tasks with an ordering key.
+   *
+   * The tasks already scheduled in the executor still run. The discarded
+   * tasks are destroyed without holding any locks, so they may call `Done()`,
+   * which has no effect after shutdown.
+   */
+  void Shutdown();
+
+  /// The number of ordering keys with a message in progress.
+  std::size_t active_keys() const;
+
+ private:
+  std::shared_ptr<pubsub::SubscriberExecutor> executor_;
+  mutable std::mutex mu_;
+  // The keys with a message in progress, and the messages waiting for it.
+  std::unordered_map<std::string, std::deque<std::function<void()>>> keys_;
+  bool shutdown_ = false;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_ORDERED_DISPATCHER_H
@@ -0,0 +1,124 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/ordered_dispatcher.h"
+#include <gmock/gmock.h>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using ::testing::ElementsAre;
+
+/// Capture the scheduled tasks, the test decides when they run.
+class ManualExecutor : public pubsub::SubscriberExecutor {
+ public:
+  void Run(std::function<void()> task) override {
+    tasks.push_back(std::move(task));
+  }
+
+  void RunAll() {
+    auto t = std::move(tasks);
+    tasks.clear();
+    for (auto& f : t) f();
+  }
+
+  std::vector<std::function<void()>> tasks;
+};
+
+TEST(OrderedDispatcherTest, WithoutKeyRunsImmediately) {
+  auto executor = std::make_shared<ManualExecutor>();
+  OrderedDispatcher dispatcher(executor);
+  std::vector<int> ran;
+  dispatcher.Dispatch("", [&ran] { ran.push_back(0); });
+  dispatcher.Dispatch("", [&ran] { ran.push_back(1); });
+  EXPECT_EQ(2U, executor->tasks.size());
+  EXPECT_EQ(0U, dispatcher.active_keys());
+  executor->RunAll();
+  EXPECT_THAT(ran, ElementsAre(0, 1));
+}
+
+TEST(OrderedDispatcherTest, SameKeyWaitsForDone) {
+  auto executor = std::make_shared<ManualExecutor>();
+  OrderedDispatcher dispatcher(executor);
+  std::vector<int> ran;
+  for (int i = 0; i != 3; ++i) {
+    dispatcher.Dispatch("k", [&ran, i] { ran.push_back(i); });
+  }
+  EXPECT_EQ(1U, executor->tasks.size());
+  executor->RunAll();
+  // The next message is not scheduled until the previous one is done.
+  executor->RunAll();
+  EXPECT_THAT(ran, ElementsAre(0));
+
+  dispatcher.Done("k");
+  executor->RunAll();
+  EXPECT_THAT(ran, ElementsAre(0, 1));
+  dispatcher.Done("k");
+  executor->RunAll();
+  EXPECT_THAT(ran, ElementsAre(0, 1, 2));
+  EXPECT_EQ(1U, dispatcher.active_keys());
+  dispatcher.Done("k");
+  EXPECT_EQ(0U, dispatcher.active_keys());
+  EXPECT_TRUE(executor->tasks.empty());
+}
+
+TEST(OrderedDispatcherTest, DifferentKeysInParallel) {
+  auto executor = std::make_shared<ManualExecutor>();
+  OrderedDispatcher dispatcher(executor);
+  std::vector<std::string> ran;
+  dispatcher.Dispatch("a", [&ran] { ran.push_back("a0"); });
+  dispatcher.Dispatch("a", [&ran] { ran.push_back("a1"); });
+  dispatcher.Dispatch("b", [&ran] { ran.push_back("b0"); });
+  dispatcher.Dispatch("", [&ran] { ran.push_back("u0"); });
+  EXPECT_EQ(3U, executor->tasks.size());
+  EXPECT_EQ(2U, dispatcher.active_keys());
+  executor->RunAll();
+  EXPECT_THAT(ran, ElementsAre("a0", "b0", "u0"));
+
+  // Finishing "b" does not release "a".
+  dispatcher.Done("b");
+  EXPECT_TRUE(executor->tasks.empty());
+  dispatcher.Done("a");
+  executor->RunAll();
+  EXPECT_THAT(ran, ElementsAre("a0", "b0", "u0", "a1"));
+}
+
+TEST(OrderedDispatcherTest, ShutdownDiscardsQueued) {
+  auto executor = std::make_shared<ManualExecutor>();
+  OrderedDispatcher dispatcher(executor);
+  auto tracker = std::make_shared<int>(0);
+  dispatcher.Dispatch("k", [] {});
+  dispatcher.Dispatch("k", [tracker] {});
+  EXPECT_EQ(2, tracker.use_count());
+
+  dispatcher.Shutdown();
+  EXPECT_EQ(1, tracker.use_count());
+  EXPECT_EQ(0U, dispatcher.active_keys());
+
+  // New tasks with a key are discarded, `Done()` has no effect.
+  dispatcher.Dispatch("k", [tracker] {});
+  EXPECT_EQ(1, tracker.use_count());
+  dispatcher.Done("k");
+  EXPECT_EQ(1U, executor->tasks.size());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,93 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/ordering_key_sequencer.h"
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+OrderingKeySequencer::OrderingKeySequencer(
+    google::cloud::grpc_utils::CompletionQueue cq,
+    std::shared_ptr<PublisherStub> stub,
+    std::shared_ptr<PublishRequestEncoder> encoder, std::string ordering_key)
+    : cq_(std::move(cq)),
+      stub_(std::move(stub)),
+      encoder_(std::move(encoder)),
+      ordering_key_(std::move(ordering_key)) {}
+
+void OrderingKeySequencer::Publish(PublishBatch batch) {
+  std::unique_lock<std::mutex> lk(mu_);
+  if (!paused_.ok()) {
+    auto status = paused_;
+    lk.unlock();
+    FailPublishBatch(std::move(batch), status);
+    return;
+  }
+  if (in_flight_) {
+    queue_.push_back(std::move(batch));
+    return;
+  }
+  in_flight_ = true;
+  lk.unlock();
+  Send(std::move(batch));
+}
+
+Status OrderingKeySequencer::PausedStatus() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return paused_;
+}
+
+void OrderingKeySequencer::Resume() {
+  std::lock_guard<std::mutex> lk(mu_);
+  paused_ = Status();
+}
+
+void OrderingKeySequencer::Send(PublishBatch batch) {
+  auto self = shared_from_this();
+  SendPublishBatch(cq_, *stub_, std::move(batch), encoder_.get())
+      .then([self](future<Status> f) { self->OnSend(f.get()); });
+}
+
+void OrderingKeySequencer::OnSend(Status const& status) {
+  std::unique_lock<std::mutex> lk(mu_);
+  if (status.ok()) {
+    if (queue_.empty()) {
+      in_flight_ = false;
+      return;
+    }
+    auto batch = std::move(queue_.front());
+    queue_.pop_front();
+    lk.unlock();
+    Send(std::move(batch));
+    return;
+  }
+  // Sending the queued batches would break the ordering guarantees, reject
+  // them and any new messages until the application resumes publishing.
+  paused_ = Status(StatusCode::kFailedPrecondition,
+                   "publishing paused for ordering key <" + ordering_key_ +
+                       "> after a previous error: " + status.message());
+  in_flight_ = false;
+  std::deque<PublishBatch> queue;
+  queue.swap(queue_);
+  auto paused = paused_;
+  lk.unlock();
+  for (auto& b : queue) FailPublishBatch(std::move(b), paused);
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
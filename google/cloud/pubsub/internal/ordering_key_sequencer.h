@@ -0,0 +1,85 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_ORDERING_KEY_SEQUENCER_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_ORDERING_KEY_SEQUENCER_H
+
+#include "google/cloud/pubsub/internal/publish_batch.h"
+#include "google/cloud/pubsub/internal/publish_request_encoder.h"
+#include "google/cloud/pubsub/internal/publisher_stub.h"
+#include "google/cloud/pubsub/version.h"
+#include "google/cloud/grpc_utils/completion_queue.h"
+#include "google/cloud/status.h"
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Send the batches for a single ordering key, one at a time and in order.
+ *
+ * At most one batch is in flight, the next batch is sent only after the
+ * previous one succeeds. If a batch fails, all the queued batches fail and the
+ * sequencer is paused: any new batches fail immediately until `Resume()` is
+ * called.
+ *
+ * Each sequencer has its own mutex, batches for different ordering keys are
+ * sent in parallel.
+ *
+ * Objects of this class must be created via `std::make_shared<>()`, the RPC
+ * callbacks keep the sequencer alive until all the queued batches are sent.
+ */
+class OrderingKeySequencer
+    : public std::enable_shared_from_this<OrderingKeySequencer> {
+ public:
+  OrderingKeySequencer(google::cloud::grpc_utils::CompletionQueue cq,
+                       std::shared_ptr<PublisherStub> stub,
+                       std::shared_ptr<PublishRequestEncoder> encoder,
+                       std::string ordering_key);
+
+  /// Send @p batch after all the previously queued batches.
+  void Publish(PublishBatch batch);
+
+  /// The status used to reject new messages, OK if the sequencer is running.
+  Status PausedStatus() const;
+
+  /// Accept new batches after an error.
+  void Resume();
+
+ private:
+  void Send(PublishBatch batch);
+  void OnSend(Status const& status);
+
+  google::cloud::grpc_utils::CompletionQueue cq_;
+  std::shared_ptr<PublisherStub> stub_;
+  std::shared_ptr<PublishRequestEncoder> encoder_;
+  std::string const ordering_key_;
+
+  mutable std::mutex mu_;
+  std::deque<PublishBatch> queue_;
+  bool in_flight_ = false;
+  Status paused_;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_ORDERING_KEY_SEQUENCER_H
@@ -0,0 +1,147 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/ordering_key_sequencer.h"
+#include "google/cloud/pubsub/testing/mock_publisher_stub.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+#include <deque>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using ::google::cloud::grpc_utils::CompletionQueue;
+using ::testing::_;
+using PublishResult = StatusOr<google::pubsub::v1::PublishResponse>;
+
+/// A batch with a single message, the message data is also its id.
+PublishBatch MakeBatch(std::string const& data) {
+  PublishBatch batch;
+  batch.topic = "projects/p/topics/t";
+  batch.messages.push_back(
+      pubsub::MessageBuilder{}.SetData(data).SetOrderingKey("k").Build());
+  batch.waiters.emplace_back();
+  return batch;
+}
+
+/// Capture the requests and complete them when the test is ready.
+class PendingRpcs {
+ public:
+  future<PublishResult> Start(google::pubsub::v1::PublishRequest const& r) {
+    requests_.push_back(r);
+    promises_.emplace_back();
+    return promises_.back().get_future();
+  }
+
+  std::size_t size() const { return promises_.size(); }
+
+  void CompleteNext(Status const& status = {}) {
+    auto p = std::move(promises_.front());
+    auto r = std::move(requests_.front());
+    promises_.pop_front();
+    requests_.pop_front();
+    if (!status.ok()) {
+      p.set_value(status);
+      return;
+    }
+    google::pubsub::v1::PublishResponse response;
+    for (auto const& m : r.messages()) response.add_message_ids(m.data());
+    p.set_value(std::move(response));
+  }
+
+ private:
+  std::deque<google::pubsub::v1::PublishRequest> requests_;
+  std::deque<promise<PublishResult>> promises_;
+};
+
+std::shared_ptr<OrderingKeySequencer> MakeSequencer(
+    std::shared_ptr<pubsub_testing::MockPublisherStub> const& mock,
+    PendingRpcs& pending) {
+  EXPECT_CALL(*mock, AsyncPublish(_, _, _))
+      .WillRepeatedly([&pending](CompletionQueue&,
+                                 std::unique_ptr<grpc::ClientContext>,
+                                 google::pubsub::v1::PublishRequest const& r) {
+        return pending.Start(r);
+      });
+  return std::make_shared<OrderingKeySequencer>(CompletionQueue{}, mock,
+                                                /*encoder=*/nullptr, "k");
+}
+
+TEST(OrderingKeySequencerTest, OneBatchInFlight) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  PendingRpcs pending;
+  auto sequencer = MakeSequencer(mock, pending);
+
+  std::vector<future<StatusOr<std::string>>> results;
+  for (auto const* data : {"m0", "m1", "m2"}) {
+    auto batch = MakeBatch(data);
+    results.push_back(batch.waiters.back().get_future());
+    sequencer->Publish(std::move(batch));
+  }
+  for (auto const* data : {"m0", "m1", "m2"}) {
+    ASSERT_EQ(1U, pending.size());
+    pending.CompleteNext();
+    auto r = results.front().get();
+    results.erase(results.begin());
+    ASSERT_STATUS_OK(r);
+    EXPECT_EQ(data, *r);
+  }
+  EXPECT_EQ(0U, pending.size());
+}
+
+TEST(OrderingKeySequencerTest, ErrorPausesUntilResume) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  PendingRpcs pending;
+  auto sequencer = MakeSequencer(mock, pending);
+
+  auto b0 = MakeBatch("m0");
+  auto f0 = b0.waiters.back().get_future();
+  auto b1 = MakeBatch("m1");
+  auto f1 = b1.waiters.back().get_future();
+  sequencer->Publish(std::move(b0));
+  sequencer->Publish(std::move(b1));
+  ASSERT_EQ(1U, pending.size());
+  pending.CompleteNext(Status(StatusCode::kUnavailable, "try-again"));
+
+  EXPECT_EQ(StatusCode::kUnavailable, f0.get().status().code());
+  // The queued batch is never sent.
+  EXPECT_EQ(StatusCode::kFailedPrecondition, f1.get().status().code());
+  EXPECT_EQ(0U, pending.size());
+  EXPECT_EQ(StatusCode::kFailedPrecondition,
+            sequencer->PausedStatus().code());
+
+  auto b2 = MakeBatch("m2");
+  auto f2 = b2.waiters.back().get_future();
+  sequencer->Publish(std::move(b2));
+  EXPECT_EQ(StatusCode::kFailedPrecondition, f2.get().status().code());
+  EXPECT_EQ(0U, pending.size());
+
+  sequencer->Resume();
+  ASSERT_STATUS_OK(sequencer->PausedStatus());
+  auto b3 = MakeBatch("m3");
+  auto f3 = b3.waiters.back().get_future();
+  sequencer->Publish(std::move(b3));
+  ASSERT_EQ(1U, pending.size());
+  pending.CompleteNext();
+  EXPECT_EQ("m3", f3.get().value());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,121 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/publish_batch.h"
+#include "google/cloud/pubsub/internal/arena_pool.h"
+#include "google/cloud/pubsub/internal/publish_request_encoder.h"
+#include "google/cloud/internal/make_unique.h"
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+google::pubsub::v1::PublishRequest* MakePublishRequest(
+    PublishBatch const& batch, google::protobuf::Arena* arena) {
+  auto* request = google::protobuf::Arena::CreateMessage<
+      google::pubsub::v1::PublishRequest>(arena);
+  request->set_topic(batch.topic);
+  request->mutable_messages()->Reserve(
+      static_cast<int>(batch.messages.size()));
+  for (auto const& m : batch.messages) ToProto(m, request->add_messages());
+  return request;
+}
+
+namespace {
+thread_local int completion_depth = 0;
+
+/// Mark the current thread as completing a batch.
+class CompletionScope {
+ public:
+  CompletionScope() { ++completion_depth; }
+  ~CompletionScope() { --completion_depth; }
+  CompletionScope(CompletionScope const&) = delete;
+  CompletionScope& operator=(CompletionScope const&) = delete;
+};
+}  // namespace
+
+bool InPublishBatchCompletion() { return completion_depth != 0; }
+
+void FailPublishBatch(PublishBatch batch, Status const& status) {
+  CompletionScope scope;
+  if (batch.on_completion) {
+    batch.on_completion(status, std::chrono::microseconds(0));
+  }
+  for (auto& w : batch.waiters) w.set_value(status);
+}
+
+namespace {
+future<StatusOr<google::pubsub::v1::PublishResponse>> StartPublish(
+    google::cloud::grpc_utils::CompletionQueue& cq, PublisherStub& stub,
+    PublishBatch const& batch, PublishRequestEncoder* encoder) {
+  auto context = google::cloud::internal::make_unique<grpc::ClientContext>();
+  if (batch.compress) context->set_compression_algorithm(GRPC_COMPRESS_GZIP);
+  if (encoder != nullptr) {
+    return stub.AsyncPublishEncoded(cq, std::move(context),
+                                    encoder->Encode(batch));
+  }
+  // The request is serialized before AsyncPublish() returns, the arena is
+  // returned to the pool immediately after.
+  auto arena = DefaultArenaPool().Acquire();
+  return stub.AsyncPublish(cq, std::move(context),
+                           *MakePublishRequest(batch, arena.get()));
+}
+}  // namespace
+
+future<Status> SendPublishBatch(google::cloud::grpc_utils::CompletionQueue& cq,
+                                PublisherStub& stub, PublishBatch batch,
+                                PublishRequestEncoder* encoder) {
+  // The continuation does not reference the caller, which may be deleted
+  // before the RPC completes.
+  using Waiters = std::vector<promise<StatusOr<std::string>>>;
+  auto waiters = std::make_shared<Waiters>(std::move(batch.waiters));
+  auto on_completion = std::move(batch.on_completion);
+  auto const start = std::chrono::steady_clock::now();
+  return StartPublish(cq, stub, batch, encoder)
+      .then([waiters, on_completion, start](
+                future<StatusOr<google::pubsub::v1::PublishResponse>> f) {
+        CompletionScope scope;
+        auto response = f.get();
+        // Release any resources before the application sees the results, it
+        // may be waiting for them to publish more messages.
+        if (on_completion) {
+          on_completion(response.status(),
+                        std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - start));
+        }
+        if (!response) {
+          for (auto& w : *waiters) w.set_value(response.status());
+          return response.status();
+        }
+        if (static_cast<std::size_t>(response->message_ids_size()) !=
+            waiters->size()) {
+          auto status =
+              Status(StatusCode::kUnknown,
+                     "mismatched message id count in PublishResponse");
+          for (auto& w : *waiters) w.set_value(status);
+          return status;
+        }
+        for (std::size_t i = 0; i != waiters->size(); ++i) {
+          (*waiters)[i].set_value(std::move(
+              *response->mutable_message_ids(static_cast<int>(i))));
+        }
+        return Status();
+      });
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
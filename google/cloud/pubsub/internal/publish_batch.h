@@ -0,0 +1,95 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_PUBLISH_BATCH_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_PUBLISH_BATCH_H
+
+#include "google/cloud/pubsub/internal/publisher_stub.h"
+#include "google/cloud/pubsub/message.h"
+#include "google/cloud/pubsub/version.h"
+#include "google/cloud/future.h"
+#include "google/cloud/grpc_utils/completion_queue.h"
+#include "google/cloud/status_or.h"
+#include <google/protobuf/arena.h>
+#include <google/pubsub/v1/pubsub.pb.h>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * The messages for a `PublishRequest` and the promises for each of them.
+ *
+ * The messages share their payload with the application, the request is only
+ * created when the batch is sent.
+ */
+struct PublishBatch {
+  std::string topic;
+  std::vector<pubsub::Message> messages;
+  std::vector<promise<StatusOr<std::string>>> waiters;
+  /// If true, the request is sent using gzip compression.
+  bool compress = false;
+  /**
+   * If set, called once the batch completes, before satisfying the promises.
+   *
+   * The arguments are the status and latency of the RPC. Batches that fail
+   * without sending a RPC report a zero latency.
+   */
+  std::function<void(Status const&, std::chrono::microseconds)> on_completion;
+};
+
+/// Create the `PublishRequest` for @p batch, owned by @p arena.
+google::pubsub::v1::PublishRequest* MakePublishRequest(
+    PublishBatch const& batch, google::protobuf::Arena* arena);
+
+/// Satisfy all the promises in @p batch with @p status.
+void FailPublishBatch(PublishBatch batch, Status const& status);
+
+/**
+ * Return true if the current thread is completing a batch.
+ *
+ * The application continuations for the `Publish()` futures run while the
+ * batch is completed, typically in the threads running the completion queue.
+ * Those continuations must not block waiting for other batches to complete.
+ */
+bool InPublishBatchCompletion();
+
+class PublishRequestEncoder;
+
+/**
+ * Send @p batch using an asynchronous RPC.
+ *
+ * If @p encoder is not null the request is serialized with it, and sent using
+ * `PublisherStub::AsyncPublishEncoded()`.
+ *
+ * Once the RPC completes the promises in @p batch are satisfied, with the
+ * server-assigned message ids, or with the error. The returned future is
+ * satisfied after the promises, with the status of the RPC.
+ */
+future<Status> SendPublishBatch(google::cloud::grpc_utils::CompletionQueue& cq,
+                                PublisherStub& stub, PublishBatch batch,
+                                PublishRequestEncoder* encoder);
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_PUBLISH_BATCH_H
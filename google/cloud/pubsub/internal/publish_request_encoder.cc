@@ -0,0 +1,135 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/publish_request_encoder.h"
+#include <google/protobuf/io/coded_stream.h>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+namespace {
+// The tags (field number and wire type) for the fields we encode, all of them
+// are length-delimited.
+char constexpr kRequestTopicTag = (1 << 3) | 2;
+char constexpr kRequestMessagesTag = (2 << 3) | 2;
+char constexpr kMessageDataTag = (1 << 3) | 2;
+char constexpr kMessageAttributesTag = (2 << 3) | 2;
+char constexpr kMessageOrderingKeyTag = (5 << 3) | 2;
+char constexpr kMapKeyTag = (1 << 3) | 2;
+char constexpr kMapValueTag = (2 << 3) | 2;
+
+std::size_t VarintSize(std::size_t v) {
+  return google::protobuf::io::CodedOutputStream::VarintSize64(v);
+}
+
+std::size_t FieldSize(std::size_t length) {
+  return 1 + VarintSize(length) + length;
+}
+
+void AppendVarint(std::string& buffer, std::size_t v) {
+  while (v >= 0x80) {
+    buffer.push_back(static_cast<char>(v | 0x80));
+    v >>= 7;
+  }
+  buffer.push_back(static_cast<char>(v));
+}
+
+void AppendField(std::string& buffer, char tag, std::string const& value) {
+  buffer.push_back(tag);
+  AppendVarint(buffer, value.size());
+  buffer.append(value);
+}
+
+std::size_t AttributeSize(std::string const& key, std::string const& value) {
+  // Map entries always include the key and value fields.
+  return FieldSize(key.size()) + FieldSize(value.size());
+}
+
+std::size_t EncodedSize(pubsub::Message const& m) {
+  std::size_t size = m.data().empty() ? 0 : FieldSize(m.data().size());
+  for (auto const& kv : m.attributes()) {
+    size += FieldSize(AttributeSize(kv.first, kv.second));
+  }
+  if (!m.ordering_key().empty()) size += FieldSize(m.ordering_key().size());
+  return size;
+}
+
+/// Create a slice referencing the payload of @p m, without copying it.
+grpc::Slice SharedPayload(pubsub::Message const& m) {
+  using Payload = std::shared_ptr<std::string const>;
+  auto* payload = new Payload(m.shared_data());
+  return grpc::Slice(
+      const_cast<char*>((*payload)->data()), (*payload)->size(),
+      [](void* p) { delete static_cast<Payload*>(p); }, payload);
+}
+
+grpc::Slice ToSlice(std::string const& buffer) {
+  return grpc::Slice(buffer.data(), buffer.size());
+}
+}  // namespace
+
+std::size_t constexpr PublishRequestEncoder::kMinimumSharedPayload;
+
+grpc::ByteBuffer PublishRequestEncoder::Encode(PublishBatch const& batch) {
+  std::vector<grpc::Slice> slices;
+  slices.push_back(EncodeTopic(batch.topic));
+  // The fields between large payloads are accumulated in `buffer`.
+  std::string buffer;
+  for (auto const& m : batch.messages) {
+    buffer.push_back(kRequestMessagesTag);
+    AppendVarint(buffer, EncodedSize(m));
+    auto const& data = m.data();
+    if (!data.empty()) {
+      buffer.push_back(kMessageDataTag);
+      AppendVarint(buffer, data.size());
+      if (data.size() < kMinimumSharedPayload) {
+        buffer.append(data);
+      } else {
+        slices.push_back(ToSlice(buffer));
+        slices.push_back(SharedPayload(m));
+        buffer.clear();
+      }
+    }
+    for (auto const& kv : m.attributes()) {
+      buffer.push_back(kMessageAttributesTag);
+      AppendVarint(buffer, AttributeSize(kv.first, kv.second));
+      AppendField(buffer, kMapKeyTag, kv.first);
+      AppendField(buffer, kMapValueTag, kv.second);
+    }
+    if (!m.ordering_key().empty()) {
+      AppendField(buffer, kMessageOrderingKeyTag, m.ordering_key());
+    }
+  }
+  if (!buffer.empty()) slices.push_back(ToSlice(buffer));
+  return grpc::ByteBuffer(slices.data(), slices.size());
+}
+
+grpc::Slice PublishRequestEncoder::EncodeTopic(std::string const& topic) {
+  auto last = std::atomic_load(&last_topic_);
+  if (last && last->topic == topic) return last->prefix;
+  std::string buffer;
+  AppendField(buffer, kRequestTopicTag, topic);
+  auto prefix = ToSlice(buffer);
+  std::atomic_store(&last_topic_, std::shared_ptr<TopicPrefix const>(
+                                      new TopicPrefix{topic, prefix}));
+  return prefix;
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
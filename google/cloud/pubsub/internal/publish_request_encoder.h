@@ -0,0 +1,75 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_PUBLISH_REQUEST_ENCODER_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_PUBLISH_REQUEST_ENCODER_H
+
+#include "google/cloud/pubsub/internal/publish_batch.h"
+#include "google/cloud/pubsub/version.h"
+#include <grpcpp/support/byte_buffer.h>
+#include <grpcpp/support/slice.h>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Serialize `PublishBatch` objects in the `PublishRequest` wire format.
+ *
+ * The encoded topic field of the most recent topic is cached, each request
+ * for that topic references the same slice. Publishers typically use a single
+ * topic, keeping one entry bounds the memory used by the cache, and a
+ * publisher alternating between topics only pays for a small copy.
+ * Message payloads of at least `kMinimumSharedPayload` bytes are not copied,
+ * the buffer holds a reference to the (immutable) payload of the message.
+ * Smaller payloads are copied, a separate slice for them is more expensive
+ * than the copy.
+ *
+ * The output-only fields in the messages (`message_id` and `publish_time`)
+ * are ignored by the service, they are not encoded.
+ *
+ * This class is thread-safe.
+ */
+class PublishRequestEncoder {
+ public:
+  static std::size_t constexpr kMinimumSharedPayload = 1024;
+
+  PublishRequestEncoder() = default;
+
+  /// Serialize @p batch.
+  grpc::ByteBuffer Encode(PublishBatch const& batch);
+
+ private:
+  struct TopicPrefix {
+    std::string topic;
+    grpc::Slice prefix;
+  };
+
+  grpc::Slice EncodeTopic(std::string const& topic);
+
+  // Accessed with `std::atomic_load()` and `std::atomic_store()`, encoding a
+  // batch never blocks on other threads.
+  std::shared_ptr<TopicPrefix const> last_topic_;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_PUBLISH_REQUEST_ENCODER_H
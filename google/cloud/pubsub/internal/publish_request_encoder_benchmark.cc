@@ -0,0 +1,77 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/arena_pool.h"
+#include "google/cloud/pubsub/internal/publish_batch.h"
+#include "google/cloud/pubsub/internal/publish_request_encoder.h"
+#include <benchmark/benchmark.h>
+#include <grpcpp/impl/codegen/proto_utils.h>
+#include <string>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+// Compare the cost of serializing a PublishRequest via the generated proto
+// against the direct encoding.
+//
+// Run with:
+//   publish_request_encoder_benchmark --benchmark_counters_tabular=true
+//
+// Each batch has 100 messages, the argument is the payload size.
+
+PublishBatch MakeBatch(std::size_t payload_size) {
+  PublishBatch batch;
+  batch.topic = "projects/test-project/topics/test-topic";
+  for (int i = 0; i != 100; ++i) {
+    batch.messages.push_back(pubsub::MessageBuilder{}
+                                 .SetData(std::string(payload_size, 'x'))
+                                 .InsertAttribute("key", "value")
+                                 .Build());
+  }
+  return batch;
+}
+
+void BM_EncodeViaProto(benchmark::State& state) {
+  auto const batch = MakeBatch(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    auto arena = DefaultArenaPool().Acquire();
+    auto const* request = MakePublishRequest(batch, arena.get());
+    grpc::ByteBuffer buffer;
+    bool own_buffer;
+    benchmark::DoNotOptimize(
+        grpc::SerializationTraits<google::pubsub::v1::PublishRequest>::
+            Serialize(*request, &buffer, &own_buffer));
+  }
+  state.SetItemsProcessed(state.iterations() * batch.messages.size());
+}
+BENCHMARK(BM_EncodeViaProto)->Range(128, 64 * 1024);
+
+void BM_EncodeDirect(benchmark::State& state) {
+  auto const batch = MakeBatch(static_cast<std::size_t>(state.range(0)));
+  PublishRequestEncoder encoder;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(encoder.Encode(batch));
+  }
+  state.SetItemsProcessed(state.iterations() * batch.messages.size());
+}
+BENCHMARK(BM_EncodeDirect)->Range(128, 64 * 1024);
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
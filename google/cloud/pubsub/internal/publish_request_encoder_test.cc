@@ -0,0 +1,113 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/publish_request_encoder.h"
+#include "google/cloud/testing_util/is_proto_equal.h"
+#include <grpcpp/impl/codegen/proto_utils.h>
+#include <gmock/gmock.h>
+#include <algorithm>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using ::google::cloud::testing_util::IsProtoEqual;
+
+google::pubsub::v1::PublishRequest Parse(grpc::ByteBuffer buffer) {
+  google::pubsub::v1::PublishRequest request;
+  auto status = grpc::SerializationTraits<
+      google::pubsub::v1::PublishRequest>::Deserialize(&buffer, &request);
+  EXPECT_TRUE(status.ok());
+  return request;
+}
+
+PublishBatch MakeBatch(std::string topic) {
+  PublishBatch batch;
+  batch.topic = std::move(topic);
+  batch.messages.push_back(pubsub::MessageBuilder{}.SetData("m0").Build());
+  batch.messages.push_back(pubsub::MessageBuilder{}
+                               .SetData(std::string(5000, 'x'))
+                               .InsertAttribute("k0", "v0")
+                               .InsertAttribute("", "")
+                               .SetOrderingKey("key")
+                               .Build());
+  batch.messages.push_back(pubsub::MessageBuilder{}
+                               .InsertAttribute("k1", std::string(200, 'v'))
+                               .Build());
+  batch.messages.emplace_back();
+  return batch;
+}
+
+TEST(PublishRequestEncoderTest, MatchesProto) {
+  PublishRequestEncoder encoder;
+  auto const batch = MakeBatch("projects/p/topics/t");
+  google::protobuf::Arena arena;
+  auto const& expected = *MakePublishRequest(batch, &arena);
+  auto const actual = Parse(encoder.Encode(batch));
+  EXPECT_THAT(actual, IsProtoEqual(expected));
+}
+
+TEST(PublishRequestEncoderTest, SharesLargePayloads) {
+  PublishRequestEncoder encoder;
+  auto const batch = MakeBatch("projects/p/topics/t");
+  auto const& payload = batch.messages[1].data();
+  auto buffer = encoder.Encode(batch);
+  std::vector<grpc::Slice> slices;
+  ASSERT_TRUE(buffer.Dump(&slices).ok());
+  auto match = [&payload](grpc::Slice const& s) {
+    return static_cast<void const*>(s.begin()) == payload.data();
+  };
+  EXPECT_EQ(1, std::count_if(slices.begin(), slices.end(), match));
+  // The buffer holds a reference to the payload.
+  EXPECT_LT(1, batch.messages[1].shared_data().use_count());
+}
+
+TEST(PublishRequestEncoderTest, ReusesTopicPrefix) {
+  PublishRequestEncoder encoder;
+  auto first_slice = [&encoder](std::string const& topic) {
+    std::vector<grpc::Slice> slices;
+    EXPECT_TRUE(encoder.Encode(MakeBatch(topic)).Dump(&slices).ok());
+    return slices.empty() ? grpc::Slice() : slices.front();
+  };
+  // Use long names, gRPC copies small slices instead of sharing them.
+  std::string const topic0 = "projects/test-project/topics/test-topic-0";
+  std::string const topic1 = "projects/test-project/topics/test-topic-1";
+  auto const t0 = first_slice(topic0);
+  EXPECT_EQ(t0.begin(), first_slice(topic0).begin());
+  // Only the most recent topic is cached.
+  auto const t1 = first_slice(topic1);
+  EXPECT_NE(t0.begin(), t1.begin());
+  EXPECT_EQ(t1.begin(), first_slice(topic1).begin());
+}
+
+TEST(PublishRequestEncoderTest, MultipleTopics) {
+  PublishRequestEncoder encoder;
+  for (auto const* topic : {"projects/p/topics/t0", "projects/p/topics/t1",
+                            "projects/p/topics/t0"}) {
+    SCOPED_TRACE("Testing with topic " + std::string(topic));
+    auto const batch = MakeBatch(topic);
+    auto const actual = Parse(encoder.Encode(batch));
+    EXPECT_EQ(topic, actual.topic());
+    google::protobuf::Arena arena;
+    EXPECT_THAT(actual, IsProtoEqual(*MakePublishRequest(batch, &arena)));
+  }
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,131 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/publisher_channel_pool.h"
+#include <algorithm>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+PublisherChannelPool::PublisherChannelPool(
+    std::size_t size, LazyStubs<PublisherStub>::Factory factory,
+    std::shared_ptr<HedgeDelay> list_hedge_delay)
+    : children_(size, std::move(factory)),
+      selector_(std::make_shared<ChannelSelector>(children_.size())),
+      list_hedge_delay_(std::move(list_hedge_delay)) {}
+
+PublisherChannelPool::PublisherChannelPool(
+    std::vector<std::shared_ptr<PublisherStub>> children,
+    std::shared_ptr<HedgeDelay> list_hedge_delay)
+    : children_(std::move(children)),
+      selector_(std::make_shared<ChannelSelector>(children_.size())),
+      list_hedge_delay_(std::move(list_hedge_delay)) {}
+
+StatusOr<google::pubsub::v1::Topic> PublisherChannelPool::CreateTopic(
+    grpc::ClientContext& client_context,
+    google::pubsub::v1::Topic const& request) {
+  auto const channel = selector_->Acquire();
+  auto response = children_[channel].CreateTopic(client_context, request);
+  selector_->Release(channel);
+  return response;
+}
+
+StatusOr<google::pubsub::v1::ListTopicsResponse>
+PublisherChannelPool::ListTopics(
+    grpc::ClientContext& client_context,
+    google::pubsub::v1::ListTopicsRequest const& request) {
+  auto const channel = selector_->Acquire();
+  auto response = children_[channel].ListTopics(client_context, request);
+  selector_->Release(channel);
+  return response;
+}
+
+future<StatusOr<google::pubsub::v1::ListTopicsResponse>>
+PublisherChannelPool::AsyncListTopics(
+    google::cloud::grpc_utils::CompletionQueue& cq,
+    std::unique_ptr<grpc::ClientContext> client_context,
+    google::pubsub::v1::ListTopicsRequest const& request) {
+  if (list_hedge_delay_) {
+    return AsyncHedgedCall<google::pubsub::v1::ListTopicsResponse>(
+        selector_, list_hedge_delay_, MakeHedgeTimer(cq),
+        std::move(client_context),
+        [this, cq, request](
+            std::size_t channel,
+            std::unique_ptr<grpc::ClientContext> context) mutable {
+          return children_[channel].AsyncListTopics(cq, std::move(context),
+                                                    request);
+        });
+  }
+  auto const channel = selector_->Acquire();
+  return ReleaseOnCompletion(
+      selector_, channel,
+      children_[channel].AsyncListTopics(cq, std::move(client_context),
+                                         request));
+}
+
+Status PublisherChannelPool::DeleteTopic(
+    grpc::ClientContext& client_context,
+    google::pubsub::v1::DeleteTopicRequest const& request) {
+  auto const channel = selector_->Acquire();
+  auto response = children_[channel].DeleteTopic(client_context, request);
+  selector_->Release(channel);
+  return response;
+}
+
+future<StatusOr<google::pubsub::v1::PublishResponse>>
+PublisherChannelPool::AsyncPublish(
+    google::cloud::grpc_utils::CompletionQueue& cq,
+    std::unique_ptr<grpc::ClientContext> client_context,
+    google::pubsub::v1::PublishRequest const& request) {
+  auto const channel = selector_->Acquire();
+  return ReleaseOnCompletion(
+      selector_, channel,
+      children_[channel].AsyncPublish(cq, std::move(client_context),
+                                      request));
+}
+
+future<StatusOr<google::pubsub::v1::PublishResponse>>
+PublisherChannelPool::AsyncPublishEncoded(
+    google::cloud::grpc_utils::CompletionQueue& cq,
+    std::unique_ptr<grpc::ClientContext> client_context,
+    grpc::ByteBuffer const& request) {
+  auto const channel = selector_->Acquire();
+  return ReleaseOnCompletion(
+      selector_, channel,
+      children_[channel].AsyncPublishEncoded(cq, std::move(client_context),
+                                             request));
+}
+
+future<Status> PublisherChannelPool::AsyncWaitForConnected(
+    google::cloud::grpc_utils::CompletionQueue& cq,
+    std::chrono::system_clock::time_point deadline) {
+  return children_.AsyncWaitForConnected(cq, deadline);
+}
+
+std::shared_ptr<PublisherChannelPool> CreateDefaultPublisherStubPool(
+    pubsub::ConnectionOptions const& options,
+    std::shared_ptr<HedgeDelay> list_hedge_delay) {
+  auto const count = (std::max)(1, options.num_channels());
+  return std::make_shared<PublisherChannelPool>(
+      count,
+      [options](int id) { return CreateDefaultPublisherStub(options, id); },
+      std::move(list_hedge_delay));
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,122 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_PUBLISHER_CHANNEL_POOL_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_PUBLISHER_CHANNEL_POOL_H
+
+#include "google/cloud/pubsub/internal/channel_selector.h"
+#include "google/cloud/pubsub/internal/hedging.h"
+#include "google/cloud/pubsub/internal/lazy_stubs.h"
+#include "google/cloud/pubsub/internal/publisher_stub.h"
+#include "google/cloud/pubsub/connection_options.h"
+#include "google/cloud/pubsub/version.h"
+#include <memory>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * A `PublisherStub` decorator spreading the calls over a pool of stubs.
+ *
+ * Each child stub uses a different channel, and therefore a different HTTP/2
+ * connection. A single connection limits the number of concurrent streams,
+ * and its throughput, long before the client runs out of CPU. Each call uses
+ * the least loaded of two randomly sampled children, see `ChannelSelector`.
+ *
+ * With message ordering the batches for an ordering key are sent one at a
+ * time, so spreading them over different connections does not reorder them.
+ *
+ * With a `HedgeDelay`, each `AsyncListTopics()` call taking longer than the
+ * hedge delay is duplicated on a different channel, and the first response
+ * wins.
+ * Listing is read-only, so the duplicate is safe, and it cuts the tail
+ * latency when a single connection (or the backend serving it) is slow.
+ */
+class PublisherChannelPool : public PublisherStub {
+ public:
+  /**
+   * Create @p size children on first use, using @p factory.
+   *
+   * If @p list_hedge_delay is not null, hedge the `AsyncListTopics()` calls.
+   */
+  PublisherChannelPool(std::size_t size,
+                       LazyStubs<PublisherStub>::Factory factory,
+                       std::shared_ptr<HedgeDelay> list_hedge_delay = {});
+  explicit PublisherChannelPool(
+      std::vector<std::shared_ptr<PublisherStub>> children,
+      std::shared_ptr<HedgeDelay> list_hedge_delay = {});
+  ~PublisherChannelPool() override = default;
+
+  StatusOr<google::pubsub::v1::Topic> CreateTopic(
+      grpc::ClientContext& client_context,
+      google::pubsub::v1::Topic const& request) override;
+
+  StatusOr<google::pubsub::v1::ListTopicsResponse> ListTopics(
+      grpc::ClientContext& client_context,
+      google::pubsub::v1::ListTopicsRequest const& request) override;
+
+  future<StatusOr<google::pubsub::v1::ListTopicsResponse>> AsyncListTopics(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::unique_ptr<grpc::ClientContext> client_context,
+      google::pubsub::v1::ListTopicsRequest const& request) override;
+
+  Status DeleteTopic(
+      grpc::ClientContext& client_context,
+      google::pubsub::v1::DeleteTopicRequest const& request) override;
+
+  future<StatusOr<google::pubsub::v1::PublishResponse>> AsyncPublish(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::unique_ptr<grpc::ClientContext> client_context,
+      google::pubsub::v1::PublishRequest const& request) override;
+
+  future<StatusOr<google::pubsub::v1::PublishResponse>> AsyncPublishEncoded(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::unique_ptr<grpc::ClientContext> client_context,
+      grpc::ByteBuffer const& request) override;
+
+  /// Create all the children and connect their channels in parallel.
+  future<Status> AsyncWaitForConnected(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::chrono::system_clock::time_point deadline) override;
+
+  /// The number of RPCs in flight on each channel.
+  std::vector<std::size_t> in_flight() const { return selector_->in_flight(); }
+
+ private:
+  LazyStubs<PublisherStub> children_;
+  std::shared_ptr<ChannelSelector> selector_;
+  std::shared_ptr<HedgeDelay> list_hedge_delay_;
+};
+
+/**
+ * Create a pool of `options.num_channels()` default stubs.
+ *
+ * Each stub uses a different channel id, and the returned stub spreads the
+ * calls over them. The stubs, and their channels, are created on first use,
+ * call `AsyncWaitForConnected()` to create and connect all of them. The
+ * `AsyncListTopics()` calls are hedged if @p list_hedge_delay is not null.
+ */
+std::shared_ptr<PublisherChannelPool> CreateDefaultPublisherStubPool(
+    pubsub::ConnectionOptions const& options,
+    std::shared_ptr<HedgeDelay> list_hedge_delay = {});
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_PUBLISHER_CHANNEL_POOL_H
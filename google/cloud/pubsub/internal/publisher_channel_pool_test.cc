@@ -0,0 +1,199 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/publisher_channel_pool.h"
+#include "google/cloud/pubsub/internal/background_threads.h"
+#include "google/cloud/pubsub/testing/mock_publisher_stub.h"
+#include "google/cloud/internal/make_unique.h"
+#include <gmock/gmock.h>
+#include <atomic>
+#include <mutex>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::InvokeWithoutArgs;
+using ::testing::Return;
+using ::testing::UnorderedElementsAre;
+
+std::vector<std::shared_ptr<pubsub_testing::MockPublisherStub>> MakeMocks(
+    std::size_t count) {
+  std::vector<std::shared_ptr<pubsub_testing::MockPublisherStub>> mocks(count);
+  for (auto& m : mocks) {
+    m = std::make_shared<pubsub_testing::MockPublisherStub>();
+  }
+  return mocks;
+}
+
+std::vector<std::shared_ptr<PublisherStub>> AsChildren(
+    std::vector<std::shared_ptr<pubsub_testing::MockPublisherStub>> const&
+        mocks) {
+  return {mocks.begin(), mocks.end()};
+}
+
+TEST(PublisherChannelPoolTest, AdminOperations) {
+  auto mocks = MakeMocks(3);
+  int calls = 0;
+  for (auto& m : mocks) {
+    EXPECT_CALL(*m, CreateTopic).WillRepeatedly(InvokeWithoutArgs([&calls] {
+      ++calls;
+      return StatusOr<google::pubsub::v1::Topic>(google::pubsub::v1::Topic{});
+    }));
+    EXPECT_CALL(*m, ListTopics).WillRepeatedly(InvokeWithoutArgs([&calls] {
+      ++calls;
+      return StatusOr<google::pubsub::v1::ListTopicsResponse>(
+          google::pubsub::v1::ListTopicsResponse{});
+    }));
+    EXPECT_CALL(*m, DeleteTopic).WillRepeatedly(InvokeWithoutArgs([&calls] {
+      ++calls;
+      return Status{};
+    }));
+  }
+  PublisherChannelPool stub(AsChildren(mocks));
+  for (int i = 0; i != 4; ++i) {
+    grpc::ClientContext c0;
+    EXPECT_TRUE(stub.CreateTopic(c0, {}).ok());
+    grpc::ClientContext c1;
+    EXPECT_TRUE(stub.ListTopics(c1, {}).ok());
+    grpc::ClientContext c2;
+    EXPECT_TRUE(stub.DeleteTopic(c2, {}).ok());
+  }
+  EXPECT_EQ(12, calls);
+  EXPECT_THAT(stub.in_flight(), ElementsAre(0, 0, 0));
+}
+
+TEST(PublisherChannelPoolTest, AsyncPublishAvoidsBusyChannel) {
+  using Response = StatusOr<google::pubsub::v1::PublishResponse>;
+  auto mocks = MakeMocks(2);
+  std::vector<promise<Response>> pending;
+  pending.reserve(2);
+  auto make_pending = [&pending] {
+    pending.emplace_back();
+    return pending.back().get_future();
+  };
+  // With one call in flight on a channel the next call must use the other
+  // channel.
+  for (auto& m : mocks) {
+    EXPECT_CALL(*m, AsyncPublish).WillOnce(InvokeWithoutArgs(make_pending));
+  }
+  PublisherChannelPool stub(AsChildren(mocks));
+  google::cloud::grpc_utils::CompletionQueue cq;
+  using google::cloud::internal::make_unique;
+  auto r0 = stub.AsyncPublish(cq, make_unique<grpc::ClientContext>(), {});
+  auto r1 = stub.AsyncPublish(cq, make_unique<grpc::ClientContext>(), {});
+  EXPECT_THAT(stub.in_flight(), ElementsAre(1, 1));
+
+  pending[0].set_value(Response(google::pubsub::v1::PublishResponse{}));
+  EXPECT_TRUE(r0.get().ok());
+  pending[1].set_value(Response(google::pubsub::v1::PublishResponse{}));
+  EXPECT_TRUE(r1.get().ok());
+  EXPECT_THAT(stub.in_flight(), ElementsAre(0, 0));
+}
+
+TEST(PublisherChannelPoolTest, AsyncPublishEncoded) {
+  using Response = StatusOr<google::pubsub::v1::PublishResponse>;
+  auto mocks = MakeMocks(2);
+  promise<Response> pending;
+  EXPECT_CALL(*mocks[0], AsyncPublishEncoded)
+      .WillRepeatedly(InvokeWithoutArgs([&pending] {
+        return pending.get_future();
+      }));
+  EXPECT_CALL(*mocks[1], AsyncPublishEncoded)
+      .WillRepeatedly(InvokeWithoutArgs([&pending] {
+        return pending.get_future();
+      }));
+  PublisherChannelPool stub(AsChildren(mocks));
+  google::cloud::grpc_utils::CompletionQueue cq;
+  auto r = stub.AsyncPublishEncoded(
+      cq, google::cloud::internal::make_unique<grpc::ClientContext>(), {});
+  auto in_flight = stub.in_flight();
+  EXPECT_EQ(1U, in_flight[0] + in_flight[1]);
+  pending.set_value(Response(Status(StatusCode::kUnavailable, "try-again")));
+  EXPECT_EQ(StatusCode::kUnavailable, r.get().status().code());
+  EXPECT_THAT(stub.in_flight(), ElementsAre(0, 0));
+}
+
+TEST(PublisherChannelPoolTest, ListTopicsHedged) {
+  using Response = StatusOr<google::pubsub::v1::ListTopicsResponse>;
+  auto mocks = MakeMocks(2);
+  // The first call does not complete until the test satisfies `slow`, the
+  // hedge on the other channel completes immediately.
+  promise<Response> slow;
+  std::atomic<int> calls(0);
+  for (auto& m : mocks) {
+    EXPECT_CALL(*m, AsyncListTopics)
+        .WillRepeatedly(InvokeWithoutArgs([&calls, &slow] {
+          if (calls.fetch_add(1) == 0) return slow.get_future();
+          google::pubsub::v1::ListTopicsResponse response;
+          response.add_topics()->set_name("topics/hedged");
+          return make_ready_future(Response(std::move(response)));
+        }));
+  }
+  auto delay = std::make_shared<HedgeDelay>();
+  for (int i = 0; i != 16; ++i) delay->Record(std::chrono::milliseconds(10));
+  PublisherChannelPool stub(AsChildren(mocks), delay);
+  BackgroundThreads background(1);
+  auto cq = background.cq();
+  auto response =
+      stub.AsyncListTopics(
+              cq, google::cloud::internal::make_unique<grpc::ClientContext>(),
+              {})
+          .get();
+  ASSERT_TRUE(response.ok());
+  ASSERT_EQ(1, response->topics_size());
+  EXPECT_EQ("topics/hedged", response->topics(0).name());
+  EXPECT_EQ(2, calls.load());
+  // The slow call is still in flight.
+  EXPECT_THAT(stub.in_flight(), UnorderedElementsAre(0, 1));
+
+  slow.set_value(Response(Status(StatusCode::kCancelled, "cancelled")));
+  EXPECT_THAT(stub.in_flight(), ElementsAre(0, 0));
+}
+
+TEST(PublisherChannelPoolTest, LazyCreation) {
+  // The children are created by `AsyncWaitForConnected()`.
+  std::mutex mu;
+  std::vector<int> created;
+  PublisherChannelPool stub(3, [&mu, &created](int id) {
+    std::lock_guard<std::mutex> lk(mu);
+    created.push_back(id);
+    auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+    EXPECT_CALL(*mock, DeleteTopic).WillRepeatedly(Return(Status{}));
+    EXPECT_CALL(*mock, AsyncWaitForConnected).WillOnce(InvokeWithoutArgs([] {
+      return make_ready_future(Status{});
+    }));
+    return mock;
+  });
+  EXPECT_TRUE(created.empty());
+  grpc::ClientContext context;
+  EXPECT_TRUE(stub.DeleteTopic(context, {}).ok());
+  EXPECT_EQ(1U, created.size());
+
+  // Connecting the pool creates all the remaining children.
+  google::cloud::grpc_utils::CompletionQueue cq;
+  auto status =
+      stub.AsyncWaitForConnected(cq, std::chrono::system_clock::now()).get();
+  EXPECT_TRUE(status.ok());
+  EXPECT_EQ(3U, created.size());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
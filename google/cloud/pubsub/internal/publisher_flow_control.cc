@@ -0,0 +1,68 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/publisher_flow_control.h"
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+bool PublisherFlowControl::TryAcquire(std::size_t bytes) {
+  std::lock_guard<std::mutex> lk(mu_);
+  if (!Fits(bytes)) return false;
+  ++messages_;
+  bytes_ += bytes;
+  return true;
+}
+
+void PublisherFlowControl::Acquire(std::size_t bytes) {
+  std::unique_lock<std::mutex> lk(mu_);
+  cv_.wait(lk, [this, bytes] { return Fits(bytes); });
+  ++messages_;
+  bytes_ += bytes;
+}
+
+void PublisherFlowControl::Release(std::size_t messages, std::size_t bytes) {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    messages_ -= messages;
+    bytes_ -= bytes;
+  }
+  cv_.notify_all();
+}
+
+pubsub::PublisherCapacity PublisherFlowControl::Capacity() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  pubsub::PublisherCapacity capacity;
+  capacity.pending_messages = messages_;
+  capacity.pending_bytes = bytes_;
+  capacity.available_messages =
+      messages_ >= maximum_messages_ ? 0 : maximum_messages_ - messages_;
+  capacity.available_bytes =
+      bytes_ >= maximum_bytes_ ? 0 : maximum_bytes_ - bytes_;
+  return capacity;
+}
+
+bool PublisherFlowControl::Fits(std::size_t bytes) const {
+  if (messages_ == 0) return true;
+  // Written to avoid overflows when the limits are the maximum values.
+  return messages_ < maximum_messages_ && bytes_ <= maximum_bytes_ &&
+         bytes <= maximum_bytes_ - bytes_;
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,69 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_PUBLISHER_FLOW_CONTROL_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_PUBLISHER_FLOW_CONTROL_H
+
+#include "google/cloud/pubsub/publisher_capacity.h"
+#include "google/cloud/pubsub/version.h"
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Track the number of pending messages and bytes in a publisher.
+ *
+ * A message is admitted if it fits in both limits. To make progress with
+ * messages larger than the byte limit, a message is always admitted if there
+ * are no other pending messages.
+ */
+class PublisherFlowControl {
+ public:
+  PublisherFlowControl(std::size_t maximum_messages, std::size_t maximum_bytes)
+      : maximum_messages_(maximum_messages), maximum_bytes_(maximum_bytes) {}
+
+  /// Admit a message of @p bytes if it fits, returns false otherwise.
+  bool TryAcquire(std::size_t bytes);
+
+  /// Block until a message of @p bytes fits, then admit it.
+  void Acquire(std::size_t bytes);
+
+  /// Release @p messages pending messages, with @p bytes in total.
+  void Release(std::size_t messages, std::size_t bytes);
+
+  /// The current state.
+  pubsub::PublisherCapacity Capacity() const;
+
+ private:
+  bool Fits(std::size_t bytes) const;
+
+  std::size_t const maximum_messages_;
+  std::size_t const maximum_bytes_;
+  mutable std::mutex mu_;
+  std::condition_variable cv_;
+  std::size_t messages_ = 0;
+  std::size_t bytes_ = 0;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_PUBLISHER_FLOW_CONTROL_H
@@ -0,0 +1,72 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/publisher_flow_control.h"
+#include <gmock/gmock.h>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+TEST(PublisherFlowControlTest, MessageLimit) {
+  PublisherFlowControl tested(2, 1000);
+  EXPECT_TRUE(tested.TryAcquire(10));
+  EXPECT_TRUE(tested.TryAcquire(10));
+  EXPECT_FALSE(tested.TryAcquire(10));
+  tested.Release(1, 10);
+  EXPECT_TRUE(tested.TryAcquire(10));
+}
+
+TEST(PublisherFlowControlTest, ByteLimit) {
+  PublisherFlowControl tested(100, 100);
+  EXPECT_TRUE(tested.TryAcquire(60));
+  EXPECT_FALSE(tested.TryAcquire(50));
+  EXPECT_TRUE(tested.TryAcquire(40));
+  tested.Release(2, 100);
+  // A large message is admitted if nothing else is pending.
+  EXPECT_TRUE(tested.TryAcquire(500));
+  EXPECT_FALSE(tested.TryAcquire(1));
+}
+
+TEST(PublisherFlowControlTest, Capacity) {
+  PublisherFlowControl tested(10, 100);
+  ASSERT_TRUE(tested.TryAcquire(30));
+  ASSERT_TRUE(tested.TryAcquire(20));
+  auto c = tested.Capacity();
+  EXPECT_EQ(2U, c.pending_messages);
+  EXPECT_EQ(50U, c.pending_bytes);
+  EXPECT_EQ(8U, c.available_messages);
+  EXPECT_EQ(50U, c.available_bytes);
+}
+
+TEST(PublisherFlowControlTest, AcquireBlocks) {
+  PublisherFlowControl tested(1, 100);
+  ASSERT_TRUE(tested.TryAcquire(10));
+  std::thread t([&tested] { tested.Acquire(10); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_EQ(1U, tested.Capacity().pending_messages);
+  tested.Release(1, 10);
+  t.join();
+  EXPECT_EQ(1U, tested.Capacity().pending_messages);
+  EXPECT_EQ(10U, tested.Capacity().pending_bytes);
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
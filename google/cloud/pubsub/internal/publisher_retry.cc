@@ -0,0 +1,122 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/publisher_retry.h"
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+namespace {
+using Operation = pubsub::IdempotencyPolicy::Operation;
+}  // namespace
+
+StatusOr<google::pubsub::v1::Topic> PublisherRetry::CreateTopic(
+    grpc::ClientContext& client_context,
+    google::pubsub::v1::Topic const& request) {
+  auto& child = *child_;
+  return RetryLoop(
+      policies_, Operation::kCreateTopic,
+      [&child](grpc::ClientContext& context,
+               google::pubsub::v1::Topic const& request) {
+        return child.CreateTopic(context, request);
+      },
+      client_context, request);
+}
+
+StatusOr<google::pubsub::v1::ListTopicsResponse> PublisherRetry::ListTopics(
+    grpc::ClientContext& client_context,
+    google::pubsub::v1::ListTopicsRequest const& request) {
+  auto& child = *child_;
+  return RetryLoop(
+      policies_, Operation::kListTopics,
+      [&child](grpc::ClientContext& context,
+               google::pubsub::v1::ListTopicsRequest const& request) {
+        return child.ListTopics(context, request);
+      },
+      client_context, request);
+}
+
+future<StatusOr<google::pubsub::v1::ListTopicsResponse>>
+PublisherRetry::AsyncListTopics(
+    google::cloud::grpc_utils::CompletionQueue& cq,
+    std::unique_ptr<grpc::ClientContext> client_context,
+    google::pubsub::v1::ListTopicsRequest const& request) {
+  auto child = child_;
+  return AsyncRetryLoop(
+      policies_, Operation::kListTopics,
+      [child](google::cloud::grpc_utils::CompletionQueue& cq,
+              std::unique_ptr<grpc::ClientContext> context,
+              google::pubsub::v1::ListTopicsRequest const& request) {
+        return child->AsyncListTopics(cq, std::move(context), request);
+      },
+      cq, std::move(client_context), request);
+}
+
+Status PublisherRetry::DeleteTopic(
+    grpc::ClientContext& client_context,
+    google::pubsub::v1::DeleteTopicRequest const& request) {
+  auto& child = *child_;
+  return RetryLoop(
+      policies_, Operation::kDeleteTopic,
+      [&child](grpc::ClientContext& context,
+               google::pubsub::v1::DeleteTopicRequest const& request) {
+        return child.DeleteTopic(context, request);
+      },
+      client_context, request);
+}
+
+future<StatusOr<google::pubsub::v1::PublishResponse>>
+PublisherRetry::AsyncPublish(
+    google::cloud::grpc_utils::CompletionQueue& cq,
+    std::unique_ptr<grpc::ClientContext> client_context,
+    google::pubsub::v1::PublishRequest const& request) {
+  auto child = child_;
+  return AsyncRetryLoop(
+      policies_, Operation::kPublish,
+      [child](google::cloud::grpc_utils::CompletionQueue& cq,
+              std::unique_ptr<grpc::ClientContext> context,
+              google::pubsub::v1::PublishRequest const& request) {
+        return child->AsyncPublish(cq, std::move(context), request);
+      },
+      cq, std::move(client_context), request);
+}
+
+future<StatusOr<google::pubsub::v1::PublishResponse>>
+PublisherRetry::AsyncPublishEncoded(
+    google::cloud::grpc_utils::CompletionQueue& cq,
+    std::unique_ptr<grpc::ClientContext> client_context,
+    grpc::ByteBuffer const& request) {
+  auto child = child_;
+  return AsyncRetryLoop(
+      policies_, Operation::kPublish,
+      [child](google::cloud::grpc_utils::CompletionQueue& cq,
+              std::unique_ptr<grpc::ClientContext> context,
+              grpc::ByteBuffer const& request) {
+        return child->AsyncPublishEncoded(cq, std::move(context), request);
+      },
+      cq, std::move(client_context), request);
+}
+
+future<Status> PublisherRetry::AsyncWaitForConnected(
+    google::cloud::grpc_utils::CompletionQueue& cq,
+    std::chrono::system_clock::time_point deadline) {
+  return child_->AsyncWaitForConnected(cq, deadline);
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,81 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_PUBLISHER_RETRY_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_PUBLISHER_RETRY_H
+
+#include "google/cloud/pubsub/internal/publisher_stub.h"
+#include "google/cloud/pubsub/internal/retry_loop.h"
+#include "google/cloud/pubsub/version.h"
+#include <memory>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * A `PublisherStub` decorator retrying the failed calls.
+ *
+ * Each call is retried according to the `RetryPolicies`. Placed above the
+ * channel pool, so each retry may use a different channel.
+ */
+class PublisherRetry : public PublisherStub {
+ public:
+  PublisherRetry(std::shared_ptr<PublisherStub> child, RetryPolicies policies)
+      : child_(std::move(child)), policies_(std::move(policies)) {}
+  ~PublisherRetry() override = default;
+
+  StatusOr<google::pubsub::v1::Topic> CreateTopic(
+      grpc::ClientContext& client_context,
+      google::pubsub::v1::Topic const& request) override;
+
+  StatusOr<google::pubsub::v1::ListTopicsResponse> ListTopics(
+      grpc::ClientContext& client_context,
+      google::pubsub::v1::ListTopicsRequest const& request) override;
+
+  future<StatusOr<google::pubsub::v1::ListTopicsResponse>> AsyncListTopics(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::unique_ptr<grpc::ClientContext> client_context,
+      google::pubsub::v1::ListTopicsRequest const& request) override;
+
+  Status DeleteTopic(
+      grpc::ClientContext& client_context,
+      google::pubsub::v1::DeleteTopicRequest const& request) override;
+
+  future<StatusOr<google::pubsub::v1::PublishResponse>> AsyncPublish(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::unique_ptr<grpc::ClientContext> client_context,
+      google::pubsub::v1::PublishRequest const& request) override;
+
+  future<StatusOr<google::pubsub::v1::PublishResponse>> AsyncPublishEncoded(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::unique_ptr<grpc::ClientContext> client_context,
+      grpc::ByteBuffer const& request) override;
+
+  future<Status> AsyncWaitForConnected(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::chrono::system_clock::time_point deadline) override;
+
+ private:
+  std::shared_ptr<PublisherStub> child_;
+  RetryPolicies policies_;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_PUBLISHER_RETRY_H
@@ -0,0 +1,177 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/publisher_retry.h"
+#include "google/cloud/pubsub/internal/background_threads.h"
+#include "google/cloud/pubsub/testing/mock_publisher_stub.h"
+#include <gmock/gmock.h>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Invoke;
+using ::testing::InvokeWithoutArgs;
+using ::testing::Return;
+
+RetryPolicies TestPolicies(pubsub::IdempotencyPolicy const& idempotency) {
+  return RetryPolicies{
+      std::make_shared<pubsub::LimitedErrorCountRetryPolicy>(3),
+      std::make_shared<pubsub::ExponentialBackoffPolicy>(
+          std::chrono::milliseconds(1), std::chrono::milliseconds(2), 2.0),
+      idempotency.clone(), std::make_shared<RetryBudget>(0, 0)};
+}
+
+Status Transient() { return Status(StatusCode::kUnavailable, "try-again"); }
+
+TEST(PublisherRetryTest, AdminOperations) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  EXPECT_CALL(*mock, CreateTopic)
+      .WillOnce(Return(StatusOr<google::pubsub::v1::Topic>(Transient())));
+  EXPECT_CALL(*mock, ListTopics)
+      .WillOnce(
+          Return(StatusOr<google::pubsub::v1::ListTopicsResponse>(Transient())))
+      .WillOnce(Return(StatusOr<google::pubsub::v1::ListTopicsResponse>(
+          google::pubsub::v1::ListTopicsResponse{})));
+  EXPECT_CALL(*mock, DeleteTopic).WillOnce(Return(Transient()));
+
+  PublisherRetry stub(mock,
+                      TestPolicies(pubsub::DefaultIdempotencyPolicy{}));
+  grpc::ClientContext c0;
+  EXPECT_EQ(StatusCode::kUnavailable,
+            stub.CreateTopic(c0, {}).status().code());
+  grpc::ClientContext c1;
+  EXPECT_TRUE(stub.ListTopics(c1, {}).ok());
+  grpc::ClientContext c2;
+  EXPECT_EQ(StatusCode::kUnavailable, stub.DeleteTopic(c2, {}).code());
+}
+
+TEST(PublisherRetryTest, PublishNotRetriedByDefault) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  EXPECT_CALL(*mock, AsyncPublish).WillOnce(InvokeWithoutArgs([] {
+    return make_ready_future(
+        StatusOr<google::pubsub::v1::PublishResponse>(Transient()));
+  }));
+  PublisherRetry stub(mock,
+                      TestPolicies(pubsub::DefaultIdempotencyPolicy{}));
+  google::cloud::grpc_utils::CompletionQueue cq;
+  auto r = stub.AsyncPublish(
+      cq, google::cloud::internal::make_unique<grpc::ClientContext>(), {});
+  EXPECT_EQ(StatusCode::kUnavailable, r.get().status().code());
+}
+
+TEST(PublisherRetryTest, PublishRetried) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  EXPECT_CALL(*mock, AsyncPublishEncoded)
+      .WillOnce(InvokeWithoutArgs([] {
+        return make_ready_future(
+            StatusOr<google::pubsub::v1::PublishResponse>(Transient()));
+      }))
+      .WillOnce(InvokeWithoutArgs([] {
+        google::pubsub::v1::PublishResponse response;
+        response.add_message_ids("m-0");
+        return make_ready_future(
+            StatusOr<google::pubsub::v1::PublishResponse>(response));
+      }));
+  PublisherRetry stub(mock,
+                      TestPolicies(pubsub::AlwaysRetryIdempotencyPolicy{}));
+  BackgroundThreads background(1);
+  auto cq = background.cq();
+  auto r = stub.AsyncPublishEncoded(
+               cq, google::cloud::internal::make_unique<grpc::ClientContext>(),
+               {})
+               .get();
+  ASSERT_TRUE(r.ok());
+  EXPECT_EQ("m-0", r->message_ids(0));
+}
+
+TEST(PublisherRetryTest, AsyncListTopicsRetried) {
+  using Response = StatusOr<google::pubsub::v1::ListTopicsResponse>;
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  EXPECT_CALL(*mock, AsyncListTopics)
+      .WillOnce(InvokeWithoutArgs(
+          [] { return make_ready_future(Response(Transient())); }))
+      .WillOnce(InvokeWithoutArgs([] {
+        return make_ready_future(
+            Response(google::pubsub::v1::ListTopicsResponse{}));
+      }));
+  PublisherRetry stub(mock, TestPolicies(pubsub::DefaultIdempotencyPolicy{}));
+  BackgroundThreads background(1);
+  auto cq = background.cq();
+  auto r = stub.AsyncListTopics(
+                   cq,
+                   google::cloud::internal::make_unique<grpc::ClientContext>(),
+                   {})
+               .get();
+  EXPECT_TRUE(r.ok());
+}
+
+TEST(PublisherRetryTest, PublishCompressedRetriedWithDeadline) {
+  auto const deadline =
+      std::chrono::system_clock::now() + std::chrono::minutes(10);
+  std::vector<grpc_compression_algorithm> compression;
+  std::vector<std::chrono::system_clock::time_point> deadlines;
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  EXPECT_CALL(*mock, AsyncPublishEncoded)
+      .Times(2)
+      .WillRepeatedly(Invoke([&](google::cloud::grpc_utils::CompletionQueue&,
+                                 std::unique_ptr<grpc::ClientContext> context,
+                                 grpc::ByteBuffer const&) {
+        compression.push_back(context->compression_algorithm());
+        deadlines.push_back(context->deadline());
+        if (compression.size() == 1) {
+          return make_ready_future(
+              StatusOr<google::pubsub::v1::PublishResponse>(Transient()));
+        }
+        google::pubsub::v1::PublishResponse response;
+        response.add_message_ids("m-0");
+        return make_ready_future(
+            StatusOr<google::pubsub::v1::PublishResponse>(response));
+      }));
+  PublisherRetry stub(mock,
+                      TestPolicies(pubsub::AlwaysRetryIdempotencyPolicy{}));
+  BackgroundThreads background(1);
+  auto cq = background.cq();
+  auto context = google::cloud::internal::make_unique<grpc::ClientContext>();
+  context->set_compression_algorithm(GRPC_COMPRESS_GZIP);
+  context->set_deadline(deadline);
+  auto r = stub.AsyncPublishEncoded(cq, std::move(context), {}).get();
+  ASSERT_TRUE(r.ok());
+  EXPECT_EQ("m-0", r->message_ids(0));
+  EXPECT_THAT(compression, ElementsAre(GRPC_COMPRESS_GZIP, GRPC_COMPRESS_GZIP));
+  EXPECT_THAT(deadlines, ElementsAre(deadline, deadline));
+}
+
+TEST(PublisherRetryTest, WaitForConnected) {
+  auto mock = std::make_shared<pubsub_testing::MockPublisherStub>();
+  EXPECT_CALL(*mock, AsyncWaitForConnected).WillOnce(InvokeWithoutArgs([] {
+    return make_ready_future(Status{});
+  }));
+  PublisherRetry stub(mock,
+                      TestPolicies(pubsub::DefaultIdempotencyPolicy{}));
+  google::cloud::grpc_utils::CompletionQueue cq;
+  auto status =
+      stub.AsyncWaitForConnected(cq, std::chrono::system_clock::now()).get();
+  EXPECT_TRUE(status.ok());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -13,7 +13,11 @@
 // limitations under the License.
 
 #include "google/cloud/pubsub/internal/publisher_stub.h"
+#include "google/cloud/pubsub/internal/connection_ready.h"
 #include "google/cloud/grpc_error_delegate.h"
+#include "google/cloud/internal/make_unique.h"
+#include <grpcpp/generic/generic_stub.h>
+#include <grpcpp/impl/codegen/proto_utils.h>
 
 namespace google {
 namespace cloud {
@@ -22,9 +26,13 @@ inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
 
 class DefaultPublisherStub : public PublisherStub {
  public:
-  explicit DefaultPublisherStub(
-      std::unique_ptr<google::pubsub::v1::Publisher::StubInterface> grpc_stub)
-      : grpc_stub_(std::move(grpc_stub)) {}
+  DefaultPublisherStub(
+      std::shared_ptr<grpc::Channel> channel,
+      std::unique_ptr<google::pubsub::v1::Publisher::StubInterface> grpc_stub,
+      std::unique_ptr<grpc::GenericStub> generic_stub)
+      : channel_(std::move(channel)),
+        grpc_stub_(std::move(grpc_stub)),
+        generic_stub_(std::move(generic_stub)) {}
 
   ~DefaultPublisherStub() override = default;
 
@@ -50,6 +58,19 @@ class DefaultPublisherStub : public PublisherStub {
     return response;
   }
 
+  future<StatusOr<google::pubsub::v1::ListTopicsResponse>> AsyncListTopics(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::unique_ptr<grpc::ClientContext> context,
+      google::pubsub::v1::ListTopicsRequest const& request) override {
+    return cq.MakeUnaryRpc(
+        [this](grpc::ClientContext* context,
+               google::pubsub::v1::ListTopicsRequest const& request,
+               grpc::CompletionQueue* cq) {
+          return grpc_stub_->AsyncListTopics(context, request, cq);
+        },
+        request, std::move(context));
+  }
+
   Status DeleteTopic(
       grpc::ClientContext& context,
       google::pubsub::v1::DeleteTopicRequest const& request) override {
@@ -61,8 +82,61 @@ class DefaultPublisherStub : public PublisherStub {
     return {};
   }
 
+  future<StatusOr<google::pubsub::v1::PublishResponse>> AsyncPublish(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::unique_ptr<grpc::ClientContext> context,
+      google::pubsub::v1::PublishRequest const& request) override {
+    return cq.MakeUnaryRpc(
+        [this](grpc::ClientContext* context,
+               google::pubsub::v1::PublishRequest const& request,
+               grpc::CompletionQueue* cq) {
+          return grpc_stub_->AsyncPublish(context, request, cq);
+        },
+        request, std::move(context));
+  }
+
+  future<StatusOr<google::pubsub::v1::PublishResponse>> AsyncPublishEncoded(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::unique_ptr<grpc::ClientContext> context,
+      grpc::ByteBuffer const& request) override {
+    using ResponseReader =
+        grpc::ClientAsyncResponseReaderInterface<grpc::ByteBuffer>;
+    return cq
+        .MakeUnaryRpc(
+            [this](grpc::ClientContext* context,
+                   grpc::ByteBuffer const& request, grpc::CompletionQueue* cq)
+                -> std::unique_ptr<ResponseReader> {
+              auto rpc = generic_stub_->PrepareUnaryCall(
+                  context, "/google.pubsub.v1.Publisher/Publish", request, cq);
+              rpc->StartCall();
+              return std::unique_ptr<ResponseReader>(rpc.release());
+            },
+            request, std::move(context))
+        .then([](future<StatusOr<grpc::ByteBuffer>> f)
+                  -> StatusOr<google::pubsub::v1::PublishResponse> {
+          auto buffer = f.get();
+          if (!buffer) return buffer.status();
+          google::pubsub::v1::PublishResponse response;
+          auto status = grpc::SerializationTraits<
+              google::pubsub::v1::PublishResponse>::Deserialize(&*buffer,
+                                                                &response);
+          if (!status.ok()) {
+            return google::cloud::MakeStatusFromRpcError(status);
+          }
+          return response;
+        });
+  }
+
+  future<Status> AsyncWaitForConnected(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::chrono::system_clock::time_point deadline) override {
+    return pubsub_internal::AsyncWaitForConnected(cq, channel_, deadline);
+  }
+
  private:
+  std::shared_ptr<grpc::Channel> channel_;
   std::unique_ptr<google::pubsub::v1::Publisher::StubInterface> grpc_stub_;
+  std::unique_ptr<grpc::GenericStub> generic_stub_;
 };
 
 std::shared_ptr<PublisherStub> CreateDefaultPublisherStub(
@@ -74,11 +148,12 @@ std::shared_ptr<PublisherStub> CreateDefaultPublisherStub(
   auto channel = grpc::CreateCustomChannel(
       options.endpoint(), options.credentials(), channel_arguments);
 
-  auto grpc_stub =
-      google::pubsub::v1::Publisher::NewStub(grpc::CreateCustomChannel(
-          options.endpoint(), options.credentials(), channel_arguments));
+  auto grpc_stub = google::pubsub::v1::Publisher::NewStub(channel);
+  auto generic_stub =
+      google::cloud::internal::make_unique<grpc::GenericStub>(channel);
 
-  return std::make_shared<DefaultPublisherStub>(std::move(grpc_stub));
+  return std::make_shared<DefaultPublisherStub>(
+      std::move(channel), std::move(grpc_stub), std::move(generic_stub));
 }
 
 }  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
@@ -16,8 +16,12 @@
 #define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_PUBLISHER_STUB_H
 
 #include "google/cloud/pubsub/connection_options.h"
+#include "google/cloud/future.h"
+#include "google/cloud/grpc_utils/completion_queue.h"
 #include "google/cloud/status_or.h"
 #include <google/pubsub/v1/pubsub.grpc.pb.h>
+#include <grpcpp/support/byte_buffer.h>
+#include <chrono>
 
 namespace google {
 namespace cloud {
@@ -48,10 +52,37 @@ class PublisherStub {
       grpc::ClientContext& client_context,
       google::pubsub::v1::ListTopicsRequest const& request) = 0;
 
+  /// List existing topics, used to hedge slow pages.
+  virtual future<StatusOr<google::pubsub::v1::ListTopicsResponse>>
+  AsyncListTopics(google::cloud::grpc_utils::CompletionQueue& cq,
+                  std::unique_ptr<grpc::ClientContext> client_context,
+                  google::pubsub::v1::ListTopicsRequest const& request) = 0;
+
   /// Delete a topic.
   virtual Status DeleteTopic(
       grpc::ClientContext& client_context,
       google::pubsub::v1::DeleteTopicRequest const& request) = 0;
+
+  /// Publish a batch of messages.
+  virtual future<StatusOr<google::pubsub::v1::PublishResponse>> AsyncPublish(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::unique_ptr<grpc::ClientContext> client_context,
+      google::pubsub::v1::PublishRequest const& request) = 0;
+
+  /// Publish a batch of messages, already serialized as a `PublishRequest`.
+  virtual future<StatusOr<google::pubsub::v1::PublishResponse>>
+  AsyncPublishEncoded(google::cloud::grpc_utils::CompletionQueue& cq,
+                      std::unique_ptr<grpc::ClientContext> client_context,
+                      grpc::ByteBuffer const& request) = 0;
+
+  /**
+   * Connect the underlying channel.
+   *
+   * The future is satisfied once the channel is ready, or at @p deadline.
+   */
+  virtual future<Status> AsyncWaitForConnected(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::chrono::system_clock::time_point deadline) = 0;
 };
 
 /**
@@ -0,0 +1,110 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/pull_pipeline.h"
+#include "google/cloud/pubsub/message.h"
+#include "google/cloud/internal/make_unique.h"
+#include <algorithm>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+PullPipeline::PullPipeline(std::vector<std::shared_ptr<SubscriberStub>> stubs,
+                           google::cloud::grpc_utils::CompletionQueue cq,
+                           std::string subscription, std::size_t depth)
+    : stubs_(std::move(stubs)),
+      cq_(std::move(cq)),
+      subscription_(std::move(subscription)),
+      depth_(depth) {}
+
+StatusOr<google::pubsub::v1::PullResponse> PullPipeline::Pull(
+    std::int32_t max_messages) {
+  future<StatusOr<google::pubsub::v1::PullResponse>> f;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (in_flight_.empty()) in_flight_.push_back(StartPull(max_messages));
+    f = std::move(in_flight_.front());
+    in_flight_.pop_front();
+    // Starting the RPCs does not block, it is safe to hold the lock.
+    while (in_flight_.size() < depth_) {
+      in_flight_.push_back(StartPull(max_messages));
+    }
+  }
+  return f.get();
+}
+
+std::size_t PullPipeline::in_flight() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return in_flight_.size();
+}
+
+future<StatusOr<google::pubsub::v1::PullResponse>> PullPipeline::StartPull(
+    std::int32_t max_messages) {
+  google::pubsub::v1::PullRequest request;
+  request.set_subscription(subscription_);
+  request.set_max_messages(max_messages);
+  auto& stub = stubs_[next_stub_++ % stubs_.size()];
+  return stub->AsyncPull(
+      cq_, google::cloud::internal::make_unique<grpc::ClientContext>(),
+      request);
+}
+
+std::vector<pubsub::ReceivedMessage> ToReceivedMessages(
+    google::pubsub::v1::PullResponse response) {
+  std::vector<pubsub::ReceivedMessage> messages;
+  messages.reserve(response.received_messages_size());
+  for (auto& m : *response.mutable_received_messages()) {
+    pubsub::ReceivedMessage r;
+    r.ack_id = std::move(*m.mutable_ack_id());
+    r.message = FromProto(m.mutable_message());
+    r.delivery_attempt = m.delivery_attempt();
+    messages.push_back(std::move(r));
+  }
+  return messages;
+}
+
+Status BulkAcknowledge(
+    std::vector<std::shared_ptr<SubscriberStub>> const& stubs,
+    google::cloud::grpc_utils::CompletionQueue cq,
+    std::string const& subscription, std::vector<std::string> ack_ids,
+    std::size_t max_per_request) {
+  std::vector<future<Status>> pending;
+  std::size_t next_stub = 0;
+  for (auto i = ack_ids.begin(); i != ack_ids.end();) {
+    auto const count = (std::min)(
+        max_per_request, static_cast<std::size_t>(ack_ids.end() - i));
+    google::pubsub::v1::AcknowledgeRequest request;
+    request.set_subscription(subscription);
+    for (auto end = i + count; i != end; ++i) {
+      request.add_ack_ids(std::move(*i));
+    }
+    auto& stub = stubs[next_stub++ % stubs.size()];
+    pending.push_back(stub->AsyncAcknowledge(
+        cq, google::cloud::internal::make_unique<grpc::ClientContext>(),
+        request));
+  }
+  Status status;
+  for (auto& f : pending) {
+    auto s = f.get();
+    if (status.ok()) status = std::move(s);
+  }
+  return status;
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,98 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_PULL_PIPELINE_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_PULL_PIPELINE_H
+
+#include "google/cloud/pubsub/internal/subscriber_stub.h"
+#include "google/cloud/pubsub/received_message.h"
+#include "google/cloud/pubsub/version.h"
+#include "google/cloud/future.h"
+#include "google/cloud/grpc_utils/completion_queue.h"
+#include "google/cloud/status.h"
+#include "google/cloud/status_or.h"
+#include <google/pubsub/v1/pubsub.pb.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Keep several `Pull` RPCs in flight for a subscription.
+ *
+ * Each call to `Pull()` returns the oldest RPC in flight (starting one if
+ * needed), and then starts new RPCs until `depth` are in flight. Therefore,
+ * while the application processes a batch, the next `depth` batches are
+ * already on their way. The prefetched batches use the `max_messages` of the
+ * call that started them.
+ *
+ * The RPCs are spread over the stubs in round-robin order, so they use
+ * different channels. This class is thread-safe.
+ */
+class PullPipeline {
+ public:
+  PullPipeline(std::vector<std::shared_ptr<SubscriberStub>> stubs,
+               google::cloud::grpc_utils::CompletionQueue cq,
+               std::string subscription, std::size_t depth);
+
+  /// Return the next batch of messages.
+  StatusOr<google::pubsub::v1::PullResponse> Pull(std::int32_t max_messages);
+
+  /// The number of RPCs in flight.
+  std::size_t in_flight() const;
+
+ private:
+  future<StatusOr<google::pubsub::v1::PullResponse>> StartPull(
+      std::int32_t max_messages);
+
+  std::vector<std::shared_ptr<SubscriberStub>> const stubs_;
+  google::cloud::grpc_utils::CompletionQueue cq_;
+  std::string const subscription_;
+  std::size_t const depth_;
+
+  mutable std::mutex mu_;
+  std::deque<future<StatusOr<google::pubsub::v1::PullResponse>>> in_flight_;
+  std::size_t next_stub_ = 0;
+};
+
+/// Convert the messages in a `PullResponse`.
+std::vector<pubsub::ReceivedMessage> ToReceivedMessages(
+    google::pubsub::v1::PullResponse response);
+
+/**
+ * Acknowledge @p ack_ids using concurrent `Acknowledge` RPCs.
+ *
+ * The ids are split in requests of at most @p max_per_request ids, spread over
+ * the stubs. Returns the first error, if any, after all the RPCs complete.
+ */
+Status BulkAcknowledge(
+    std::vector<std::shared_ptr<SubscriberStub>> const& stubs,
+    google::cloud::grpc_utils::CompletionQueue cq,
+    std::string const& subscription, std::vector<std::string> ack_ids,
+    std::size_t max_per_request);
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_PULL_PIPELINE_H
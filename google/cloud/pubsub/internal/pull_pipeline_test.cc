@@ -0,0 +1,167 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/pull_pipeline.h"
+#include "google/cloud/pubsub/testing/mock_subscriber_stub.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using ::testing::_;
+using ::testing::ElementsAre;
+
+std::string const kSubscription = "projects/test-project/subscriptions/test-s";
+
+/// Return a response with a single message, the ack id counts the calls.
+std::function<future<StatusOr<google::pubsub::v1::PullResponse>>(
+    google::cloud::grpc_utils::CompletionQueue&,
+    std::unique_ptr<grpc::ClientContext>,
+    google::pubsub::v1::PullRequest const&)>
+CountingPull(std::string const& prefix, int& counter) {
+  return [prefix, &counter](google::cloud::grpc_utils::CompletionQueue&,
+                            std::unique_ptr<grpc::ClientContext>,
+                            google::pubsub::v1::PullRequest const& request) {
+    EXPECT_EQ(kSubscription, request.subscription());
+    google::pubsub::v1::PullResponse response;
+    auto& m = *response.add_received_messages();
+    m.set_ack_id(prefix + std::to_string(counter++));
+    m.mutable_message()->set_data(std::to_string(request.max_messages()));
+    return make_ready_future(
+        StatusOr<google::pubsub::v1::PullResponse>(std::move(response)));
+  };
+}
+
+TEST(PullPipelineTest, WithoutPrefetch) {
+  auto mock = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  int counter = 0;
+  EXPECT_CALL(*mock, AsyncPull).Times(2).WillRepeatedly(
+      CountingPull("a", counter));
+
+  google::cloud::grpc_utils::CompletionQueue cq;
+  PullPipeline pipeline({mock}, cq, kSubscription, 0);
+  auto r0 = pipeline.Pull(10);
+  ASSERT_TRUE(r0.ok());
+  EXPECT_EQ("a0", r0->received_messages(0).ack_id());
+  EXPECT_EQ("10", r0->received_messages(0).message().data());
+  EXPECT_EQ(0U, pipeline.in_flight());
+  auto r1 = pipeline.Pull(10);
+  ASSERT_TRUE(r1.ok());
+  EXPECT_EQ("a1", r1->received_messages(0).ack_id());
+}
+
+TEST(PullPipelineTest, KeepsDepthInFlight) {
+  auto mock = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  int counter = 0;
+  EXPECT_CALL(*mock, AsyncPull).Times(4).WillRepeatedly(
+      CountingPull("a", counter));
+
+  google::cloud::grpc_utils::CompletionQueue cq;
+  PullPipeline pipeline({mock}, cq, kSubscription, 2);
+  auto r0 = pipeline.Pull(10);
+  ASSERT_TRUE(r0.ok());
+  EXPECT_EQ("a0", r0->received_messages(0).ack_id());
+  EXPECT_EQ(3, counter);
+  EXPECT_EQ(2U, pipeline.in_flight());
+
+  // The next batch was already in flight, only one new RPC starts.
+  auto r1 = pipeline.Pull(20);
+  ASSERT_TRUE(r1.ok());
+  EXPECT_EQ("a1", r1->received_messages(0).ack_id());
+  EXPECT_EQ("10", r1->received_messages(0).message().data());
+  EXPECT_EQ(4, counter);
+  EXPECT_EQ(2U, pipeline.in_flight());
+}
+
+TEST(PullPipelineTest, SpreadsOverStubs) {
+  auto m0 = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  auto m1 = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  int c0 = 0;
+  int c1 = 0;
+  EXPECT_CALL(*m0, AsyncPull).WillOnce(CountingPull("m0-", c0));
+  EXPECT_CALL(*m1, AsyncPull).WillOnce(CountingPull("m1-", c1));
+
+  google::cloud::grpc_utils::CompletionQueue cq;
+  PullPipeline pipeline({m0, m1}, cq, kSubscription, 1);
+  auto r0 = pipeline.Pull(10);
+  ASSERT_TRUE(r0.ok());
+  EXPECT_EQ("m0-0", r0->received_messages(0).ack_id());
+  EXPECT_EQ(1U, pipeline.in_flight());
+}
+
+TEST(PullPipelineTest, ReturnsError) {
+  auto mock = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  EXPECT_CALL(*mock, AsyncPull)
+      .WillOnce([](google::cloud::grpc_utils::CompletionQueue&,
+                   std::unique_ptr<grpc::ClientContext>,
+                   google::pubsub::v1::PullRequest const&) {
+        return make_ready_future(StatusOr<google::pubsub::v1::PullResponse>(
+            Status(StatusCode::kPermissionDenied, "uh-oh")));
+      });
+
+  google::cloud::grpc_utils::CompletionQueue cq;
+  PullPipeline pipeline({mock}, cq, kSubscription, 0);
+  auto r = pipeline.Pull(10);
+  EXPECT_EQ(StatusCode::kPermissionDenied, r.status().code());
+}
+
+TEST(PullPipelineTest, ToReceivedMessages) {
+  google::pubsub::v1::PullResponse response;
+  auto& m = *response.add_received_messages();
+  m.set_ack_id("a0");
+  m.set_delivery_attempt(3);
+  m.mutable_message()->set_data("data-a0");
+  auto messages = ToReceivedMessages(std::move(response));
+  ASSERT_EQ(1U, messages.size());
+  EXPECT_EQ("a0", messages[0].ack_id);
+  EXPECT_EQ(3, messages[0].delivery_attempt);
+  EXPECT_EQ("data-a0", messages[0].message.data());
+}
+
+TEST(PullPipelineTest, BulkAcknowledge) {
+  auto mock = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  std::vector<std::vector<std::string>> requests;
+  EXPECT_CALL(*mock, AsyncAcknowledge)
+      .Times(3)
+      .WillRepeatedly(
+          [&](google::cloud::grpc_utils::CompletionQueue&,
+              std::unique_ptr<grpc::ClientContext>,
+              google::pubsub::v1::AcknowledgeRequest const& request) {
+            EXPECT_EQ(kSubscription, request.subscription());
+            requests.emplace_back(request.ack_ids().begin(),
+                                  request.ack_ids().end());
+            if (requests.size() == 2) {
+              return make_ready_future(
+                  Status(StatusCode::kUnavailable, "try-again"));
+            }
+            return make_ready_future(Status{});
+          });
+
+  google::cloud::grpc_utils::CompletionQueue cq;
+  auto status = BulkAcknowledge({mock}, cq, kSubscription,
+                                {"a0", "a1", "a2", "a3", "a4"}, 2);
+  EXPECT_EQ(StatusCode::kUnavailable, status.code());
+  EXPECT_THAT(requests, ElementsAre(ElementsAre("a0", "a1"),
+                                    ElementsAre("a2", "a3"),
+                                    ElementsAre("a4")));
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
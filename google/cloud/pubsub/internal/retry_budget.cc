@@ -0,0 +1,44 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/retry_budget.h"
+#include <algorithm>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+void RetryBudget::OnSuccess() {
+  if (max_tokens_ <= 0) return;
+  std::lock_guard<std::mutex> lk(mu_);
+  tokens_ = (std::min)(max_tokens_, tokens_ + token_ratio_);
+}
+
+bool RetryBudget::OnFailure() {
+  if (max_tokens_ <= 0) return true;
+  std::lock_guard<std::mutex> lk(mu_);
+  tokens_ = (std::max)(0.0, tokens_ - 1.0);
+  return tokens_ > max_tokens_ / 2;
+}
+
+double RetryBudget::tokens() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return tokens_;
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
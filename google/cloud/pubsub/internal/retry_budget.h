@@ -0,0 +1,67 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_RETRY_BUDGET_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_RETRY_BUDGET_H
+
+#include "google/cloud/pubsub/version.h"
+#include <mutex>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Limit the retries sent to a service that is already failing.
+ *
+ * A token bucket shared by all the operations in a connection, similar to
+ * the gRPC retry throttling. Each failed attempt removes one token, each
+ * successful attempt adds @p token_ratio tokens, up to @p max_tokens. Retries
+ * are only allowed while the bucket is more than half full. Without this
+ * limit an overloaded backend sees each failed request several times, which
+ * makes the overload worse.
+ *
+ * A budget with `max_tokens <= 0` always allows retries. This class is
+ * thread-safe.
+ */
+class RetryBudget {
+ public:
+  RetryBudget(double max_tokens, double token_ratio)
+      : max_tokens_(max_tokens),
+        token_ratio_(token_ratio),
+        tokens_(max_tokens) {}
+
+  /// Record a successful attempt.
+  void OnSuccess();
+
+  /// Record a failed attempt, return `true` if a retry is allowed.
+  bool OnFailure();
+
+  /// The number of tokens in the bucket.
+  double tokens() const;
+
+ private:
+  double const max_tokens_;
+  double const token_ratio_;
+  mutable std::mutex mu_;
+  double tokens_;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_RETRY_BUDGET_H
@@ -0,0 +1,55 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/retry_budget.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+TEST(RetryBudgetTest, StopsRetriesWhenHalfEmpty) {
+  RetryBudget budget(10, 0.5);
+  EXPECT_DOUBLE_EQ(10.0, budget.tokens());
+  for (int i = 0; i != 4; ++i) EXPECT_TRUE(budget.OnFailure()) << i;
+  // 5 tokens left, that is not more than half.
+  EXPECT_FALSE(budget.OnFailure());
+  EXPECT_FALSE(budget.OnFailure());
+  EXPECT_DOUBLE_EQ(4.0, budget.tokens());
+}
+
+TEST(RetryBudgetTest, RefillsOnSuccess) {
+  RetryBudget budget(10, 0.5);
+  for (int i = 0; i != 6; ++i) budget.OnFailure();
+  EXPECT_DOUBLE_EQ(4.0, budget.tokens());
+  // Two successes per failure are needed to keep retrying.
+  for (int i = 0; i != 6; ++i) budget.OnSuccess();
+  EXPECT_DOUBLE_EQ(7.0, budget.tokens());
+  EXPECT_TRUE(budget.OnFailure());
+  for (int i = 0; i != 100; ++i) budget.OnSuccess();
+  EXPECT_DOUBLE_EQ(10.0, budget.tokens());
+}
+
+TEST(RetryBudgetTest, Disabled) {
+  RetryBudget budget(0, 0.1);
+  for (int i = 0; i != 100; ++i) EXPECT_TRUE(budget.OnFailure());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
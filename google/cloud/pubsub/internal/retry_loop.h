@@ -0,0 +1,322 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_RETRY_LOOP_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_RETRY_LOOP_H
+
+#include "google/cloud/pubsub/backoff_policy.h"
+#include "google/cloud/pubsub/idempotency_policy.h"
+#include "google/cloud/pubsub/internal/retry_budget.h"
+#include "google/cloud/pubsub/retry_policy.h"
+#include "google/cloud/pubsub/version.h"
+#include "google/cloud/future.h"
+#include "google/cloud/grpc_utils/completion_queue.h"
+#include "google/cloud/internal/make_unique.h"
+#include "google/cloud/status_or.h"
+#include <grpcpp/grpcpp.h>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/// The policies, and the retry budget, shared by all the calls in a stub.
+struct RetryPolicies {
+  std::shared_ptr<pubsub::RetryPolicy const> retry;
+  std::shared_ptr<pubsub::BackoffPolicy const> backoff;
+  std::shared_ptr<pubsub::IdempotencyPolicy const> idempotency;
+  std::shared_ptr<RetryBudget> budget;
+};
+
+/// Create the policies, and a new retry budget, configured in @p options.
+template <typename Options>
+RetryPolicies MakeRetryPolicies(Options const& options) {
+  return RetryPolicies{
+      options.retry_policy(), options.backoff_policy(),
+      options.idempotency_policy(),
+      std::make_shared<RetryBudget>(options.retry_budget_max_tokens(),
+                                    options.retry_budget_token_ratio())};
+}
+
+inline Status const& GetResultStatus(Status const& status) { return status; }
+
+template <typename T>
+Status const& GetResultStatus(StatusOr<T> const& result) {
+  return result.status();
+}
+
+/**
+ * Record the result of an attempt in @p budget.
+ *
+ * Only transient failures count against the budget, permanent errors (say
+ * `kNotFound`) say nothing about the load in the service. Returns `false` if
+ * the budget does not allow retrying this attempt.
+ */
+inline bool RecordInBudget(RetryBudget& budget, Status const& status) {
+  if (status.ok()) {
+    budget.OnSuccess();
+    return true;
+  }
+  if (!pubsub::IsTransientFailure(status)) return true;
+  return budget.OnFailure();
+}
+
+/// The state of a single operation, decides if a failed attempt is retried.
+class RetryState {
+ public:
+  RetryState(RetryPolicies const& policies,
+             pubsub::IdempotencyPolicy::Operation operation)
+      : retry_(policies.retry->clone()),
+        backoff_(policies.backoff->clone()),
+        budget_(policies.budget),
+        idempotent_(policies.idempotency->IsIdempotent(operation)) {}
+
+  /// Record the result of an attempt, return `true` to try again.
+  bool OnAttempt(Status const& status) {
+    auto const allowed = RecordInBudget(*budget_, status);
+    if (status.ok()) return false;
+    return idempotent_ && allowed && retry_->OnFailure(status);
+  }
+
+  /// The delay before the next attempt.
+  std::chrono::milliseconds Backoff() { return backoff_->OnCompletion(); }
+
+ private:
+  std::unique_ptr<pubsub::RetryPolicy> retry_;
+  std::unique_ptr<pubsub::BackoffPolicy> backoff_;
+  std::shared_ptr<RetryBudget> budget_;
+  bool const idempotent_;
+};
+
+/**
+ * Configure the context of a retry.
+ *
+ * gRPC does not allow reusing a `grpc::ClientContext`, each retry uses a new
+ * context, and the retry loops call this function to configure it like the
+ * context of the first attempt.
+ */
+using ContextConfigurator = std::function<void(grpc::ClientContext&)>;
+
+/**
+ * Return a configurator that copies the settings of @p context.
+ *
+ * gRPC only exposes the deadline and the compression algorithm of a context.
+ * Callers that add metadata must provide their own configurator.
+ */
+inline ContextConfigurator CopyContextSettings(
+    grpc::ClientContext const& context) {
+  auto const deadline = context.deadline();
+  auto const compression = context.compression_algorithm();
+  return [deadline, compression](grpc::ClientContext& c) {
+    if (deadline != std::chrono::system_clock::time_point::max()) {
+      c.set_deadline(deadline);
+    }
+    if (compression != GRPC_COMPRESS_NONE) {
+      c.set_compression_algorithm(compression);
+    }
+  };
+}
+
+/**
+ * Return true if there is time for another attempt after @p backoff.
+ *
+ * The deadline of the first context applies to the whole operation, the
+ * retries fail immediately once it expires.
+ */
+inline bool BeforeDeadline(std::chrono::system_clock::time_point deadline,
+                           std::chrono::milliseconds backoff) {
+  return std::chrono::system_clock::now() + backoff < deadline;
+}
+
+/**
+ * Call @p functor until it succeeds, or the policies stop the retries.
+ *
+ * The first attempt uses @p context, gRPC does not allow reusing a context,
+ * so each retry uses a new context, configured by @p configure. The retries
+ * stop at the deadline of @p context. Blocks the calling thread during the
+ * backoff.
+ */
+template <typename Functor, typename Request>
+auto RetryLoop(RetryPolicies const& policies,
+               pubsub::IdempotencyPolicy::Operation operation,
+               Functor&& functor, grpc::ClientContext& context,
+               Request const& request, ContextConfigurator const& configure)
+    -> decltype(functor(context, request)) {
+  RetryState state(policies, operation);
+  auto const deadline = context.deadline();
+  auto result = functor(context, request);
+  while (state.OnAttempt(GetResultStatus(result))) {
+    auto const backoff = state.Backoff();
+    if (!BeforeDeadline(deadline, backoff)) break;
+    std::this_thread::sleep_for(backoff);
+    grpc::ClientContext retry_context;
+    configure(retry_context);
+    result = functor(retry_context, request);
+  }
+  return result;
+}
+
+/// Call `RetryLoop()`, the retries copy the settings of @p context.
+template <typename Functor, typename Request>
+auto RetryLoop(RetryPolicies const& policies,
+               pubsub::IdempotencyPolicy::Operation operation,
+               Functor&& functor, grpc::ClientContext& context,
+               Request const& request) -> decltype(functor(context, request)) {
+  return RetryLoop(policies, operation, std::forward<Functor>(functor), context,
+                   request, CopyContextSettings(context));
+}
+
+/// Extract `T` from `future<T>`.
+template <typename T>
+struct FutureValueType;
+
+template <typename T>
+struct FutureValueType<future<T>> {
+  using type = T;
+};
+
+/// Implement `AsyncRetryLoop()`, the object owns itself until it completes.
+template <typename Functor, typename Request, typename Response>
+class AsyncRetryLoopImpl
+    : public std::enable_shared_from_this<
+          AsyncRetryLoopImpl<Functor, Request, Response>> {
+ public:
+  AsyncRetryLoopImpl(RetryPolicies const& policies,
+                     pubsub::IdempotencyPolicy::Operation operation,
+                     Functor functor,
+                     google::cloud::grpc_utils::CompletionQueue cq,
+                     Request const& request, ContextConfigurator configure)
+      : state_(policies, operation),
+        functor_(std::move(functor)),
+        cq_(std::move(cq)),
+        request_(request),
+        configure_(std::move(configure)) {}
+
+  future<Response> Start(std::unique_ptr<grpc::ClientContext> context) {
+    auto f = result_.get_future();
+    deadline_ = context->deadline();
+    StartAttempt(std::move(context));
+    return f;
+  }
+
+ private:
+  void StartAttempt(std::unique_ptr<grpc::ClientContext> context) {
+    auto self = this->shared_from_this();
+    functor_(cq_, std::move(context), request_)
+        .then([self](future<Response> f) { self->OnAttempt(f.get()); });
+  }
+
+  void OnAttempt(Response response) {
+    if (!state_.OnAttempt(GetResultStatus(response))) {
+      result_.set_value(std::move(response));
+      return;
+    }
+    auto const backoff = state_.Backoff();
+    if (!BeforeDeadline(deadline_, backoff)) {
+      result_.set_value(std::move(response));
+      return;
+    }
+    auto self = this->shared_from_this();
+    auto last = std::make_shared<Response>(std::move(response));
+    cq_.MakeRelativeTimer(backoff)
+        .then([self, last](
+                  future<StatusOr<std::chrono::system_clock::time_point>> f) {
+          if (!f.get()) {
+            // The completion queue is shutting down, report the last error.
+            self->result_.set_value(std::move(*last));
+            return;
+          }
+          auto context =
+              google::cloud::internal::make_unique<grpc::ClientContext>();
+          self->configure_(*context);
+          self->StartAttempt(std::move(context));
+        });
+  }
+
+  RetryState state_;
+  Functor functor_;
+  google::cloud::grpc_utils::CompletionQueue cq_;
+  Request request_;
+  ContextConfigurator configure_;
+  std::chrono::system_clock::time_point deadline_;
+  promise<Response> result_;
+};
+
+/**
+ * Call the asynchronous @p functor until it succeeds, or the policies stop
+ * the retries.
+ *
+ * The first attempt uses @p context, each retry uses a new context configured
+ * by @p configure. The retries stop at the deadline of @p context. The backoff
+ * uses a timer in @p cq, no thread blocks while waiting.
+ */
+template <typename Functor, typename Request,
+          typename Response = typename FutureValueType<decltype(
+              std::declval<Functor>()(
+                  std::declval<google::cloud::grpc_utils::CompletionQueue&>(),
+                  std::declval<std::unique_ptr<grpc::ClientContext>>(),
+                  std::declval<Request const&>()))>::type>
+future<Response> AsyncRetryLoop(RetryPolicies const& policies,
+                                pubsub::IdempotencyPolicy::Operation operation,
+                                Functor functor,
+                                google::cloud::grpc_utils::CompletionQueue& cq,
+                                std::unique_ptr<grpc::ClientContext> context,
+                                Request const& request,
+                                ContextConfigurator configure) {
+  if (!policies.idempotency->IsIdempotent(operation)) {
+    // Avoid copying the request when it is never retried, the result still
+    // counts towards the retry budget.
+    auto budget = policies.budget;
+    return functor(cq, std::move(context), request)
+        .then([budget](future<Response> f) {
+          auto response = f.get();
+          RecordInBudget(*budget, GetResultStatus(response));
+          return response;
+        });
+  }
+  auto loop =
+      std::make_shared<AsyncRetryLoopImpl<Functor, Request, Response>>(
+          policies, operation, std::move(functor), cq, request,
+          std::move(configure));
+  return loop->Start(std::move(context));
+}
+
+/// Call `AsyncRetryLoop()`, the retries copy the settings of @p context.
+template <typename Functor, typename Request,
+          typename Response = typename FutureValueType<decltype(
+              std::declval<Functor>()(
+                  std::declval<google::cloud::grpc_utils::CompletionQueue&>(),
+                  std::declval<std::unique_ptr<grpc::ClientContext>>(),
+                  std::declval<Request const&>()))>::type>
+future<Response> AsyncRetryLoop(RetryPolicies const& policies,
+                                pubsub::IdempotencyPolicy::Operation operation,
+                                Functor functor,
+                                google::cloud::grpc_utils::CompletionQueue& cq,
+                                std::unique_ptr<grpc::ClientContext> context,
+                                Request const& request) {
+  auto configure = CopyContextSettings(*context);
+  return AsyncRetryLoop(policies, operation, std::move(functor), cq,
+                        std::move(context), request, std::move(configure));
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_RETRY_LOOP_H
@@ -0,0 +1,289 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/retry_loop.h"
+#include "google/cloud/pubsub/internal/background_threads.h"
+#include <gmock/gmock.h>
+#include <string>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using Operation = pubsub::IdempotencyPolicy::Operation;
+using ms = std::chrono::milliseconds;
+
+RetryPolicies TestPolicies(int maximum_failures = 3,
+                           double budget_tokens = 0) {
+  return RetryPolicies{
+      std::make_shared<pubsub::LimitedErrorCountRetryPolicy>(
+          maximum_failures),
+      std::make_shared<pubsub::ExponentialBackoffPolicy>(ms(1), ms(2), 2.0),
+      std::make_shared<pubsub::DefaultIdempotencyPolicy>(),
+      std::make_shared<RetryBudget>(budget_tokens, 0.5)};
+}
+
+Status Transient() { return Status(StatusCode::kUnavailable, "try-again"); }
+
+TEST(RetryLoopTest, RetriesTransientFailures) {
+  int calls = 0;
+  grpc::ClientContext context;
+  auto result = RetryLoop(
+      TestPolicies(), Operation::kListTopics,
+      [&calls](grpc::ClientContext&, int request) -> StatusOr<int> {
+        if (++calls < 3) return Transient();
+        return request * 2;
+      },
+      context, 21);
+  ASSERT_TRUE(result.ok());
+  EXPECT_EQ(42, *result);
+  EXPECT_EQ(3, calls);
+}
+
+TEST(RetryLoopTest, PolicyExhausted) {
+  int calls = 0;
+  grpc::ClientContext context;
+  auto status = RetryLoop(
+      TestPolicies(2), Operation::kListTopics,
+      [&calls](grpc::ClientContext&, int) {
+        ++calls;
+        return Transient();
+      },
+      context, 0);
+  EXPECT_EQ(StatusCode::kUnavailable, status.code());
+  EXPECT_EQ(3, calls);
+}
+
+TEST(RetryLoopTest, PermanentFailure) {
+  int calls = 0;
+  grpc::ClientContext context;
+  auto status = RetryLoop(
+      TestPolicies(), Operation::kListTopics,
+      [&calls](grpc::ClientContext&, int) {
+        ++calls;
+        return Status(StatusCode::kNotFound, "not-found");
+      },
+      context, 0);
+  EXPECT_EQ(StatusCode::kNotFound, status.code());
+  EXPECT_EQ(1, calls);
+}
+
+TEST(RetryLoopTest, NotIdempotent) {
+  int calls = 0;
+  grpc::ClientContext context;
+  auto status = RetryLoop(
+      TestPolicies(), Operation::kCreateTopic,
+      [&calls](grpc::ClientContext&, int) {
+        ++calls;
+        return Transient();
+      },
+      context, 0);
+  EXPECT_EQ(StatusCode::kUnavailable, status.code());
+  EXPECT_EQ(1, calls);
+}
+
+TEST(RetryLoopTest, BudgetStopsRetries) {
+  // With 10 tokens only 4 failures are retried, across all the operations.
+  auto policies = TestPolicies(100, 10);
+  int calls = 0;
+  auto failing = [&calls](grpc::ClientContext&, int) {
+    ++calls;
+    return Transient();
+  };
+  grpc::ClientContext c0;
+  EXPECT_FALSE(
+      RetryLoop(policies, Operation::kListTopics, failing, c0, 0).ok());
+  EXPECT_EQ(5, calls);
+  grpc::ClientContext c1;
+  EXPECT_FALSE(
+      RetryLoop(policies, Operation::kListTopics, failing, c1, 0).ok());
+  EXPECT_EQ(6, calls);
+  EXPECT_DOUBLE_EQ(4.0, policies.budget->tokens());
+}
+
+TEST(RetryLoopTest, RetriesCopyContextSettings) {
+  auto const deadline =
+      std::chrono::system_clock::now() + std::chrono::minutes(10);
+  std::vector<grpc_compression_algorithm> compression;
+  std::vector<std::chrono::system_clock::time_point> deadlines;
+  grpc::ClientContext context;
+  context.set_compression_algorithm(GRPC_COMPRESS_GZIP);
+  context.set_deadline(deadline);
+  auto status = RetryLoop(
+      TestPolicies(), Operation::kListTopics,
+      [&](grpc::ClientContext& c, int) {
+        compression.push_back(c.compression_algorithm());
+        deadlines.push_back(c.deadline());
+        if (compression.size() < 3) return Transient();
+        return Status{};
+      },
+      context, 0);
+  EXPECT_TRUE(status.ok());
+  EXPECT_THAT(compression, ::testing::Each(GRPC_COMPRESS_GZIP));
+  EXPECT_THAT(deadlines, ::testing::Each(deadline));
+  EXPECT_EQ(3, compression.size());
+}
+
+TEST(RetryLoopTest, RetriesUseConfigurator) {
+  int configured = 0;
+  std::vector<std::string> values;
+  grpc::ClientContext context;
+  context.AddMetadata("x-test", "first");
+  auto status = RetryLoop(
+      TestPolicies(), Operation::kListTopics,
+      [&](grpc::ClientContext& c, int) {
+        values.push_back(c.compression_algorithm() == GRPC_COMPRESS_GZIP
+                             ? "gzip"
+                             : "none");
+        if (values.size() < 3) return Transient();
+        return Status{};
+      },
+      context, 0,
+      [&configured](grpc::ClientContext& c) {
+        ++configured;
+        c.set_compression_algorithm(GRPC_COMPRESS_GZIP);
+      });
+  EXPECT_TRUE(status.ok());
+  EXPECT_THAT(values, ::testing::ElementsAre("none", "gzip", "gzip"));
+  EXPECT_EQ(2, configured);
+}
+
+TEST(RetryLoopTest, StopsAtDeadline) {
+  int calls = 0;
+  grpc::ClientContext context;
+  context.set_deadline(std::chrono::system_clock::now());
+  auto status = RetryLoop(
+      TestPolicies(), Operation::kListTopics,
+      [&calls](grpc::ClientContext&, int) {
+        ++calls;
+        return Transient();
+      },
+      context, 0);
+  EXPECT_EQ(StatusCode::kUnavailable, status.code());
+  EXPECT_EQ(1, calls);
+}
+
+TEST(RetryLoopTest, AsyncRetriesTransientFailures) {
+  BackgroundThreads background(1);
+  auto cq = background.cq();
+  int calls = 0;
+  auto result =
+      AsyncRetryLoop(
+          TestPolicies(), Operation::kAcknowledge,
+          [&calls](google::cloud::grpc_utils::CompletionQueue&,
+                   std::unique_ptr<grpc::ClientContext> context, int) {
+            EXPECT_NE(nullptr, context);
+            if (++calls < 3) return make_ready_future(Transient());
+            return make_ready_future(Status{});
+          },
+          cq, google::cloud::internal::make_unique<grpc::ClientContext>(), 0)
+          .get();
+  EXPECT_TRUE(result.ok());
+  EXPECT_EQ(3, calls);
+}
+
+TEST(RetryLoopTest, AsyncPolicyExhausted) {
+  BackgroundThreads background(1);
+  auto cq = background.cq();
+  int calls = 0;
+  auto result =
+      AsyncRetryLoop(
+          TestPolicies(2), Operation::kPull,
+          [&calls](google::cloud::grpc_utils::CompletionQueue&,
+                   std::unique_ptr<grpc::ClientContext>, int) {
+            ++calls;
+            return make_ready_future(StatusOr<int>(Transient()));
+          },
+          cq, google::cloud::internal::make_unique<grpc::ClientContext>(), 0)
+          .get();
+  EXPECT_EQ(StatusCode::kUnavailable, result.status().code());
+  EXPECT_EQ(3, calls);
+}
+
+TEST(RetryLoopTest, AsyncRetriesCopyContextSettings) {
+  BackgroundThreads background(1);
+  auto cq = background.cq();
+  auto const deadline =
+      std::chrono::system_clock::now() + std::chrono::minutes(10);
+  std::vector<grpc_compression_algorithm> compression;
+  std::vector<std::chrono::system_clock::time_point> deadlines;
+  auto context = google::cloud::internal::make_unique<grpc::ClientContext>();
+  context->set_compression_algorithm(GRPC_COMPRESS_GZIP);
+  context->set_deadline(deadline);
+  auto result =
+      AsyncRetryLoop(
+          TestPolicies(), Operation::kAcknowledge,
+          [&](google::cloud::grpc_utils::CompletionQueue&,
+              std::unique_ptr<grpc::ClientContext> c, int) {
+            compression.push_back(c->compression_algorithm());
+            deadlines.push_back(c->deadline());
+            if (compression.size() < 3) return make_ready_future(Transient());
+            return make_ready_future(Status{});
+          },
+          cq, std::move(context), 0)
+          .get();
+  EXPECT_TRUE(result.ok());
+  EXPECT_THAT(compression, ::testing::Each(GRPC_COMPRESS_GZIP));
+  EXPECT_THAT(deadlines, ::testing::Each(deadline));
+  EXPECT_EQ(3, compression.size());
+}
+
+TEST(RetryLoopTest, AsyncStopsAtDeadline) {
+  BackgroundThreads background(1);
+  auto cq = background.cq();
+  int calls = 0;
+  auto context = google::cloud::internal::make_unique<grpc::ClientContext>();
+  context->set_deadline(std::chrono::system_clock::now());
+  auto result =
+      AsyncRetryLoop(
+          TestPolicies(), Operation::kAcknowledge,
+          [&calls](google::cloud::grpc_utils::CompletionQueue&,
+                   std::unique_ptr<grpc::ClientContext>, int) {
+            ++calls;
+            return make_ready_future(Transient());
+          },
+          cq, std::move(context), 0)
+          .get();
+  EXPECT_EQ(StatusCode::kUnavailable, result.code());
+  EXPECT_EQ(1, calls);
+}
+
+TEST(RetryLoopTest, AsyncNotIdempotent) {
+  google::cloud::grpc_utils::CompletionQueue cq;
+  auto policies = TestPolicies(3, 10);
+  int calls = 0;
+  auto result =
+      AsyncRetryLoop(
+          policies, Operation::kPublish,
+          [&calls](google::cloud::grpc_utils::CompletionQueue&,
+                   std::unique_ptr<grpc::ClientContext>, int) {
+            ++calls;
+            return make_ready_future(Transient());
+          },
+          cq, google::cloud::internal::make_unique<grpc::ClientContext>(), 0)
+          .get();
+  EXPECT_EQ(StatusCode::kUnavailable, result.code());
+  EXPECT_EQ(1, calls);
+  // The failure still counts against the budget.
+  EXPECT_DOUBLE_EQ(9.0, policies.budget->tokens());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,184 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/subscriber_channel_pool.h"
+#include "google/cloud/internal/make_unique.h"
+#include <algorithm>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+namespace {
+/// Count a stream as an RPC in flight until it is destroyed.
+class TrackedStream : public StreamingPullStream {
+ public:
+  TrackedStream(std::unique_ptr<StreamingPullStream> child,
+                std::shared_ptr<ChannelSelector> selector, std::size_t channel)
+      : child_(std::move(child)),
+        selector_(std::move(selector)),
+        channel_(channel) {}
+  ~TrackedStream() override { selector_->Release(channel_); }
+
+  void Cancel() override { child_->Cancel(); }
+  bool Write(google::pubsub::v1::StreamingPullRequest const& request) override {
+    return child_->Write(request);
+  }
+  bool Read(google::pubsub::v1::StreamingPullResponse* response) override {
+    return child_->Read(response);
+  }
+  Status Finish() override { return child_->Finish(); }
+
+ private:
+  std::unique_ptr<StreamingPullStream> child_;
+  std::shared_ptr<ChannelSelector> selector_;
+  std::size_t channel_;
+};
+}  // namespace
+
+SubscriberChannelPool::SubscriberChannelPool(
+    std::size_t size, LazyStubs<SubscriberStub>::Factory factory,
+    std::shared_ptr<HedgeDelay> list_hedge_delay)
+    : children_(size, std::move(factory)),
+      selector_(std::make_shared<ChannelSelector>(children_.size())),
+      list_hedge_delay_(std::move(list_hedge_delay)) {}
+
+SubscriberChannelPool::SubscriberChannelPool(
+    std::vector<std::shared_ptr<SubscriberStub>> children,
+    std::shared_ptr<HedgeDelay> list_hedge_delay)
+    : children_(std::move(children)),
+      selector_(std::make_shared<ChannelSelector>(children_.size())),
+      list_hedge_delay_(std::move(list_hedge_delay)) {}
+
+StatusOr<google::pubsub::v1::Subscription>
+SubscriberChannelPool::CreateSubscription(
+    grpc::ClientContext& client_context,
+    google::pubsub::v1::Subscription const& request) {
+  auto const channel = selector_->Acquire();
+  auto response =
+      children_[channel].CreateSubscription(client_context, request);
+  selector_->Release(channel);
+  return response;
+}
+
+StatusOr<google::pubsub::v1::ListSubscriptionsResponse>
+SubscriberChannelPool::ListSubscriptions(
+    grpc::ClientContext& client_context,
+    google::pubsub::v1::ListSubscriptionsRequest const& request) {
+  auto const channel = selector_->Acquire();
+  auto response =
+      children_[channel].ListSubscriptions(client_context, request);
+  selector_->Release(channel);
+  return response;
+}
+
+future<StatusOr<google::pubsub::v1::ListSubscriptionsResponse>>
+SubscriberChannelPool::AsyncListSubscriptions(
+    google::cloud::grpc_utils::CompletionQueue& cq,
+    std::unique_ptr<grpc::ClientContext> client_context,
+    google::pubsub::v1::ListSubscriptionsRequest const& request) {
+  if (list_hedge_delay_) {
+    return AsyncHedgedCall<google::pubsub::v1::ListSubscriptionsResponse>(
+        selector_, list_hedge_delay_, MakeHedgeTimer(cq),
+        std::move(client_context),
+        [this, cq, request](
+            std::size_t channel,
+            std::unique_ptr<grpc::ClientContext> context) mutable {
+          return children_[channel].AsyncListSubscriptions(
+              cq, std::move(context), request);
+        });
+  }
+  auto const channel = selector_->Acquire();
+  return ReleaseOnCompletion(
+      selector_, channel,
+      children_[channel].AsyncListSubscriptions(
+          cq, std::move(client_context), request));
+}
+
+Status SubscriberChannelPool::DeleteSubscription(
+    grpc::ClientContext& client_context,
+    google::pubsub::v1::DeleteSubscriptionRequest const& request) {
+  auto const channel = selector_->Acquire();
+  auto response =
+      children_[channel].DeleteSubscription(client_context, request);
+  selector_->Release(channel);
+  return response;
+}
+
+future<Status> SubscriberChannelPool::AsyncAcknowledge(
+    google::cloud::grpc_utils::CompletionQueue& cq,
+    std::unique_ptr<grpc::ClientContext> client_context,
+    google::pubsub::v1::AcknowledgeRequest const& request) {
+  auto const channel = selector_->Acquire();
+  return ReleaseOnCompletion(
+      selector_, channel,
+      children_[channel].AsyncAcknowledge(cq, std::move(client_context),
+                                          request));
+}
+
+future<Status> SubscriberChannelPool::AsyncModifyAckDeadline(
+    google::cloud::grpc_utils::CompletionQueue& cq,
+    std::unique_ptr<grpc::ClientContext> client_context,
+    google::pubsub::v1::ModifyAckDeadlineRequest const& request) {
+  auto const channel = selector_->Acquire();
+  return ReleaseOnCompletion(
+      selector_, channel,
+      children_[channel].AsyncModifyAckDeadline(
+          cq, std::move(client_context), request));
+}
+
+future<StatusOr<google::pubsub::v1::PullResponse>>
+SubscriberChannelPool::AsyncPull(
+    google::cloud::grpc_utils::CompletionQueue& cq,
+    std::unique_ptr<grpc::ClientContext> client_context,
+    google::pubsub::v1::PullRequest const& request) {
+  auto const channel = selector_->Acquire();
+  return ReleaseOnCompletion(
+      selector_, channel,
+      children_[channel].AsyncPull(cq, std::move(client_context), request));
+}
+
+std::unique_ptr<StreamingPullStream> SubscriberChannelPool::StreamingPull(
+    std::unique_ptr<grpc::ClientContext> client_context) {
+  auto const channel = selector_->Acquire();
+  auto stream = children_[channel].StreamingPull(std::move(client_context));
+  if (!stream) {
+    selector_->Release(channel);
+    return stream;
+  }
+  return google::cloud::internal::make_unique<TrackedStream>(
+      std::move(stream), selector_, channel);
+}
+
+future<Status> SubscriberChannelPool::AsyncWaitForConnected(
+    google::cloud::grpc_utils::CompletionQueue& cq,
+    std::chrono::system_clock::time_point deadline) {
+  return children_.AsyncWaitForConnected(cq, deadline);
+}
+
+std::shared_ptr<SubscriberChannelPool> CreateDefaultSubscriberStubPool(
+    pubsub::ConnectionOptions const& options,
+    std::shared_ptr<HedgeDelay> list_hedge_delay) {
+  auto const count = (std::max)(1, options.num_channels());
+  return std::make_shared<SubscriberChannelPool>(
+      count,
+      [options](int id) { return CreateDefaultSubscriberStub(options, id); },
+      std::move(list_hedge_delay));
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,240 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/subscriber_channel_pool.h"
+#include "google/cloud/pubsub/internal/background_threads.h"
+#include "google/cloud/pubsub/testing/mock_subscriber_stub.h"
+#include "google/cloud/internal/make_unique.h"
+#include <gmock/gmock.h>
+#include <atomic>
+#include <mutex>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::InvokeWithoutArgs;
+using ::testing::UnorderedElementsAre;
+
+std::vector<std::shared_ptr<pubsub_testing::MockSubscriberStub>> MakeMocks(
+    std::size_t count) {
+  std::vector<std::shared_ptr<pubsub_testing::MockSubscriberStub>> mocks(
+      count);
+  for (auto& m : mocks) {
+    m = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  }
+  return mocks;
+}
+
+std::vector<std::shared_ptr<SubscriberStub>> AsChildren(
+    std::vector<std::shared_ptr<pubsub_testing::MockSubscriberStub>> const&
+        mocks) {
+  return {mocks.begin(), mocks.end()};
+}
+
+class FakeStream : public StreamingPullStream {
+ public:
+  void Cancel() override {}
+  bool Write(google::pubsub::v1::StreamingPullRequest const&) override {
+    return true;
+  }
+  bool Read(google::pubsub::v1::StreamingPullResponse*) override {
+    return false;
+  }
+  Status Finish() override { return Status{}; }
+};
+
+TEST(SubscriberChannelPoolTest, AdminOperations) {
+  auto mocks = MakeMocks(3);
+  int calls = 0;
+  for (auto& m : mocks) {
+    EXPECT_CALL(*m, CreateSubscription)
+        .WillRepeatedly(InvokeWithoutArgs([&calls] {
+          ++calls;
+          return StatusOr<google::pubsub::v1::Subscription>(
+              google::pubsub::v1::Subscription{});
+        }));
+    EXPECT_CALL(*m, ListSubscriptions)
+        .WillRepeatedly(InvokeWithoutArgs([&calls] {
+          ++calls;
+          return StatusOr<google::pubsub::v1::ListSubscriptionsResponse>(
+              google::pubsub::v1::ListSubscriptionsResponse{});
+        }));
+    EXPECT_CALL(*m, DeleteSubscription)
+        .WillRepeatedly(InvokeWithoutArgs([&calls] {
+          ++calls;
+          return Status{};
+        }));
+  }
+  SubscriberChannelPool stub(AsChildren(mocks));
+  for (int i = 0; i != 4; ++i) {
+    grpc::ClientContext c0;
+    EXPECT_TRUE(stub.CreateSubscription(c0, {}).ok());
+    grpc::ClientContext c1;
+    EXPECT_TRUE(stub.ListSubscriptions(c1, {}).ok());
+    grpc::ClientContext c2;
+    EXPECT_TRUE(stub.DeleteSubscription(c2, {}).ok());
+  }
+  EXPECT_EQ(12, calls);
+  EXPECT_THAT(stub.in_flight(), ElementsAre(0, 0, 0));
+}
+
+TEST(SubscriberChannelPoolTest, AsyncOperationsAvoidBusyChannel) {
+  auto mocks = MakeMocks(2);
+  std::vector<promise<Status>> pending;
+  pending.reserve(2);
+  promise<StatusOr<google::pubsub::v1::PullResponse>> pull;
+  // The acknowledgement is in flight on one channel, the deadline
+  // modification must use the other channel. Once both complete, the pull
+  // can use either.
+  for (auto& m : mocks) {
+    EXPECT_CALL(*m, AsyncAcknowledge)
+        .Times(testing::AtMost(1))
+        .WillRepeatedly(InvokeWithoutArgs([&pending] {
+          pending.emplace_back();
+          return pending.back().get_future();
+        }));
+    EXPECT_CALL(*m, AsyncModifyAckDeadline)
+        .Times(testing::AtMost(1))
+        .WillRepeatedly(InvokeWithoutArgs([&pending] {
+          pending.emplace_back();
+          return pending.back().get_future();
+        }));
+    EXPECT_CALL(*m, AsyncPull)
+        .Times(testing::AtMost(1))
+        .WillRepeatedly(InvokeWithoutArgs([&pull] {
+          return pull.get_future();
+        }));
+  }
+  SubscriberChannelPool stub(AsChildren(mocks));
+  google::cloud::grpc_utils::CompletionQueue cq;
+  using google::cloud::internal::make_unique;
+  auto ack = stub.AsyncAcknowledge(cq, make_unique<grpc::ClientContext>(), {});
+  auto modify =
+      stub.AsyncModifyAckDeadline(cq, make_unique<grpc::ClientContext>(), {});
+  EXPECT_THAT(stub.in_flight(), ElementsAre(1, 1));
+  for (auto& p : pending) p.set_value(Status{});
+  EXPECT_TRUE(ack.get().ok());
+  EXPECT_TRUE(modify.get().ok());
+  EXPECT_THAT(stub.in_flight(), ElementsAre(0, 0));
+
+  auto r = stub.AsyncPull(cq, make_unique<grpc::ClientContext>(), {});
+  pull.set_value(StatusOr<google::pubsub::v1::PullResponse>(
+      google::pubsub::v1::PullResponse{}));
+  EXPECT_TRUE(r.get().ok());
+  EXPECT_THAT(stub.in_flight(), ElementsAre(0, 0));
+}
+
+TEST(SubscriberChannelPoolTest, StreamingPullCountsUntilClosed) {
+  auto mocks = MakeMocks(2);
+  for (auto& m : mocks) {
+    EXPECT_CALL(*m, StreamingPull).WillOnce(InvokeWithoutArgs([] {
+      return std::unique_ptr<StreamingPullStream>(
+          google::cloud::internal::make_unique<FakeStream>());
+    }));
+  }
+  SubscriberChannelPool stub(AsChildren(mocks));
+  using google::cloud::internal::make_unique;
+  auto s0 = stub.StreamingPull(make_unique<grpc::ClientContext>());
+  ASSERT_NE(nullptr, s0);
+  auto s1 = stub.StreamingPull(make_unique<grpc::ClientContext>());
+  ASSERT_NE(nullptr, s1);
+  EXPECT_THAT(stub.in_flight(), ElementsAre(1, 1));
+  EXPECT_TRUE(s0->Write({}));
+  EXPECT_FALSE(s0->Read(nullptr));
+  EXPECT_TRUE(s0->Finish().ok());
+  s0.reset();
+  s1.reset();
+  EXPECT_THAT(stub.in_flight(), ElementsAre(0, 0));
+}
+
+TEST(SubscriberChannelPoolTest, StreamingPullFailure) {
+  auto mocks = MakeMocks(1);
+  EXPECT_CALL(*mocks[0], StreamingPull).WillOnce(InvokeWithoutArgs([] {
+    return std::unique_ptr<StreamingPullStream>{};
+  }));
+  SubscriberChannelPool stub(AsChildren(mocks));
+  EXPECT_EQ(nullptr,
+            stub.StreamingPull(
+                google::cloud::internal::make_unique<grpc::ClientContext>()));
+  EXPECT_THAT(stub.in_flight(), ElementsAre(0));
+}
+
+TEST(SubscriberChannelPoolTest, ListSubscriptionsHedged) {
+  using Response = StatusOr<google::pubsub::v1::ListSubscriptionsResponse>;
+  auto mocks = MakeMocks(2);
+  // The first call does not complete until the test satisfies `slow`, the
+  // hedge on the other channel completes immediately.
+  promise<Response> slow;
+  std::atomic<int> calls(0);
+  for (auto& m : mocks) {
+    EXPECT_CALL(*m, AsyncListSubscriptions)
+        .WillRepeatedly(InvokeWithoutArgs([&calls, &slow] {
+          if (calls.fetch_add(1) == 0) return slow.get_future();
+          google::pubsub::v1::ListSubscriptionsResponse response;
+          response.add_subscriptions()->set_name("subscriptions/hedged");
+          return make_ready_future(Response(std::move(response)));
+        }));
+  }
+  auto delay = std::make_shared<HedgeDelay>();
+  for (int i = 0; i != 16; ++i) delay->Record(std::chrono::milliseconds(10));
+  SubscriberChannelPool stub(AsChildren(mocks), delay);
+  BackgroundThreads background(1);
+  auto cq = background.cq();
+  auto response =
+      stub.AsyncListSubscriptions(
+              cq, google::cloud::internal::make_unique<grpc::ClientContext>(),
+              {})
+          .get();
+  ASSERT_TRUE(response.ok());
+  ASSERT_EQ(1, response->subscriptions_size());
+  EXPECT_EQ("subscriptions/hedged", response->subscriptions(0).name());
+  EXPECT_EQ(2, calls.load());
+  // The slow call is still in flight.
+  EXPECT_THAT(stub.in_flight(), UnorderedElementsAre(0, 1));
+
+  slow.set_value(Response(Status(StatusCode::kCancelled, "cancelled")));
+  EXPECT_THAT(stub.in_flight(), ElementsAre(0, 0));
+}
+
+TEST(SubscriberChannelPoolTest, LazyCreation) {
+  // The children are created by `AsyncWaitForConnected()`.
+  std::mutex mu;
+  std::vector<int> created;
+  SubscriberChannelPool stub(2, [&mu, &created](int id) {
+    std::lock_guard<std::mutex> lk(mu);
+    created.push_back(id);
+    auto mock = std::make_shared<pubsub_testing::MockSubscriberStub>();
+    EXPECT_CALL(*mock, AsyncWaitForConnected).WillOnce(InvokeWithoutArgs([] {
+      return make_ready_future(
+          Status(StatusCode::kDeadlineExceeded, "timeout"));
+    }));
+    return mock;
+  });
+  EXPECT_TRUE(created.empty());
+  google::cloud::grpc_utils::CompletionQueue cq;
+  auto status =
+      stub.AsyncWaitForConnected(cq, std::chrono::system_clock::now()).get();
+  EXPECT_EQ(StatusCode::kDeadlineExceeded, status.code());
+  EXPECT_EQ(2U, created.size());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,59 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_SUBSCRIBER_COUNTERS_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_SUBSCRIBER_COUNTERS_H
+
+#include "google/cloud/pubsub/subscriber_statistics.h"
+#include "google/cloud/pubsub/version.h"
+#include <atomic>
+#include <cstdint>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * The counters shared by all the sessions in a subscriber connection.
+ *
+ * The counters are updated without locking, a snapshot may be slightly
+ * inconsistent if it is taken while the counters change.
+ */
+struct SubscriberCounters {
+  std::atomic<std::uint64_t> ack_batches{0};
+  std::atomic<std::uint64_t> ack_batch_items{0};
+  std::atomic<std::uint64_t> unary_ack_batches{0};
+  std::atomic<std::uint64_t> flow_control_pauses{0};
+  std::atomic<std::uint64_t> duplicate_filter_lookups{0};
+  std::atomic<std::uint64_t> duplicate_filter_hits{0};
+
+  pubsub::SubscriberStatistics Snapshot() const {
+    pubsub::SubscriberStatistics s;
+    s.ack_batches = ack_batches.load();
+    s.ack_batch_items = ack_batch_items.load();
+    s.unary_ack_batches = unary_ack_batches.load();
+    s.flow_control_pauses = flow_control_pauses.load();
+    s.duplicate_filter_lookups = duplicate_filter_lookups.load();
+    s.duplicate_filter_hits = duplicate_filter_hits.load();
+    return s;
+  }
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_SUBSCRIBER_COUNTERS_H
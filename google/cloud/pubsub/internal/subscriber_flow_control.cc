@@ -0,0 +1,70 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/subscriber_flow_control.h"
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+void SubscriberFlowControl::Add(std::size_t bytes) {
+  std::lock_guard<std::mutex> lk(mu_);
+  ++messages_;
+  bytes_ += bytes;
+}
+
+void SubscriberFlowControl::Release(std::size_t messages, std::size_t bytes) {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    messages_ -= messages;
+    bytes_ -= bytes;
+  }
+  cv_.notify_all();
+}
+
+bool SubscriberFlowControl::WaitForCapacity() {
+  std::unique_lock<std::mutex> lk(mu_);
+  if (HasCapacity()) return false;
+  cv_.wait(lk, [this] { return HasCapacity(); });
+  return true;
+}
+
+void SubscriberFlowControl::Shutdown() {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    shutdown_ = true;
+  }
+  cv_.notify_all();
+}
+
+std::size_t SubscriberFlowControl::messages() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return messages_;
+}
+
+std::size_t SubscriberFlowControl::bytes() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return bytes_;
+}
+
+bool SubscriberFlowControl::HasCapacity() const {
+  if (shutdown_ || messages_ == 0) return true;
+  return messages_ < maximum_messages_ && bytes_ < maximum_bytes_;
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
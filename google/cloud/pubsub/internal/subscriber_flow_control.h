@@ -0,0 +1,83 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_SUBSCRIBER_FLOW_CONTROL_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_SUBSCRIBER_FLOW_CONTROL_H
+
+#include "google/cloud/pubsub/version.h"
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Track the number of outstanding messages and bytes in a subscription
+ * session.
+ *
+ * Messages are received in batches, the session cannot refuse a message once
+ * it is received, so `Add()` never blocks. Instead the session calls
+ * `WaitForCapacity()` before reading the next batch, this pauses the stream
+ * while the limits are exceeded. To make progress with messages larger than
+ * the byte limit the stream is never paused if there are no outstanding
+ * messages.
+ */
+class SubscriberFlowControl {
+ public:
+  SubscriberFlowControl(std::size_t maximum_messages, std::size_t maximum_bytes)
+      : maximum_messages_(maximum_messages), maximum_bytes_(maximum_bytes) {}
+
+  /// Add a received message of @p bytes.
+  void Add(std::size_t bytes);
+
+  /// Release @p messages outstanding messages, with @p bytes in total.
+  void Release(std::size_t messages, std::size_t bytes);
+
+  /**
+   * Block until the outstanding messages are below the limits.
+   *
+   * Returns `true` if the caller had to wait.
+   */
+  bool WaitForCapacity();
+
+  /// Unblock any current and future calls to `WaitForCapacity()`.
+  void Shutdown();
+
+  /// The number of outstanding messages.
+  std::size_t messages() const;
+
+  /// The total size of the outstanding messages.
+  std::size_t bytes() const;
+
+ private:
+  bool HasCapacity() const;
+
+  std::size_t const maximum_messages_;
+  std::size_t const maximum_bytes_;
+  mutable std::mutex mu_;
+  std::condition_variable cv_;
+  std::size_t messages_ = 0;
+  std::size_t bytes_ = 0;
+  bool shutdown_ = false;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_SUBSCRIBER_FLOW_CONTROL_H
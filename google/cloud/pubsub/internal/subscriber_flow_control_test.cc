@@ -0,0 +1,86 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/subscriber_flow_control.h"
+#include "google/cloud/future.h"
+#include <gmock/gmock.h>
+#include <chrono>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+TEST(SubscriberFlowControlTest, MessageLimit) {
+  SubscriberFlowControl tested(2, 1000);
+  tested.Add(10);
+  EXPECT_FALSE(tested.WaitForCapacity());
+  tested.Add(10);
+  tested.Add(10);
+  EXPECT_EQ(3U, tested.messages());
+  EXPECT_EQ(30U, tested.bytes());
+
+  promise<void> resumed;
+  std::thread t([&] {
+    tested.WaitForCapacity();
+    resumed.set_value();
+  });
+  auto f = resumed.get_future();
+  EXPECT_EQ(std::future_status::timeout,
+            f.wait_for(std::chrono::milliseconds(10)));
+  tested.Release(2, 20);
+  f.get();
+  t.join();
+  EXPECT_EQ(1U, tested.messages());
+  EXPECT_EQ(10U, tested.bytes());
+}
+
+TEST(SubscriberFlowControlTest, ByteLimit) {
+  SubscriberFlowControl tested(100, 100);
+  tested.Add(60);
+  EXPECT_FALSE(tested.WaitForCapacity());
+  tested.Add(60);
+
+  std::thread t([&] { tested.WaitForCapacity(); });
+  tested.Release(1, 60);
+  t.join();
+  EXPECT_FALSE(tested.WaitForCapacity());
+}
+
+TEST(SubscriberFlowControlTest, LargeMessage) {
+  SubscriberFlowControl tested(100, 100);
+  tested.Add(500);
+  tested.Release(1, 500);
+  // Nothing is outstanding, the stream is never paused.
+  EXPECT_FALSE(tested.WaitForCapacity());
+}
+
+TEST(SubscriberFlowControlTest, Shutdown) {
+  SubscriberFlowControl tested(1, 100);
+  tested.Add(10);
+  tested.Add(10);
+
+  std::thread t([&] { tested.WaitForCapacity(); });
+  tested.Shutdown();
+  t.join();
+  EXPECT_FALSE(tested.WaitForCapacity());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
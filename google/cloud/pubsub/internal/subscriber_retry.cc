@@ -0,0 +1,141 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/subscriber_retry.h"
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+namespace {
+using Operation = pubsub::IdempotencyPolicy::Operation;
+}  // namespace
+
+StatusOr<google::pubsub::v1::Subscription> SubscriberRetry::CreateSubscription(
+    grpc::ClientContext& client_context,
+    google::pubsub::v1::Subscription const& request) {
+  auto& child = *child_;
+  return RetryLoop(
+      policies_, Operation::kCreateSubscription,
+      [&child](grpc::ClientContext& context,
+               google::pubsub::v1::Subscription const& request) {
+        return child.CreateSubscription(context, request);
+      },
+      client_context, request);
+}
+
+StatusOr<google::pubsub::v1::ListSubscriptionsResponse>
+SubscriberRetry::ListSubscriptions(
+    grpc::ClientContext& client_context,
+    google::pubsub::v1::ListSubscriptionsRequest const& request) {
+  auto& child = *child_;
+  return RetryLoop(
+      policies_, Operation::kListSubscriptions,
+      [&child](grpc::ClientContext& context,
+               google::pubsub::v1::ListSubscriptionsRequest const& request) {
+        return child.ListSubscriptions(context, request);
+      },
+      client_context, request);
+}
+
+future<StatusOr<google::pubsub::v1::ListSubscriptionsResponse>>
+SubscriberRetry::AsyncListSubscriptions(
+    google::cloud::grpc_utils::CompletionQueue& cq,
+    std::unique_ptr<grpc::ClientContext> client_context,
+    google::pubsub::v1::ListSubscriptionsRequest const& request) {
+  auto child = child_;
+  return AsyncRetryLoop(
+      policies_, Operation::kListSubscriptions,
+      [child](google::cloud::grpc_utils::CompletionQueue& cq,
+              std::unique_ptr<grpc::ClientContext> context,
+              google::pubsub::v1::ListSubscriptionsRequest const& request) {
+        return child->AsyncListSubscriptions(cq, std::move(context), request);
+      },
+      cq, std::move(client_context), request);
+}
+
+Status SubscriberRetry::DeleteSubscription(
+    grpc::ClientContext& client_context,
+    google::pubsub::v1::DeleteSubscriptionRequest const& request) {
+  auto& child = *child_;
+  return RetryLoop(
+      policies_, Operation::kDeleteSubscription,
+      [&child](grpc::ClientContext& context,
+               google::pubsub::v1::DeleteSubscriptionRequest const& request) {
+        return child.DeleteSubscription(context, request);
+      },
+      client_context, request);
+}
+
+future<Status> SubscriberRetry::AsyncAcknowledge(
+    google::cloud::grpc_utils::CompletionQueue& cq,
+    std::unique_ptr<grpc::ClientContext> client_context,
+    google::pubsub::v1::AcknowledgeRequest const& request) {
+  auto child = child_;
+  return AsyncRetryLoop(
+      policies_, Operation::kAcknowledge,
+      [child](google::cloud::grpc_utils::CompletionQueue& cq,
+              std::unique_ptr<grpc::ClientContext> context,
+              google::pubsub::v1::AcknowledgeRequest const& request) {
+        return child->AsyncAcknowledge(cq, std::move(context), request);
+      },
+      cq, std::move(client_context), request);
+}
+
+future<Status> SubscriberRetry::AsyncModifyAckDeadline(
+    google::cloud::grpc_utils::CompletionQueue& cq,
+    std::unique_ptr<grpc::ClientContext> client_context,
+    google::pubsub::v1::ModifyAckDeadlineRequest const& request) {
+  auto child = child_;
+  return AsyncRetryLoop(
+      policies_, Operation::kModifyAckDeadline,
+      [child](google::cloud::grpc_utils::CompletionQueue& cq,
+              std::unique_ptr<grpc::ClientContext> context,
+              google::pubsub::v1::ModifyAckDeadlineRequest const& request) {
+        return child->AsyncModifyAckDeadline(cq, std::move(context), request);
+      },
+      cq, std::move(client_context), request);
+}
+
+future<StatusOr<google::pubsub::v1::PullResponse>> SubscriberRetry::AsyncPull(
+    google::cloud::grpc_utils::CompletionQueue& cq,
+    std::unique_ptr<grpc::ClientContext> client_context,
+    google::pubsub::v1::PullRequest const& request) {
+  auto child = child_;
+  return AsyncRetryLoop(
+      policies_, Operation::kPull,
+      [child](google::cloud::grpc_utils::CompletionQueue& cq,
+              std::unique_ptr<grpc::ClientContext> context,
+              google::pubsub::v1::PullRequest const& request) {
+        return child->AsyncPull(cq, std::move(context), request);
+      },
+      cq, std::move(client_context), request);
+}
+
+std::unique_ptr<StreamingPullStream> SubscriberRetry::StreamingPull(
+    std::unique_ptr<grpc::ClientContext> client_context) {
+  return child_->StreamingPull(std::move(client_context));
+}
+
+future<Status> SubscriberRetry::AsyncWaitForConnected(
+    google::cloud::grpc_utils::CompletionQueue& cq,
+    std::chrono::system_clock::time_point deadline) {
+  return child_->AsyncWaitForConnected(cq, deadline);
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,92 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_SUBSCRIBER_RETRY_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_SUBSCRIBER_RETRY_H
+
+#include "google/cloud/pubsub/internal/retry_loop.h"
+#include "google/cloud/pubsub/internal/subscriber_stub.h"
+#include "google/cloud/pubsub/version.h"
+#include <memory>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * A `SubscriberStub` decorator retrying the failed unary calls.
+ *
+ * Each unary call is retried according to the `RetryPolicies`. The
+ * `StreamingPull` streams are not retried here, the subscription sessions
+ * already reconnect their streams.
+ */
+class SubscriberRetry : public SubscriberStub {
+ public:
+  SubscriberRetry(std::shared_ptr<SubscriberStub> child,
+                  RetryPolicies policies)
+      : child_(std::move(child)), policies_(std::move(policies)) {}
+  ~SubscriberRetry() override = default;
+
+  StatusOr<google::pubsub::v1::Subscription> CreateSubscription(
+      grpc::ClientContext& client_context,
+      google::pubsub::v1::Subscription const& request) override;
+
+  StatusOr<google::pubsub::v1::ListSubscriptionsResponse> ListSubscriptions(
+      grpc::ClientContext& client_context,
+      google::pubsub::v1::ListSubscriptionsRequest const& request) override;
+
+  future<StatusOr<google::pubsub::v1::ListSubscriptionsResponse>>
+  AsyncListSubscriptions(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::unique_ptr<grpc::ClientContext> client_context,
+      google::pubsub::v1::ListSubscriptionsRequest const& request) override;
+
+  Status DeleteSubscription(
+      grpc::ClientContext& client_context,
+      google::pubsub::v1::DeleteSubscriptionRequest const& request) override;
+
+  future<Status> AsyncAcknowledge(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::unique_ptr<grpc::ClientContext> client_context,
+      google::pubsub::v1::AcknowledgeRequest const& request) override;
+
+  future<Status> AsyncModifyAckDeadline(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::unique_ptr<grpc::ClientContext> client_context,
+      google::pubsub::v1::ModifyAckDeadlineRequest const& request) override;
+
+  future<StatusOr<google::pubsub::v1::PullResponse>> AsyncPull(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::unique_ptr<grpc::ClientContext> client_context,
+      google::pubsub::v1::PullRequest const& request) override;
+
+  std::unique_ptr<StreamingPullStream> StreamingPull(
+      std::unique_ptr<grpc::ClientContext> client_context) override;
+
+  future<Status> AsyncWaitForConnected(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::chrono::system_clock::time_point deadline) override;
+
+ private:
+  std::shared_ptr<SubscriberStub> child_;
+  RetryPolicies policies_;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_SUBSCRIBER_RETRY_H
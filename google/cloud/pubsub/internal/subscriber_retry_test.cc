@@ -0,0 +1,132 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/subscriber_retry.h"
+#include "google/cloud/pubsub/internal/background_threads.h"
+#include "google/cloud/pubsub/testing/mock_subscriber_stub.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using ::testing::InvokeWithoutArgs;
+using ::testing::Return;
+
+RetryPolicies TestPolicies() {
+  return RetryPolicies{
+      std::make_shared<pubsub::LimitedErrorCountRetryPolicy>(3),
+      std::make_shared<pubsub::ExponentialBackoffPolicy>(
+          std::chrono::milliseconds(1), std::chrono::milliseconds(2), 2.0),
+      std::make_shared<pubsub::DefaultIdempotencyPolicy>(),
+      std::make_shared<RetryBudget>(0, 0)};
+}
+
+Status Transient() { return Status(StatusCode::kUnavailable, "try-again"); }
+
+TEST(SubscriberRetryTest, AdminOperations) {
+  auto mock = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  EXPECT_CALL(*mock, CreateSubscription)
+      .WillOnce(
+          Return(StatusOr<google::pubsub::v1::Subscription>(Transient())));
+  EXPECT_CALL(*mock, ListSubscriptions)
+      .WillOnce(Return(
+          StatusOr<google::pubsub::v1::ListSubscriptionsResponse>(Transient())))
+      .WillOnce(Return(StatusOr<google::pubsub::v1::ListSubscriptionsResponse>(
+          google::pubsub::v1::ListSubscriptionsResponse{})));
+  EXPECT_CALL(*mock, DeleteSubscription).WillOnce(Return(Transient()));
+
+  SubscriberRetry stub(mock, TestPolicies());
+  grpc::ClientContext c0;
+  EXPECT_EQ(StatusCode::kUnavailable,
+            stub.CreateSubscription(c0, {}).status().code());
+  grpc::ClientContext c1;
+  EXPECT_TRUE(stub.ListSubscriptions(c1, {}).ok());
+  grpc::ClientContext c2;
+  EXPECT_EQ(StatusCode::kUnavailable, stub.DeleteSubscription(c2, {}).code());
+}
+
+TEST(SubscriberRetryTest, AsyncOperations) {
+  auto mock = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  auto transient = [] { return make_ready_future(Transient()); };
+  auto success = [] { return make_ready_future(Status{}); };
+  EXPECT_CALL(*mock, AsyncAcknowledge)
+      .WillOnce(InvokeWithoutArgs(transient))
+      .WillOnce(InvokeWithoutArgs(success));
+  EXPECT_CALL(*mock, AsyncModifyAckDeadline)
+      .WillOnce(InvokeWithoutArgs(transient))
+      .WillOnce(InvokeWithoutArgs(success));
+  EXPECT_CALL(*mock, AsyncPull)
+      .WillOnce(InvokeWithoutArgs([] {
+        return make_ready_future(
+            StatusOr<google::pubsub::v1::PullResponse>(Transient()));
+      }))
+      .WillOnce(InvokeWithoutArgs([] {
+        return make_ready_future(StatusOr<google::pubsub::v1::PullResponse>(
+            google::pubsub::v1::PullResponse{}));
+      }));
+  using ListResponse = StatusOr<google::pubsub::v1::ListSubscriptionsResponse>;
+  EXPECT_CALL(*mock, AsyncListSubscriptions)
+      .WillOnce(InvokeWithoutArgs(
+          [] { return make_ready_future(ListResponse(Transient())); }))
+      .WillOnce(InvokeWithoutArgs([] {
+        return make_ready_future(
+            ListResponse(google::pubsub::v1::ListSubscriptionsResponse{}));
+      }));
+
+  SubscriberRetry stub(mock, TestPolicies());
+  BackgroundThreads background(1);
+  auto cq = background.cq();
+  using google::cloud::internal::make_unique;
+  EXPECT_TRUE(
+      stub.AsyncAcknowledge(cq, make_unique<grpc::ClientContext>(), {})
+          .get()
+          .ok());
+  EXPECT_TRUE(
+      stub.AsyncModifyAckDeadline(cq, make_unique<grpc::ClientContext>(), {})
+          .get()
+          .ok());
+  EXPECT_TRUE(
+      stub.AsyncPull(cq, make_unique<grpc::ClientContext>(), {}).get().ok());
+  EXPECT_TRUE(
+      stub.AsyncListSubscriptions(cq, make_unique<grpc::ClientContext>(), {})
+          .get()
+          .ok());
+}
+
+TEST(SubscriberRetryTest, StreamingPullNotRetried) {
+  auto mock = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  EXPECT_CALL(*mock, StreamingPull).WillOnce(InvokeWithoutArgs([] {
+    return std::unique_ptr<StreamingPullStream>{};
+  }));
+  EXPECT_CALL(*mock, AsyncWaitForConnected).WillOnce(InvokeWithoutArgs([] {
+    return make_ready_future(Status{});
+  }));
+  SubscriberRetry stub(mock, TestPolicies());
+  EXPECT_EQ(nullptr,
+            stub.StreamingPull(
+                google::cloud::internal::make_unique<grpc::ClientContext>()));
+  google::cloud::grpc_utils::CompletionQueue cq;
+  auto status =
+      stub.AsyncWaitForConnected(cq, std::chrono::system_clock::now()).get();
+  EXPECT_TRUE(status.ok());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -13,18 +13,56 @@
 // limitations under the License.
 
 #include "google/cloud/pubsub/internal/subscriber_stub.h"
+#include "google/cloud/pubsub/internal/connection_ready.h"
 #include "google/cloud/grpc_error_delegate.h"
+#include "google/cloud/internal/make_unique.h"
 
 namespace google {
 namespace cloud {
 namespace pubsub_internal {
 inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
 
+namespace {
+class DefaultStreamingPullStream : public StreamingPullStream {
+ public:
+  using GrpcStream = grpc::ClientReaderWriterInterface<
+      google::pubsub::v1::StreamingPullRequest,
+      google::pubsub::v1::StreamingPullResponse>;
+
+  DefaultStreamingPullStream(std::unique_ptr<grpc::ClientContext> context,
+                             std::unique_ptr<GrpcStream> stream)
+      : context_(std::move(context)), stream_(std::move(stream)) {}
+
+  ~DefaultStreamingPullStream() override = default;
+
+  void Cancel() override { context_->TryCancel(); }
+
+  bool Write(google::pubsub::v1::StreamingPullRequest const& request) override {
+    return stream_->Write(request);
+  }
+
+  bool Read(google::pubsub::v1::StreamingPullResponse* response) override {
+    return stream_->Read(response);
+  }
+
+  Status Finish() override {
+    stream_->WritesDone();
+    return google::cloud::MakeStatusFromRpcError(stream_->Finish());
+  }
+
+ private:
+  // The context must outlive the stream.
+  std::unique_ptr<grpc::ClientContext> context_;
+  std::unique_ptr<GrpcStream> stream_;
+};
+}  // namespace
+
 class DefaultSubscriberStub : public SubscriberStub {
  public:
-  explicit DefaultSubscriberStub(
+  DefaultSubscriberStub(
+      std::shared_ptr<grpc::Channel> channel,
       std::unique_ptr<google::pubsub::v1::Subscriber::StubInterface> grpc_stub)
-      : grpc_stub_(std::move(grpc_stub)) {}
+      : channel_(std::move(channel)), grpc_stub_(std::move(grpc_stub)) {}
 
   ~DefaultSubscriberStub() override = default;
 
@@ -50,6 +88,20 @@ class DefaultSubscriberStub : public SubscriberStub {
     return response;
   }
 
+  future<StatusOr<google::pubsub::v1::ListSubscriptionsResponse>>
+  AsyncListSubscriptions(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::unique_ptr<grpc::ClientContext> context,
+      google::pubsub::v1::ListSubscriptionsRequest const& request) override {
+    return cq.MakeUnaryRpc(
+        [this](grpc::ClientContext* context,
+               google::pubsub::v1::ListSubscriptionsRequest const& request,
+               grpc::CompletionQueue* cq) {
+          return grpc_stub_->AsyncListSubscriptions(context, request, cq);
+        },
+        request, std::move(context));
+  }
+
   Status DeleteSubscription(
       grpc::ClientContext& context,
       google::pubsub::v1::DeleteSubscriptionRequest const& request) override {
@@ -61,7 +113,68 @@ class DefaultSubscriberStub : public SubscriberStub {
     return {};
   }
 
+  future<Status> AsyncAcknowledge(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::unique_ptr<grpc::ClientContext> context,
+      google::pubsub::v1::AcknowledgeRequest const& request) override {
+    return cq
+        .MakeUnaryRpc(
+            [this](grpc::ClientContext* context,
+                   google::pubsub::v1::AcknowledgeRequest const& request,
+                   grpc::CompletionQueue* cq) {
+              return grpc_stub_->AsyncAcknowledge(context, request, cq);
+            },
+            request, std::move(context))
+        .then([](future<StatusOr<google::protobuf::Empty>> f) {
+          return f.get().status();
+        });
+  }
+
+  future<Status> AsyncModifyAckDeadline(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::unique_ptr<grpc::ClientContext> context,
+      google::pubsub::v1::ModifyAckDeadlineRequest const& request) override {
+    return cq
+        .MakeUnaryRpc(
+            [this](grpc::ClientContext* context,
+                   google::pubsub::v1::ModifyAckDeadlineRequest const& request,
+                   grpc::CompletionQueue* cq) {
+              return grpc_stub_->AsyncModifyAckDeadline(context, request, cq);
+            },
+            request, std::move(context))
+        .then([](future<StatusOr<google::protobuf::Empty>> f) {
+          return f.get().status();
+        });
+  }
+
+  future<StatusOr<google::pubsub::v1::PullResponse>> AsyncPull(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::unique_ptr<grpc::ClientContext> context,
+      google::pubsub::v1::PullRequest const& request) override {
+    return cq.MakeUnaryRpc(
+        [this](grpc::ClientContext* context,
+               google::pubsub::v1::PullRequest const& request,
+               grpc::CompletionQueue* cq) {
+          return grpc_stub_->AsyncPull(context, request, cq);
+        },
+        request, std::move(context));
+  }
+
+  std::unique_ptr<StreamingPullStream> StreamingPull(
+      std::unique_ptr<grpc::ClientContext> context) override {
+    auto stream = grpc_stub_->StreamingPull(context.get());
+    return google::cloud::internal::make_unique<DefaultStreamingPullStream>(
+        std::move(context), std::move(stream));
+  }
+
+  future<Status> AsyncWaitForConnected(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::chrono::system_clock::time_point deadline) override {
+    return pubsub_internal::AsyncWaitForConnected(cq, channel_, deadline);
+  }
+
  private:
+  std::shared_ptr<grpc::Channel> channel_;
   std::unique_ptr<google::pubsub::v1::Subscriber::StubInterface> grpc_stub_;
 };
 
@@ -74,11 +187,10 @@ std::shared_ptr<SubscriberStub> CreateDefaultSubscriberStub(
   auto channel = grpc::CreateCustomChannel(
       options.endpoint(), options.credentials(), channel_arguments);
 
-  auto grpc_stub =
-      google::pubsub::v1::Subscriber::NewStub(grpc::CreateCustomChannel(
-          options.endpoint(), options.credentials(), channel_arguments));
+  auto grpc_stub = google::pubsub::v1::Subscriber::NewStub(channel);
 
-  return std::make_shared<DefaultSubscriberStub>(std::move(grpc_stub));
+  return std::make_shared<DefaultSubscriberStub>(std::move(channel),
+                                                 std::move(grpc_stub));
 }
 
 }  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
@@ -16,14 +16,44 @@
 #define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_SUBSCRIBER_STUB_H
 
 #include "google/cloud/pubsub/connection_options.h"
+#include "google/cloud/future.h"
+#include "google/cloud/grpc_utils/completion_queue.h"
 #include "google/cloud/status_or.h"
 #include <google/pubsub/v1/pubsub.grpc.pb.h>
+#include <chrono>
+#include <memory>
 
 namespace google {
 namespace cloud {
 namespace pubsub_internal {
 inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
 
+/**
+ * Wrap a bidirectional `StreamingPull` stream.
+ *
+ * The session reading from the stream runs in its own thread, while the
+ * acknowledgements are written from the threads running the application
+ * callbacks. Implementations must support one `Read()` concurrently with one
+ * `Write()`, and `Cancel()` at any time from any thread.
+ */
+class StreamingPullStream {
+ public:
+  virtual ~StreamingPullStream() = default;
+
+  /// Cancel the stream, any blocked `Read()` or `Write()` calls return `false`.
+  virtual void Cancel() = 0;
+
+  /// Send a request, returns `false` if the stream is closed.
+  virtual bool Write(
+      google::pubsub::v1::StreamingPullRequest const& request) = 0;
+
+  /// Block until a response is received, returns `false` at end of stream.
+  virtual bool Read(google::pubsub::v1::StreamingPullResponse* response) = 0;
+
+  /// Return the final status of the stream, call after `Read()` fails.
+  virtual Status Finish() = 0;
+};
+
 /**
  * Define the interface for the gRPC wrapper.
  *
@@ -49,10 +79,48 @@ class SubscriberStub {
       grpc::ClientContext& client_context,
       google::pubsub::v1::ListSubscriptionsRequest const& request) = 0;
 
+  /// List existing subscriptions, used to hedge slow pages.
+  virtual future<StatusOr<google::pubsub::v1::ListSubscriptionsResponse>>
+  AsyncListSubscriptions(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::unique_ptr<grpc::ClientContext> client_context,
+      google::pubsub::v1::ListSubscriptionsRequest const& request) = 0;
+
   /// Delete a subscription.
   virtual Status DeleteSubscription(
       grpc::ClientContext& client_context,
       google::pubsub::v1::DeleteSubscriptionRequest const& request) = 0;
+
+  /// Acknowledge messages, used when there is no stream to send them.
+  virtual future<Status> AsyncAcknowledge(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::unique_ptr<grpc::ClientContext> client_context,
+      google::pubsub::v1::AcknowledgeRequest const& request) = 0;
+
+  /// Modify the ack deadline of messages, used when there is no stream.
+  virtual future<Status> AsyncModifyAckDeadline(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::unique_ptr<grpc::ClientContext> client_context,
+      google::pubsub::v1::ModifyAckDeadlineRequest const& request) = 0;
+
+  /// Pull a batch of messages, used by the synchronous `Pull()` API.
+  virtual future<StatusOr<google::pubsub::v1::PullResponse>> AsyncPull(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::unique_ptr<grpc::ClientContext> client_context,
+      google::pubsub::v1::PullRequest const& request) = 0;
+
+  /// Start a bidirectional stream to receive messages.
+  virtual std::unique_ptr<StreamingPullStream> StreamingPull(
+      std::unique_ptr<grpc::ClientContext> client_context) = 0;
+
+  /**
+   * Connect the underlying channel.
+   *
+   * The future is satisfied once the channel is ready, or at @p deadline.
+   */
+  virtual future<Status> AsyncWaitForConnected(
+      google::cloud::grpc_utils::CompletionQueue& cq,
+      std::chrono::system_clock::time_point deadline) = 0;
 };
 
 /**
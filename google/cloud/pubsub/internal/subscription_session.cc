@@ -0,0 +1,397 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/subscription_session.h"
+#include "google/cloud/pubsub/internal/arena_pool.h"
+#include "google/cloud/pubsub/message.h"
+#include "google/cloud/pubsub/retry_policy.h"
+#include "google/cloud/internal/make_unique.h"
+#include <algorithm>
+#include <future>
+#include <limits>
+#include <map>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+namespace {
+auto constexpr kInitialBackoff = std::chrono::milliseconds(100);
+auto constexpr kMaximumBackoff = std::chrono::milliseconds(10 * 1000);
+
+std::int64_t ClampToInt64(std::size_t v) {
+  auto constexpr kMax = (std::numeric_limits<std::int64_t>::max)();
+  return v >= static_cast<std::uint64_t>(kMax) ? kMax
+                                               : static_cast<std::int64_t>(v);
+}
+
+/**
+ * The handler keeps a handle to the lease, the ack id, message id, and
+ * ordering key are stored with the lease and looked up when the message is
+ * acknowledged.
+ */
+class StreamingAckHandler : public pubsub::AckHandler::Impl {
+ public:
+  StreamingAckHandler(std::shared_ptr<SubscriptionSession> session,
+                      LeaseManager::Handle lease,
+                      std::int32_t delivery_attempt)
+      : session_(std::move(session)),
+        lease_(lease),
+        delivery_attempt_(delivery_attempt) {}
+
+  ~StreamingAckHandler() override = default;
+
+  void ack() override { session_->Ack(lease_); }
+  void nack() override { session_->Nack(lease_); }
+  std::string ack_id() const override { return session_->AckId(lease_); }
+  std::int32_t delivery_attempt() const override { return delivery_attempt_; }
+
+ private:
+  std::shared_ptr<SubscriptionSession> session_;
+  LeaseManager::Handle lease_;
+  std::int32_t delivery_attempt_;
+};
+}  // namespace
+
+std::chrono::milliseconds constexpr SubscriptionSession::kLeaseRefreshPeriod;
+
+SubscriptionSession::SubscriptionSession(
+    std::vector<std::shared_ptr<SubscriberStub>> stubs,
+    google::cloud::grpc_utils::CompletionQueue cq,
+    std::shared_ptr<pubsub::SubscriberExecutor> executor,
+    std::string subscription, pubsub::SubscriberCallback callback,
+    pubsub::SubscriberOptions const& options,
+    std::shared_ptr<SubscriberCounters> counters)
+    : cq_(std::move(cq)),
+      executor_(std::move(executor)),
+      dispatcher_(executor_),
+      message_ordering_(options.message_ordering()),
+      subscription_(std::move(subscription)),
+      callback_(std::move(callback)),
+      maximum_ack_batch_count_(options.maximum_ack_batch_count()),
+      maximum_ack_hold_time_(options.maximum_ack_hold_time()),
+      counters_(std::move(counters)),
+      maximum_outstanding_messages_(options.maximum_outstanding_messages()),
+      maximum_outstanding_bytes_(options.maximum_outstanding_bytes()),
+      leases_(options.stream_ack_deadline(), options.max_deadline_time()),
+      flow_control_(maximum_outstanding_messages_,
+                    maximum_outstanding_bytes_) {
+  if (options.duplicate_filter_size() != 0) {
+    duplicates_ = google::cloud::internal::make_unique<DuplicateFilter>(
+        options.duplicate_filter_size(), options.duplicate_filter_window());
+  }
+  auto const count = options.concurrent_streams();
+  streams_.reserve(count);
+  for (std::size_t i = 0; i != count; ++i) {
+    auto s = google::cloud::internal::make_unique<Stream>();
+    s->stub = stubs[i % stubs.size()];
+    streams_.push_back(std::move(s));
+  }
+}
+
+future<Status> SubscriptionSession::Start() {
+  std::weak_ptr<SubscriptionSession> w = shared_from_this();
+  promise_ = promise<Status>([w] {
+    if (auto self = w.lock()) self->Cancel();
+  });
+  auto f = promise_.get_future();
+  batcher_ = std::make_shared<AckBatcher>(
+      cq_,
+      [w](google::pubsub::v1::StreamingPullRequest request) {
+        if (auto self = w.lock()) self->SendAcks(std::move(request));
+      },
+      maximum_ack_batch_count_, maximum_ack_hold_time_, counters_);
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    running_ = streams_.size();
+  }
+  auto stopped = std::make_shared<std::promise<void>>();
+  stopped_ = stopped->get_future().share();
+  auto remaining = std::make_shared<std::atomic<std::size_t>>(streams_.size());
+  for (auto& s : streams_) {
+    auto self = shared_from_this();
+    auto* stream = s.get();
+    std::thread([self, stream, stopped, remaining]() mutable {
+      self->ReadLoop(*stream);
+      // Release the session before signaling, `WaitForShutdown()` returns
+      // once the reader threads no longer keep the session alive.
+      self.reset();
+      if (remaining->fetch_sub(1) == 1) stopped->set_value();
+    }).detach();
+  }
+  ScheduleLeaseRefresh();
+  return f;
+}
+
+void SubscriptionSession::Cancel() {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    cancelled_ = true;
+  }
+  Stop();
+}
+
+void SubscriptionSession::WaitForShutdown() {
+  if (stopped_.valid()) stopped_.wait();
+}
+
+void SubscriptionSession::Ack(LeaseManager::Handle lease) {
+  auto const now = LeaseManager::Clock::now();
+  auto r = leases_.Ack(lease, now);
+  if (r.ack_id.empty()) return;
+  if (duplicates_) duplicates_->Record(r.message_id, now);
+  flow_control_.Release(r.released.messages, r.released.bytes);
+  batcher_->Ack(std::move(r.ack_id));
+  dispatcher_.Done(r.ordering_key);
+}
+
+void SubscriptionSession::Nack(LeaseManager::Handle lease) {
+  auto r = leases_.Nack(lease);
+  if (r.ack_id.empty()) return;
+  flow_control_.Release(r.released.messages, r.released.bytes);
+  // A deadline of 0 makes the message available for redelivery immediately.
+  batcher_->ModifyDeadline(std::move(r.ack_id), 0);
+  dispatcher_.Done(r.ordering_key);
+}
+
+std::string SubscriptionSession::AckId(LeaseManager::Handle lease) const {
+  return leases_.AckId(lease);
+}
+
+void SubscriptionSession::ExtendLeases(LeaseManager::Clock::time_point now) {
+  auto extension = leases_.Refresh(now);
+  // The service redelivers the expired messages, they no longer count against
+  // the flow control limits.
+  flow_control_.Release(extension.expired.messages, extension.expired.bytes);
+  auto const seconds = static_cast<std::int32_t>(extension.deadline.count());
+  for (auto& id : extension.ack_ids) {
+    batcher_->ModifyDeadline(std::move(id), seconds);
+  }
+}
+
+void SubscriptionSession::Stop() {
+  std::vector<std::shared_ptr<StreamingPullStream>> active;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    stopping_ = true;
+    for (auto const& s : streams_) {
+      if (s->active) active.push_back(s->active);
+    }
+  }
+  cv_.notify_all();
+  flow_control_.Shutdown();
+  for (auto const& a : active) a->Cancel();
+}
+
+void SubscriptionSession::ReadLoop(Stream& s) {
+  auto backoff = std::chrono::milliseconds(kInitialBackoff);
+  Status status;
+  for (;;) {
+    bool received = false;
+    status = RunStream(s, received);
+    // The service closes streams periodically, a successful close is not an
+    // error and the stream is simply reopened.
+    if (!status.ok() && !pubsub::IsTransientFailure(status)) break;
+    if (received) backoff = kInitialBackoff;
+    if (!WaitForBackoff(backoff)) break;
+    backoff = (std::min)(std::chrono::milliseconds(kMaximumBackoff),
+                         2 * backoff);
+  }
+  bool stop_others;
+  {
+    std::unique_lock<std::mutex> lk(mu_);
+    // The first permanent error ends the session, the other streams report
+    // the cancellation.
+    stop_others = !stopping_;
+    if (stop_others) status_ = std::move(status);
+    if (--running_ != 0) {
+      lk.unlock();
+      if (stop_others) Stop();
+      return;
+    }
+    // A cancelled stream reports an error, but cancelling is how the
+    // application ends the session.
+    status = cancelled_ ? Status{} : status_;
+  }
+  // The messages waiting for an earlier message with the same ordering key
+  // are rejected, the service redelivers them in order.
+  dispatcher_.Shutdown();
+  // Send any pending acknowledgements, new acknowledgements are discarded and
+  // the service redelivers those messages.
+  batcher_->Shutdown();
+  promise_.set_value(std::move(status));
+
+  std::lock_guard<std::mutex> lk(mu_);
+  shutdown_ = true;
+  cv_.notify_all();
+}
+
+Status SubscriptionSession::RunStream(Stream& s, bool& received) {
+  std::shared_ptr<StreamingPullStream> stream = s.stub->StreamingPull(
+      google::cloud::internal::make_unique<grpc::ClientContext>());
+  bool stopping;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    stopping = stopping_;
+    s.active = stream;
+  }
+  if (stopping) stream->Cancel();
+
+  // The first request must name the subscription, send it before any
+  // acknowledgements can be written. New streams use the current deadline
+  // extension, which reflects how long the application takes to process
+  // messages. The messages received by this stream expire after this
+  // deadline, their leases must use the same value.
+  auto const deadline = leases_.extension();
+  google::pubsub::v1::StreamingPullRequest request;
+  request.set_subscription(subscription_);
+  request.set_stream_ack_deadline_seconds(
+      static_cast<std::int32_t>(deadline.count()));
+  // The service applies these limits to each stream, divide them so the
+  // session as a whole stays close to the configured values.
+  auto const n = streams_.size();
+  request.set_max_outstanding_messages(
+      ClampToInt64((maximum_outstanding_messages_ + n - 1) / n));
+  request.set_max_outstanding_bytes(
+      ClampToInt64((maximum_outstanding_bytes_ + n - 1) / n));
+  if (stream->Write(request)) {
+    {
+      std::lock_guard<std::mutex> lk(s.write_mu);
+      s.writer = stream;
+    }
+    for (;;) {
+      // Each response is parsed into a pooled arena, all its messages (and
+      // their attributes) are allocated in the arena's initial block.
+      // `Dispatch()` moves the fields it keeps out of the arena.
+      auto arena = DefaultArenaPool().Acquire();
+      auto* response = google::protobuf::Arena::CreateMessage<
+          google::pubsub::v1::StreamingPullResponse>(arena.get());
+      if (!stream->Read(response)) break;
+      received = true;
+      for (auto& m : *response->mutable_received_messages()) {
+        Dispatch(m, deadline);
+      }
+      // Stop reading, and let the gRPC and service flow control push back,
+      // until the application catches up.
+      if (flow_control_.WaitForCapacity()) {
+        counters_->flow_control_pauses.fetch_add(1);
+      }
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    s.active.reset();
+  }
+  {
+    // Wait for any write in progress, `Finish()` must be called after the
+    // last `Write()`.
+    std::lock_guard<std::mutex> lk(s.write_mu);
+    s.writer.reset();
+  }
+  return stream->Finish();
+}
+
+void SubscriptionSession::ScheduleLeaseRefresh() {
+  using TimerResult = StatusOr<std::chrono::system_clock::time_point>;
+  std::weak_ptr<SubscriptionSession> w = shared_from_this();
+  // Schedule the timer while holding the lock, the connection shuts down the
+  // completion queue only after the session is shutdown.
+  std::lock_guard<std::mutex> lk(mu_);
+  if (stopping_ || shutdown_) return;
+  cq_.MakeRelativeTimer(kLeaseRefreshPeriod).then([w](future<TimerResult> f) {
+    auto self = w.lock();
+    if (!self || !f.get().ok()) return;
+    self->ExtendLeases(LeaseManager::Clock::now());
+    self->ScheduleLeaseRefresh();
+  });
+}
+
+bool SubscriptionSession::WaitForBackoff(std::chrono::milliseconds backoff) {
+  std::unique_lock<std::mutex> lk(mu_);
+  return !cv_.wait_for(lk, backoff, [this] { return stopping_; });
+}
+
+void SubscriptionSession::Dispatch(google::pubsub::v1::ReceivedMessage& m,
+                                   std::chrono::seconds deadline) {
+  std::string message_id;
+  if (duplicates_) {
+    counters_->duplicate_filter_lookups.fetch_add(1);
+    message_id = m.message().message_id();
+    if (duplicates_->IsDuplicate(message_id, LeaseManager::Clock::now())) {
+      // The application already acknowledged this message, acknowledge the
+      // redelivery too, otherwise the service keeps sending it.
+      counters_->duplicate_filter_hits.fetch_add(1);
+      batcher_->Ack(m.ack_id());
+      return;
+    }
+  }
+  auto self = shared_from_this();
+  // Compute the size before the message is moved out of `m`.
+  auto const bytes = m.message().ByteSizeLong();
+  auto ordering_key =
+      message_ordering_ ? m.message().ordering_key() : std::string{};
+  auto message = std::make_shared<pubsub::Message>(
+      FromProto(m.mutable_message()));
+  auto const lease = leases_.Add(m.ack_id(), message_id, ordering_key, bytes,
+                                deadline, LeaseManager::Clock::now());
+  flow_control_.Add(bytes);
+  auto handler = std::make_shared<pubsub::AckHandler>(
+      google::cloud::internal::make_unique<StreamingAckHandler>(
+          self, lease, m.delivery_attempt()));
+  dispatcher_.Dispatch(ordering_key, [self, message, handler] {
+    self->callback_(std::move(*message), std::move(*handler));
+  });
+}
+
+void SubscriptionSession::SendAcks(
+    google::pubsub::v1::StreamingPullRequest request) {
+  // Rotate the starting stream to spread the writes.
+  auto const start = next_writer_.fetch_add(1);
+  for (std::size_t i = 0; i != streams_.size(); ++i) {
+    auto& s = *streams_[(start + i) % streams_.size()];
+    std::lock_guard<std::mutex> lk(s.write_mu);
+    if (s.writer && s.writer->Write(request)) return;
+  }
+  // There is no stream, or they are broken. Use unary RPCs, the
+  // acknowledgements are not lost while the session opens new streams.
+  counters_->unary_ack_batches.fetch_add(1);
+  if (request.ack_ids_size() != 0) {
+    google::pubsub::v1::AcknowledgeRequest ack;
+    ack.set_subscription(subscription_);
+    ack.mutable_ack_ids()->Swap(request.mutable_ack_ids());
+    streams_.front()->stub->AsyncAcknowledge(
+        cq_, google::cloud::internal::make_unique<grpc::ClientContext>(), ack);
+  }
+  // Each `ModifyAckDeadlineRequest` has a single deadline, group the ack ids.
+  std::map<std::int32_t, google::pubsub::v1::ModifyAckDeadlineRequest> modify;
+  for (int i = 0; i != request.modify_deadline_ack_ids_size(); ++i) {
+    auto& r = modify[request.modify_deadline_seconds(i)];
+    r.add_ack_ids(std::move(*request.mutable_modify_deadline_ack_ids(i)));
+  }
+  for (auto& kv : modify) {
+    kv.second.set_subscription(subscription_);
+    kv.second.set_ack_deadline_seconds(kv.first);
+    streams_.front()->stub->AsyncModifyAckDeadline(
+        cq_, google::cloud::internal::make_unique<grpc::ClientContext>(),
+        kv.second);
+  }
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,191 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_SUBSCRIPTION_SESSION_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_SUBSCRIPTION_SESSION_H
+
+#include "google/cloud/pubsub/internal/ack_batcher.h"
+#include "google/cloud/pubsub/internal/duplicate_filter.h"
+#include "google/cloud/pubsub/internal/lease_manager.h"
+#include "google/cloud/pubsub/internal/ordered_dispatcher.h"
+#include "google/cloud/pubsub/internal/subscriber_counters.h"
+#include "google/cloud/pubsub/internal/subscriber_flow_control.h"
+#include "google/cloud/pubsub/internal/subscriber_stub.h"
+#include "google/cloud/pubsub/subscriber_connection.h"
+#include "google/cloud/pubsub/subscriber_executor.h"
+#include "google/cloud/pubsub/subscriber_options.h"
+#include "google/cloud/pubsub/version.h"
+#include "google/cloud/future.h"
+#include "google/cloud/grpc_utils/completion_queue.h"
+#include "google/cloud/status.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Receive the messages for a subscription using `StreamingPull`.
+ *
+ * The session opens `pubsub::SubscriberOptions::concurrent_streams()` streams,
+ * spread over the stubs (and therefore the channels) given to the
+ * constructor. Each stream is read in a dedicated thread, and the session
+ * schedules one application callback per message in the executor. The
+ * completion queue runs the timers and any unary RPCs. The acknowledgements
+ * are written back on any of the streams, the service accepts them on any
+ * stream for the same subscription.
+ *
+ * The session tracks the outstanding messages, that is, messages delivered to
+ * the application but not yet acknowledged or rejected. Every
+ * `kLeaseRefreshPeriod` it extends the deadlines that are about to expire, see
+ * `LeaseManager` for details. The acknowledgements and deadline extensions are
+ * sent in batches, see `AckBatcher`, over the stream if possible, or using
+ * unary RPCs otherwise.
+ *
+ * If the duplicate filter is enabled the session records the id of each
+ * acknowledged message, and acknowledges any redeliveries of those messages
+ * without running the callback, see `DuplicateFilter`.
+ *
+ * With message ordering enabled the callbacks for messages with the same
+ * ordering key run one at a time, in order, see `OrderedDispatcher`.
+ *
+ * The session stops reading from the streams while the number (or size) of
+ * the outstanding messages exceeds the limits in `pubsub::SubscriberOptions`.
+ * The limits are divided evenly between the streams, and sent to the service
+ * in the initial request of each stream.
+ *
+ * If a stream is closed with a transient error the session opens a new
+ * stream, with exponential backoff between attempts. The session ends when
+ * the application cancels it, or when any stream is closed with a permanent
+ * error.
+ *
+ * Objects of this class must be created via `std::make_shared<>()`, the
+ * reader threads and the `pubsub::AckHandler` objects keep the session alive.
+ */
+class SubscriptionSession
+    : public std::enable_shared_from_this<SubscriptionSession> {
+ public:
+  /// How often the session checks for deadlines that need an extension.
+  static std::chrono::milliseconds constexpr kLeaseRefreshPeriod{1000};
+
+  SubscriptionSession(std::vector<std::shared_ptr<SubscriberStub>> stubs,
+                      google::cloud::grpc_utils::CompletionQueue cq,
+                      std::shared_ptr<pubsub::SubscriberExecutor> executor,
+                      std::string subscription,
+                      pubsub::SubscriberCallback callback,
+                      pubsub::SubscriberOptions const& options,
+                      std::shared_ptr<SubscriberCounters> counters);
+
+  /**
+   * Start reading from the stream.
+   *
+   * The returned future is satisfied when the session ends, with an OK status
+   * if the session was cancelled. Cancelling the future cancels the session.
+   */
+  future<Status> Start();
+
+  /// Stop the session, the callbacks already scheduled still run.
+  void Cancel();
+
+  /**
+   * Block until the reader threads exit, call after `Cancel()`.
+   *
+   * On return the reader threads no longer hold a reference to the session.
+   */
+  void WaitForShutdown();
+
+  /// Acknowledge a message received by this session.
+  void Ack(LeaseManager::Handle lease);
+
+  /// Reject a message received by this session.
+  void Nack(LeaseManager::Handle lease);
+
+  /// The ack id of a message received by this session.
+  std::string AckId(LeaseManager::Handle lease) const;
+
+  /// Extend the deadlines that expire soon, called periodically.
+  void ExtendLeases(LeaseManager::Clock::time_point now);
+
+  /// The number of messages not yet acknowledged or rejected.
+  std::size_t outstanding() const { return leases_.size(); }
+
+  /// The approximate memory used by the duplicate filter, `0` if disabled.
+  std::size_t duplicate_filter_memory_usage() const {
+    return duplicates_ ? duplicates_->memory_usage() : 0;
+  }
+
+ private:
+  struct Stream {
+    std::shared_ptr<SubscriberStub> stub;
+    // Guarded by the session `mu_`.
+    std::shared_ptr<StreamingPullStream> active;
+    // Serializes the writes, which may block, without blocking `Cancel()`.
+    // Only the initial request and the acknowledgement batches are written.
+    std::mutex write_mu;
+    std::shared_ptr<StreamingPullStream> writer;
+  };
+
+  void Stop();
+  void ReadLoop(Stream& s);
+  Status RunStream(Stream& s, bool& received);
+  bool WaitForBackoff(std::chrono::milliseconds backoff);
+  void ScheduleLeaseRefresh();
+  void Dispatch(google::pubsub::v1::ReceivedMessage& m,
+                std::chrono::seconds deadline);
+  void SendAcks(google::pubsub::v1::StreamingPullRequest request);
+
+  std::vector<std::unique_ptr<Stream>> streams_;
+  google::cloud::grpc_utils::CompletionQueue cq_;
+  std::shared_ptr<pubsub::SubscriberExecutor> executor_;
+  OrderedDispatcher dispatcher_;
+  bool const message_ordering_;
+  std::string const subscription_;
+  pubsub::SubscriberCallback const callback_;
+  std::size_t const maximum_ack_batch_count_;
+  std::chrono::microseconds const maximum_ack_hold_time_;
+  std::shared_ptr<SubscriberCounters> counters_;
+  std::size_t const maximum_outstanding_messages_;
+  std::size_t const maximum_outstanding_bytes_;
+  std::atomic<std::size_t> next_writer_{0};
+  LeaseManager leases_;
+  SubscriberFlowControl flow_control_;
+  std::unique_ptr<DuplicateFilter> duplicates_;
+  std::shared_ptr<AckBatcher> batcher_;
+  promise<Status> promise_;
+  std::shared_future<void> stopped_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool cancelled_ = false;
+  bool stopping_ = false;
+  bool shutdown_ = false;
+  std::size_t running_ = 0;
+  Status status_;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_SUBSCRIPTION_SESSION_H
@@ -0,0 +1,641 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/subscription_session.h"
+#include "google/cloud/pubsub/internal/background_threads.h"
+#include "google/cloud/pubsub/internal/work_stealing_executor.h"
+#include "google/cloud/pubsub/testing/mock_subscriber_stub.h"
+#include "google/cloud/internal/make_unique.h"
+#include <gmock/gmock.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::UnorderedElementsAre;
+
+/// A stream where the test controls the responses and captures the requests.
+class FakeStream {
+ public:
+  void Push(std::vector<std::string> const& ack_ids,
+            std::string const& ordering_key = {}) {
+    google::pubsub::v1::StreamingPullResponse response;
+    for (auto const& id : ack_ids) {
+      auto& m = *response.add_received_messages();
+      m.set_ack_id(id);
+      m.mutable_message()->set_message_id("m-" + id);
+      m.mutable_message()->set_data("data-" + id);
+      m.mutable_message()->set_ordering_key(ordering_key);
+    }
+    std::lock_guard<std::mutex> lk(mu_);
+    responses_.push_back(std::move(response));
+    cv_.notify_all();
+  }
+
+  /// Deliver the message sent with @p ack_id again, with a new ack id.
+  void Redeliver(std::string const& ack_id, std::string const& new_ack_id) {
+    google::pubsub::v1::StreamingPullResponse response;
+    auto& m = *response.add_received_messages();
+    m.set_ack_id(new_ack_id);
+    m.mutable_message()->set_message_id("m-" + ack_id);
+    m.mutable_message()->set_data("data-" + ack_id);
+    std::lock_guard<std::mutex> lk(mu_);
+    responses_.push_back(std::move(response));
+    cv_.notify_all();
+  }
+
+  void Close(Status status) {
+    std::lock_guard<std::mutex> lk(mu_);
+    closed_ = true;
+    status_ = std::move(status);
+    cv_.notify_all();
+  }
+
+  std::vector<google::pubsub::v1::StreamingPullRequest> WaitForWrites(
+      std::size_t count) {
+    std::unique_lock<std::mutex> lk(mu_);
+    cv_.wait(lk, [&] { return writes_.size() >= count; });
+    return writes_;
+  }
+
+  /// Wait until the acknowledgements for @p count messages are written.
+  std::vector<std::string> WaitForAckIds(std::size_t count) {
+    std::unique_lock<std::mutex> lk(mu_);
+    std::vector<std::string> ids;
+    cv_.wait(lk, [&] {
+      ids.clear();
+      for (auto const& w : writes_) {
+        ids.insert(ids.end(), w.ack_ids().begin(), w.ack_ids().end());
+      }
+      return ids.size() >= count;
+    });
+    return ids;
+  }
+
+  /// Make all the writes, except the initial request, fail.
+  void RejectWrites() {
+    std::lock_guard<std::mutex> lk(mu_);
+    reject_writes_ = true;
+  }
+
+  void Cancel() { Close(Status(StatusCode::kCancelled, "cancelled")); }
+
+  bool Write(google::pubsub::v1::StreamingPullRequest const& request) {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (closed_) return false;
+    if (reject_writes_ && !writes_.empty()) return false;
+    writes_.push_back(request);
+    cv_.notify_all();
+    return true;
+  }
+
+  bool Read(google::pubsub::v1::StreamingPullResponse* response) {
+    std::unique_lock<std::mutex> lk(mu_);
+    cv_.wait(lk, [this] { return closed_ || !responses_.empty(); });
+    if (responses_.empty()) return false;
+    *response = std::move(responses_.front());
+    responses_.pop_front();
+    return true;
+  }
+
+  Status Finish() {
+    std::lock_guard<std::mutex> lk(mu_);
+    return status_;
+  }
+
+ private:
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<google::pubsub::v1::StreamingPullResponse> responses_;
+  std::vector<google::pubsub::v1::StreamingPullRequest> writes_;
+  bool closed_ = false;
+  bool reject_writes_ = false;
+  Status status_;
+};
+
+class ForwardingStream : public StreamingPullStream {
+ public:
+  explicit ForwardingStream(std::shared_ptr<FakeStream> fake)
+      : fake_(std::move(fake)) {}
+
+  void Cancel() override { fake_->Cancel(); }
+  bool Write(google::pubsub::v1::StreamingPullRequest const& r) override {
+    return fake_->Write(r);
+  }
+  bool Read(google::pubsub::v1::StreamingPullResponse* r) override {
+    return fake_->Read(r);
+  }
+  Status Finish() override { return fake_->Finish(); }
+
+ private:
+  std::shared_ptr<FakeStream> fake_;
+};
+
+std::function<std::unique_ptr<StreamingPullStream>(
+    std::unique_ptr<grpc::ClientContext>)>
+ReturnStream(std::shared_ptr<FakeStream> fake) {
+  return [fake](std::unique_ptr<grpc::ClientContext>) {
+    return std::unique_ptr<StreamingPullStream>(
+        google::cloud::internal::make_unique<ForwardingStream>(fake));
+  };
+}
+
+std::vector<std::shared_ptr<SubscriberStub>> Stubs(
+    std::shared_ptr<SubscriberStub> stub) {
+  return {std::move(stub)};
+}
+
+std::string const kSubscription = "projects/test-project/subscriptions/test-s";
+
+/// Send the acknowledgements quickly to keep the tests fast.
+pubsub::SubscriberOptions TestOptions() {
+  return pubsub::SubscriberOptions{}.set_maximum_ack_hold_time(
+      std::chrono::milliseconds(1));
+}
+
+TEST(SubscriptionSessionTest, DispatchesAndAcks) {
+  auto mock = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  auto fake = std::make_shared<FakeStream>();
+  EXPECT_CALL(*mock, StreamingPull).WillOnce(ReturnStream(fake));
+
+  BackgroundThreads background(2);
+  auto executor = std::make_shared<WorkStealingExecutor>(2);
+  std::mutex mu;
+  std::vector<std::string> received;
+  auto session = std::make_shared<SubscriptionSession>(
+      Stubs(mock), background.cq(), executor, kSubscription,
+      [&](pubsub::Message const& m, pubsub::AckHandler h) {
+        {
+          std::lock_guard<std::mutex> lk(mu);
+          received.push_back(m.data());
+        }
+        std::move(h).ack();
+      },
+      TestOptions().set_stream_ack_deadline(std::chrono::seconds(30)),
+      std::make_shared<SubscriberCounters>());
+  auto done = session->Start();
+
+  fake->Push({"a0", "a1"});
+  EXPECT_THAT(fake->WaitForAckIds(2), UnorderedElementsAre("a0", "a1"));
+  auto writes = fake->WaitForWrites(1);
+  EXPECT_EQ(kSubscription, writes[0].subscription());
+  EXPECT_EQ(30, writes[0].stream_ack_deadline_seconds());
+  {
+    std::lock_guard<std::mutex> lk(mu);
+    EXPECT_THAT(received, UnorderedElementsAre("data-a0", "data-a1"));
+  }
+
+  done.cancel();
+  EXPECT_EQ(StatusCode::kOk, done.get().code());
+  session->WaitForShutdown();
+}
+
+TEST(SubscriptionSessionTest, NackOnDestruction) {
+  auto mock = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  auto fake = std::make_shared<FakeStream>();
+  EXPECT_CALL(*mock, StreamingPull).WillOnce(ReturnStream(fake));
+
+  BackgroundThreads background(1);
+  auto executor = std::make_shared<WorkStealingExecutor>(1);
+  auto session = std::make_shared<SubscriptionSession>(
+      Stubs(mock), background.cq(), executor, kSubscription,
+      [](pubsub::Message const&, pubsub::AckHandler) {},
+      TestOptions(), std::make_shared<SubscriberCounters>());
+  auto done = session->Start();
+
+  fake->Push({"a0"});
+  auto writes = fake->WaitForWrites(2);
+  ASSERT_EQ(2U, writes.size());
+  EXPECT_THAT(writes[1].modify_deadline_ack_ids(), ElementsAre("a0"));
+  EXPECT_THAT(writes[1].modify_deadline_seconds(), ElementsAre(0));
+
+  session->Cancel();
+  EXPECT_EQ(StatusCode::kOk, done.get().code());
+  session->WaitForShutdown();
+}
+
+TEST(SubscriptionSessionTest, ExtendsLeases) {
+  auto mock = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  auto fake = std::make_shared<FakeStream>();
+  EXPECT_CALL(*mock, StreamingPull).WillOnce(ReturnStream(fake));
+
+  BackgroundThreads background(1);
+  auto executor = std::make_shared<WorkStealingExecutor>(1);
+  std::mutex mu;
+  std::condition_variable cv;
+  std::vector<pubsub::AckHandler> handlers;
+  auto session = std::make_shared<SubscriptionSession>(
+      Stubs(mock), background.cq(), executor, kSubscription,
+      [&](pubsub::Message const&, pubsub::AckHandler h) {
+        std::lock_guard<std::mutex> lk(mu);
+        handlers.push_back(std::move(h));
+        cv.notify_one();
+      },
+      TestOptions(), std::make_shared<SubscriberCounters>());
+  auto done = session->Start();
+
+  fake->Push({"a0", "a1"});
+  {
+    std::unique_lock<std::mutex> lk(mu);
+    cv.wait(lk, [&] { return handlers.size() == 2; });
+    std::move(handlers[0]).ack();
+  }
+  EXPECT_EQ(1U, session->outstanding());
+  EXPECT_THAT(fake->WaitForAckIds(1), ElementsAre("a0"));
+
+  session->ExtendLeases(LeaseManager::Clock::now() + std::chrono::seconds(8));
+  auto writes = fake->WaitForWrites(3);
+  ASSERT_EQ(3U, writes.size());
+  auto const& last = writes.back();
+  EXPECT_THAT(last.modify_deadline_ack_ids(),
+              ElementsAre(handlers[1].ack_id()));
+  EXPECT_THAT(last.modify_deadline_seconds(), ElementsAre(10));
+
+  done.cancel();
+  EXPECT_EQ(StatusCode::kOk, done.get().code());
+  session->WaitForShutdown();
+}
+
+TEST(SubscriptionSessionTest, ReopenedStreamLeasesUseRequestedDeadline) {
+  auto mock = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  auto f0 = std::make_shared<FakeStream>();
+  auto f1 = std::make_shared<FakeStream>();
+  EXPECT_CALL(*mock, StreamingPull)
+      .WillOnce(ReturnStream(f0))
+      .WillOnce(ReturnStream(f1));
+
+  BackgroundThreads background(1);
+  auto executor = std::make_shared<WorkStealingExecutor>(1);
+  std::mutex mu;
+  std::condition_variable cv;
+  std::vector<pubsub::AckHandler> handlers;
+  auto session = std::make_shared<SubscriptionSession>(
+      Stubs(mock), background.cq(), executor, kSubscription,
+      [&](pubsub::Message const& m, pubsub::AckHandler h) {
+        if (m.message_id() == "m-a0") return std::move(h).ack();
+        std::lock_guard<std::mutex> lk(mu);
+        handlers.push_back(std::move(h));
+        cv.notify_one();
+      },
+      TestOptions().set_stream_ack_deadline(std::chrono::seconds(60)),
+      std::make_shared<SubscriberCounters>());
+  auto done = session->Start();
+
+  EXPECT_EQ(60, f0->WaitForWrites(1)[0].stream_ack_deadline_seconds());
+  // A fast acknowledgement lowers the extension to the minimum.
+  f0->Push({"a0"});
+  EXPECT_THAT(f0->WaitForAckIds(1), ElementsAre("a0"));
+  f0->Close(Status(StatusCode::kUnavailable, "try-again"));
+
+  // The new stream requests the current extension, and the messages it
+  // receives expire after that deadline, not the initial one.
+  EXPECT_EQ(10, f1->WaitForWrites(1)[0].stream_ack_deadline_seconds());
+  f1->Push({"b0"});
+  {
+    std::unique_lock<std::mutex> lk(mu);
+    cv.wait(lk, [&] { return handlers.size() == 1; });
+  }
+  session->ExtendLeases(LeaseManager::Clock::now() + std::chrono::seconds(6));
+  auto writes = f1->WaitForWrites(2);
+  ASSERT_EQ(2U, writes.size());
+  EXPECT_THAT(writes.back().modify_deadline_ack_ids(), ElementsAre("b0"));
+  EXPECT_THAT(writes.back().modify_deadline_seconds(), ElementsAre(10));
+
+  done.cancel();
+  EXPECT_EQ(StatusCode::kOk, done.get().code());
+  session->WaitForShutdown();
+}
+
+TEST(SubscriptionSessionTest, UnaryAcksWithoutStream) {
+  auto mock = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  auto fake = std::make_shared<FakeStream>();
+  fake->RejectWrites();
+  EXPECT_CALL(*mock, StreamingPull).WillOnce(ReturnStream(fake));
+
+  promise<void> acked;
+  EXPECT_CALL(*mock, AsyncAcknowledge)
+      .WillOnce([&](google::cloud::grpc_utils::CompletionQueue&,
+                    std::unique_ptr<grpc::ClientContext>,
+                    google::pubsub::v1::AcknowledgeRequest const& request) {
+        EXPECT_EQ(kSubscription, request.subscription());
+        EXPECT_THAT(request.ack_ids(), ElementsAre("a0"));
+        acked.set_value();
+        return make_ready_future(Status{});
+      });
+
+  BackgroundThreads background(1);
+  auto executor = std::make_shared<WorkStealingExecutor>(1);
+  auto counters = std::make_shared<SubscriberCounters>();
+  auto session = std::make_shared<SubscriptionSession>(
+      Stubs(mock), background.cq(), executor, kSubscription,
+      [](pubsub::Message const&, pubsub::AckHandler h) {
+        std::move(h).ack();
+      },
+      TestOptions(), counters);
+  auto done = session->Start();
+
+  fake->Push({"a0"});
+  acked.get_future().get();
+  auto const stats = counters->Snapshot();
+  EXPECT_EQ(1U, stats.ack_batches);
+  EXPECT_EQ(1U, stats.unary_ack_batches);
+
+  done.cancel();
+  EXPECT_EQ(StatusCode::kOk, done.get().code());
+  session->WaitForShutdown();
+}
+
+TEST(SubscriptionSessionTest, FlowControl) {
+  auto mock = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  auto fake = std::make_shared<FakeStream>();
+  EXPECT_CALL(*mock, StreamingPull).WillOnce(ReturnStream(fake));
+
+  BackgroundThreads background(1);
+  auto executor = std::make_shared<WorkStealingExecutor>(1);
+  std::mutex mu;
+  std::condition_variable cv;
+  std::vector<pubsub::AckHandler> handlers;
+  auto counters = std::make_shared<SubscriberCounters>();
+  auto session = std::make_shared<SubscriptionSession>(
+      Stubs(mock), background.cq(), executor, kSubscription,
+      [&](pubsub::Message const&, pubsub::AckHandler h) {
+        std::lock_guard<std::mutex> lk(mu);
+        handlers.push_back(std::move(h));
+        cv.notify_one();
+      },
+      TestOptions()
+          .set_maximum_outstanding_messages(1)
+          .set_maximum_outstanding_bytes(1024),
+      counters);
+  auto done = session->Start();
+
+  auto writes = fake->WaitForWrites(1);
+  EXPECT_EQ(1, writes[0].max_outstanding_messages());
+  EXPECT_EQ(1024, writes[0].max_outstanding_bytes());
+
+  fake->Push({"a0"});
+  fake->Push({"a1"});
+  std::unique_lock<std::mutex> lk(mu);
+  cv.wait(lk, [&] { return handlers.size() == 1; });
+  // The session does not read "a1" until "a0" is acknowledged.
+  EXPECT_FALSE(cv.wait_for(lk, std::chrono::milliseconds(50),
+                           [&] { return handlers.size() > 1; }));
+  EXPECT_EQ(1U, session->outstanding());
+  std::move(handlers[0]).ack();
+  cv.wait(lk, [&] { return handlers.size() == 2; });
+  EXPECT_EQ("a1", handlers[1].ack_id());
+  lk.unlock();
+  EXPECT_THAT(fake->WaitForAckIds(1), ElementsAre("a0"));
+  EXPECT_LE(1U, counters->Snapshot().flow_control_pauses);
+
+  done.cancel();
+  EXPECT_EQ(StatusCode::kOk, done.get().code());
+  session->WaitForShutdown();
+}
+
+TEST(SubscriptionSessionTest, DropsDuplicates) {
+  auto mock = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  auto fake = std::make_shared<FakeStream>();
+  EXPECT_CALL(*mock, StreamingPull).WillOnce(ReturnStream(fake));
+
+  BackgroundThreads background(1);
+  auto executor = std::make_shared<WorkStealingExecutor>(1);
+  std::mutex mu;
+  std::vector<std::string> received;
+  auto counters = std::make_shared<SubscriberCounters>();
+  auto session = std::make_shared<SubscriptionSession>(
+      Stubs(mock), background.cq(), executor, kSubscription,
+      [&](pubsub::Message const& m, pubsub::AckHandler h) {
+        {
+          std::lock_guard<std::mutex> lk(mu);
+          received.push_back(m.data());
+        }
+        std::move(h).ack();
+      },
+      TestOptions().set_duplicate_filter_size(100), counters);
+  auto done = session->Start();
+
+  fake->Push({"a0"});
+  EXPECT_THAT(fake->WaitForAckIds(1), ElementsAre("a0"));
+  // The redelivery is acknowledged without calling the callback.
+  fake->Redeliver("a0", "a0-again");
+  fake->Push({"a1"});
+  EXPECT_THAT(fake->WaitForAckIds(3),
+              UnorderedElementsAre("a0", "a0-again", "a1"));
+  {
+    std::lock_guard<std::mutex> lk(mu);
+    EXPECT_THAT(received, ElementsAre("data-a0", "data-a1"));
+  }
+  auto const statistics = counters->Snapshot();
+  EXPECT_EQ(3U, statistics.duplicate_filter_lookups);
+  EXPECT_EQ(1U, statistics.duplicate_filter_hits);
+  EXPECT_LT(0U, session->duplicate_filter_memory_usage());
+
+  done.cancel();
+  EXPECT_EQ(StatusCode::kOk, done.get().code());
+  session->WaitForShutdown();
+}
+
+TEST(SubscriptionSessionTest, OrderedDelivery) {
+  auto mock = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  auto fake = std::make_shared<FakeStream>();
+  EXPECT_CALL(*mock, StreamingPull).WillOnce(ReturnStream(fake));
+  // "k2" is still queued when the session is cancelled, it is rejected.
+  EXPECT_CALL(*mock, AsyncModifyAckDeadline)
+      .WillOnce([](google::cloud::grpc_utils::CompletionQueue&,
+                   std::unique_ptr<grpc::ClientContext>,
+                   google::pubsub::v1::ModifyAckDeadlineRequest const& r) {
+        EXPECT_EQ(0, r.ack_deadline_seconds());
+        EXPECT_THAT(r.ack_ids(), ElementsAre("k2"));
+        return make_ready_future(Status{});
+      });
+
+  BackgroundThreads background(1);
+  auto executor = std::make_shared<WorkStealingExecutor>(4);
+  std::mutex mu;
+  std::condition_variable cv;
+  std::vector<pubsub::AckHandler> handlers;
+  auto session = std::make_shared<SubscriptionSession>(
+      Stubs(mock), background.cq(), executor, kSubscription,
+      [&](pubsub::Message const&, pubsub::AckHandler h) {
+        std::lock_guard<std::mutex> lk(mu);
+        handlers.push_back(std::move(h));
+        cv.notify_one();
+      },
+      TestOptions().enable_message_ordering(),
+      std::make_shared<SubscriberCounters>());
+  auto done = session->Start();
+
+  fake->Push({"k0", "k1", "k2"}, "key");
+  fake->Push({"u0"}, "other-key");
+  std::unique_lock<std::mutex> lk(mu);
+  // Only the first message for each key is delivered.
+  cv.wait(lk, [&] { return handlers.size() == 2; });
+  std::vector<std::string> ids;
+  for (auto const& h : handlers) ids.push_back(h.ack_id());
+  EXPECT_THAT(ids, UnorderedElementsAre("k0", "u0"));
+  EXPECT_FALSE(cv.wait_for(lk, std::chrono::milliseconds(50),
+                           [&] { return handlers.size() > 2; }));
+
+  auto first = std::move(handlers[ids[0] == "k0" ? 0 : 1]);
+  lk.unlock();
+  std::move(first).ack();
+  lk.lock();
+  cv.wait(lk, [&] { return handlers.size() == 3; });
+  EXPECT_EQ("k1", handlers[2].ack_id());
+  lk.unlock();
+  EXPECT_THAT(fake->WaitForAckIds(1), ElementsAre("k0"));
+
+  done.cancel();
+  EXPECT_EQ(StatusCode::kOk, done.get().code());
+  session->WaitForShutdown();
+}
+
+TEST(SubscriptionSessionTest, PermanentError) {
+  auto mock = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  auto fake = std::make_shared<FakeStream>();
+  EXPECT_CALL(*mock, StreamingPull).WillOnce(ReturnStream(fake));
+
+  BackgroundThreads background(1);
+  auto executor = std::make_shared<WorkStealingExecutor>(1);
+  auto session = std::make_shared<SubscriptionSession>(
+      Stubs(mock), background.cq(), executor, kSubscription,
+      [](pubsub::Message const&, pubsub::AckHandler) {},
+      TestOptions(), std::make_shared<SubscriberCounters>());
+  auto done = session->Start();
+
+  fake->Close(Status(StatusCode::kPermissionDenied, "uh-oh"));
+  EXPECT_EQ(StatusCode::kPermissionDenied, done.get().code());
+  session->WaitForShutdown();
+}
+
+TEST(SubscriptionSessionTest, MultipleStreams) {
+  auto m0 = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  auto m1 = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  auto f0 = std::make_shared<FakeStream>();
+  auto f1 = std::make_shared<FakeStream>();
+  EXPECT_CALL(*m0, StreamingPull).WillOnce(ReturnStream(f0));
+  EXPECT_CALL(*m1, StreamingPull).WillOnce(ReturnStream(f1));
+
+  BackgroundThreads background(1);
+  auto executor = std::make_shared<WorkStealingExecutor>(2);
+  auto session = std::make_shared<SubscriptionSession>(
+      std::vector<std::shared_ptr<SubscriberStub>>{m0, m1}, background.cq(),
+      executor, kSubscription,
+      [](pubsub::Message const&, pubsub::AckHandler h) {
+        std::move(h).ack();
+      },
+      TestOptions().set_concurrent_streams(2).set_maximum_outstanding_messages(
+          1001),
+      std::make_shared<SubscriberCounters>());
+  auto done = session->Start();
+
+  // Each stream requests half of the flow control limits, rounded up.
+  EXPECT_EQ(501, f0->WaitForWrites(1)[0].max_outstanding_messages());
+  EXPECT_EQ(501, f1->WaitForWrites(1)[0].max_outstanding_messages());
+
+  f0->Push({"a0"});
+  f1->Push({"b0"});
+  // The acknowledgements may use either stream.
+  std::vector<std::string> acked;
+  while (acked.size() < 2) {
+    acked.clear();
+    for (auto const& f : {f0, f1}) {
+      for (auto const& w : f->WaitForWrites(1)) {
+        acked.insert(acked.end(), w.ack_ids().begin(), w.ack_ids().end());
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_THAT(acked, UnorderedElementsAre("a0", "b0"));
+
+  // A permanent error on one stream ends the session.
+  f1->Close(Status(StatusCode::kPermissionDenied, "uh-oh"));
+  EXPECT_EQ(StatusCode::kPermissionDenied, done.get().code());
+  session->WaitForShutdown();
+}
+
+TEST(SubscriptionSessionTest, ReconnectOnTransientError) {
+  auto mock = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  auto f0 = std::make_shared<FakeStream>();
+  auto f1 = std::make_shared<FakeStream>();
+  f0->Close(Status(StatusCode::kUnavailable, "try-again"));
+  EXPECT_CALL(*mock, StreamingPull)
+      .WillOnce(ReturnStream(f0))
+      .WillOnce(ReturnStream(f1));
+
+  BackgroundThreads background(1);
+  auto executor = std::make_shared<WorkStealingExecutor>(1);
+  auto session = std::make_shared<SubscriptionSession>(
+      Stubs(mock), background.cq(), executor, kSubscription,
+      [](pubsub::Message const&, pubsub::AckHandler h) {
+        std::move(h).ack();
+      },
+      TestOptions(), std::make_shared<SubscriberCounters>());
+  auto done = session->Start();
+
+  f1->Push({"a0"});
+  EXPECT_THAT(f1->WaitForAckIds(1), ElementsAre("a0"));
+  EXPECT_EQ(kSubscription, f1->WaitForWrites(1)[0].subscription());
+
+  done.cancel();
+  EXPECT_EQ(StatusCode::kOk, done.get().code());
+  session->WaitForShutdown();
+}
+
+TEST(SubscriptionSessionTest, ReconnectClassifiesLikeRetryPolicy) {
+  auto mock = std::make_shared<pubsub_testing::MockSubscriberStub>();
+  auto f0 = std::make_shared<FakeStream>();
+  auto f1 = std::make_shared<FakeStream>();
+  auto f2 = std::make_shared<FakeStream>();
+  // The service closes streams successfully, and `kUnknown` is transient for
+  // the unary RPCs too.
+  f0->Close(Status{});
+  f1->Close(Status(StatusCode::kUnknown, "try-again"));
+  EXPECT_CALL(*mock, StreamingPull)
+      .WillOnce(ReturnStream(f0))
+      .WillOnce(ReturnStream(f1))
+      .WillOnce(ReturnStream(f2));
+
+  BackgroundThreads background(1);
+  auto executor = std::make_shared<WorkStealingExecutor>(1);
+  auto session = std::make_shared<SubscriptionSession>(
+      Stubs(mock), background.cq(), executor, kSubscription,
+      [](pubsub::Message const&, pubsub::AckHandler h) {
+        std::move(h).ack();
+      },
+      TestOptions(), std::make_shared<SubscriberCounters>());
+  auto done = session->Start();
+
+  f2->Push({"a0"});
+  EXPECT_THAT(f2->WaitForAckIds(1), ElementsAre("a0"));
+
+  done.cancel();
+  EXPECT_EQ(StatusCode::kOk, done.get().code());
+  session->WaitForShutdown();
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,159 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/work_stealing_executor.h"
+#include "google/cloud/internal/make_unique.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+namespace {
+// Identify the pool, and the worker, running in the current thread.
+thread_local void const* current_pool = nullptr;
+thread_local std::size_t current_worker = 0;
+}  // namespace
+
+class WorkStealingExecutor::Impl {
+ public:
+  explicit Impl(std::size_t thread_count) {
+    queues_.reserve(thread_count);
+    for (std::size_t i = 0; i != thread_count; ++i) {
+      queues_.push_back(google::cloud::internal::make_unique<Queue>());
+    }
+  }
+
+  void Push(std::function<void()> task) {
+    auto const index = current_pool == this
+                           ? current_worker
+                           : next_.fetch_add(1) % queues_.size();
+    auto& q = *queues_[index];
+    {
+      std::lock_guard<std::mutex> lk(q.mu);
+      q.tasks.push_back(std::move(task));
+      // Count the task while holding the lock, so the worker that pops it
+      // always sees the increment first.
+      pending_.fetch_add(1);
+    }
+    if (idle_.load() == 0) return;
+    std::lock_guard<std::mutex> lk(mu_);
+    cv_.notify_one();
+  }
+
+  void Shutdown() {
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      shutdown_ = true;
+    }
+    cv_.notify_all();
+  }
+
+  void WorkLoop(std::size_t index) {
+    current_pool = this;
+    current_worker = index;
+    for (;;) {
+      std::function<void()> task;
+      if (Pop(index, task)) {
+        task();
+        continue;
+      }
+      std::unique_lock<std::mutex> lk(mu_);
+      // `Push()` increments `pending_` before it reads `idle_`, and we
+      // increment `idle_` before we read `pending_`, so at least one of them
+      // sees the other and no wakeup is lost.
+      idle_.fetch_add(1);
+      cv_.wait(lk, [this] { return pending_.load() != 0 || shutdown_; });
+      idle_.fetch_sub(1);
+      // Drain all the queues before exiting, the tasks hold `AckHandler`
+      // objects and must run (or be destroyed) before the session ends.
+      if (shutdown_ && pending_.load() == 0) break;
+    }
+    current_pool = nullptr;
+  }
+
+ private:
+  struct Queue {
+    std::mutex mu;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  bool Pop(std::size_t index, std::function<void()>& task) {
+    {
+      auto& q = *queues_[index];
+      std::lock_guard<std::mutex> lk(q.mu);
+      if (!q.tasks.empty()) {
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        pending_.fetch_sub(1);
+        return true;
+      }
+    }
+    for (std::size_t i = 1; i != queues_.size(); ++i) {
+      auto& q = *queues_[(index + i) % queues_.size()];
+      std::lock_guard<std::mutex> lk(q.mu);
+      if (q.tasks.empty()) continue;
+      task = std::move(q.tasks.back());
+      q.tasks.pop_back();
+      pending_.fetch_sub(1);
+      return true;
+    }
+    return false;
+  }
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::atomic<std::size_t> next_{0};
+  std::atomic<std::uint64_t> pending_{0};
+  std::atomic<std::size_t> idle_{0};
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool shutdown_ = false;
+};
+
+WorkStealingExecutor::WorkStealingExecutor(std::size_t thread_count) {
+  if (thread_count == 0) thread_count = 1;
+  impl_ = std::make_shared<Impl>(thread_count);
+  workers_.reserve(thread_count);
+  for (std::size_t i = 0; i != thread_count; ++i) {
+    auto impl = impl_;
+    workers_.emplace_back([impl, i] { impl->WorkLoop(i); });
+  }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+  impl_->Shutdown();
+  for (auto& t : workers_) {
+    if (t.get_id() == std::this_thread::get_id()) {
+      // The worker holds a reference to `impl_`, it exits once the queues
+      // are drained.
+      t.detach();
+      continue;
+    }
+    t.join();
+  }
+}
+
+void WorkStealingExecutor::Run(std::function<void()> task) {
+  impl_->Push(std::move(task));
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
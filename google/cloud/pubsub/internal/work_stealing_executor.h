@@ -0,0 +1,73 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_WORK_STEALING_EXECUTOR_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_WORK_STEALING_EXECUTOR_H
+
+#include "google/cloud/pubsub/subscriber_executor.h"
+#include "google/cloud/pubsub/version.h"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * A thread pool where each worker has its own deque of tasks.
+ *
+ * `Run()` pushes the task to the back of a deque: the deque of the calling
+ * thread if it is one of the workers, otherwise the deques are used in
+ * round-robin order. Workers take tasks from the front of their own deque,
+ * which preserves the order of the messages from a single stream, and steal
+ * from the back of the other deques when their own is empty.
+ *
+ * Each deque has its own mutex, the pool-wide mutex is only used to put idle
+ * workers to sleep and wake them up.
+ *
+ * The state shared with the workers is reference counted. If the last
+ * reference to the executor is released by one of its own tasks the
+ * destructor detaches that worker instead of deadlocking.
+ */
+class WorkStealingExecutor : public pubsub::SubscriberExecutor {
+ public:
+  explicit WorkStealingExecutor(std::size_t thread_count);
+
+  /// Run any pending tasks and wait for the workers to finish.
+  ~WorkStealingExecutor() override;
+
+  WorkStealingExecutor(WorkStealingExecutor const&) = delete;
+  WorkStealingExecutor& operator=(WorkStealingExecutor const&) = delete;
+
+  void Run(std::function<void()> task) override;
+
+  /// The number of worker threads.
+  std::size_t size() const { return workers_.size(); }
+
+ private:
+  class Impl;
+  std::shared_ptr<Impl> impl_;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_INTERNAL_WORK_STEALING_EXECUTOR_H
@@ -0,0 +1,116 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/background_threads.h"
+#include "google/cloud/pubsub/internal/work_stealing_executor.h"
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+// Compare the cost of dispatching short callbacks via a single shared queue
+// (the completion queue) against the work-stealing executor.
+//
+// Run with:
+//   work_stealing_executor_benchmark --benchmark_counters_tabular=true
+//
+// Each iteration schedules 1,000 tasks from a single thread, as the
+// subscription session does, and waits for all of them. The first argument is
+// the number of threads, the second is the work in each task, in
+// microseconds.
+
+auto constexpr kTasks = 1000;
+
+class Latch {
+ public:
+  explicit Latch(int count) : count_(count) {}
+
+  void CountDown() {
+    if (count_.fetch_sub(1) != 1) return;
+    std::lock_guard<std::mutex> lk(mu_);
+    done_ = true;
+    cv_.notify_one();
+  }
+
+  void Wait() {
+    std::unique_lock<std::mutex> lk(mu_);
+    cv_.wait(lk, [this] { return done_; });
+  }
+
+ private:
+  std::atomic<int> count_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool done_ = false;
+};
+
+void SpinFor(std::chrono::microseconds work) {
+  auto const deadline = std::chrono::steady_clock::now() + work;
+  while (std::chrono::steady_clock::now() < deadline) continue;
+}
+
+void DispatchArguments(benchmark::internal::Benchmark* b) {
+  for (auto threads : {4, 16}) {
+    for (auto work : {0, 10, 50}) b->Args({threads, work});
+  }
+}
+
+void RunTasks(benchmark::State& state,
+              std::function<void(std::function<void()>)> const& run) {
+  auto const work = std::chrono::microseconds(state.range(1));
+  for (auto _ : state) {
+    Latch latch(kTasks);
+    for (int i = 0; i != kTasks; ++i) {
+      run([&latch, work] {
+        SpinFor(work);
+        latch.CountDown();
+      });
+    }
+    latch.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * kTasks);
+}
+
+void BM_CompletionQueueRunAsync(benchmark::State& state) {
+  BackgroundThreads background(static_cast<std::size_t>(state.range(0)));
+  auto cq = background.cq();
+  RunTasks(state, [&cq](std::function<void()> task) {
+    cq.RunAsync([task](google::cloud::grpc_utils::CompletionQueue&) {
+      task();
+    });
+  });
+}
+BENCHMARK(BM_CompletionQueueRunAsync)->Apply(DispatchArguments)->UseRealTime();
+
+void BM_WorkStealingExecutor(benchmark::State& state) {
+  WorkStealingExecutor executor(static_cast<std::size_t>(state.range(0)));
+  RunTasks(state, [&executor](std::function<void()> task) {
+    executor.Run(std::move(task));
+  });
+}
+BENCHMARK(BM_WorkStealingExecutor)->Apply(DispatchArguments)->UseRealTime();
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,117 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/internal/work_stealing_executor.h"
+#include "google/cloud/future.h"
+#include <gmock/gmock.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+TEST(WorkStealingExecutorTest, RunsAllTasks) {
+  int const count = 1000;
+  std::atomic<int> ran{0};
+  promise<void> done;
+  WorkStealingExecutor executor(4);
+  EXPECT_EQ(4U, executor.size());
+  for (int i = 0; i != count; ++i) {
+    executor.Run([&] {
+      if (ran.fetch_add(1) + 1 == count) done.set_value();
+    });
+  }
+  done.get_future().get();
+  EXPECT_EQ(count, ran.load());
+}
+
+TEST(WorkStealingExecutorTest, StealsFromBusyWorker) {
+  // The tasks scheduled from a worker go to its own deque, and that worker is
+  // blocked until they run, so the other worker must steal them.
+  int const count = 10;
+  std::atomic<int> ran{0};
+  promise<void> all_ran;
+  promise<std::thread::id> parent;
+  std::mutex mu;
+  std::set<std::thread::id> threads;
+  WorkStealingExecutor executor(2);
+  executor.Run([&] {
+    parent.set_value(std::this_thread::get_id());
+    for (int i = 0; i != count; ++i) {
+      executor.Run([&] {
+        {
+          std::lock_guard<std::mutex> lk(mu);
+          threads.insert(std::this_thread::get_id());
+        }
+        if (ran.fetch_add(1) + 1 == count) all_ran.set_value();
+      });
+    }
+    // Wait for the children without consuming the future used by the test.
+    while (ran.load() != count) std::this_thread::yield();
+  });
+  auto const parent_id = parent.get_future().get();
+  all_ran.get_future().get();
+
+  EXPECT_EQ(count, ran.load());
+  std::lock_guard<std::mutex> lk(mu);
+  EXPECT_EQ(1U, threads.size());
+  EXPECT_EQ(0U, threads.count(parent_id));
+}
+
+TEST(WorkStealingExecutorTest, DestructorRunsPendingTasks) {
+  std::atomic<int> ran{0};
+  promise<void> release;
+  auto blocked = release.get_future();
+  {
+    WorkStealingExecutor executor(1);
+    executor.Run([&blocked] { blocked.get(); });
+    for (int i = 0; i != 10; ++i) {
+      executor.Run([&ran] { ++ran; });
+    }
+    release.set_value();
+  }
+  EXPECT_EQ(10, ran.load());
+}
+
+TEST(WorkStealingExecutorTest, ReleasedFromOwnTask) {
+  auto executor = std::make_shared<std::shared_ptr<WorkStealingExecutor>>(
+      std::make_shared<WorkStealingExecutor>(2));
+  auto done = std::make_shared<promise<void>>();
+  auto f = done->get_future();
+  auto& e = **executor;
+  e.Run([executor, done] {
+    // Releasing the last reference in a worker must not join that worker.
+    executor->reset();
+    done->set_value();
+  });
+  executor.reset();
+  EXPECT_EQ(std::future_status::ready, f.wait_for(std::chrono::seconds(10)));
+}
+
+TEST(WorkStealingExecutorTest, AtLeastOneThread) {
+  WorkStealingExecutor executor(0);
+  EXPECT_EQ(1U, executor.size());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,150 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/message.h"
+#include <google/protobuf/io/coded_stream.h>
+#include <ostream>
+
+namespace google {
+namespace cloud {
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+std::string const& Message::data() const {
+  static auto const* const kEmpty = new std::string;
+  return data_ ? *data_ : *kEmpty;
+}
+
+bool operator==(Message const& a, Message const& b) {
+  return a.data() == b.data() && a.ordering_key_ == b.ordering_key_ &&
+         a.attributes_ == b.attributes_ && a.message_id_ == b.message_id_ &&
+         a.publish_time_ == b.publish_time_;
+}
+
+std::ostream& operator<<(std::ostream& os, Message const& rhs) {
+  auto constexpr kMaxData = 64;
+  auto const& data = rhs.data();
+  os << "{message_id=" << rhs.message_id() << ", data.size=" << data.size()
+     << ", data=" << data.substr(0, kMaxData);
+  if (data.size() > kMaxData) os << "...";
+  os << ", ordering_key=" << rhs.ordering_key() << ", attributes={";
+  char const* sep = "";
+  for (auto const& kv : rhs.attributes()) {
+    os << sep << kv.first << "=" << kv.second;
+    sep = ", ";
+  }
+  return os << "}}";
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+namespace {
+google::protobuf::Timestamp ToProtoTimestamp(
+    std::chrono::system_clock::time_point tp) {
+  auto const d = tp.time_since_epoch();
+  auto s = std::chrono::duration_cast<std::chrono::seconds>(d);
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(d - s);
+  if (ns.count() < 0) {
+    s -= std::chrono::seconds(1);
+    ns += std::chrono::seconds(1);
+  }
+  google::protobuf::Timestamp result;
+  result.set_seconds(s.count());
+  result.set_nanos(static_cast<std::int32_t>(ns.count()));
+  return result;
+}
+
+std::chrono::system_clock::time_point FromProtoTimestamp(
+    google::protobuf::Timestamp const& ts) {
+  auto const d = std::chrono::seconds(ts.seconds()) +
+                 std::chrono::nanoseconds(ts.nanos());
+  return std::chrono::system_clock::time_point(
+      std::chrono::duration_cast<std::chrono::system_clock::duration>(d));
+}
+
+/// The encoded size of a length-delimited field with a single byte tag.
+std::size_t FieldSize(std::size_t length) {
+  using google::protobuf::io::CodedOutputStream;
+  return 1 + CodedOutputStream::VarintSize64(length) + length;
+}
+
+std::size_t StringFieldSize(std::string const& v) {
+  return v.empty() ? 0 : FieldSize(v.size());
+}
+}  // namespace
+
+google::pubsub::v1::PubsubMessage ToProto(pubsub::Message const& m) {
+  google::pubsub::v1::PubsubMessage result;
+  ToProto(m, &result);
+  return result;
+}
+
+void ToProto(pubsub::Message const& m,
+             google::pubsub::v1::PubsubMessage* proto) {
+  proto->set_data(m.data());
+  proto->set_ordering_key(m.ordering_key());
+  proto->set_message_id(m.message_id());
+  auto& attributes = *proto->mutable_attributes();
+  for (auto const& kv : m.attributes()) attributes[kv.first] = kv.second;
+  if (m.publish_time() != std::chrono::system_clock::time_point{}) {
+    *proto->mutable_publish_time() = ToProtoTimestamp(m.publish_time());
+  }
+}
+
+pubsub::Message FromProto(google::pubsub::v1::PubsubMessage m) {
+  return FromProto(&m);
+}
+
+pubsub::Message FromProto(google::pubsub::v1::PubsubMessage* proto) {
+  // Moving the strings is safe even if `proto` is owned by an arena: the arena
+  // owns the `std::string` objects, but not their contents.
+  pubsub::Message result;
+  if (!proto->data().empty()) {
+    result.data_ =
+        std::make_shared<std::string const>(std::move(*proto->mutable_data()));
+  }
+  result.ordering_key_ = std::move(*proto->mutable_ordering_key());
+  result.message_id_ = std::move(*proto->mutable_message_id());
+  for (auto& kv : *proto->mutable_attributes()) {
+    result.attributes_.emplace(kv.first, std::move(kv.second));
+  }
+  if (proto->has_publish_time()) {
+    result.publish_time_ = FromProtoTimestamp(proto->publish_time());
+  }
+  return result;
+}
+
+std::size_t MessageProtoSize(pubsub::Message const& m) {
+  // Compute the size without creating the proto, that would copy the payload.
+  // Map entries always include both the key and value fields.
+  std::size_t size = StringFieldSize(m.data());
+  for (auto const& kv : m.attributes()) {
+    size += FieldSize(FieldSize(kv.first.size()) + FieldSize(kv.second.size()));
+  }
+  size += StringFieldSize(m.message_id());
+  if (m.publish_time() != std::chrono::system_clock::time_point{}) {
+    size += FieldSize(ToProtoTimestamp(m.publish_time()).ByteSizeLong());
+  }
+  size += StringFieldSize(m.ordering_key());
+  return size;
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,181 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_MESSAGE_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_MESSAGE_H
+
+#include "google/cloud/pubsub/version.h"
+#include <google/pubsub/v1/pubsub.pb.h>
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace google {
+namespace cloud {
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+class Message;
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+
+namespace pubsub_internal {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+google::pubsub::v1::PubsubMessage ToProto(pubsub::Message const& m);
+/// Copy @p m into @p proto, which may be allocated in an arena.
+void ToProto(pubsub::Message const& m,
+             google::pubsub::v1::PubsubMessage* proto);
+pubsub::Message FromProto(google::pubsub::v1::PubsubMessage m);
+/// Move the fields of @p proto, which may be allocated in an arena.
+pubsub::Message FromProto(google::pubsub::v1::PubsubMessage* proto);
+std::size_t MessageProtoSize(pubsub::Message const& m);
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_internal
+
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * The C++ representation for a Cloud Pub/Sub message.
+ *
+ * The message payload is stored in a reference-counted, immutable, buffer.
+ * Copying a `Message` does not copy the payload, and the publisher holds a
+ * reference to the same buffer until the message is sent. Applications
+ * publishing the same payload many times (or to many topics) can share a
+ * single buffer, see `MessageBuilder::SetData(std::shared_ptr<>)`.
+ *
+ * Use `MessageBuilder` to create new messages. Messages received from Cloud
+ * Pub/Sub also include the `message_id()` and `publish_time()` assigned by the
+ * service.
+ */
+class Message {
+ public:
+  /// An empty message.
+  Message() = default;
+
+  /// @name Copy and move
+  //@{
+  Message(Message const&) = default;
+  Message& operator=(Message const&) = default;
+  Message(Message&&) = default;
+  Message& operator=(Message&&) = default;
+  //@}
+
+  /// The message payload.
+  std::string const& data() const;
+
+  /// The buffer holding the message payload, may be `nullptr` if it is empty.
+  std::shared_ptr<std::string const> const& shared_data() const {
+    return data_;
+  }
+
+  /// The ordering key, empty if the message does not have one.
+  std::string const& ordering_key() const { return ordering_key_; }
+
+  /// The message attributes.
+  std::map<std::string, std::string> const& attributes() const {
+    return attributes_;
+  }
+
+  /// The server-assigned id, empty for messages that are not yet published.
+  std::string const& message_id() const { return message_id_; }
+
+  /// The time when the service received the message.
+  std::chrono::system_clock::time_point publish_time() const {
+    return publish_time_;
+  }
+
+  /// @name Equality operators
+  //@{
+  friend bool operator==(Message const& a, Message const& b);
+  friend bool operator!=(Message const& a, Message const& b) {
+    return !(a == b);
+  }
+  //@}
+
+  /// Output the message, the payload is truncated, for debugging.
+  friend std::ostream& operator<<(std::ostream& os, Message const& rhs);
+
+ private:
+  friend class MessageBuilder;
+  friend Message pubsub_internal::FromProto(
+      google::pubsub::v1::PubsubMessage* proto);
+
+  std::shared_ptr<std::string const> data_;
+  std::string ordering_key_;
+  std::map<std::string, std::string> attributes_;
+  std::string message_id_;
+  std::chrono::system_clock::time_point publish_time_;
+};
+
+/**
+ * Create new `Message` objects.
+ *
+ * @par Example
+ * @code
+ * auto message = pubsub::MessageBuilder{}
+ *                    .SetData("Hello World!")
+ *                    .InsertAttribute("origin", "example")
+ *                    .Build();
+ * @endcode
+ */
+class MessageBuilder {
+ public:
+  MessageBuilder() = default;
+
+  /// Copy (or move) @p data into a new buffer for the message payload.
+  MessageBuilder& SetData(std::string data) {
+    message_.data_ = std::make_shared<std::string const>(std::move(data));
+    return *this;
+  }
+
+  /// Use @p data as the message payload, without copying it.
+  MessageBuilder& SetData(std::shared_ptr<std::string const> data) {
+    message_.data_ = std::move(data);
+    return *this;
+  }
+
+  /// Set the ordering key.
+  MessageBuilder& SetOrderingKey(std::string key) {
+    message_.ordering_key_ = std::move(key);
+    return *this;
+  }
+
+  /// Insert (or replace) an attribute.
+  MessageBuilder& InsertAttribute(std::string key, std::string value) {
+    message_.attributes_[std::move(key)] = std::move(value);
+    return *this;
+  }
+
+  /// Replace all the attributes.
+  MessageBuilder& SetAttributes(std::map<std::string, std::string> v) {
+    message_.attributes_ = std::move(v);
+    return *this;
+  }
+
+  /// Create the message.
+  Message Build() { return std::move(message_); }
+
+ private:
+  Message message_;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_MESSAGE_H
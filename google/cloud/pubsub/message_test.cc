@@ -0,0 +1,149 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/message.h"
+#include "google/cloud/testing_util/is_proto_equal.h"
+#include <gmock/gmock.h>
+#include <sstream>
+
+namespace google {
+namespace cloud {
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+using ::google::cloud::testing_util::IsProtoEqual;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::Pair;
+
+TEST(Message, Empty) {
+  Message const m;
+  EXPECT_TRUE(m.data().empty());
+  EXPECT_EQ(nullptr, m.shared_data());
+  EXPECT_TRUE(m.ordering_key().empty());
+  EXPECT_TRUE(m.attributes().empty());
+  EXPECT_EQ(Message{}, m);
+  EXPECT_EQ(0, pubsub_internal::MessageProtoSize(m));
+}
+
+TEST(Message, Basics) {
+  auto const in = MessageBuilder{}
+                      .SetData("contents-0")
+                      .SetOrderingKey("key-0")
+                      .InsertAttribute("k1", "v1")
+                      .InsertAttribute("k0", "v0")
+                      .Build();
+  EXPECT_EQ("contents-0", in.data());
+  EXPECT_EQ("key-0", in.ordering_key());
+  EXPECT_THAT(in.attributes(), ElementsAre(Pair("k0", "v0"), Pair("k1", "v1")));
+
+  auto copy = in;
+  EXPECT_EQ(copy, in);
+  EXPECT_EQ(copy.shared_data(), in.shared_data());
+
+  auto moved = std::move(copy);
+  EXPECT_EQ(moved, in);
+
+  auto const other = MessageBuilder{}.SetData("contents-1").Build();
+  EXPECT_NE(other, in);
+}
+
+TEST(Message, SharedData) {
+  auto const data = std::make_shared<std::string const>("shared-contents");
+  auto const m0 = MessageBuilder{}.SetData(data).Build();
+  auto const m1 = MessageBuilder{}.SetData(data).SetOrderingKey("k").Build();
+  EXPECT_EQ(data.get(), m0.shared_data().get());
+  EXPECT_EQ(data.get(), m1.shared_data().get());
+  EXPECT_EQ(3, data.use_count());
+}
+
+TEST(Message, ProtoRoundTrip) {
+  google::pubsub::v1::PubsubMessage proto;
+  proto.set_data("contents");
+  proto.set_ordering_key("key");
+  proto.set_message_id("id-0");
+  (*proto.mutable_attributes())["k0"] = "v0";
+  (*proto.mutable_attributes())[""] = "";
+  proto.mutable_publish_time()->set_seconds(1577836800);
+  proto.mutable_publish_time()->set_nanos(123000);
+
+  auto const m = pubsub_internal::FromProto(proto);
+  EXPECT_EQ("contents", m.data());
+  EXPECT_EQ("key", m.ordering_key());
+  EXPECT_EQ("id-0", m.message_id());
+  EXPECT_THAT(m.attributes(), ElementsAre(Pair("", ""), Pair("k0", "v0")));
+  EXPECT_EQ(std::chrono::seconds(1577836800) + std::chrono::microseconds(123),
+            m.publish_time().time_since_epoch());
+
+  auto const actual = pubsub_internal::ToProto(m);
+  EXPECT_THAT(actual, IsProtoEqual(proto));
+}
+
+TEST(Message, FromArenaProto) {
+  google::protobuf::Arena arena;
+  auto* proto =
+      google::protobuf::Arena::CreateMessage<google::pubsub::v1::PubsubMessage>(
+          &arena);
+  std::string const data(1000, 'x');
+  proto->set_data(data);
+  proto->set_message_id("id-0");
+  (*proto->mutable_attributes())["k0"] = "v0";
+  auto const* payload = proto->data().data();
+
+  auto const m = pubsub_internal::FromProto(proto);
+  EXPECT_EQ(data, m.data());
+  EXPECT_EQ("id-0", m.message_id());
+  EXPECT_THAT(m.attributes(), ElementsAre(Pair("k0", "v0")));
+  // The payload is moved, not copied, out of the arena.
+  EXPECT_EQ(payload, m.data().data());
+}
+
+TEST(Message, ProtoSize) {
+  std::vector<Message> messages{
+      MessageBuilder{}.SetData("x").Build(),
+      MessageBuilder{}.SetData(std::string(200, 'x')).Build(),
+      MessageBuilder{}.SetOrderingKey("k").InsertAttribute("", "").Build(),
+      MessageBuilder{}
+          .SetData(std::string(20000, 'x'))
+          .InsertAttribute("k0", std::string(300, 'v'))
+          .InsertAttribute("k1", "v1")
+          .Build(),
+  };
+  for (auto const& m : messages) {
+    SCOPED_TRACE("Testing with " + std::to_string(m.data().size()));
+    EXPECT_EQ(pubsub_internal::ToProto(m).ByteSizeLong(),
+              pubsub_internal::MessageProtoSize(m));
+  }
+}
+
+TEST(Message, OutputStream) {
+  auto const m = MessageBuilder{}
+                     .SetData(std::string(100, 'x'))
+                     .SetOrderingKey("key-0")
+                     .InsertAttribute("k0", "v0")
+                     .Build();
+  std::ostringstream os;
+  os << m;
+  EXPECT_THAT(os.str(), HasSubstr("data.size=100"));
+  EXPECT_THAT(os.str(), HasSubstr(std::string(64, 'x') + "..."));
+  EXPECT_THAT(os.str(), HasSubstr("ordering_key=key-0"));
+  EXPECT_THAT(os.str(), HasSubstr("k0=v0"));
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,55 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_PUBLISHER_CAPACITY_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_PUBLISHER_CAPACITY_H
+
+#include "google/cloud/pubsub/version.h"
+#include <cstddef>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * A snapshot of the publisher flow control state.
+ *
+ * Pending messages have been published by the application, but the service
+ * has not acknowledged them (or reported an error) yet.
+ *
+ * @see `PublisherOptions::set_maximum_pending_messages()` and
+ *     `PublisherOptions::set_maximum_pending_bytes()`.
+ */
+struct PublisherCapacity {
+  /// The number of pending messages.
+  std::size_t pending_messages = 0;
+  /// The total size, in bytes, of the pending messages.
+  std::size_t pending_bytes = 0;
+  /// How many more messages can be published before reaching the limit.
+  std::size_t available_messages = 0;
+  /// How many more bytes can be published before reaching the limit.
+  std::size_t available_bytes = 0;
+  /// The number of RPCs in flight on each channel. A large imbalance
+  /// indicates some connections are slow.
+  std::vector<std::size_t> channel_rpcs_in_flight;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_PUBLISHER_CAPACITY_H
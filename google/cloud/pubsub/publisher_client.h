@@ -17,6 +17,7 @@
 
 #include "google/cloud/pubsub/create_topic_builder.h"
 #include "google/cloud/pubsub/publisher_connection.h"
+#include <chrono>
 #include <memory>
 
 namespace google {
@@ -71,7 +72,8 @@ class PublisherClient {
    * Create a new topic in Cloud Pub/Sub.
    *
    * @par Idempotency
-   * This is not an idempotent operation and therefore it is never retried.
+   * This is not an idempotent operation and therefore it is not retried, unless
+   * the application changes the `PublisherOptions::idempotency_policy()`.
    *
    * @par Example
    * @snippet samples.cc create-topic
@@ -100,7 +102,8 @@ class PublisherClient {
    * Delete an existing topic in Cloud Pub/Sub.
    *
    * @par Idempotency
-   * This is not an idempotent operation and therefore it is never retried.
+   * This is not an idempotent operation and therefore it is not retried, unless
+   * the application changes the `PublisherOptions::idempotency_policy()`.
    *
    * @par Example
    * @snippet samples.cc delete-topic
@@ -111,6 +114,105 @@ class PublisherClient {
     return connection_->DeleteTopic({std::move(topic)});
   }
 
+  /**
+   * Publish a message to a Cloud Pub/Sub topic.
+   *
+   * Messages are not sent immediately, they are collected into batches, see
+   * `PublisherOptions` for the limits that control when a batch is sent. The
+   * returned future is satisfied with the server-assigned message id when
+   * the batch containing this message is successfully sent.
+   *
+   * This function does not block waiting for the RPC. The batches are sent
+   * using asynchronous RPCs, which complete in a pool of background threads
+   * owned by the connection, and the returned future is satisfied in one of
+   * those threads. Use `PublisherOptions::set_background_thread_pool_size()` to
+   * configure the size of the pool.
+   *
+   * If the number of pending messages reaches the limits configured in
+   * `PublisherOptions`, this function blocks, fails the message with
+   * `StatusCode::kResourceExhausted`, or drops older messages, depending on
+   * `PublisherOptions::flow_control_action()`.
+   *
+   * @par Idempotency
+   * This is not an idempotent operation, retrying it may result in duplicate
+   * messages. It is not retried, unless the application changes the
+   * `PublisherOptions::idempotency_policy()`.
+   *
+   * @par Example
+   * @snippet samples.cc publish
+   *
+   * @param topic the topic receiving the message.
+   * @param message the message contents, the service assigns the
+   *     `message_id` and `publish_time` fields. Messages with an
+   *     `ordering_key` require `PublisherOptions::enable_message_ordering()`.
+   *     The payload is not copied until the batch is sent, see `Message`.
+   */
+  future<StatusOr<std::string>> Publish(Topic topic, Message message) {
+    return connection_->Publish({std::move(topic), std::move(message)});
+  }
+
+  /**
+   * Send any pending batches immediately.
+   *
+   * This function does not wait for the batches to complete, use the futures
+   * returned by `Publish()` for that purpose.
+   */
+  void Flush() { connection_->Flush({}); }
+
+  /**
+   * Resume publishing for @p ordering_key after an error.
+   *
+   * With message ordering enabled, a failure to publish a message pauses all
+   * publishing for its ordering key: any pending and new messages with the
+   * same key fail. Applications call this function once they are ready to
+   * publish messages with that key again, for example, after re-publishing the
+   * failed messages.
+   *
+   * @see `PublisherOptions::enable_message_ordering()`
+   */
+  void ResumePublish(Topic topic, std::string ordering_key) {
+    connection_->ResumePublish({std::move(topic), std::move(ordering_key)});
+  }
+
+  /**
+   * Return the number of pending messages and the remaining capacity.
+   *
+   * Applications can use this function to slow down before reaching the flow
+   * control limits, or to export the state of the publisher as a metric.
+   *
+   * @see `PublisherOptions::set_maximum_pending_messages()`
+   */
+  PublisherCapacity Capacity() { return connection_->Capacity(); }
+
+  /**
+   * Connect all the channels in the connection pool, in parallel.
+   *
+   * The connection creates its channels on first use, so the first requests
+   * on each channel pay for the DNS resolution and the TLS handshake.
+   * Applications that need to serve traffic as soon as they start can call
+   * this function to create and connect all the channels upfront. It blocks
+   * until all the channels are ready, or until @p deadline.
+   *
+   * @return an error with `StatusCode::kDeadlineExceeded` if some channel is
+   *     not ready before @p deadline. The channels keep connecting in the
+   *     background, the application may use the client regardless.
+   *
+   * @see `ConnectionOptions::set_num_channels()`
+   */
+  Status Connect(std::chrono::system_clock::time_point deadline) {
+    return connection_->Connect({deadline});
+  }
+
+  /**
+   * Connect all the channels in the connection pool, waiting up to
+   * @p timeout.
+   *
+   * @see `PublisherClient::Connect()`
+   */
+  Status WarmUp(std::chrono::milliseconds timeout = std::chrono::seconds(10)) {
+    return Connect(std::chrono::system_clock::now() + timeout);
+  }
+
  private:
   std::shared_ptr<PublisherConnection> connection_;
 };
@@ -13,8 +13,15 @@
 // limitations under the License.
 
 #include "google/cloud/pubsub/publisher_connection.h"
+#include "google/cloud/pubsub/internal/background_threads.h"
+#include "google/cloud/pubsub/internal/batching_publisher.h"
+#include "google/cloud/pubsub/internal/publisher_channel_pool.h"
+#include "google/cloud/pubsub/internal/publisher_retry.h"
 #include "google/cloud/pubsub/internal/publisher_stub.h"
+#include "google/cloud/internal/make_unique.h"
+#include <functional>
 #include <memory>
+#include <mutex>
 
 namespace google {
 namespace cloud {
@@ -24,11 +31,18 @@ inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
 namespace {
 class PublisherConnectionImpl : public PublisherConnection {
  public:
-  explicit PublisherConnectionImpl(
-      std::shared_ptr<pubsub_internal::PublisherStub> stub)
-      : stub_(std::move(stub)) {}
+  PublisherConnectionImpl(
+      std::shared_ptr<pubsub_internal::PublisherChannelPool> pool,
+      PublisherOptions publisher_options)
+      : pool_(std::move(pool)),
+        stub_(std::make_shared<pubsub_internal::PublisherRetry>(
+            pool_, pubsub_internal::MakeRetryPolicies(publisher_options))),
+        publisher_options_(std::move(publisher_options)) {}
 
-  ~PublisherConnectionImpl() override = default;
+  ~PublisherConnectionImpl() override {
+    // Send any pending messages before the background threads stop.
+    publisher_.reset();
+  }
 
   StatusOr<google::pubsub::v1::Topic> CreateTopic(
       CreateTopicParams p) override {
@@ -40,12 +54,26 @@ class PublisherConnectionImpl : public PublisherConnection {
     google::pubsub::v1::ListTopicsRequest request;
     request.set_project(std::move(p.project_id));
     auto& stub = stub_;
-    return ListTopicsRange(
-        std::move(request),
-        [stub](google::pubsub::v1::ListTopicsRequest const& request) {
+    // Hedging needs timers, only then use the background threads.
+    std::function<StatusOr<google::pubsub::v1::ListTopicsResponse>(
+        google::pubsub::v1::ListTopicsRequest const&)>
+        list = [stub](google::pubsub::v1::ListTopicsRequest const& request) {
           grpc::ClientContext context;
           return stub->ListTopics(context, request);
-        },
+        };
+    if (publisher_options_.hedging()) {
+      auto cq = background().cq();
+      list = [stub, cq](google::pubsub::v1::ListTopicsRequest const&
+                            request) mutable {
+        return stub
+            ->AsyncListTopics(
+                cq, google::cloud::internal::make_unique<grpc::ClientContext>(),
+                request)
+            .get();
+      };
+    }
+    return ListTopicsRange(
+        std::move(request), std::move(list),
         [](google::pubsub::v1::ListTopicsResponse response) {
           std::vector<google::pubsub::v1::Topic> items;
           items.reserve(response.topics_size());
@@ -63,18 +91,71 @@ class PublisherConnectionImpl : public PublisherConnection {
     return stub_->DeleteTopic(context, request);
   }
 
+  future<StatusOr<std::string>> Publish(PublishParams p) override {
+    return publisher().Publish(p.topic.FullName(), std::move(p.message));
+  }
+
+  void Flush(FlushParams) override { publisher().Flush(); }
+
+  void ResumePublish(ResumePublishParams p) override {
+    publisher().ResumePublish(p.topic.FullName(), p.ordering_key);
+  }
+
+  PublisherCapacity Capacity() override {
+    auto capacity = publisher().Capacity();
+    capacity.channel_rpcs_in_flight = pool_->in_flight();
+    return capacity;
+  }
+
+  Status Connect(ConnectParams p) override {
+    // The channels connect in parallel, in the background threads.
+    auto cq = background().cq();
+    return pool_->AsyncWaitForConnected(cq, p.deadline).get();
+  }
+
  private:
+  // Applications that only use the administrative operations never need the
+  // background threads used by the batching publisher, create them on demand.
+  pubsub_internal::BackgroundThreads& background() {
+    std::call_once(background_once_, [this] {
+      background_ = google::cloud::internal::make_unique<
+          pubsub_internal::BackgroundThreads>(
+          publisher_options_.background_thread_pool_size());
+    });
+    return *background_;
+  }
+
+  pubsub_internal::BatchingPublisher& publisher() {
+    std::call_once(publisher_once_, [this] {
+      publisher_ = std::make_shared<pubsub_internal::BatchingPublisher>(
+          background().cq(), stub_, publisher_options_);
+    });
+    return *publisher_;
+  }
+
+  std::shared_ptr<pubsub_internal::PublisherChannelPool> pool_;
+  // Retries the calls, each attempt uses the least loaded channel in `pool_`.
   std::shared_ptr<pubsub_internal::PublisherStub> stub_;
+  PublisherOptions const publisher_options_;
+  std::once_flag background_once_;
+  std::once_flag publisher_once_;
+  std::unique_ptr<pubsub_internal::BackgroundThreads> background_;
+  std::shared_ptr<pubsub_internal::BatchingPublisher> publisher_;
 };
 }  // namespace
 
 PublisherConnection::~PublisherConnection() = default;
 
 std::shared_ptr<PublisherConnection> MakePublisherConnection(
-    ConnectionOptions const& options) {
-  auto stub =
-      pubsub_internal::CreateDefaultPublisherStub(options, /*channel_id=*/0);
-  return std::make_shared<PublisherConnectionImpl>(std::move(stub));
+    ConnectionOptions const& options, PublisherOptions publisher_options) {
+  std::shared_ptr<pubsub_internal::HedgeDelay> list_hedge_delay;
+  if (publisher_options.hedging()) {
+    list_hedge_delay = std::make_shared<pubsub_internal::HedgeDelay>();
+  }
+  auto stub = pubsub_internal::CreateDefaultPublisherStubPool(
+      options, std::move(list_hedge_delay));
+  return std::make_shared<PublisherConnectionImpl>(
+      std::move(stub), std::move(publisher_options));
 }
 
 }  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
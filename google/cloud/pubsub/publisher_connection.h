@@ -16,10 +16,15 @@
 #define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_PUBLISHER_CONNECTION_H
 
 #include "google/cloud/pubsub/connection_options.h"
+#include "google/cloud/pubsub/message.h"
+#include "google/cloud/pubsub/publisher_capacity.h"
+#include "google/cloud/pubsub/publisher_options.h"
 #include "google/cloud/pubsub/topic.h"
+#include "google/cloud/future.h"
 #include "google/cloud/internal/pagination_range.h"
 #include "google/cloud/status_or.h"
 #include <google/pubsub/v1/pubsub.pb.h>
+#include <chrono>
 #include <memory>
 
 namespace google {
@@ -79,6 +84,26 @@ class PublisherConnection {
   struct DeleteTopicParams {
     Topic topic;
   };
+
+  /// Wrap the arguments for `Publish()`
+  struct PublishParams {
+    Topic topic;
+    Message message;
+  };
+
+  /// Wrap the arguments for `Flush()`
+  struct FlushParams {};
+
+  /// Wrap the arguments for `ResumePublish()`
+  struct ResumePublishParams {
+    Topic topic;
+    std::string ordering_key;
+  };
+
+  /// Wrap the arguments for `Connect()`
+  struct ConnectParams {
+    std::chrono::system_clock::time_point deadline;
+  };
   //@}
 
   /// Defines the interface for `Client::CreateTopic()`
@@ -90,6 +115,21 @@ class PublisherConnection {
 
   /// Defines the interface for `Client::DeleteTopic()`
   virtual Status DeleteTopic(DeleteTopicParams) = 0;
+
+  /// Defines the interface for `Client::Publish()`
+  virtual future<StatusOr<std::string>> Publish(PublishParams) = 0;
+
+  /// Defines the interface for `Client::Flush()`
+  virtual void Flush(FlushParams) = 0;
+
+  /// Defines the interface for `Client::ResumePublish()`
+  virtual void ResumePublish(ResumePublishParams) = 0;
+
+  /// Defines the interface for `Client::Capacity()`
+  virtual PublisherCapacity Capacity() = 0;
+
+  /// Defines the interface for `Client::Connect()`
+  virtual Status Connect(ConnectParams) = 0;
 };
 
 /**
@@ -104,9 +144,13 @@ class PublisherConnection {
  *
  * @param options (optional) configure the `PublisherConnection` created by
  *     this function.
+ * @param publisher_options (optional) configure how `Publish()` batches
+ *     messages, and the number of background threads used to complete the
+ *     asynchronous RPCs.
  */
 std::shared_ptr<PublisherConnection> MakePublisherConnection(
-    ConnectionOptions const& options = ConnectionOptions());
+    ConnectionOptions const& options = ConnectionOptions(),
+    PublisherOptions publisher_options = PublisherOptions());
 
 }  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
 }  // namespace pubsub
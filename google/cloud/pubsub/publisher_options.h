@@ -0,0 +1,449 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_PUBLISHER_OPTIONS_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_PUBLISHER_OPTIONS_H
+
+#include "google/cloud/pubsub/backoff_policy.h"
+#include "google/cloud/pubsub/idempotency_policy.h"
+#include "google/cloud/pubsub/retry_policy.h"
+#include "google/cloud/pubsub/version.h"
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * What `PublisherClient::Publish()` does when the flow control limits are
+ * reached.
+ *
+ * @see `PublisherOptions::set_maximum_pending_messages()` and
+ *     `PublisherOptions::set_maximum_pending_bytes()`.
+ */
+enum class PublisherFlowControlAction {
+  /**
+   * Block the caller until enough pending messages complete.
+   *
+   * Calls to `Publish()` from the continuation of a `Publish()` future run in
+   * the threads that complete the pending messages, and cannot block. If the
+   * new message does not fit, these calls fail immediately with
+   * `StatusCode::kResourceExhausted`, as with `kReject`.
+   */
+  kBlock,
+  /// Fail the new message immediately with `StatusCode::kResourceExhausted`.
+  kReject,
+  /**
+   * Drop the oldest messages that are not yet sent until the new message fits.
+   *
+   * The dropped messages fail with `StatusCode::kResourceExhausted`. Messages
+   * in batches already sent to the service are never dropped, and neither are
+   * messages with an ordering key: that would leave a gap in their order. If
+   * there are no messages to drop the new message is rejected.
+   */
+  kDropOldest,
+};
+
+/**
+ * Configure the batching behavior of `PublisherClient::Publish()`.
+ *
+ * Messages published to the same topic are collected into a single
+ * `PublishRequest`. The batch is sent as soon as any of the following limits
+ * is reached:
+ *   - The batch contains `maximum_batch_message_count()` messages.
+ *   - The batch contains `maximum_batch_bytes()` bytes of message data.
+ *   - The oldest message in the batch has been waiting for
+ *     `maximum_hold_time()`.
+ *
+ * Batches are sent using asynchronous RPCs, which are completed by a pool of
+ * `background_thread_pool_size()` threads. `Publish()` never blocks waiting for
+ * the RPC.
+ *
+ * Messages with an ordering key require `enable_message_ordering()`. With
+ * message ordering enabled the publisher keeps at most one batch in flight
+ * for each ordering key, and messages with the same key are sent in the order
+ * they were published. Batches for different ordering keys are sent in
+ * parallel.
+ *
+ * The publisher can also limit the number of messages (and bytes) that are
+ * pending, that is, published by the application but not yet acknowledged by
+ * the service. The `flow_control_action()` determines what happens when a
+ * new message would exceed these limits. By default there are no limits.
+ *
+ * With `enable_adaptive_batching()` the publisher adjusts the batch size and
+ * hold time based on the observed RPC latency and throughput. The batch grows
+ * (additively) while the latency stays close to the lowest latency observed,
+ * and shrinks (multiplicatively) when the latency increases, or the RPCs
+ * fail. The hold time only grows while the throughput keeps up. The
+ * `maximum_batch_bytes()` and `maximum_hold_time()` become the upper bounds
+ * for these values, and `minimum_batch_bytes()` and `minimum_hold_time()` the
+ * lower bounds.
+ *
+ * With `enable_compression()` batches of at least `compression_threshold()`
+ * bytes are sent using gzip compression. Compression trades CPU time for
+ * fewer bytes on the network, and works best with text payloads.
+ *
+ * With `enable_hedging()` a slow `PublisherClient::ListTopics()` page is
+ * requested again on a different channel, see `hedging()`.
+ *
+ * @note The service rejects `PublishRequest`s with more than 1,000 messages or
+ *     more than 10MB, applications should not exceed these limits.
+ */
+class PublisherOptions {
+ public:
+  PublisherOptions() = default;
+
+  /// The maximum time a message is held before its batch is sent.
+  std::chrono::microseconds maximum_hold_time() const {
+    return maximum_hold_time_;
+  }
+
+  /// Set the maximum time a message is held before its batch is sent.
+  template <typename Rep, typename Period>
+  PublisherOptions& set_maximum_hold_time(
+      std::chrono::duration<Rep, Period> v) {
+    maximum_hold_time_ =
+        std::chrono::duration_cast<std::chrono::microseconds>(v);
+    return *this;
+  }
+
+  /// The maximum number of messages in a batch.
+  std::size_t maximum_batch_message_count() const {
+    return maximum_batch_message_count_;
+  }
+
+  /// Set the maximum number of messages in a batch, `0` is treated as `1`.
+  PublisherOptions& set_maximum_batch_message_count(std::size_t v) {
+    maximum_batch_message_count_ = v == 0 ? 1 : v;
+    return *this;
+  }
+
+  /// The maximum size, in bytes, of the messages in a batch.
+  std::size_t maximum_batch_bytes() const { return maximum_batch_bytes_; }
+
+  /// Set the maximum size, in bytes, of the messages in a batch.
+  PublisherOptions& set_maximum_batch_bytes(std::size_t v) {
+    maximum_batch_bytes_ = v;
+    return *this;
+  }
+
+  /// If true, the batch size and hold time adapt to the RPC latency.
+  bool adaptive_batching() const { return adaptive_batching_; }
+
+  /**
+   * Adjust the batch size and hold time based on the observed RPC latency.
+   *
+   * The values change between the minimums and maximums configured in this
+   * class. Larger batches reduce the number of RPCs, smaller batches reduce
+   * the latency of each message.
+   */
+  PublisherOptions& enable_adaptive_batching() {
+    adaptive_batching_ = true;
+    return *this;
+  }
+
+  /// Use the maximum batch size and hold time for all batches.
+  PublisherOptions& disable_adaptive_batching() {
+    adaptive_batching_ = false;
+    return *this;
+  }
+
+  /// The lower bound for the batch size with adaptive batching.
+  std::size_t minimum_batch_bytes() const { return minimum_batch_bytes_; }
+
+  /// Set the lower bound for the batch size with adaptive batching.
+  PublisherOptions& set_minimum_batch_bytes(std::size_t v) {
+    minimum_batch_bytes_ = v;
+    return *this;
+  }
+
+  /// The lower bound for the hold time with adaptive batching.
+  std::chrono::microseconds minimum_hold_time() const {
+    return minimum_hold_time_;
+  }
+
+  /// Set the lower bound for the hold time with adaptive batching.
+  template <typename Rep, typename Period>
+  PublisherOptions& set_minimum_hold_time(
+      std::chrono::duration<Rep, Period> v) {
+    minimum_hold_time_ =
+        std::chrono::duration_cast<std::chrono::microseconds>(v);
+    return *this;
+  }
+
+  /// If true, messages with the same ordering key are sent in order.
+  bool message_ordering() const { return message_ordering_; }
+
+  /**
+   * Send messages with the same ordering key in order.
+   *
+   * If a batch fails, publishing for its ordering key is paused: all the
+   * pending and new messages with that key fail until the application calls
+   * `PublisherClient::ResumePublish()`. Other ordering keys are not affected.
+   */
+  PublisherOptions& enable_message_ordering() {
+    message_ordering_ = true;
+    return *this;
+  }
+
+  /// Disable message ordering, messages with an ordering key are rejected.
+  PublisherOptions& disable_message_ordering() {
+    message_ordering_ = false;
+    return *this;
+  }
+
+  /// The maximum number of pending messages.
+  std::size_t maximum_pending_messages() const {
+    return maximum_pending_messages_;
+  }
+
+  /// Set the maximum number of pending messages, `0` is treated as `1`.
+  PublisherOptions& set_maximum_pending_messages(std::size_t v) {
+    maximum_pending_messages_ = v == 0 ? 1 : v;
+    return *this;
+  }
+
+  /// The maximum size, in bytes, of the pending messages.
+  std::size_t maximum_pending_bytes() const { return maximum_pending_bytes_; }
+
+  /**
+   * Set the maximum size, in bytes, of the pending messages.
+   *
+   * A single message larger than this limit is accepted if there are no other
+   * pending messages.
+   */
+  PublisherOptions& set_maximum_pending_bytes(std::size_t v) {
+    maximum_pending_bytes_ = v;
+    return *this;
+  }
+
+  /// What to do when the pending message limits are reached.
+  PublisherFlowControlAction flow_control_action() const {
+    return flow_control_action_;
+  }
+
+  /// Set the action taken when the pending message limits are reached.
+  PublisherOptions& set_flow_control_action(PublisherFlowControlAction v) {
+    flow_control_action_ = v;
+    return *this;
+  }
+
+  /// If true, the publisher serializes the requests directly.
+  bool direct_encoding() const { return direct_encoding_; }
+
+  /**
+   * Serialize the `PublishRequest` wire format directly, without a proto.
+   *
+   * With this option the publisher writes the batches into a
+   * `grpc::ByteBuffer` and sends them through a generic gRPC stub. The request
+   * proto is never created, and large message payloads are referenced by the
+   * buffer instead of being copied.
+   */
+  PublisherOptions& enable_direct_encoding() {
+    direct_encoding_ = true;
+    return *this;
+  }
+
+  /// Use the generated gRPC stub to serialize the requests.
+  PublisherOptions& disable_direct_encoding() {
+    direct_encoding_ = false;
+    return *this;
+  }
+
+  /// If true, large batches are compressed.
+  bool compression() const { return compression_; }
+
+  /// Compress batches of at least `compression_threshold()` bytes with gzip.
+  PublisherOptions& enable_compression() {
+    compression_ = true;
+    return *this;
+  }
+
+  /// Send all batches uncompressed.
+  PublisherOptions& disable_compression() {
+    compression_ = false;
+    return *this;
+  }
+
+  /// The minimum size, in bytes, of compressed batches.
+  std::size_t compression_threshold() const { return compression_threshold_; }
+
+  /**
+   * Set the minimum size, in bytes, of compressed batches.
+   *
+   * Compressing small batches costs more CPU than it saves in the network, and
+   * may even increase their size. This has no effect unless compression is
+   * enabled.
+   */
+  PublisherOptions& set_compression_threshold(std::size_t v) {
+    compression_threshold_ = v;
+    return *this;
+  }
+
+  /// The number of threads used to complete the asynchronous RPCs.
+  std::size_t background_thread_pool_size() const {
+    return background_thread_pool_size_;
+  }
+
+  /// Set the number of background threads, `0` is treated as `1`.
+  PublisherOptions& set_background_thread_pool_size(std::size_t v) {
+    background_thread_pool_size_ = v == 0 ? 1 : v;
+    return *this;
+  }
+
+  /// The policy controlling how long failed operations are retried.
+  std::shared_ptr<RetryPolicy const> retry_policy() const {
+    return retry_policy_;
+  }
+
+  /**
+   * Set the policy controlling how long failed operations are retried.
+   *
+   * The connection keeps a copy of @p v, and uses a fresh `clone()` of it for
+   * each operation. The default retries transient failures for up to 60
+   * seconds.
+   */
+  PublisherOptions& set_retry_policy(RetryPolicy const& v) {
+    retry_policy_ = v.clone();
+    return *this;
+  }
+
+  /// The policy controlling the delay between retries.
+  std::shared_ptr<BackoffPolicy const> backoff_policy() const {
+    return backoff_policy_;
+  }
+
+  /**
+   * Set the policy controlling the delay between retries.
+   *
+   * The default is a truncated exponential backoff with jitter, starting at
+   * 100 milliseconds and growing up to 10 seconds.
+   */
+  PublisherOptions& set_backoff_policy(BackoffPolicy const& v) {
+    backoff_policy_ = v.clone();
+    return *this;
+  }
+
+  /// The policy controlling which operations are retried.
+  std::shared_ptr<IdempotencyPolicy const> idempotency_policy() const {
+    return idempotency_policy_;
+  }
+
+  /**
+   * Set the policy controlling which operations are retried.
+   *
+   * The default, `DefaultIdempotencyPolicy`, does not retry `CreateTopic()`,
+   * `DeleteTopic()`, and `Publish()`: retrying them is not always safe. Use
+   * `AlwaysRetryIdempotencyPolicy` to retry all of them.
+   */
+  PublisherOptions& set_idempotency_policy(IdempotencyPolicy const& v) {
+    idempotency_policy_ = v.clone();
+    return *this;
+  }
+
+  /// The maximum number of tokens in the retry budget.
+  double retry_budget_max_tokens() const { return retry_budget_max_tokens_; }
+
+  /// The tokens added to the retry budget by each successful attempt.
+  double retry_budget_token_ratio() const { return retry_budget_token_ratio_; }
+
+  /**
+   * Limit the retries when most attempts fail.
+   *
+   * All the operations in a connection share a bucket of up to
+   * @p max_tokens tokens. Each attempt failing with a transient error removes
+   * one token, each successful attempt adds @p token_ratio tokens, and the
+   * operations are only retried while the bucket is more than half full. That
+   * is, once the ratio of failed to successful attempts exceeds
+   * @p token_ratio the connection stops retrying, instead of adding load to
+   * an already overloaded service. Use `0` @p max_tokens to disable the
+   * budget.
+   */
+  PublisherOptions& set_retry_budget(double max_tokens, double token_ratio) {
+    retry_budget_max_tokens_ = max_tokens;
+    retry_budget_token_ratio_ = token_ratio;
+    return *this;
+  }
+
+  /// If true, slow `ListTopics()` pages are hedged.
+  bool hedging() const { return hedging_; }
+
+  /**
+   * Hedge the `ListTopics()` calls.
+   *
+   * A page that takes longer than the 95th percentile of the recent pages is
+   * requested again on a different channel, and the first response is used.
+   * The delay adapts to the observed latency, so this sends about 5% more
+   * calls. Hedging starts after a few pages complete, and has no effect with a
+   * single channel, see `ConnectionOptions::set_num_channels()`. The hedge
+   * timers run in the background threads.
+   */
+  PublisherOptions& enable_hedging() {
+    hedging_ = true;
+    return *this;
+  }
+
+  /// Send each `ListTopics()` call once.
+  PublisherOptions& disable_hedging() {
+    hedging_ = false;
+    return *this;
+  }
+
+ private:
+  static std::size_t DefaultThreadPoolSize() {
+    // hardware_concurrency() may return 0 if the value is not computable.
+    auto const n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+  }
+
+  std::chrono::microseconds maximum_hold_time_ = std::chrono::milliseconds(10);
+  std::size_t maximum_batch_message_count_ = 100;
+  std::size_t maximum_batch_bytes_ = 1024 * 1024L;
+  std::size_t background_thread_pool_size_ = DefaultThreadPoolSize();
+  bool message_ordering_ = false;
+  std::size_t maximum_pending_messages_ =
+      (std::numeric_limits<std::size_t>::max)();
+  std::size_t maximum_pending_bytes_ =
+      (std::numeric_limits<std::size_t>::max)();
+  PublisherFlowControlAction flow_control_action_ =
+      PublisherFlowControlAction::kReject;
+  bool direct_encoding_ = false;
+  bool compression_ = false;
+  bool adaptive_batching_ = false;
+  std::size_t minimum_batch_bytes_ = 16 * 1024L;
+  std::chrono::microseconds minimum_hold_time_ = std::chrono::milliseconds(1);
+  std::size_t compression_threshold_ = 1024;
+  std::shared_ptr<RetryPolicy const> retry_policy_ =
+      std::make_shared<LimitedTimeRetryPolicy>(std::chrono::seconds(60));
+  std::shared_ptr<BackoffPolicy const> backoff_policy_ =
+      std::make_shared<ExponentialBackoffPolicy>(
+          std::chrono::milliseconds(100), std::chrono::seconds(10), 2.0);
+  std::shared_ptr<IdempotencyPolicy const> idempotency_policy_ =
+      std::make_shared<DefaultIdempotencyPolicy>();
+  double retry_budget_max_tokens_ = 100;
+  double retry_budget_token_ratio_ = 0.1;
+  bool hedging_ = false;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_PUBLISHER_OPTIONS_H
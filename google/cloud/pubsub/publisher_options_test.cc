@@ -0,0 +1,155 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/publisher_options.h"
+#include <gmock/gmock.h>
+#include <limits>
+
+namespace google {
+namespace cloud {
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+TEST(PublisherOptions, Defaults) {
+  PublisherOptions const options;
+  EXPECT_EQ(std::chrono::milliseconds(10), options.maximum_hold_time());
+  EXPECT_EQ(100U, options.maximum_batch_message_count());
+  EXPECT_EQ(1024 * 1024U, options.maximum_batch_bytes());
+  EXPECT_LE(1U, options.background_thread_pool_size());
+  EXPECT_FALSE(options.message_ordering());
+  EXPECT_EQ((std::numeric_limits<std::size_t>::max)(),
+            options.maximum_pending_messages());
+  EXPECT_EQ((std::numeric_limits<std::size_t>::max)(),
+            options.maximum_pending_bytes());
+  EXPECT_EQ(PublisherFlowControlAction::kReject,
+            options.flow_control_action());
+  EXPECT_FALSE(options.direct_encoding());
+  EXPECT_FALSE(options.compression());
+  EXPECT_EQ(1024U, options.compression_threshold());
+  EXPECT_FALSE(options.adaptive_batching());
+  EXPECT_EQ(16 * 1024U, options.minimum_batch_bytes());
+  EXPECT_EQ(std::chrono::milliseconds(1), options.minimum_hold_time());
+  ASSERT_NE(nullptr, options.retry_policy());
+  ASSERT_NE(nullptr, options.backoff_policy());
+  EXPECT_FALSE(options.idempotency_policy()->IsIdempotent(
+      IdempotencyPolicy::Operation::kPublish));
+  EXPECT_DOUBLE_EQ(100.0, options.retry_budget_max_tokens());
+  EXPECT_DOUBLE_EQ(0.1, options.retry_budget_token_ratio());
+  EXPECT_FALSE(options.hedging());
+}
+
+TEST(PublisherOptions, RetryPolicies) {
+  auto const options =
+      PublisherOptions{}
+          .set_retry_policy(LimitedErrorCountRetryPolicy(0))
+          .set_backoff_policy(ExponentialBackoffPolicy(
+              std::chrono::milliseconds(10), std::chrono::milliseconds(10), 2))
+          .set_idempotency_policy(AlwaysRetryIdempotencyPolicy{})
+          .set_retry_budget(10, 0.5);
+  EXPECT_FALSE(options.retry_policy()->clone()->OnFailure(
+      Status(StatusCode::kUnavailable, "try-again")));
+  auto const delay = options.backoff_policy()->clone()->OnCompletion();
+  EXPECT_LE(std::chrono::milliseconds(5), delay);
+  EXPECT_GE(std::chrono::milliseconds(10), delay);
+  EXPECT_TRUE(options.idempotency_policy()->IsIdempotent(
+      IdempotencyPolicy::Operation::kCreateTopic));
+  EXPECT_DOUBLE_EQ(10.0, options.retry_budget_max_tokens());
+  EXPECT_DOUBLE_EQ(0.5, options.retry_budget_token_ratio());
+}
+
+TEST(PublisherOptions, Setters) {
+  auto const options = PublisherOptions{}
+                           .set_maximum_hold_time(std::chrono::seconds(2))
+                           .set_maximum_batch_message_count(42)
+                           .set_maximum_batch_bytes(123)
+                           .set_background_thread_pool_size(3);
+  EXPECT_EQ(std::chrono::seconds(2), options.maximum_hold_time());
+  EXPECT_EQ(42U, options.maximum_batch_message_count());
+  EXPECT_EQ(123U, options.maximum_batch_bytes());
+  EXPECT_EQ(3U, options.background_thread_pool_size());
+}
+
+TEST(PublisherOptions, Hedging) {
+  auto options = PublisherOptions{}.enable_hedging();
+  EXPECT_TRUE(options.hedging());
+  options.disable_hedging();
+  EXPECT_FALSE(options.hedging());
+}
+
+TEST(PublisherOptions, MessageOrdering) {
+  auto options = PublisherOptions{}.enable_message_ordering();
+  EXPECT_TRUE(options.message_ordering());
+  options.disable_message_ordering();
+  EXPECT_FALSE(options.message_ordering());
+}
+
+TEST(PublisherOptions, DirectEncoding) {
+  auto options = PublisherOptions{}.enable_direct_encoding();
+  EXPECT_TRUE(options.direct_encoding());
+  options.disable_direct_encoding();
+  EXPECT_FALSE(options.direct_encoding());
+}
+
+TEST(PublisherOptions, Compression) {
+  auto options =
+      PublisherOptions{}.enable_compression().set_compression_threshold(42);
+  EXPECT_TRUE(options.compression());
+  EXPECT_EQ(42U, options.compression_threshold());
+  options.disable_compression();
+  EXPECT_FALSE(options.compression());
+}
+
+TEST(PublisherOptions, AdaptiveBatching) {
+  auto options = PublisherOptions{}
+                     .enable_adaptive_batching()
+                     .set_minimum_batch_bytes(1000)
+                     .set_minimum_hold_time(std::chrono::microseconds(50));
+  EXPECT_TRUE(options.adaptive_batching());
+  EXPECT_EQ(1000U, options.minimum_batch_bytes());
+  EXPECT_EQ(std::chrono::microseconds(50), options.minimum_hold_time());
+  options.disable_adaptive_batching();
+  EXPECT_FALSE(options.adaptive_batching());
+}
+
+TEST(PublisherOptions, FlowControl) {
+  auto const options =
+      PublisherOptions{}
+          .set_maximum_pending_messages(10)
+          .set_maximum_pending_bytes(1000)
+          .set_flow_control_action(PublisherFlowControlAction::kDropOldest);
+  EXPECT_EQ(10U, options.maximum_pending_messages());
+  EXPECT_EQ(1000U, options.maximum_pending_bytes());
+  EXPECT_EQ(PublisherFlowControlAction::kDropOldest,
+            options.flow_control_action());
+  EXPECT_EQ(1U, PublisherOptions{}
+                    .set_maximum_pending_messages(0)
+                    .maximum_pending_messages());
+}
+
+TEST(PublisherOptions, ZeroMessageCount) {
+  auto const options = PublisherOptions{}.set_maximum_batch_message_count(0);
+  EXPECT_EQ(1U, options.maximum_batch_message_count());
+}
+
+TEST(PublisherOptions, ZeroThreadPoolSize) {
+  auto const options = PublisherOptions{}.set_background_thread_pool_size(0);
+  EXPECT_EQ(1U, options.background_thread_pool_size());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+}  // namespace cloud
+}  // namespace google
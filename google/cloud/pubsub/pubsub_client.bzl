@@ -17,18 +17,59 @@
 """Automatically generated source lists for pubsub_client - DO NOT EDIT."""
 
 pubsub_client_hdrs = [
+    "ack_handler.h",
+    "backoff_policy.h",
     "connection_options.h",
     "create_subscription_builder.h",
     "create_topic_builder.h",
+    "idempotency_policy.h",
+    "internal/ack_batcher.h",
+    "internal/ack_id_map.h",
+    "internal/ack_latency_histogram.h",
+    "internal/adaptive_batch_controller.h",
+    "internal/arena_pool.h",
+    "internal/background_threads.h",
+    "internal/batching_publisher.h",
     "internal/build_info.h",
+    "internal/channel_selector.h",
     "internal/compiler_info.h",
+    "internal/connection_ready.h",
+    "internal/duplicate_filter.h",
+    "internal/hedging.h",
+    "internal/lazy_stubs.h",
+    "internal/lease_manager.h",
+    "internal/mpsc_queue.h",
+    "internal/ordered_dispatcher.h",
+    "internal/ordering_key_sequencer.h",
+    "internal/publish_batch.h",
+    "internal/publish_request_encoder.h",
+    "internal/publisher_channel_pool.h",
+    "internal/publisher_flow_control.h",
+    "internal/publisher_retry.h",
     "internal/publisher_stub.h",
+    "internal/pull_pipeline.h",
+    "internal/retry_budget.h",
+    "internal/retry_loop.h",
+    "internal/subscriber_channel_pool.h",
+    "internal/subscriber_counters.h",
+    "internal/subscriber_flow_control.h",
+    "internal/subscriber_retry.h",
     "internal/subscriber_stub.h",
+    "internal/subscription_session.h",
     "internal/user_agent_prefix.h",
+    "internal/work_stealing_executor.h",
+    "message.h",
+    "publisher_capacity.h",
     "publisher_client.h",
     "publisher_connection.h",
+    "publisher_options.h",
+    "received_message.h",
+    "retry_policy.h",
     "subscriber_client.h",
     "subscriber_connection.h",
+    "subscriber_executor.h",
+    "subscriber_options.h",
+    "subscriber_statistics.h",
     "subscription.h",
     "topic.h",
     "version.h",
@@ -36,15 +77,47 @@ pubsub_client_hdrs = [
 ]
 
 pubsub_client_srcs = [
+    "ack_handler.cc",
+    "backoff_policy.cc",
     "connection_options.cc",
+    "idempotency_policy.cc",
+    "internal/ack_batcher.cc",
+    "internal/ack_id_map.cc",
+    "internal/ack_latency_histogram.cc",
+    "internal/adaptive_batch_controller.cc",
+    "internal/arena_pool.cc",
+    "internal/background_threads.cc",
+    "internal/batching_publisher.cc",
+    "internal/channel_selector.cc",
     "internal/compiler_info.cc",
+    "internal/connection_ready.cc",
+    "internal/duplicate_filter.cc",
+    "internal/hedging.cc",
+    "internal/lease_manager.cc",
+    "internal/ordered_dispatcher.cc",
+    "internal/ordering_key_sequencer.cc",
+    "internal/publish_batch.cc",
+    "internal/publish_request_encoder.cc",
+    "internal/publisher_channel_pool.cc",
+    "internal/publisher_flow_control.cc",
+    "internal/publisher_retry.cc",
     "internal/publisher_stub.cc",
+    "internal/pull_pipeline.cc",
+    "internal/retry_budget.cc",
+    "internal/subscriber_channel_pool.cc",
+    "internal/subscriber_flow_control.cc",
+    "internal/subscriber_retry.cc",
     "internal/subscriber_stub.cc",
+    "internal/subscription_session.cc",
     "internal/user_agent_prefix.cc",
+    "internal/work_stealing_executor.cc",
+    "message.cc",
     "publisher_client.cc",
     "publisher_connection.cc",
+    "retry_policy.cc",
     "subscriber_client.cc",
     "subscriber_connection.cc",
+    "subscriber_executor.cc",
     "subscription.cc",
     "topic.cc",
     "version.cc",
@@ -0,0 +1,26 @@
+# Copyright 2020 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# DO NOT EDIT -- GENERATED BY CMake -- Change the CMakeLists.txt file if needed
+
+"""Automatically generated unit tests list - DO NOT EDIT."""
+
+pubsub_client_benchmarks = [
+    "internal/ack_id_map_benchmark.cc",
+    "internal/batching_publisher_benchmark.cc",
+    "internal/ordered_dispatcher_benchmark.cc",
+    "internal/publish_compression_benchmark.cc",
+    "internal/publish_request_encoder_benchmark.cc",
+    "internal/work_stealing_executor_benchmark.cc",
+]
@@ -17,11 +17,46 @@
 """Automatically generated unit tests list - DO NOT EDIT."""
 
 pubsub_client_unit_tests = [
+    "ack_handler_test.cc",
+    "backoff_policy_test.cc",
     "create_subscription_builder_test.cc",
     "create_topic_builder_test.cc",
+    "idempotency_policy_test.cc",
+    "internal/ack_batcher_test.cc",
+    "internal/ack_id_map_test.cc",
+    "internal/ack_latency_histogram_test.cc",
+    "internal/adaptive_batch_controller_test.cc",
+    "internal/arena_pool_test.cc",
+    "internal/background_threads_test.cc",
+    "internal/batching_publisher_test.cc",
     "internal/build_info_test.cc",
+    "internal/channel_selector_test.cc",
     "internal/compiler_info_test.cc",
+    "internal/connection_ready_test.cc",
+    "internal/duplicate_filter_test.cc",
+    "internal/hedging_test.cc",
+    "internal/lazy_stubs_test.cc",
+    "internal/lease_manager_test.cc",
+    "internal/mpsc_queue_test.cc",
+    "internal/ordered_dispatcher_test.cc",
+    "internal/ordering_key_sequencer_test.cc",
+    "internal/publish_request_encoder_test.cc",
+    "internal/publisher_channel_pool_test.cc",
+    "internal/publisher_flow_control_test.cc",
+    "internal/publisher_retry_test.cc",
+    "internal/pull_pipeline_test.cc",
+    "internal/retry_budget_test.cc",
+    "internal/retry_loop_test.cc",
+    "internal/subscriber_channel_pool_test.cc",
+    "internal/subscriber_flow_control_test.cc",
+    "internal/subscriber_retry_test.cc",
+    "internal/subscription_session_test.cc",
     "internal/user_agent_prefix_test.cc",
+    "internal/work_stealing_executor_test.cc",
+    "message_test.cc",
+    "publisher_options_test.cc",
+    "retry_policy_test.cc",
+    "subscriber_options_test.cc",
     "subscription_test.cc",
     "topic_test.cc",
 ]
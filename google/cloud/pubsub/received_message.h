@@ -0,0 +1,57 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_RECEIVED_MESSAGE_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_RECEIVED_MESSAGE_H
+
+#include "google/cloud/pubsub/message.h"
+#include "google/cloud/pubsub/version.h"
+#include <cstdint>
+#include <string>
+
+namespace google {
+namespace cloud {
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * A message received via `SubscriberClient::Pull()`.
+ *
+ * Unlike the messages delivered to `SubscriberClient::Subscribe()` callbacks,
+ * the library does not extend the deadline of these messages. Applications
+ * must acknowledge them, via `SubscriberClient::Acknowledge()`, before the
+ * acknowledgement deadline of the subscription expires, otherwise the service
+ * delivers them again.
+ */
+struct ReceivedMessage {
+  /// The id used to acknowledge the message.
+  std::string ack_id;
+
+  /// The message contents.
+  Message message;
+
+  /**
+   * The approximate number of delivery attempts for this message.
+   *
+   * This is `0` unless the subscription has a dead letter policy.
+   */
+  std::int32_t delivery_attempt = 0;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_RECEIVED_MESSAGE_H
@@ -0,0 +1,69 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/retry_policy.h"
+#include "google/cloud/internal/make_unique.h"
+
+namespace google {
+namespace cloud {
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+bool IsTransientFailure(Status const& status) {
+  switch (status.code()) {
+    case StatusCode::kAborted:
+    case StatusCode::kDeadlineExceeded:
+    case StatusCode::kInternal:
+    case StatusCode::kResourceExhausted:
+    case StatusCode::kUnavailable:
+    case StatusCode::kUnknown:
+      return true;
+    default:
+      return false;
+  }
+}
+
+std::unique_ptr<RetryPolicy> LimitedErrorCountRetryPolicy::clone() const {
+  return google::cloud::internal::make_unique<LimitedErrorCountRetryPolicy>(
+      maximum_failures_);
+}
+
+bool LimitedErrorCountRetryPolicy::OnFailure(Status const& status) {
+  if (!IsTransientFailure(status)) return false;
+  ++failure_count_;
+  return !IsExhausted();
+}
+
+bool LimitedErrorCountRetryPolicy::IsExhausted() const {
+  return failure_count_ > maximum_failures_;
+}
+
+std::unique_ptr<RetryPolicy> LimitedTimeRetryPolicy::clone() const {
+  return google::cloud::internal::make_unique<LimitedTimeRetryPolicy>(
+      maximum_duration_);
+}
+
+bool LimitedTimeRetryPolicy::OnFailure(Status const& status) {
+  if (!IsTransientFailure(status)) return false;
+  return !IsExhausted();
+}
+
+bool LimitedTimeRetryPolicy::IsExhausted() const {
+  return std::chrono::system_clock::now() >= deadline_;
+}
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,106 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_RETRY_POLICY_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_RETRY_POLICY_H
+
+#include "google/cloud/pubsub/version.h"
+#include "google/cloud/status.h"
+#include <chrono>
+#include <memory>
+
+namespace google {
+namespace cloud {
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Control how many times, and for how long, a failed operation is retried.
+ *
+ * Each operation gets its own copy of the policy (see `clone()`), which
+ * counts the failures of that operation only. Only operations that are
+ * idempotent (see `IdempotencyPolicy`) and fail with a transient error (see
+ * `IsTransientFailure()`) are retried.
+ */
+class RetryPolicy {
+ public:
+  virtual ~RetryPolicy() = default;
+
+  /// Return a new copy of this policy, with its initial state.
+  virtual std::unique_ptr<RetryPolicy> clone() const = 0;
+
+  /**
+   * Record a failure, return `true` if the operation can be retried.
+   *
+   * Returns `false` for permanent errors, or if the policy is exhausted.
+   */
+  virtual bool OnFailure(Status const& status) = 0;
+
+  /// Return `true` if the policy does not allow any more retries.
+  virtual bool IsExhausted() const = 0;
+};
+
+/// Return `true` if @p status may succeed if the operation is retried.
+bool IsTransientFailure(Status const& status);
+
+/**
+ * Retry a failed operation up to @p maximum_failures times.
+ *
+ * A value of `0` disables retries.
+ */
+class LimitedErrorCountRetryPolicy : public RetryPolicy {
+ public:
+  explicit LimitedErrorCountRetryPolicy(int maximum_failures)
+      : maximum_failures_(maximum_failures) {}
+
+  std::unique_ptr<RetryPolicy> clone() const override;
+  bool OnFailure(Status const& status) override;
+  bool IsExhausted() const override;
+
+ private:
+  int const maximum_failures_;
+  int failure_count_ = 0;
+};
+
+/**
+ * Retry an operation until @p maximum_duration has elapsed.
+ *
+ * The time is measured from the creation of the policy (or its `clone()`),
+ * that is, from the start of the operation.
+ */
+class LimitedTimeRetryPolicy : public RetryPolicy {
+ public:
+  template <typename Rep, typename Period>
+  explicit LimitedTimeRetryPolicy(
+      std::chrono::duration<Rep, Period> maximum_duration)
+      : maximum_duration_(
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                maximum_duration)),
+        deadline_(std::chrono::system_clock::now() + maximum_duration_) {}
+
+  std::unique_ptr<RetryPolicy> clone() const override;
+  bool OnFailure(Status const& status) override;
+  bool IsExhausted() const override;
+
+ private:
+  std::chrono::milliseconds const maximum_duration_;
+  std::chrono::system_clock::time_point const deadline_;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_RETRY_POLICY_H
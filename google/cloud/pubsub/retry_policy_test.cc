@@ -0,0 +1,78 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/retry_policy.h"
+#include <gmock/gmock.h>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+Status Transient() { return Status(StatusCode::kUnavailable, "try-again"); }
+Status Permanent() { return Status(StatusCode::kNotFound, "not-found"); }
+
+TEST(RetryPolicyTest, IsTransientFailure) {
+  EXPECT_TRUE(IsTransientFailure(Transient()));
+  EXPECT_TRUE(IsTransientFailure(Status(StatusCode::kAborted, "")));
+  EXPECT_TRUE(IsTransientFailure(Status(StatusCode::kDeadlineExceeded, "")));
+  EXPECT_FALSE(IsTransientFailure(Status{}));
+  EXPECT_FALSE(IsTransientFailure(Permanent()));
+  EXPECT_FALSE(IsTransientFailure(Status(StatusCode::kPermissionDenied, "")));
+}
+
+TEST(RetryPolicyTest, LimitedErrorCount) {
+  LimitedErrorCountRetryPolicy policy(2);
+  auto tested = policy.clone();
+  EXPECT_TRUE(tested->OnFailure(Transient()));
+  EXPECT_TRUE(tested->OnFailure(Transient()));
+  EXPECT_FALSE(tested->IsExhausted());
+  EXPECT_FALSE(tested->OnFailure(Transient()));
+  EXPECT_TRUE(tested->IsExhausted());
+
+  // Each clone starts from scratch.
+  auto fresh = tested->clone();
+  EXPECT_FALSE(fresh->IsExhausted());
+  EXPECT_TRUE(fresh->OnFailure(Transient()));
+}
+
+TEST(RetryPolicyTest, LimitedErrorCountPermanent) {
+  LimitedErrorCountRetryPolicy policy(5);
+  EXPECT_FALSE(policy.OnFailure(Permanent()));
+  EXPECT_FALSE(policy.IsExhausted());
+}
+
+TEST(RetryPolicyTest, LimitedErrorCountZero) {
+  LimitedErrorCountRetryPolicy policy(0);
+  EXPECT_FALSE(policy.OnFailure(Transient()));
+}
+
+TEST(RetryPolicyTest, LimitedTime) {
+  LimitedTimeRetryPolicy policy(std::chrono::milliseconds(50));
+  auto tested = policy.clone();
+  EXPECT_TRUE(tested->OnFailure(Transient()));
+  EXPECT_FALSE(tested->OnFailure(Permanent()));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_TRUE(tested->IsExhausted());
+  EXPECT_FALSE(tested->OnFailure(Transient()));
+  EXPECT_FALSE(tested->clone()->IsExhausted());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+}  // namespace cloud
+}  // namespace google
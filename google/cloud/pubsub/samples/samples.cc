@@ -17,6 +17,8 @@
 #include "google/cloud/internal/getenv.h"
 #include "google/cloud/internal/random.h"
 #include "google/cloud/optional.h"
+#include <condition_variable>
+#include <mutex>
 #include <sstream>
 #include <tuple>
 #include <utility>
@@ -106,6 +108,37 @@ void DeleteTopicCommand(std::vector<std::string> const& argv) {
   DeleteTopic(std::move(client), argv[0], argv[1]);
 }
 
+//! [publish]
+void Publish(google::cloud::pubsub::PublisherClient client,
+             std::string project_id, std::string topic_id) {
+  namespace pubsub = google::cloud::pubsub;
+  using google::cloud::future;
+  using google::cloud::StatusOr;
+  pubsub::Topic topic(std::move(project_id), std::move(topic_id));
+  std::vector<future<StatusOr<std::string>>> done;
+  for (int i = 0; i != 10; ++i) {
+    auto message = pubsub::MessageBuilder{}
+                       .SetData("Hello World! [" + std::to_string(i) + "]")
+                       .Build();
+    done.push_back(client.Publish(topic, std::move(message)));
+  }
+  for (auto& f : done) {
+    auto id = f.get();
+    if (!id) throw std::runtime_error(id.status().message());
+    std::cout << "Message published with id=" << *id << "\n";
+  }
+}
+//! [publish]
+
+void PublishCommand(std::vector<std::string> const& argv) {
+  if (argv.size() != 2) {
+    throw std::runtime_error("publish <project-id> <topic-id>");
+  }
+  google::cloud::pubsub::PublisherClient client(
+      google::cloud::pubsub::MakePublisherConnection());
+  Publish(std::move(client), argv[0], argv[1]);
+}
+
 //! [create-subscription]
 void CreateSubscription(google::cloud::pubsub::SubscriberClient client,
                         std::string const& project_id, std::string topic_id,
@@ -179,6 +212,71 @@ void DeleteSubscriptionCommand(std::vector<std::string> const& argv) {
   DeleteSubscription(std::move(client), argv[0], argv[1]);
 }
 
+//! [subscribe]
+void Subscribe(google::cloud::pubsub::SubscriberClient client,
+               std::string project_id, std::string subscription_id) {
+  namespace pubsub = google::cloud::pubsub;
+  std::mutex mu;
+  std::condition_variable cv;
+  int message_count = 0;
+  auto session = client.Subscribe(
+      pubsub::Subscription(std::move(project_id), std::move(subscription_id)),
+      [&](pubsub::Message const& m, pubsub::AckHandler h) {
+        std::cout << "Received message " << m << "\n";
+        std::move(h).ack();
+        std::lock_guard<std::mutex> lk(mu);
+        ++message_count;
+        cv.notify_one();
+      });
+  // Wait until at least one message is received, then stop the session.
+  {
+    std::unique_lock<std::mutex> lk(mu);
+    cv.wait_for(lk, std::chrono::seconds(30),
+                [&message_count] { return message_count > 0; });
+  }
+  session.cancel();
+  auto status = session.get();
+  if (!status.ok()) throw std::runtime_error(status.message());
+}
+//! [subscribe]
+
+void SubscribeCommand(std::vector<std::string> const& argv) {
+  if (argv.size() != 2) {
+    throw std::runtime_error("subscribe <project-id> <subscription-id>");
+  }
+  google::cloud::pubsub::SubscriberClient client(
+      google::cloud::pubsub::MakeSubscriberConnection());
+  Subscribe(std::move(client), argv[0], argv[1]);
+}
+
+//! [pull]
+void Pull(google::cloud::pubsub::SubscriberClient client,
+          std::string project_id, std::string subscription_id) {
+  namespace pubsub = google::cloud::pubsub;
+  pubsub::Subscription subscription(std::move(project_id),
+                                    std::move(subscription_id));
+  auto messages = client.Pull(subscription, /*max_messages=*/100);
+  if (!messages) throw std::runtime_error(messages.status().message());
+
+  std::vector<std::string> ack_ids;
+  for (auto& r : *messages) {
+    std::cout << "Received message " << r.message << "\n";
+    ack_ids.push_back(std::move(r.ack_id));
+  }
+  auto status = client.Acknowledge(std::move(subscription), std::move(ack_ids));
+  if (!status.ok()) throw std::runtime_error(status.message());
+}
+//! [pull]
+
+void PullCommand(std::vector<std::string> const& argv) {
+  if (argv.size() != 2) {
+    throw std::runtime_error("pull <project-id> <subscription-id>");
+  }
+  google::cloud::pubsub::SubscriberClient client(
+      google::cloud::pubsub::MakeSubscriberConnection());
+  Pull(std::move(client), argv[0], argv[1]);
+}
+
 int RunOneCommand(std::vector<std::string> argv) {
   using CommandType = std::function<void(std::vector<std::string> const&)>;
   using CommandMap = std::map<std::string, CommandType>;
@@ -187,9 +285,12 @@ int RunOneCommand(std::vector<std::string> argv) {
       {"create-topic", CreateTopicCommand},
       {"list-topics", ListTopicsCommand},
       {"delete-topic", DeleteTopicCommand},
+      {"publish", PublishCommand},
       {"create-subscription", CreateSubscriptionCommand},
       {"list-subscriptions", ListSubscriptionsCommand},
       {"delete-subscription", DeleteSubscriptionCommand},
+      {"subscribe", SubscribeCommand},
+      {"pull", PullCommand},
   };
 
   static std::string usage_msg = [&argv, &commands] {
@@ -259,6 +360,18 @@ void RunAll() {
   std::cout << "\nRunning list-subscriptions sample\n";
   RunOneCommand({"", "list-subscriptions", project_id});
 
+  std::cout << "\nRunning publish sample\n";
+  RunOneCommand({"", "publish", project_id, topic_id});
+
+  std::cout << "\nRunning subscribe sample\n";
+  RunOneCommand({"", "subscribe", project_id, subscription_id});
+
+  std::cout << "\nRunning publish sample\n";
+  RunOneCommand({"", "publish", project_id, topic_id});
+
+  std::cout << "\nRunning pull sample\n";
+  RunOneCommand({"", "pull", project_id, subscription_id});
+
   std::cout << "\nRunning delete-subscription sample\n";
   RunOneCommand({"", "delete-subscription", project_id, subscription_id});
 
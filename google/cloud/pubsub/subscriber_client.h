@@ -17,6 +17,7 @@
 
 #include "google/cloud/pubsub/create_subscription_builder.h"
 #include "google/cloud/pubsub/subscriber_connection.h"
+#include <chrono>
 #include <memory>
 
 namespace google {
@@ -71,7 +72,8 @@ class SubscriberClient {
    * Create a new subscription in Cloud Pub/Sub.
    *
    * @par Idempotency
-   * This is not an idempotent operation and therefore it is never retried.
+   * This is not an idempotent operation and therefore it is not retried, unless
+   * the application changes the `SubscriberOptions::idempotency_policy()`.
    *
    * @par Example
    * @snippet samples.cc create-subscription
@@ -101,7 +103,8 @@ class SubscriberClient {
    * Delete an existing subscription in Cloud Pub/Sub.
    *
    * @par Idempotency
-   * This is not an idempotent operation and therefore it is never retried.
+   * This is not an idempotent operation and therefore it is not retried, unless
+   * the application changes the `SubscriberOptions::idempotency_policy()`.
    *
    * @par Example
    * @snippet samples.cc delete-subscription
@@ -112,6 +115,128 @@ class SubscriberClient {
     return connection_->DeleteSubscription({std::move(subscription)});
   }
 
+  /**
+   * Receive messages from a subscription, calling @p callback for each one.
+   *
+   * This function opens a `StreamingPull` stream and returns immediately. The
+   * messages are delivered to @p callback in a pool of background threads
+   * owned by the connection, the callbacks may run concurrently. Use
+   * `SubscriberOptions::set_background_thread_pool_size()` to configure the
+   * size of the pool.
+   *
+   * The returned future is satisfied when the session ends. To stop receiving
+   * messages call `cancel()` on the future, the future is then satisfied with
+   * an OK status. The session also ends if the stream fails with a permanent
+   * error, transient errors are retried by opening a new stream.
+   *
+   * @par Idempotency
+   * Receiving messages is always treated as idempotent, the service
+   * redelivers any messages that are not acknowledged.
+   *
+   * @par Example
+   * @snippet samples.cc subscribe
+   *
+   * @param subscription the subscription to receive messages from.
+   * @param callback called once for each message, the callback must use the
+   *     `AckHandler` to acknowledge or reject the message.
+   */
+  future<Status> Subscribe(Subscription subscription,
+                           SubscriberCallback callback) {
+    return connection_->Subscribe(
+        {std::move(subscription), std::move(callback)});
+  }
+
+  /**
+   * Receive up to @p max_messages from a subscription.
+   *
+   * This function blocks until the service returns a batch of messages, the
+   * batch may contain fewer messages than requested. Use `Acknowledge()` to
+   * acknowledge the messages, in bulk, once they are processed. Messages that
+   * are not acknowledged before their deadline are delivered again.
+   *
+   * The connection can prefetch the next batches while the application
+   * processes the current one, see
+   * `SubscriberOptions::set_pull_pipeline_depth()`. This favors throughput,
+   * applications that need low latency for each message should prefer
+   * `Subscribe()`.
+   *
+   * @par Idempotency
+   * Receiving messages is always treated as idempotent, the service
+   * redelivers any messages that are not acknowledged.
+   *
+   * @par Example
+   * @snippet samples.cc pull
+   *
+   * @param subscription the subscription to receive messages from.
+   * @param max_messages the maximum number of messages in the batch.
+   */
+  StatusOr<std::vector<ReceivedMessage>> Pull(Subscription subscription,
+                                              std::int32_t max_messages) {
+    return connection_->Pull({std::move(subscription), max_messages});
+  }
+
+  /**
+   * Acknowledge messages received via `Pull()`.
+   *
+   * Large sets of ids are split into several requests, sent concurrently. The
+   * function returns after all the requests complete, with the first error,
+   * if any.
+   *
+   * @par Idempotency
+   * Acknowledging a message more than once has no effect, this operation is
+   * always treated as idempotent.
+   *
+   * @par Example
+   * @snippet samples.cc pull
+   *
+   * @param subscription the subscription the messages were received from.
+   * @param ack_ids the `ReceivedMessage::ack_id` of each message.
+   */
+  Status Acknowledge(Subscription subscription,
+                     std::vector<std::string> ack_ids) {
+    return connection_->Acknowledge(
+        {std::move(subscription), std::move(ack_ids)});
+  }
+
+  /**
+   * Return the counters for all the `Subscribe()` sessions in the connection.
+   *
+   * Applications can use this function to export the subscriber behavior as
+   * metrics, for example, the average size of the acknowledgement batches.
+   *
+   * @see `SubscriberOptions::set_maximum_ack_batch_count()`
+   */
+  SubscriberStatistics Statistics() { return connection_->Statistics(); }
+
+  /**
+   * Connect all the channels in the connection pool, in parallel.
+   *
+   * The connection creates its channels on first use, so the first requests
+   * on each channel pay for the DNS resolution and the TLS handshake.
+   * Applications that need to serve traffic as soon as they start can call
+   * this function to create and connect all the channels upfront. It blocks
+   * until all the channels are ready, or until @p deadline.
+   *
+   * @return an error with `StatusCode::kDeadlineExceeded` if some channel is
+   *     not ready before @p deadline. The channels keep connecting in the
+   *     background, the application may use the client regardless.
+   *
+   * @see `ConnectionOptions::set_num_channels()`
+   */
+  Status Connect(std::chrono::system_clock::time_point deadline) {
+    return connection_->Connect({deadline});
+  }
+
+  /**
+   * Connect all the channels in the connection pool, waiting up to
+   * @p timeout.
+   *
+   * @see `SubscriberClient::Connect()`
+   */
+  Status WarmUp(std::chrono::milliseconds timeout = std::chrono::seconds(10)) {
+    return Connect(std::chrono::system_clock::now() + timeout);
+  }
+
  private:
   std::shared_ptr<SubscriberConnection> connection_;
 };
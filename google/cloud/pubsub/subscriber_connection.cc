@@ -13,8 +13,21 @@
 // limitations under the License.
 
 #include "google/cloud/pubsub/subscriber_connection.h"
+#include "google/cloud/pubsub/internal/background_threads.h"
+#include "google/cloud/pubsub/internal/pull_pipeline.h"
+#include "google/cloud/pubsub/internal/subscriber_counters.h"
+#include "google/cloud/pubsub/internal/subscriber_channel_pool.h"
+#include "google/cloud/pubsub/internal/subscriber_retry.h"
 #include "google/cloud/pubsub/internal/subscriber_stub.h"
+#include "google/cloud/pubsub/internal/subscription_session.h"
+#include "google/cloud/pubsub/subscriber_executor.h"
+#include "google/cloud/internal/make_unique.h"
+#include <algorithm>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 namespace google {
 namespace cloud {
@@ -22,13 +35,37 @@ namespace pubsub {
 inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
 
 namespace {
+// The callbacks run in the executor, the completion queue threads only run
+// timers and unary RPCs.
+std::size_t constexpr kCompletionQueueThreads = 2;
+
+// The service rejects `Acknowledge` requests larger than 512KiB, with ack ids
+// of up to ~200 bytes this keeps the requests well below that limit.
+std::size_t constexpr kMaximumAckIdsPerRequest = 2500;
+
 class SubscriberConnectionImpl : public SubscriberConnection {
  public:
-  explicit SubscriberConnectionImpl(
-      std::shared_ptr<pubsub_internal::SubscriberStub> stub)
-      : stub_(std::move(stub)) {}
+  SubscriberConnectionImpl(
+      std::shared_ptr<pubsub_internal::SubscriberChannelPool> pool,
+      SubscriberOptions subscriber_options)
+      : pool_(std::move(pool)),
+        stub_(std::make_shared<pubsub_internal::SubscriberRetry>(
+            pool_, pubsub_internal::MakeRetryPolicies(subscriber_options))),
+        subscriber_options_(std::move(subscriber_options)),
+        counters_(std::make_shared<pubsub_internal::SubscriberCounters>()) {}
 
-  ~SubscriberConnectionImpl() override = default;
+  ~SubscriberConnectionImpl() override {
+    // Stop any active sessions before the background threads stop.
+    std::vector<std::shared_ptr<pubsub_internal::SubscriptionSession>> active;
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      for (auto const& w : sessions_) {
+        if (auto s = w.lock()) active.push_back(std::move(s));
+      }
+    }
+    for (auto const& s : active) s->Cancel();
+    for (auto const& s : active) s->WaitForShutdown();
+  }
 
   StatusOr<google::pubsub::v1::Subscription> CreateSubscription(
       CreateSubscriptionParams p) override {
@@ -40,12 +77,26 @@ class SubscriberConnectionImpl : public SubscriberConnection {
     google::pubsub::v1::ListSubscriptionsRequest request;
     request.set_project(std::move(p.project_id));
     auto& stub = stub_;
-    return ListSubscriptionsRange(
-        std::move(request),
-        [stub](google::pubsub::v1::ListSubscriptionsRequest const& request) {
+    // Hedging needs timers, only then use the background threads.
+    std::function<StatusOr<google::pubsub::v1::ListSubscriptionsResponse>(
+        google::pubsub::v1::ListSubscriptionsRequest const&)>
+        list = [stub](google::pubsub::v1::ListSubscriptionsRequest const& r) {
           grpc::ClientContext context;
-          return stub->ListSubscriptions(context, request);
-        },
+          return stub->ListSubscriptions(context, r);
+        };
+    if (subscriber_options_.hedging()) {
+      auto cq = background().cq();
+      list = [stub, cq](google::pubsub::v1::ListSubscriptionsRequest const&
+                            request) mutable {
+        return stub
+            ->AsyncListSubscriptions(
+                cq, google::cloud::internal::make_unique<grpc::ClientContext>(),
+                request)
+            .get();
+      };
+    }
+    return ListSubscriptionsRange(
+        std::move(request), std::move(list),
         [](google::pubsub::v1::ListSubscriptionsResponse response) {
           std::vector<google::pubsub::v1::Subscription> items;
           items.reserve(response.subscriptions_size());
@@ -63,18 +114,123 @@ class SubscriberConnectionImpl : public SubscriberConnection {
     return stub_->DeleteSubscription(context, request);
   }
 
+  future<Status> Subscribe(SubscribeParams p) override {
+    auto& b = background();
+    auto session = std::make_shared<pubsub_internal::SubscriptionSession>(
+        Stubs(), b.cq(), executor_, p.subscription.FullName(),
+        std::move(p.callback), subscriber_options_, counters_);
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      // Forget any sessions that already ended.
+      sessions_.erase(
+          std::remove_if(sessions_.begin(), sessions_.end(),
+                         [](std::weak_ptr<pubsub_internal::SubscriptionSession>
+                                const& w) { return w.expired(); }),
+          sessions_.end());
+      sessions_.push_back(session);
+    }
+    return session->Start();
+  }
+
+  StatusOr<std::vector<ReceivedMessage>> Pull(PullParams p) override {
+    auto response = pipeline(p.subscription).Pull(p.max_messages);
+    if (!response) return std::move(response).status();
+    return pubsub_internal::ToReceivedMessages(*std::move(response));
+  }
+
+  Status Acknowledge(AcknowledgeParams p) override {
+    return pubsub_internal::BulkAcknowledge(
+        Stubs(), background().cq(), p.subscription.FullName(),
+        std::move(p.ack_ids), kMaximumAckIdsPerRequest);
+  }
+
+  SubscriberStatistics Statistics() override {
+    auto statistics = counters_->Snapshot();
+    statistics.channel_rpcs_in_flight = pool_->in_flight();
+    std::lock_guard<std::mutex> lk(mu_);
+    for (auto const& w : sessions_) {
+      if (auto s = w.lock()) {
+        statistics.duplicate_filter_bytes += s->duplicate_filter_memory_usage();
+      }
+    }
+    return statistics;
+  }
+
+  Status Connect(ConnectParams p) override {
+    // The channels connect in parallel, in the background threads.
+    auto cq = background().cq();
+    return pool_->AsyncWaitForConnected(cq, p.deadline).get();
+  }
+
  private:
+  // Applications that only use the administrative operations never need the
+  // background threads, or the executor to run the callbacks, create them on
+  // demand.
+  pubsub_internal::BackgroundThreads& background() {
+    std::call_once(background_once_, [this] {
+      background_ = google::cloud::internal::make_unique<
+          pubsub_internal::BackgroundThreads>(kCompletionQueueThreads);
+      executor_ = subscriber_options_.executor();
+      if (!executor_) {
+        executor_ = MakeWorkStealingExecutor(
+            subscriber_options_.background_thread_pool_size());
+      }
+    });
+    return *background_;
+  }
+
+  // The sessions and pipelines accept several stubs, the pool already spreads
+  // the calls over its channels.
+  std::vector<std::shared_ptr<pubsub_internal::SubscriberStub>> Stubs() const {
+    return {stub_};
+  }
+
+  pubsub_internal::PullPipeline& pipeline(Subscription const& subscription) {
+    auto& b = background();
+    auto name = subscription.FullName();
+    std::lock_guard<std::mutex> lk(mu_);
+    auto i = pipelines_.find(name);
+    if (i == pipelines_.end()) {
+      auto p = std::make_shared<pubsub_internal::PullPipeline>(
+          Stubs(), b.cq(), name, subscriber_options_.pull_pipeline_depth());
+      i = pipelines_.emplace(std::move(name), std::move(p)).first;
+    }
+    return *i->second;
+  }
+
+  // Spreads the calls, including each stream, over the channels in the pool.
+  std::shared_ptr<pubsub_internal::SubscriberChannelPool> pool_;
+  // Retries the unary calls, and forwards the streams to `pool_`.
   std::shared_ptr<pubsub_internal::SubscriberStub> stub_;
+  SubscriberOptions const subscriber_options_;
+  std::shared_ptr<pubsub_internal::SubscriberCounters> counters_;
+  std::once_flag background_once_;
+  std::unique_ptr<pubsub_internal::BackgroundThreads> background_;
+  // Destroyed before `background_`, any pending callbacks run while the
+  // completion queue is still usable.
+  std::shared_ptr<SubscriberExecutor> executor_;
+  std::mutex mu_;
+  std::vector<std::weak_ptr<pubsub_internal::SubscriptionSession>> sessions_;
+  // The prefetched batches, if any, are discarded when the connection is
+  // destroyed, the service delivers those messages again.
+  std::unordered_map<std::string,
+                     std::shared_ptr<pubsub_internal::PullPipeline>>
+      pipelines_;
 };
 }  // namespace
 
 SubscriberConnection::~SubscriberConnection() = default;
 
 std::shared_ptr<SubscriberConnection> MakeSubscriberConnection(
-    ConnectionOptions const& options) {
-  auto stub =
-      pubsub_internal::CreateDefaultSubscriberStub(options, /*channel_id=*/0);
-  return std::make_shared<SubscriberConnectionImpl>(std::move(stub));
+    ConnectionOptions const& options, SubscriberOptions subscriber_options) {
+  std::shared_ptr<pubsub_internal::HedgeDelay> list_hedge_delay;
+  if (subscriber_options.hedging()) {
+    list_hedge_delay = std::make_shared<pubsub_internal::HedgeDelay>();
+  }
+  auto stub = pubsub_internal::CreateDefaultSubscriberStubPool(
+      options, std::move(list_hedge_delay));
+  return std::make_shared<SubscriberConnectionImpl>(
+      std::move(stub), std::move(subscriber_options));
 }
 
 }  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
@@ -15,12 +15,21 @@
 #ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_SUBSCRIBER_CONNECTION_H
 #define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_SUBSCRIBER_CONNECTION_H
 
+#include "google/cloud/pubsub/ack_handler.h"
 #include "google/cloud/pubsub/connection_options.h"
+#include "google/cloud/pubsub/message.h"
+#include "google/cloud/pubsub/received_message.h"
+#include "google/cloud/pubsub/subscriber_options.h"
+#include "google/cloud/pubsub/subscriber_statistics.h"
 #include "google/cloud/pubsub/subscription.h"
+#include "google/cloud/future.h"
 #include "google/cloud/internal/pagination_range.h"
 #include "google/cloud/status_or.h"
 #include <google/pubsub/v1/pubsub.pb.h>
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <vector>
 
 namespace google {
 namespace cloud {
@@ -41,6 +50,15 @@ using ListSubscriptionsRange = google::cloud::internal::PaginationRange<
     google::pubsub::v1::ListSubscriptionsRequest,
     google::pubsub::v1::ListSubscriptionsResponse>;
 
+/**
+ * The application callback invoked for each message received via
+ * `SubscriberClient::Subscribe()`.
+ *
+ * The callback should use the `AckHandler` to acknowledge (or reject) the
+ * message, possibly after the callback returns.
+ */
+using SubscriberCallback = std::function<void(Message, AckHandler)>;
+
 /**
  * A connection to Cloud Pub/Sub for subscriber operations.
  *
@@ -81,6 +99,29 @@ class SubscriberConnection {
   struct DeleteSubscriptionParams {
     Subscription subscription;
   };
+
+  /// Wrap the arguments for `Subscribe()`
+  struct SubscribeParams {
+    Subscription subscription;
+    SubscriberCallback callback;
+  };
+
+  /// Wrap the arguments for `Pull()`
+  struct PullParams {
+    Subscription subscription;
+    std::int32_t max_messages;
+  };
+
+  /// Wrap the arguments for `Acknowledge()`
+  struct AcknowledgeParams {
+    Subscription subscription;
+    std::vector<std::string> ack_ids;
+  };
+
+  /// Wrap the arguments for `Connect()`
+  struct ConnectParams {
+    std::chrono::system_clock::time_point deadline;
+  };
   //@}
 
   /// Defines the interface for `Client::CreateSubscription()`
@@ -92,6 +133,21 @@ class SubscriberConnection {
 
   /// Defines the interface for `Client::DeleteSubscription()`
   virtual Status DeleteSubscription(DeleteSubscriptionParams) = 0;
+
+  /// Defines the interface for `Client::Subscribe()`
+  virtual future<Status> Subscribe(SubscribeParams) = 0;
+
+  /// Defines the interface for `Client::Pull()`
+  virtual StatusOr<std::vector<ReceivedMessage>> Pull(PullParams) = 0;
+
+  /// Defines the interface for `Client::Acknowledge()`
+  virtual Status Acknowledge(AcknowledgeParams) = 0;
+
+  /// Defines the interface for `Client::Statistics()`
+  virtual SubscriberStatistics Statistics() = 0;
+
+  /// Defines the interface for `Client::Connect()`
+  virtual Status Connect(ConnectParams) = 0;
 };
 
 /**
@@ -106,9 +162,13 @@ class SubscriberConnection {
  *
  * @param options (optional) configure the `SubscriberConnection` created by
  *     this function.
+ * @param subscriber_options (optional) configure how `Subscribe()` receives
+ *     messages, and the number of background threads used to run the
+ *     application callbacks.
  */
 std::shared_ptr<SubscriberConnection> MakeSubscriberConnection(
-    ConnectionOptions const& options = ConnectionOptions());
+    ConnectionOptions const& options = ConnectionOptions(),
+    SubscriberOptions subscriber_options = SubscriberOptions());
 
 }  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
 }  // namespace pubsub
@@ -0,0 +1,72 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_SUBSCRIBER_EXECUTOR_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_SUBSCRIBER_EXECUTOR_H
+
+#include "google/cloud/pubsub/version.h"
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace google {
+namespace cloud {
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Runs the application callbacks for `SubscriberClient::Subscribe()`.
+ *
+ * The library calls `Run()` once for each message received, the task invokes
+ * the application callback. By default the callbacks run in a work-stealing
+ * thread pool owned by the connection, see `MakeWorkStealingExecutor()`.
+ * Applications can provide their own implementation via
+ * `SubscriberOptions::set_executor()`, for example, to run the callbacks in a
+ * thread pool shared with other parts of the application.
+ *
+ * Implementations must be thread-safe, `Run()` is called from several
+ * threads. `Run()` should not block, the library calls it from the thread
+ * reading the `StreamingPull` stream. Tasks destroyed without running reject
+ * their message, which the service then delivers again.
+ */
+class SubscriberExecutor {
+ public:
+  virtual ~SubscriberExecutor() = default;
+
+  /// Schedule @p task to run, usually in a different thread.
+  virtual void Run(std::function<void()> task) = 0;
+};
+
+/**
+ * Create a work-stealing executor with @p thread_count threads.
+ *
+ * Each thread has its own queue of tasks. Tasks scheduled from outside the
+ * pool are distributed across the queues, tasks scheduled from a pool thread
+ * go to the queue of that thread. Idle threads take work from the queues of
+ * busy threads. Unlike a single shared queue, scheduling a task only contends
+ * with the thread that owns the queue (or a thread stealing from it), which
+ * matters when the callbacks are short.
+ *
+ * The destructor runs any pending tasks before it returns. A @p thread_count
+ * of `0` is treated as `1`.
+ */
+std::shared_ptr<SubscriberExecutor> MakeWorkStealingExecutor(
+    std::size_t thread_count);
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_SUBSCRIBER_EXECUTOR_H
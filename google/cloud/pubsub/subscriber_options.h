@@ -0,0 +1,434 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_SUBSCRIBER_OPTIONS_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_SUBSCRIBER_OPTIONS_H
+
+#include "google/cloud/pubsub/backoff_policy.h"
+#include "google/cloud/pubsub/idempotency_policy.h"
+#include "google/cloud/pubsub/retry_policy.h"
+#include "google/cloud/pubsub/subscriber_executor.h"
+#include "google/cloud/pubsub/version.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * Configure the behavior of `SubscriberClient::Subscribe()`.
+ *
+ * Each call to `Subscribe()` opens `concurrent_streams()` `StreamingPull`
+ * streams to receive messages. The streams use different channels (up to
+ * `ConnectionOptions::num_channels()`), so a single high-volume subscription
+ * can use more than one TCP connection, and more than one partition in the
+ * service. The application callbacks run in the `executor()`, shared by all
+ * the subscriptions using the same connection. If the application does not
+ * provide an executor the connection creates a work-stealing pool with
+ * `background_thread_pool_size()` threads, see `MakeWorkStealingExecutor()`.
+ *
+ * The `stream_ack_deadline()` is the initial deadline for messages received
+ * via the stream. Messages that are not acknowledged (or rejected) before
+ * their deadline expires are delivered again.
+ *
+ * The library extends the deadline of the messages while the application
+ * processes them. The extension is the 99th percentile of the time taken to
+ * acknowledge recent messages, bounded by the service limits (10 to 600
+ * seconds). The deadline is not extended beyond `max_deadline_time()` since
+ * the message was received.
+ *
+ * The acknowledgements, rejections, and deadline extensions are sent in
+ * batches. A batch is sent when it contains `maximum_ack_batch_count()` items,
+ * or `maximum_ack_hold_time()` after its first item, whichever happens first.
+ * The batches are sent over the `StreamingPull` stream, or using unary RPCs if
+ * the stream is not available.
+ *
+ * Each session limits the number of outstanding messages, that is, messages
+ * delivered to the application that are not yet acknowledged or rejected. The
+ * limits are sent to the service as the flow control settings of the stream,
+ * and the session stops reading from the stream while the limits are
+ * exceeded. This keeps the memory usage bounded even if the subscription has
+ * a large backlog.
+ *
+ * Subscriptions created with message ordering enabled should also use
+ * `enable_message_ordering()`. With message ordering enabled the callbacks
+ * for messages with the same ordering key run one at a time, and in order:
+ * the callback for a message starts only after the previous message with the
+ * same key is acknowledged or rejected. Messages with different ordering keys
+ * still run in parallel.
+ *
+ * Cloud Pub/Sub delivers messages at least once. Applications where processing
+ * a duplicate is expensive can enable a duplicate filter, see
+ * `set_duplicate_filter_size()`. The filter remembers the ids of recently
+ * acknowledged messages, and acknowledges any redelivery of those messages
+ * without calling the application callback. This does not eliminate
+ * duplicates: a redelivery can still arrive before the first delivery is
+ * acknowledged, or after it is evicted from the filter.
+ *
+ * With `enable_hedging()` a slow `SubscriberClient::ListSubscriptions()` page
+ * is requested again on a different channel, see `hedging()`.
+ */
+class SubscriberOptions {
+ public:
+  SubscriberOptions() = default;
+
+  /// The acknowledgement deadline for messages received via the stream.
+  std::chrono::seconds stream_ack_deadline() const {
+    return stream_ack_deadline_;
+  }
+
+  /**
+   * Set the acknowledgement deadline for messages received via the stream.
+   *
+   * The service requires values between 10 and 600 seconds, the value is
+   * clamped to that range.
+   */
+  template <typename Rep, typename Period>
+  SubscriberOptions& set_stream_ack_deadline(
+      std::chrono::duration<Rep, Period> v) {
+    auto const s = std::chrono::duration_cast<std::chrono::seconds>(v);
+    auto const minimum = std::chrono::seconds(10);
+    auto const maximum = std::chrono::seconds(600);
+    stream_ack_deadline_ = (std::max)(minimum, (std::min)(maximum, s));
+    return *this;
+  }
+
+  /// The maximum time the deadline of a message is extended.
+  std::chrono::seconds max_deadline_time() const { return max_deadline_time_; }
+
+  /**
+   * Set the maximum time the deadline of a message is extended.
+   *
+   * If the application does not acknowledge (or reject) the message within
+   * this time the service delivers it again.
+   */
+  template <typename Rep, typename Period>
+  SubscriberOptions& set_max_deadline_time(
+      std::chrono::duration<Rep, Period> v) {
+    max_deadline_time_ = std::chrono::duration_cast<std::chrono::seconds>(v);
+    return *this;
+  }
+
+  /// The maximum number of items in an acknowledgement batch.
+  std::size_t maximum_ack_batch_count() const {
+    return maximum_ack_batch_count_;
+  }
+
+  /**
+   * Set the maximum number of items in an acknowledgement batch.
+   *
+   * The value is clamped to the [1, 2500] range, larger batches can exceed the
+   * maximum request size in the service.
+   */
+  SubscriberOptions& set_maximum_ack_batch_count(std::size_t v) {
+    maximum_ack_batch_count_ =
+        (std::max)(std::size_t{1}, (std::min)(std::size_t{2500}, v));
+    return *this;
+  }
+
+  /// The maximum time an acknowledgement is held before its batch is sent.
+  std::chrono::microseconds maximum_ack_hold_time() const {
+    return maximum_ack_hold_time_;
+  }
+
+  /// Set the maximum time an acknowledgement is held before it is sent.
+  template <typename Rep, typename Period>
+  SubscriberOptions& set_maximum_ack_hold_time(
+      std::chrono::duration<Rep, Period> v) {
+    maximum_ack_hold_time_ =
+        std::chrono::duration_cast<std::chrono::microseconds>(v);
+    return *this;
+  }
+
+  /// The maximum number of outstanding messages in each session.
+  std::size_t maximum_outstanding_messages() const {
+    return maximum_outstanding_messages_;
+  }
+
+  /// Set the maximum number of outstanding messages, `0` is treated as `1`.
+  SubscriberOptions& set_maximum_outstanding_messages(std::size_t v) {
+    maximum_outstanding_messages_ = v == 0 ? 1 : v;
+    return *this;
+  }
+
+  /// The maximum size, in bytes, of the outstanding messages in each session.
+  std::size_t maximum_outstanding_bytes() const {
+    return maximum_outstanding_bytes_;
+  }
+
+  /// Set the maximum size, in bytes, of the outstanding messages.
+  SubscriberOptions& set_maximum_outstanding_bytes(std::size_t v) {
+    maximum_outstanding_bytes_ = v;
+    return *this;
+  }
+
+  /// The number of `StreamingPull` streams opened by each `Subscribe()` call.
+  std::size_t concurrent_streams() const { return concurrent_streams_; }
+
+  /**
+   * Set the number of `StreamingPull` streams for each subscription.
+   *
+   * More streams can increase the throughput for high-volume subscriptions.
+   * The flow control limits apply to all the streams in a session, each stream
+   * requests a proportional share from the service. A value of `0` is treated
+   * as `1`.
+   */
+  SubscriberOptions& set_concurrent_streams(std::size_t v) {
+    concurrent_streams_ = v == 0 ? 1 : v;
+    return *this;
+  }
+
+  /// The number of `Pull` RPCs prefetched by `SubscriberClient::Pull()`.
+  std::size_t pull_pipeline_depth() const { return pull_pipeline_depth_; }
+
+  /**
+   * Set the number of `Pull` RPCs prefetched by `SubscriberClient::Pull()`.
+   *
+   * With a depth of `N` each call to `Pull()` returns a batch that is already
+   * in flight, and starts new RPCs to keep `N` batches in flight. This hides
+   * the round-trip latency while the application processes a batch.
+   *
+   * The prefetched messages are not leased: their acknowledgement deadline
+   * runs while they wait for the next `Pull()` call. Only enable prefetching
+   * if the application processes each batch well within the acknowledgement
+   * deadline of the subscription, otherwise the prefetched messages are
+   * delivered again. The default is `0`, prefetching is disabled.
+   */
+  SubscriberOptions& set_pull_pipeline_depth(std::size_t v) {
+    pull_pipeline_depth_ = v;
+    return *this;
+  }
+
+  /// The maximum number of message ids in the duplicate filter, `0` if off.
+  std::size_t duplicate_filter_size() const { return duplicate_filter_size_; }
+
+  /**
+   * Set the maximum number of message ids in the duplicate filter.
+   *
+   * Each session remembers the ids of up to @p v acknowledged messages, for
+   * `duplicate_filter_window()`. Use `0` (the default) to disable the filter.
+   * Each id uses about 150 bytes, see `SubscriberStatistics` for the hit rate
+   * and the memory used by the filters.
+   */
+  SubscriberOptions& set_duplicate_filter_size(std::size_t v) {
+    duplicate_filter_size_ = v;
+    return *this;
+  }
+
+  /// How long the duplicate filter remembers an acknowledged message.
+  std::chrono::seconds duplicate_filter_window() const {
+    return duplicate_filter_window_;
+  }
+
+  /// Set how long the duplicate filter remembers an acknowledged message.
+  template <typename Rep, typename Period>
+  SubscriberOptions& set_duplicate_filter_window(
+      std::chrono::duration<Rep, Period> v) {
+    duplicate_filter_window_ =
+        std::chrono::duration_cast<std::chrono::seconds>(v);
+    return *this;
+  }
+
+  /// If true, messages with the same ordering key are delivered in order.
+  bool message_ordering() const { return message_ordering_; }
+
+  /**
+   * Deliver messages with the same ordering key one at a time, in order.
+   *
+   * The application must acknowledge (or reject) each message to receive the
+   * next message with the same ordering key.
+   */
+  SubscriberOptions& enable_message_ordering() {
+    message_ordering_ = true;
+    return *this;
+  }
+
+  /// Disable message ordering, all messages are delivered in parallel.
+  SubscriberOptions& disable_message_ordering() {
+    message_ordering_ = false;
+    return *this;
+  }
+
+  /// The number of threads in the default executor.
+  std::size_t background_thread_pool_size() const {
+    return background_thread_pool_size_;
+  }
+
+  /**
+   * Set the number of threads in the default executor, `0` is treated as `1`.
+   *
+   * This option is ignored if the application provides an executor.
+   */
+  SubscriberOptions& set_background_thread_pool_size(std::size_t v) {
+    background_thread_pool_size_ = v == 0 ? 1 : v;
+    return *this;
+  }
+
+  /// The executor used to run the callbacks, `nullptr` for the default.
+  std::shared_ptr<SubscriberExecutor> executor() const { return executor_; }
+
+  /**
+   * Run the application callbacks in @p v.
+   *
+   * The connection keeps a reference to the executor, and all the sessions
+   * created by the connection share it. Pass `nullptr` to use the default
+   * work-stealing pool.
+   */
+  SubscriberOptions& set_executor(std::shared_ptr<SubscriberExecutor> v) {
+    executor_ = std::move(v);
+    return *this;
+  }
+
+  /// The policy controlling how long failed operations are retried.
+  std::shared_ptr<RetryPolicy const> retry_policy() const {
+    return retry_policy_;
+  }
+
+  /**
+   * Set the policy controlling how long failed operations are retried.
+   *
+   * The connection keeps a copy of @p v, and uses a fresh `clone()` of it for
+   * each operation. The default retries transient failures for up to 60
+   * seconds.
+   */
+  SubscriberOptions& set_retry_policy(RetryPolicy const& v) {
+    retry_policy_ = v.clone();
+    return *this;
+  }
+
+  /// The policy controlling the delay between retries.
+  std::shared_ptr<BackoffPolicy const> backoff_policy() const {
+    return backoff_policy_;
+  }
+
+  /**
+   * Set the policy controlling the delay between retries.
+   *
+   * The default is a truncated exponential backoff with jitter, starting at
+   * 100 milliseconds and growing up to 10 seconds.
+   */
+  SubscriberOptions& set_backoff_policy(BackoffPolicy const& v) {
+    backoff_policy_ = v.clone();
+    return *this;
+  }
+
+  /// The policy controlling which operations are retried.
+  std::shared_ptr<IdempotencyPolicy const> idempotency_policy() const {
+    return idempotency_policy_;
+  }
+
+  /**
+   * Set the policy controlling which operations are retried.
+   *
+   * The default, `DefaultIdempotencyPolicy`, retries the acknowledgements, the
+   * deadline changes, and `Pull()`, but not `CreateSubscription()` and
+   * `DeleteSubscription()`.
+   */
+  SubscriberOptions& set_idempotency_policy(IdempotencyPolicy const& v) {
+    idempotency_policy_ = v.clone();
+    return *this;
+  }
+
+  /// The maximum number of tokens in the retry budget.
+  double retry_budget_max_tokens() const { return retry_budget_max_tokens_; }
+
+  /// The tokens added to the retry budget by each successful attempt.
+  double retry_budget_token_ratio() const { return retry_budget_token_ratio_; }
+
+  /**
+   * Limit the retries when most attempts fail.
+   *
+   * All the operations in a connection share a bucket of up to
+   * @p max_tokens tokens. Each attempt failing with a transient error removes
+   * one token, each successful attempt adds @p token_ratio tokens, and the
+   * operations are only retried while the bucket is more than half full. That
+   * is, once the ratio of failed to successful attempts exceeds
+   * @p token_ratio the connection stops retrying, instead of adding load to
+   * an already overloaded service. Use `0` @p max_tokens to disable the
+   * budget.
+   */
+  SubscriberOptions& set_retry_budget(double max_tokens, double token_ratio) {
+    retry_budget_max_tokens_ = max_tokens;
+    retry_budget_token_ratio_ = token_ratio;
+    return *this;
+  }
+
+  /// If true, slow `ListSubscriptions()` pages are hedged.
+  bool hedging() const { return hedging_; }
+
+  /**
+   * Hedge the `ListSubscriptions()` calls.
+   *
+   * A page that takes longer than the 95th percentile of the recent pages is
+   * requested again on a different channel, and the first response is used.
+   * The delay adapts to the observed latency, so this sends about 5% more
+   * calls. Hedging starts after a few pages complete, and has no effect with a
+   * single channel, see `ConnectionOptions::set_num_channels()`. The hedge
+   * timers run in the background threads.
+   */
+  SubscriberOptions& enable_hedging() {
+    hedging_ = true;
+    return *this;
+  }
+
+  /// Send each `ListSubscriptions()` call once.
+  SubscriberOptions& disable_hedging() {
+    hedging_ = false;
+    return *this;
+  }
+
+ private:
+  static std::size_t DefaultThreadPoolSize() {
+    // hardware_concurrency() may return 0 if the value is not computable.
+    auto const n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+  }
+
+  std::chrono::seconds stream_ack_deadline_ = std::chrono::seconds(10);
+  std::chrono::seconds max_deadline_time_ = std::chrono::minutes(60);
+  std::size_t maximum_outstanding_messages_ = 1000;
+  std::size_t maximum_outstanding_bytes_ = 100 * 1024 * 1024L;
+  std::size_t maximum_ack_batch_count_ = 1000;
+  std::size_t concurrent_streams_ = 1;
+  std::size_t pull_pipeline_depth_ = 0;
+  bool message_ordering_ = false;
+  std::size_t duplicate_filter_size_ = 0;
+  std::chrono::seconds duplicate_filter_window_ = std::chrono::minutes(10);
+  std::chrono::microseconds maximum_ack_hold_time_ =
+      std::chrono::milliseconds(100);
+  std::size_t background_thread_pool_size_ = DefaultThreadPoolSize();
+  std::shared_ptr<SubscriberExecutor> executor_;
+  std::shared_ptr<RetryPolicy const> retry_policy_ =
+      std::make_shared<LimitedTimeRetryPolicy>(std::chrono::seconds(60));
+  std::shared_ptr<BackoffPolicy const> backoff_policy_ =
+      std::make_shared<ExponentialBackoffPolicy>(
+          std::chrono::milliseconds(100), std::chrono::seconds(10), 2.0);
+  std::shared_ptr<IdempotencyPolicy const> idempotency_policy_ =
+      std::make_shared<DefaultIdempotencyPolicy>();
+  double retry_budget_max_tokens_ = 100;
+  double retry_budget_token_ratio_ = 0.1;
+  bool hedging_ = false;
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_SUBSCRIBER_OPTIONS_H
@@ -0,0 +1,160 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/pubsub/subscriber_options.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+namespace {
+
+TEST(SubscriberOptions, Defaults) {
+  SubscriberOptions const options;
+  EXPECT_EQ(std::chrono::seconds(10), options.stream_ack_deadline());
+  EXPECT_EQ(std::chrono::minutes(60), options.max_deadline_time());
+  EXPECT_EQ(1000U, options.maximum_outstanding_messages());
+  EXPECT_EQ(100 * 1024 * 1024U, options.maximum_outstanding_bytes());
+  EXPECT_EQ(1000U, options.maximum_ack_batch_count());
+  EXPECT_EQ(std::chrono::milliseconds(100), options.maximum_ack_hold_time());
+  EXPECT_LE(1U, options.background_thread_pool_size());
+  EXPECT_EQ(nullptr, options.executor());
+  EXPECT_FALSE(options.message_ordering());
+  EXPECT_EQ(1U, options.concurrent_streams());
+  EXPECT_EQ(0U, options.pull_pipeline_depth());
+  EXPECT_EQ(0U, options.duplicate_filter_size());
+  EXPECT_EQ(std::chrono::minutes(10), options.duplicate_filter_window());
+  ASSERT_NE(nullptr, options.retry_policy());
+  ASSERT_NE(nullptr, options.backoff_policy());
+  EXPECT_FALSE(options.idempotency_policy()->IsIdempotent(
+      IdempotencyPolicy::Operation::kCreateSubscription));
+  EXPECT_DOUBLE_EQ(100.0, options.retry_budget_max_tokens());
+  EXPECT_DOUBLE_EQ(0.1, options.retry_budget_token_ratio());
+  EXPECT_FALSE(options.hedging());
+}
+
+TEST(SubscriberOptions, RetryPolicies) {
+  auto const options =
+      SubscriberOptions{}
+          .set_retry_policy(LimitedErrorCountRetryPolicy(0))
+          .set_backoff_policy(ExponentialBackoffPolicy(
+              std::chrono::milliseconds(10), std::chrono::milliseconds(10), 2))
+          .set_idempotency_policy(AlwaysRetryIdempotencyPolicy{})
+          .set_retry_budget(10, 0.5);
+  EXPECT_FALSE(options.retry_policy()->clone()->OnFailure(
+      Status(StatusCode::kUnavailable, "try-again")));
+  auto const delay = options.backoff_policy()->clone()->OnCompletion();
+  EXPECT_LE(std::chrono::milliseconds(5), delay);
+  EXPECT_GE(std::chrono::milliseconds(10), delay);
+  EXPECT_TRUE(options.idempotency_policy()->IsIdempotent(
+      IdempotencyPolicy::Operation::kCreateTopic));
+  EXPECT_DOUBLE_EQ(10.0, options.retry_budget_max_tokens());
+  EXPECT_DOUBLE_EQ(0.5, options.retry_budget_token_ratio());
+}
+
+TEST(SubscriberOptions, Setters) {
+  auto const options = SubscriberOptions{}
+                           .set_stream_ack_deadline(std::chrono::minutes(1))
+                           .set_max_deadline_time(std::chrono::minutes(5))
+                           .set_background_thread_pool_size(3);
+  EXPECT_EQ(std::chrono::seconds(60), options.stream_ack_deadline());
+  EXPECT_EQ(std::chrono::minutes(5), options.max_deadline_time());
+  EXPECT_EQ(3U, options.background_thread_pool_size());
+}
+
+TEST(SubscriberOptions, StreamAckDeadlineClamped) {
+  auto options =
+      SubscriberOptions{}.set_stream_ack_deadline(std::chrono::seconds(1));
+  EXPECT_EQ(std::chrono::seconds(10), options.stream_ack_deadline());
+  options.set_stream_ack_deadline(std::chrono::hours(1));
+  EXPECT_EQ(std::chrono::seconds(600), options.stream_ack_deadline());
+}
+
+TEST(SubscriberOptions, AckBatching) {
+  auto options = SubscriberOptions{}
+                     .set_maximum_ack_batch_count(10)
+                     .set_maximum_ack_hold_time(std::chrono::milliseconds(5));
+  EXPECT_EQ(10U, options.maximum_ack_batch_count());
+  EXPECT_EQ(std::chrono::milliseconds(5), options.maximum_ack_hold_time());
+  options.set_maximum_ack_batch_count(0);
+  EXPECT_EQ(1U, options.maximum_ack_batch_count());
+  options.set_maximum_ack_batch_count(10000);
+  EXPECT_EQ(2500U, options.maximum_ack_batch_count());
+}
+
+TEST(SubscriberOptions, FlowControl) {
+  auto options = SubscriberOptions{}
+                     .set_maximum_outstanding_messages(10)
+                     .set_maximum_outstanding_bytes(1024);
+  EXPECT_EQ(10U, options.maximum_outstanding_messages());
+  EXPECT_EQ(1024U, options.maximum_outstanding_bytes());
+  options.set_maximum_outstanding_messages(0);
+  EXPECT_EQ(1U, options.maximum_outstanding_messages());
+}
+
+TEST(SubscriberOptions, ZeroThreadsIsOne) {
+  auto const options = SubscriberOptions{}.set_background_thread_pool_size(0);
+  EXPECT_EQ(1U, options.background_thread_pool_size());
+}
+
+TEST(SubscriberOptions, ConcurrentStreams) {
+  auto options = SubscriberOptions{}.set_concurrent_streams(4);
+  EXPECT_EQ(4U, options.concurrent_streams());
+  options.set_concurrent_streams(0);
+  EXPECT_EQ(1U, options.concurrent_streams());
+}
+
+TEST(SubscriberOptions, PullPipelineDepth) {
+  auto options = SubscriberOptions{}.set_pull_pipeline_depth(4);
+  EXPECT_EQ(4U, options.pull_pipeline_depth());
+  options.set_pull_pipeline_depth(0);
+  EXPECT_EQ(0U, options.pull_pipeline_depth());
+}
+
+TEST(SubscriberOptions, DuplicateFilter) {
+  auto const options = SubscriberOptions{}
+                           .set_duplicate_filter_size(10000)
+                           .set_duplicate_filter_window(std::chrono::hours(1));
+  EXPECT_EQ(10000U, options.duplicate_filter_size());
+  EXPECT_EQ(std::chrono::minutes(60), options.duplicate_filter_window());
+}
+
+TEST(SubscriberOptions, Hedging) {
+  auto options = SubscriberOptions{}.enable_hedging();
+  EXPECT_TRUE(options.hedging());
+  options.disable_hedging();
+  EXPECT_FALSE(options.hedging());
+}
+
+TEST(SubscriberOptions, MessageOrdering) {
+  auto options = SubscriberOptions{}.enable_message_ordering();
+  EXPECT_TRUE(options.message_ordering());
+  options.disable_message_ordering();
+  EXPECT_FALSE(options.message_ordering());
+}
+
+TEST(SubscriberOptions, Executor) {
+  auto executor = MakeWorkStealingExecutor(2);
+  auto options = SubscriberOptions{}.set_executor(executor);
+  EXPECT_EQ(executor, options.executor());
+  options.set_executor(nullptr);
+  EXPECT_EQ(nullptr, options.executor());
+}
+
+}  // namespace
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,78 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_SUBSCRIBER_STATISTICS_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_SUBSCRIBER_STATISTICS_H
+
+#include "google/cloud/pubsub/version.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace pubsub {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+/**
+ * A snapshot of the counters kept by the subscriber.
+ *
+ * The counters include all the `Subscribe()` sessions created by a connection
+ * since the connection was created. Applications can use them to export
+ * metrics, or to tune the `SubscriberOptions`.
+ */
+struct SubscriberStatistics {
+  /// The number of batches of acknowledgements sent.
+  std::uint64_t ack_batches = 0;
+  /// The number of acknowledgements, rejections, and deadline modifications
+  /// in those batches.
+  std::uint64_t ack_batch_items = 0;
+  /// The number of batches sent using unary RPCs, because there was no stream.
+  std::uint64_t unary_ack_batches = 0;
+  /// The number of times a session stopped reading from its stream because
+  /// the flow control limits were exceeded.
+  std::uint64_t flow_control_pauses = 0;
+  /// The number of messages checked against the duplicate filter.
+  std::uint64_t duplicate_filter_lookups = 0;
+  /// The number of redeliveries dropped by the duplicate filter.
+  std::uint64_t duplicate_filter_hits = 0;
+  /// The approximate memory used by the duplicate filters of the active
+  /// sessions, in bytes.
+  std::uint64_t duplicate_filter_bytes = 0;
+  /// The number of RPCs in flight on each channel, including the
+  /// `StreamingPull` streams. A large imbalance indicates some connections are
+  /// slow, see `ConnectionOptions::set_num_channels()`.
+  std::vector<std::size_t> channel_rpcs_in_flight;
+
+  /// The average number of items per batch.
+  double average_ack_batch_size() const {
+    if (ack_batches == 0) return 0.0;
+    return static_cast<double>(ack_batch_items) /
+           static_cast<double>(ack_batches);
+  }
+
+  /// The fraction of the messages dropped by the duplicate filter.
+  double duplicate_filter_hit_rate() const {
+    if (duplicate_filter_lookups == 0) return 0.0;
+    return static_cast<double>(duplicate_filter_hits) /
+           static_cast<double>(duplicate_filter_lookups);
+  }
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_SUBSCRIBER_STATISTICS_H
@@ -0,0 +1,98 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_TESTING_MOCK_SUBSCRIBER_STUB_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_TESTING_MOCK_SUBSCRIBER_STUB_H
+
+#include "google/cloud/pubsub/internal/subscriber_stub.h"
+#include "google/cloud/pubsub/version.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace pubsub_testing {
+inline namespace GOOGLE_CLOUD_CPP_PUBSUB_NS {
+
+class MockSubscriberStub : public pubsub_internal::SubscriberStub {
+ public:
+  ~MockSubscriberStub() override = default;
+
+  MOCK_METHOD(StatusOr<google::pubsub::v1::Subscription>, CreateSubscription,
+              (grpc::ClientContext&, google::pubsub::v1::Subscription const&),
+              (override));
+
+  MOCK_METHOD(StatusOr<google::pubsub::v1::ListSubscriptionsResponse>,
+              ListSubscriptions,
+              (grpc::ClientContext&,
+               google::pubsub::v1::ListSubscriptionsRequest const&),
+              (override));
+
+  MOCK_METHOD(future<StatusOr<google::pubsub::v1::ListSubscriptionsResponse>>,
+              AsyncListSubscriptions,
+              (google::cloud::grpc_utils::CompletionQueue&,
+               std::unique_ptr<grpc::ClientContext>,
+               google::pubsub::v1::ListSubscriptionsRequest const&),
+              (override));
+
+  MOCK_METHOD(Status, DeleteSubscription,
+              (grpc::ClientContext&,
+               google::pubsub::v1::DeleteSubscriptionRequest const&),
+              (override));
+
+  MOCK_METHOD(future<Status>, AsyncAcknowledge,
+              (google::cloud::grpc_utils::CompletionQueue&,
+               std::unique_ptr<grpc::ClientContext>,
+               google::pubsub::v1::AcknowledgeRequest const&),
+              (override));
+
+  MOCK_METHOD(future<Status>, AsyncModifyAckDeadline,
+              (google::cloud::grpc_utils::CompletionQueue&,
+               std::unique_ptr<grpc::ClientContext>,
+               google::pubsub::v1::ModifyAckDeadlineRequest const&),
+              (override));
+
+  MOCK_METHOD(future<StatusOr<google::pubsub::v1::PullResponse>>, AsyncPull,
+              (google::cloud::grpc_utils::CompletionQueue&,
+               std::unique_ptr<grpc::ClientContext>,
+               google::pubsub::v1::PullRequest const&),
+              (override));
+
+  MOCK_METHOD(std::unique_ptr<pubsub_internal::StreamingPullStream>,
+              StreamingPull, (std::unique_ptr<grpc::ClientContext>),
+              (override));
+
+  MOCK_METHOD(future<Status>, AsyncWaitForConnected,
+              (google::cloud::grpc_utils::CompletionQueue&,
+               std::chrono::system_clock::time_point),
+              (override));
+};
+
+class MockStreamingPullStream : public pubsub_internal::StreamingPullStream {
+ public:
+  ~MockStreamingPullStream() override = default;
+
+  MOCK_METHOD(void, Cancel, (), (override));
+  MOCK_METHOD(bool, Write, (google::pubsub::v1::StreamingPullRequest const&),
+              (override));
+  MOCK_METHOD(bool, Read, (google::pubsub::v1::StreamingPullResponse*),
+              (override));
+  MOCK_METHOD(Status, Finish, (), (override));
+};
+
+}  // namespace GOOGLE_CLOUD_CPP_PUBSUB_NS
+}  // namespace pubsub_testing
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_PUBSUB_TESTING_MOCK_SUBSCRIBER_STUB_H